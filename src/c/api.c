@@ -9,6 +9,9 @@
 #include <ovmo.h>
 #include <ovnum.h>
 #include <ovthreads.h>
+#include <ovutf.h>
+
+#include <string.h>
 
 #include <aviutl2_plugin2.h>
 
@@ -148,6 +151,24 @@ cleanup:
   return result;
 }
 
+/**
+ * @brief Same checks as is_safe_file_path on a UTF-8 path, so a path can be rejected before it is converted
+ */
+static bool is_safe_file_path_utf8(char const *const path, size_t const path_len) {
+  if (!path || path_len == 0 || strlen(path) != path_len) {
+    return false;
+  }
+  if (strstr(path, "..") != NULL) {
+    return false;
+  }
+  // A drive letter is ASCII, so the second character is the second byte
+  if (path_len < 3 || path[1] != ':') {
+    return false;
+  }
+  size_t const wide_len = ov_utf8_to_wchar_len(path, path_len);
+  return wide_len >= 3 && wide_len <= max_file_path_length;
+}
+
 static bool validate_request_limits(enum external_api_format_version const format_version,
                                     struct gcmz_api_request_params const *const params) {
   if (!params) {
@@ -182,57 +203,6 @@ cleanup:
   return result;
 }
 
-static NODISCARD bool
-utf8_to_wstr(char const *const utf8_str, size_t const utf8_len, wchar_t **const ws, struct ov_error *const err) {
-  if (!utf8_str || !ws) {
-    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
-    return false;
-  }
-
-  bool result = false;
-
-  if (utf8_len == 0) {
-    if (!OV_ARRAY_GROW(ws, 1)) {
-      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
-      goto cleanup;
-    }
-    (*ws)[0] = L'\0';
-    result = true;
-    goto cleanup;
-  }
-
-  {
-    int const ws_len = MultiByteToWideChar(CP_UTF8, 0, utf8_str, (int)utf8_len, NULL, 0);
-    if (ws_len <= 0) {
-      OV_ERROR_SET_HRESULT(err, HRESULT_FROM_WIN32(GetLastError()));
-      goto cleanup;
-    }
-    if (!OV_ARRAY_GROW(ws, (size_t)ws_len + 1)) {
-      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
-      goto cleanup;
-    }
-    int const converted = MultiByteToWideChar(CP_UTF8, 0, utf8_str, (int)utf8_len, *ws, ws_len);
-    if (converted <= 0) {
-      OV_ERROR_SET_HRESULT(err, HRESULT_FROM_WIN32(GetLastError()));
-      goto cleanup;
-    }
-    if (converted != ws_len) {
-      OV_ERROR_SET(err, ov_error_type_generic, ov_error_generic_fail, "failed to convert UTF-8 to wide character");
-      goto cleanup;
-    }
-
-    (*ws)[ws_len] = L'\0';
-  }
-
-  result = true;
-
-cleanup:
-  if (!result && ws && *ws) {
-    OV_ARRAY_DESTROY(ws);
-  }
-  return result;
-}
-
 static NODISCARD HANDLE create_mutex(wchar_t const *const name, struct ov_error *const err) {
   if (!name) {
     OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
@@ -496,22 +466,15 @@ static NODISCARD bool parse_v1v2_request(enum external_api_format_version format
 
       char const *file_path_utf8 = yyjson_get_str(file_val);
       size_t file_path_len = yyjson_get_len(file_val);
-      wchar_t *file_path_wstr = NULL;
-      if (!utf8_to_wstr(file_path_utf8, file_path_len, &file_path_wstr, err)) {
-        OV_ERROR_ADD_TRACE(err);
-        goto cleanup;
-      }
-      if (!is_safe_file_path(file_path_wstr)) {
-        OV_ARRAY_DESTROY(&file_path_wstr);
+      if (!is_safe_file_path_utf8(file_path_utf8, file_path_len)) {
         OV_ERROR_SET(err, ov_error_type_generic, ov_error_generic_fail, "unsafe file path detected");
         goto cleanup;
       }
-      if (!gcmz_file_list_add(params->files, file_path_wstr, L"application/octet-stream", err)) {
-        OV_ARRAY_DESTROY(&file_path_wstr);
+      // The UTF-8 path is kept with the entry and handed to Lua as is
+      if (!gcmz_file_list_add_utf8(params->files, file_path_utf8, "application/octet-stream", false, err)) {
         OV_ERROR_ADD_TRACE(err);
         goto cleanup;
       }
-      OV_ARRAY_DESTROY(&file_path_wstr);
     }
   }
 
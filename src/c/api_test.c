@@ -463,6 +463,37 @@ static void test_margin_parameter(void) {
   test_api_fixture_cleanup(&fixture);
 }
 
+static void test_unsafe_json_paths(void) {
+  SKIP_IF_MUTEX_EXISTS();
+
+  struct test_api_fixture fixture = {0};
+  struct ov_error err = {0};
+
+  if (!TEST_SUCCEEDED(test_api_fixture_init(&fixture, &err), &err)) {
+    return;
+  }
+
+  // Requests with an unsafe path anywhere in the list are rejected before reaching the callback
+  {
+    char json[] = "{\"layer\":1,\"frameAdvance\":0,\"files\":[\"C:\\\\test\\\\..\\\\secret.txt\"]}";
+    TEST_CHECK(!test_api_send_request(&fixture, api_format_v2, json, strlen(json)));
+    TEST_CHECK(!fixture.ctx.callback_called);
+  }
+  {
+    char json[] = "{\"layer\":1,\"frameAdvance\":0,\"files\":[\"C:\\\\test\\\\ok.txt\",\"relative.txt\"]}";
+    TEST_CHECK(!test_api_send_request(&fixture, api_format_v2, json, strlen(json)));
+    TEST_CHECK(!fixture.ctx.callback_called);
+  }
+
+  // A safe request still goes through afterwards
+  {
+    char json[] = "{\"layer\":1,\"frameAdvance\":0,\"files\":[\"C:\\\\test\\\\\xe3\x83\x86.txt\"]}";
+    TEST_CHECK(test_api_send_request(&fixture, api_format_v2, json, strlen(json)));
+  }
+
+  test_api_fixture_cleanup(&fixture);
+}
+
 TEST_LIST = {
     {"api_create_destroy", test_api_create_destroy},
     {"api_callback_setting", test_api_callback_setting},
@@ -473,5 +504,6 @@ TEST_LIST = {
     {"api_structures", test_api_structures},
     {"multiple_data_sets", test_multiple_data_sets},
     {"margin_parameter", test_margin_parameter},
+    {"unsafe_json_paths", test_unsafe_json_paths},
     {NULL, NULL},
 };
@@ -23,6 +23,8 @@ struct gcmz_config {
   enum gcmz_processing_mode processing_mode;
   bool allow_create_directories;
   bool external_api;
+  bool async_handlers;
+  size_t async_handler_states;
   bool show_debug_menu;
   gcmz_project_path_provider_fn project_path_getter;
   void *userdata;
@@ -154,6 +156,7 @@ struct gcmz_config *gcmz_config_create(struct gcmz_config_options const *const o
   }
   *cfg = (struct gcmz_config){
       .external_api = true,
+      .async_handler_states = 1,
       .project_path_getter = options ? options->project_path_provider : NULL,
       .userdata = options ? options->userdata : NULL,
   };
@@ -481,6 +484,8 @@ static char const g_json_key_version[] = "version";
 static char const g_json_key_processing_mode[] = "processing_mode";
 static char const g_json_key_allow_create_directories[] = "allow_create_directories";
 static char const g_json_key_external_api[] = "external_api";
+static char const g_json_key_async_handlers[] = "async_handlers";
+static char const g_json_key_async_handler_states[] = "async_handler_states";
 static char const g_json_key_show_debug_menu[] = "show_debug_menu";
 static char const g_json_key_save_paths[] = "save_paths";
 
@@ -640,6 +645,19 @@ bool gcmz_config_load(struct gcmz_config *const config, struct ov_error *const e
       config->external_api = yyjson_get_bool(external_api_val);
     }
 
+    yyjson_val *async_handlers_val = yyjson_obj_get(root, g_json_key_async_handlers);
+    if (async_handlers_val && yyjson_is_bool(async_handlers_val)) {
+      config->async_handlers = yyjson_get_bool(async_handlers_val);
+    }
+
+    yyjson_val *async_handler_states_val = yyjson_obj_get(root, g_json_key_async_handler_states);
+    if (async_handler_states_val && yyjson_is_int(async_handler_states_val)) {
+      int const states = yyjson_get_int(async_handler_states_val);
+      if (states >= 1 && states <= gcmz_config_async_handler_states_max) {
+        config->async_handler_states = (size_t)states;
+      }
+    }
+
     yyjson_val *show_debug_menu_val = yyjson_obj_get(root, g_json_key_show_debug_menu);
     if (show_debug_menu_val && yyjson_is_bool(show_debug_menu_val)) {
       config->show_debug_menu = yyjson_get_bool(show_debug_menu_val);
@@ -707,6 +725,8 @@ bool gcmz_config_save(struct gcmz_config const *const config, struct ov_error *c
         doc, root, g_json_key_processing_mode, gcmz_processing_mode_to_string(config->processing_mode));
     yyjson_mut_obj_add_bool(doc, root, g_json_key_allow_create_directories, config->allow_create_directories);
     yyjson_mut_obj_add_bool(doc, root, g_json_key_external_api, config->external_api);
+    yyjson_mut_obj_add_bool(doc, root, g_json_key_async_handlers, config->async_handlers);
+    yyjson_mut_obj_add_uint(doc, root, g_json_key_async_handler_states, config->async_handler_states);
     yyjson_mut_obj_add_bool(doc, root, g_json_key_show_debug_menu, config->show_debug_menu);
 
     yyjson_mut_val *save_paths_array = yyjson_mut_arr(doc);
@@ -937,6 +957,54 @@ bool gcmz_config_set_external_api(struct gcmz_config *const config,
   return true;
 }
 
+bool gcmz_config_get_async_handlers(struct gcmz_config const *const config,
+                                    bool *const async_handlers,
+                                    struct ov_error *const err) {
+  if (!config || !async_handlers) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  *async_handlers = config->async_handlers;
+  return true;
+}
+
+bool gcmz_config_set_async_handlers(struct gcmz_config *const config,
+                                    bool const async_handlers,
+                                    struct ov_error *const err) {
+  if (!config) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  config->async_handlers = async_handlers;
+  return true;
+}
+
+bool gcmz_config_get_async_handler_states(struct gcmz_config const *const config,
+                                          size_t *const states,
+                                          struct ov_error *const err) {
+  if (!config || !states) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  *states = config->async_handler_states;
+  return true;
+}
+
+bool gcmz_config_set_async_handler_states(struct gcmz_config *const config,
+                                          size_t const states,
+                                          struct ov_error *const err) {
+  if (!config || states < 1 || states > gcmz_config_async_handler_states_max) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  config->async_handler_states = states;
+  return true;
+}
+
 bool gcmz_config_get_show_debug_menu(struct gcmz_config const *const config,
                                      bool *const show_debug_menu,
                                      struct ov_error *const err) {
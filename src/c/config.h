@@ -143,6 +143,67 @@ bool gcmz_config_set_external_api(struct gcmz_config *const config,
                                   bool const external_api,
                                   struct ov_error *const err);
 
+/**
+ * @brief Get asynchronous handler setting
+ *
+ * @param config Configuration structure
+ * @param async_handlers Output setting value
+ * @param err Error information
+ * @return true on success, false on failure
+ */
+bool gcmz_config_get_async_handlers(struct gcmz_config const *const config,
+                                    bool *const async_handlers,
+                                    struct ov_error *const err);
+
+/**
+ * @brief Set asynchronous handler setting
+ *
+ * When enabled, exo_convert and drop handlers for external API requests run on a worker thread
+ * and only the timeline insertion is performed on the UI thread.
+ *
+ * @param config Configuration structure
+ * @param async_handlers Whether to run handlers for external API requests on a worker thread
+ * @param err Error information
+ * @return true on success, false on failure
+ */
+bool gcmz_config_set_async_handlers(struct gcmz_config *const config,
+                                    bool const async_handlers,
+                                    struct ov_error *const err);
+
+/**
+ * @brief Upper limit of the number of Lua states used for asynchronous handlers
+ */
+enum {
+  gcmz_config_async_handler_states_max = 8,
+};
+
+/**
+ * @brief Get the number of Lua states used for asynchronous handlers
+ *
+ * @param config Configuration structure
+ * @param states Output setting value
+ * @param err Error information
+ * @return true on success, false on failure
+ */
+bool gcmz_config_get_async_handler_states(struct gcmz_config const *const config,
+                                          size_t *const states,
+                                          struct ov_error *const err);
+
+/**
+ * @brief Set the number of Lua states used for asynchronous handlers
+ *
+ * Each state loads its own copy of the handlers, so external API requests arriving
+ * at the same time can run their handlers in parallel. Takes effect on the next start.
+ *
+ * @param config Configuration structure
+ * @param states Number of states, from 1 to gcmz_config_async_handler_states_max
+ * @param err Error information
+ * @return true on success, false on failure
+ */
+bool gcmz_config_set_async_handler_states(struct gcmz_config *const config,
+                                          size_t const states,
+                                          struct ov_error *const err);
+
 /**
  * @brief Get show debug menu setting
  *
@@ -44,6 +44,7 @@ enum {
   id_group_external_api = 300,
   id_check_enable_external_api = 301,
   id_label_external_api_status = 302,
+  id_check_async_handlers = 303,
 
   id_group_debug = 400,
   id_check_show_debug_menu = 401,
@@ -332,6 +333,8 @@ static INT_PTR init_dialog(HWND dialog, struct dialog_data *data) {
   SetWindowTextW(GetDlgItem(dialog, id_group_external_api), buf);
   ov_snprintf_wchar(buf, sizeof(buf) / sizeof(WCHAR), ph, ph, gettext("&Enable"));
   SetWindowTextW(GetDlgItem(dialog, id_check_enable_external_api), buf);
+  ov_snprintf_wchar(buf, sizeof(buf) / sizeof(WCHAR), ph, ph, gettext("Run drop handlers in the &background"));
+  SetWindowTextW(GetDlgItem(dialog, id_check_async_handlers), buf);
   ov_snprintf_wchar(buf, sizeof(buf) / sizeof(WCHAR), ph, ph, gettext("Debug"));
   SetWindowTextW(GetDlgItem(dialog, id_group_debug), buf);
   ov_snprintf_wchar(buf, sizeof(buf) / sizeof(WCHAR), ph, ph, gettext("&Show debug menu"));
@@ -389,6 +392,16 @@ static INT_PTR init_dialog(HWND dialog, struct dialog_data *data) {
     SetWindowTextW(GetDlgItem(dialog, id_label_external_api_status), buf);
   }
 
+  {
+    bool async_handlers;
+    if (!gcmz_config_get_async_handlers(data->config, &async_handlers, &err)) {
+      OV_ERROR_REPORT(&err, NULL);
+      async_handlers = false;
+    }
+    SendMessageW(
+        GetDlgItem(dialog, id_check_async_handlers), BM_SETCHECK, async_handlers ? BST_CHECKED : BST_UNCHECKED, 0);
+  }
+
   {
     bool show_debug_menu;
     if (!gcmz_config_get_show_debug_menu(data->config, &show_debug_menu, &err)) {
@@ -521,6 +534,7 @@ static int const settings_tab_controls[] = {
     id_group_external_api,
     id_check_enable_external_api,
     id_label_external_api_status,
+    id_check_async_handlers,
     id_group_debug,
     id_check_show_debug_menu,
 };
@@ -1058,6 +1072,17 @@ static bool click_ok(HWND dialog, struct dialog_data *data) {
     }
   }
 
+  {
+    // Save asynchronous handler setting
+    HWND h = GetDlgItem(dialog, id_check_async_handlers);
+    LRESULT const async_handlers_checked = SendMessageW(h, BM_GETCHECK, 0, 0);
+    bool const async_handlers = (async_handlers_checked == BST_CHECKED);
+    if (!gcmz_config_set_async_handlers(data->config, async_handlers, &err)) {
+      OV_ERROR_ADD_TRACE(&err);
+      goto cleanup;
+    }
+  }
+
   {
     // Save show debug menu setting
     HWND h = GetDlgItem(dialog, id_check_show_debug_menu);
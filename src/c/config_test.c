@@ -77,6 +77,47 @@ static void test_config_default_values(void) {
   }
   TEST_CHECK(mode == gcmz_processing_mode_auto);
 
+  size_t states = 0;
+  if (!TEST_SUCCEEDED(gcmz_config_get_async_handler_states(config, &states, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(states == 1);
+
+cleanup:
+  gcmz_config_destroy(&config);
+}
+
+static void test_config_async_handler_states_getset(void) {
+  struct gcmz_config *config = NULL;
+  size_t states = 0;
+  struct ov_error err = {0};
+
+  config = gcmz_config_create(NULL, &err);
+  if (!TEST_SUCCEEDED(config != NULL, &err)) {
+    goto cleanup;
+  }
+
+  if (!TEST_SUCCEEDED(gcmz_config_set_async_handler_states(config, 4, &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_config_get_async_handler_states(config, &states, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(states == 4);
+
+  TEST_FAILED_WITH(gcmz_config_set_async_handler_states(config, 0, &err),
+                   &err,
+                   ov_error_type_generic,
+                   ov_error_generic_invalid_argument);
+  TEST_FAILED_WITH(gcmz_config_set_async_handler_states(config, gcmz_config_async_handler_states_max + 1, &err),
+                   &err,
+                   ov_error_type_generic,
+                   ov_error_generic_invalid_argument);
+  if (!TEST_SUCCEEDED(gcmz_config_get_async_handler_states(config, &states, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(states == 4);
+
 cleanup:
   gcmz_config_destroy(&config);
 }
@@ -474,6 +515,7 @@ TEST_LIST = {
     {"config_create_destroy", test_config_create_destroy},
     {"config_default_values", test_config_default_values},
     {"config_processing_mode_getset", test_config_processing_mode_getset},
+    {"config_async_handler_states_getset", test_config_async_handler_states_getset},
     {"config_save_load", test_config_save_load},
     {"config_get_save_path_with_save_paths", test_config_get_save_path_with_save_paths},
     {"config_get_save_path_nonexistent_dir_no_create", test_config_get_save_path_nonexistent_dir_no_create},
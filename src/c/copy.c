@@ -13,7 +13,8 @@
 #include <shlobj.h>
 #include <shlwapi.h>
 
-static bool calc_file_hash(wchar_t const *const file_path, uint64_t *const hash, struct ov_error *const err) {
+NODISCARD bool
+gcmz_copy_calc_file_hash(wchar_t const *const file_path, uint64_t *const hash, struct ov_error *const err) {
   if (!file_path || !hash) {
     OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
     return false;
@@ -82,6 +83,33 @@ cleanup:
   return result;
 }
 
+uint64_t gcmz_copy_calc_hash(void const *const data, size_t const len) {
+  enum {
+    chunk_words = 1024,
+  };
+
+  uint32_t chunk[chunk_words];
+  struct ov_cyrb64 ctx;
+  ov_cyrb64_init(&ctx, 0);
+
+  // Same word sequence as gcmz_copy_calc_file_hash, data is copied because it may not be 4-byte aligned
+  uint8_t const *p = (uint8_t const *)data;
+  size_t remaining = data ? len : 0;
+  while (remaining >= 4) {
+    size_t const words = remaining / 4 < chunk_words ? remaining / 4 : chunk_words;
+    memcpy(chunk, p, words * 4);
+    ov_cyrb64_update(&ctx, chunk, words);
+    p += words * 4;
+    remaining -= words * 4;
+  }
+  if (remaining > 0) {
+    chunk[0] = 0;
+    memcpy(chunk, p, remaining);
+    ov_cyrb64_update(&ctx, chunk, 1);
+  }
+  return ov_cyrb64_final(&ctx);
+}
+
 static bool is_file_under_directory(wchar_t const *file_path, wchar_t const *directory_path) {
   if (!file_path || !directory_path) {
     return false;
@@ -353,7 +381,7 @@ bool gcmz_copy(wchar_t const *const source_file,
       result = true;
       goto cleanup;
     }
-    if (!calc_file_hash(source_file, &file_hash, err)) {
+    if (!gcmz_copy_calc_file_hash(source_file, &file_hash, err)) {
       OV_ERROR_ADD_TRACE(err);
       goto cleanup;
     }
@@ -14,6 +14,30 @@
  */
 typedef wchar_t *(*gcmz_copy_get_save_path_fn)(wchar_t const *filename, void *userdata, struct ov_error *err);
 
+/**
+ * @brief Calculate the content hash of a file
+ *
+ * This is the hash used to name and find cached copies in gcmz_copy.
+ *
+ * @param file_path File to hash
+ * @param hash [out] 64-bit hash of the file content
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+NODISCARD bool
+gcmz_copy_calc_file_hash(wchar_t const *const file_path, uint64_t *const hash, struct ov_error *const err);
+
+/**
+ * @brief Calculate the content hash of a memory block
+ *
+ * Gives the same value as gcmz_copy_calc_file_hash for a file with the same content.
+ *
+ * @param data Data to hash, may be NULL if len is 0
+ * @param len Size of data in bytes
+ * @return 64-bit hash of the data
+ */
+uint64_t gcmz_copy_calc_hash(void const *const data, size_t const len);
+
 /**
  * @brief Manage file processing including hash-based caching and copying
  *
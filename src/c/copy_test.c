@@ -179,8 +179,37 @@ cleanup:
   RemoveDirectoryW(temp_dir);
 }
 
+static void test_memory_hash_matches_file_hash(void) {
+  static char const data[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+  struct ov_error err = {0};
+
+  // Every tail length, so the zero padding of the last word is covered
+  for (size_t len = 0; len < 9; ++len) {
+    char content[16] = {0};
+    memcpy(content, data, len);
+    wchar_t *path = create_test_file(L"gcmz_hash_test.txt", content, &err);
+    if (!TEST_SUCCEEDED(path != NULL, &err)) {
+      return;
+    }
+    uint64_t file_hash = 0;
+    if (TEST_SUCCEEDED(gcmz_copy_calc_file_hash(path, &file_hash, &err), &err)) {
+      TEST_CHECK(file_hash == gcmz_copy_calc_hash(content, len));
+      TEST_MSG("len=%zu", len);
+    }
+    DeleteFileW(path);
+    OV_ARRAY_DESTROY(&path);
+  }
+
+  // Unaligned input gives the same result
+  char unaligned[sizeof(data) + 1];
+  memcpy(unaligned + 1, data, sizeof(data));
+  TEST_CHECK(gcmz_copy_calc_hash(unaligned + 1, sizeof(data) - 1) == gcmz_copy_calc_hash(data, sizeof(data) - 1));
+  TEST_CHECK(gcmz_copy_calc_hash(data, 4) != gcmz_copy_calc_hash(data, 5));
+}
+
 TEST_LIST = {
     {"hash_filename_generation", test_hash_filename_generation},
+    {"memory_hash_matches_file_hash", test_memory_hash_matches_file_hash},
     {"copy_needs_determination", test_copy_needs_determination},
     {"file_management_with_callback", test_file_management_with_callback},
     {NULL, NULL},
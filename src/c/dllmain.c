@@ -32,6 +32,19 @@ static struct gcmz_lua_context *g_lua = NULL;
 static struct gcmzdrops *g_gcmzdrops = NULL;
 static struct mo *g_mo = NULL;
 
+/**
+ * @brief Script module registered before g_gcmzdrops was created
+ *
+ * Kept until InitializePlugin so that the Lua worker threads also receive it.
+ */
+struct pending_script_module {
+  struct aviutl2_script_module_table *table;
+  char *name;
+  char *source;
+};
+
+static struct pending_script_module *g_pending_script_modules = NULL;
+
 /**
  * @brief Get or create the Lua context
  *
@@ -55,6 +68,71 @@ static struct gcmz_lua_context *get_lua(struct ov_error *const err) {
   return g_lua;
 }
 
+static NODISCARD bool add_pending_script_module(struct aviutl2_script_module_table *const table,
+                                                char const *const module_name,
+                                                char const *const source,
+                                                struct ov_error *const err) {
+  struct pending_script_module m = {.table = table};
+  bool result = false;
+
+  {
+    size_t const name_len = strlen(module_name);
+    size_t const source_len = strlen(source);
+    if (!OV_ARRAY_GROW(&m.name, name_len + 1) || !OV_ARRAY_GROW(&m.source, source_len + 1)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    memcpy(m.name, module_name, name_len + 1);
+    memcpy(m.source, source, source_len + 1);
+
+    size_t const ln = OV_ARRAY_LENGTH(g_pending_script_modules);
+    if (!OV_ARRAY_GROW(&g_pending_script_modules, ln + 1)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    g_pending_script_modules[ln] = m;
+    OV_ARRAY_SET_LENGTH(g_pending_script_modules, ln + 1);
+    m = (struct pending_script_module){0};
+  }
+  result = true;
+
+cleanup:
+  if (m.name) {
+    OV_ARRAY_DESTROY(&m.name);
+  }
+  if (m.source) {
+    OV_ARRAY_DESTROY(&m.source);
+  }
+  return result;
+}
+
+/**
+ * @brief Pass the pending script modules to g_gcmzdrops (if created) and release them
+ */
+static void flush_pending_script_modules(void) {
+  if (!g_pending_script_modules) {
+    return;
+  }
+  size_t const ln = OV_ARRAY_LENGTH(g_pending_script_modules);
+  for (size_t i = 0; i < ln; ++i) {
+    struct pending_script_module *const m = &g_pending_script_modules[i];
+    if (g_gcmzdrops) {
+      struct ov_error err = {0};
+      if (!gcmzdrops_register_script_module(g_gcmzdrops, m->table, m->name, m->source, &err)) {
+        gcmz_logf_warn(&err,
+                       "%1$hs",
+                       gettext("failed to register script module %1$hs from %2$hs"),
+                       m->name,
+                       m->source);
+        OV_ERROR_DESTROY(&err);
+      }
+    }
+    OV_ARRAY_DESTROY(&m->name);
+    OV_ARRAY_DESTROY(&m->source);
+  }
+  OV_ARRAY_DESTROY(&g_pending_script_modules);
+}
+
 /**
  * @brief Get UTF-8 module path from function address
  * @param fnptr Function address to get module path for
@@ -140,6 +218,7 @@ BOOL __declspec(dllexport) InitializePlugin(DWORD version) {
       OV_ERROR_ADD_TRACE(&err);
       goto cleanup;
     }
+    flush_pending_script_modules();
   }
 
 cleanup:
@@ -167,6 +246,7 @@ cleanup:
 
 void __declspec(dllexport) UninitializePlugin(void);
 void __declspec(dllexport) UninitializePlugin(void) {
+  flush_pending_script_modules();
   gcmzdrops_destroy(&g_gcmzdrops);
   if (g_lua) {
     gcmz_lua_destroy(&g_lua);
@@ -320,6 +400,16 @@ bool __declspec(dllexport) RegisterScriptModule(struct aviutl2_script_module_tab
       OV_ERROR_ADD_TRACE(&err);
       goto cleanup;
     }
+    // Handlers on the Lua worker threads need the module as well
+    if (g_gcmzdrops) {
+      if (!gcmzdrops_register_script_module(g_gcmzdrops, table, module_name, module_path_utf8, &err)) {
+        OV_ERROR_ADD_TRACE(&err);
+        goto cleanup;
+      }
+    } else if (!add_pending_script_module(table, module_name, module_path_utf8, &err)) {
+      OV_ERROR_ADD_TRACE(&err);
+      goto cleanup;
+    }
   }
 
   result = true;
@@ -917,9 +917,7 @@ static IDataObject *prepare_drop_dataobj(struct wrapped_drop_target *const wdt,
               OV_ERROR_REPORT(&cleanup_err, NULL);
             }
           }
-          OV_ARRAY_DESTROY(&file->path);
-          file->path = managed_path;
-          managed_path = NULL;
+          gcmz_file_set_path(file, &managed_path);
           file->temporary = false;
         } else {
           OV_ARRAY_DESTROY(&managed_path);
@@ -1300,27 +1298,61 @@ void *gcmz_drop_create_file_list_dataobj(struct gcmz_file_list const *const file
   return pDataObject;
 }
 
-bool gcmz_drop_simulate_drop(struct gcmz_drop *const d,
-                             struct gcmz_file_list *file_list,
+void gcmz_drop_manage_files(struct gcmz_drop_options const *const options, struct gcmz_file_list *const file_list) {
+  if (!options || !options->file_manage || !file_list) {
+    return;
+  }
+  struct ov_error err = {0};
+  wchar_t *managed_path = NULL;
+  size_t const file_count = gcmz_file_list_count(file_list);
+  for (size_t i = 0; i < file_count; i++) {
+    struct gcmz_file *file = gcmz_file_list_get_mutable(file_list, i);
+    if (!file || !file->path) {
+      continue;
+    }
+
+    if (!options->file_manage(file->path, &managed_path, options->userdata, &err)) {
+      // Report error but continue processing other files
+      OV_ERROR_REPORT(&err, NULL);
+      continue;
+    }
+
+    // If path changed, update the file list
+    if (wcscmp(file->path, managed_path) != 0) {
+      // If the old path was temporary, clean it up before replacing
+      if (file->temporary && options->cleanup) {
+        struct ov_error cleanup_err = {0};
+        if (!options->cleanup(file->path, options->userdata, &cleanup_err)) {
+          OV_ERROR_REPORT(&cleanup_err, NULL);
+        }
+      }
+      gcmz_file_set_path(file, &managed_path);
+      file->temporary = false;
+    }
+    if (managed_path) {
+      OV_ARRAY_DESTROY(&managed_path);
+    }
+  }
+}
+
+bool gcmz_drop_process_files(struct gcmz_drop_options const *const options,
+                             struct gcmz_file_list *const file_list,
                              bool const use_exo_converter,
-                             gcmz_drop_simulate_callback const completion_callback,
-                             void *const completion_userdata,
                              struct ov_error *const err) {
-  if (!d || !file_list || !completion_callback) {
+  if (!options || !file_list) {
     OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
     return false;
   }
 
   bool result = false;
-  wchar_t *managed_path = NULL;
 
   {
     // Step 1: EXO conversion (if enabled)
-    if (use_exo_converter && d->exo_convert) {
+    if (use_exo_converter && options->exo_convert) {
 #if GCMZ_DEBUG
       gcmz_logf_verbose(NULL, NULL, "External API: Invoking EXO file conversion via Lua");
 #endif
-      if (!d->exo_convert(file_list, d->userdata, err)) {
+      if (!options->exo_convert(file_list, options->userdata, err)) {
         gcmz_logf_warn(err, "%1$hs", "%1$hs", gettext("EXO file conversion failed, proceeding with original files"));
         OV_ERROR_DESTROY(err);
       }
@@ -1332,60 +1364,58 @@ bool gcmz_drop_simulate_drop(struct gcmz_drop *const d,
     }
 
     // Step 2: Call Lua handlers in sequence (Enter → Drop)
-    if (d->drag_enter) {
-      if (!d->drag_enter(file_list, 0, 0, true, d->userdata, err)) {
+    if (options->drag_enter) {
+      if (!options->drag_enter(file_list, 0, 0, true, options->userdata, err)) {
         gcmz_logf_warn(err, "%1$s", gettext("error occurred while executing %1$s script handler"), "drag_enter");
         OV_ERROR_DESTROY(err);
       }
     }
-    if (d->drop) {
-      if (!d->drop(file_list, 0, 0, true, d->userdata, err)) {
+    if (options->drop) {
+      if (!options->drop(file_list, 0, 0, true, options->userdata, err)) {
         gcmz_logf_warn(err, "%1$s", gettext("error occurred while executing %1$s script handler"), "drop");
         OV_ERROR_DESTROY(err);
       }
     }
 
     // Step 3: Apply file management (copying, etc.)
-    if (d->file_manage) {
-      size_t const file_count = gcmz_file_list_count(file_list);
-      for (size_t i = 0; i < file_count; i++) {
-        struct gcmz_file *file = gcmz_file_list_get_mutable(file_list, i);
-        if (!file || !file->path) {
-          continue;
-        }
-
-        if (!d->file_manage(file->path, &managed_path, d->userdata, err)) {
-          // Report error but continue processing other files
-          OV_ERROR_REPORT(err, NULL);
-          continue;
-        }
-
-        // If path changed, update the file list
-        if (wcscmp(file->path, managed_path) != 0) {
-          // If the old path was temporary, clean it up before replacing
-          if (file->temporary && d->cleanup) {
-            struct ov_error cleanup_err = {0};
-            if (!d->cleanup(file->path, d->userdata, &cleanup_err)) {
-              OV_ERROR_REPORT(&cleanup_err, NULL);
-            }
-          }
-          wchar_t *old_path = file->path;
-          file->path = managed_path;
-          managed_path = old_path; // Will be freed in cleanup
-          file->temporary = false;
-        }
-        OV_ARRAY_DESTROY(&managed_path);
-      }
-    }
-
-    // Step 4: Call completion callback with processed file list
-    completion_callback(file_list, completion_userdata);
+    gcmz_drop_manage_files(options, file_list);
   }
   result = true;
 
 cleanup:
-  if (managed_path) {
-    OV_ARRAY_DESTROY(&managed_path);
-  }
   return result;
 }
+
+bool gcmz_drop_simulate_drop(struct gcmz_drop *const d,
+                             struct gcmz_file_list *file_list,
+                             bool const use_exo_converter,
+                             gcmz_drop_simulate_callback const completion_callback,
+                             void *const completion_userdata,
+                             struct ov_error *const err) {
+  if (!d || !file_list || !completion_callback) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  if (!gcmz_drop_process_files(
+          &(struct gcmz_drop_options){
+              .extract = d->extract,
+              .cleanup = d->cleanup,
+              .file_manage = d->file_manage,
+              .exo_convert = d->exo_convert,
+              .drag_enter = d->drag_enter,
+              .drop = d->drop,
+              .drag_leave = d->drag_leave,
+              .userdata = d->userdata,
+          },
+          file_list,
+          use_exo_converter,
+          err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+
+  // Step 4: Call completion callback with processed file list
+  completion_callback(file_list, completion_userdata);
+  return true;
+}
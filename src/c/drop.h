@@ -171,6 +171,38 @@ void *gcmz_drop_create_file_list_dataobj(struct gcmz_file_list const *const file
  */
 typedef void (*gcmz_drop_simulate_callback)(struct gcmz_file_list const *file_list, void *userdata);
 
+/**
+ * @brief Apply file management to every file in the list
+ *
+ * Calls options->file_manage for each file and replaces the path when it changes,
+ * cleaning up the old path through options->cleanup if it was temporary.
+ * Errors are reported per file and do not stop the remaining files.
+ * Does nothing if options->file_manage is NULL.
+ *
+ * @param options Callbacks and user data to use (only file_manage, cleanup and userdata are used)
+ * @param file_list File list to process
+ */
+void gcmz_drop_manage_files(struct gcmz_drop_options const *const options, struct gcmz_file_list *const file_list);
+
+/**
+ * @brief Run the drop processing steps with the given callbacks
+ *
+ * Performs EXO conversion if enabled, calls drag_enter and drop in sequence,
+ * and applies file management. The file list is modified in place.
+ * Does not require a drop context, so it can be used on threads that have their own callbacks.
+ * extract and drag_leave in options are not used.
+ *
+ * @param options Callbacks and user data to use
+ * @param file_list File list to process
+ * @param use_exo_converter Whether to enable EXO conversion
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+bool gcmz_drop_process_files(struct gcmz_drop_options const *const options,
+                             struct gcmz_file_list *const file_list,
+                             bool const use_exo_converter,
+                             struct ov_error *const err);
+
 /**
  * @brief Process files with Lua hooks
  *
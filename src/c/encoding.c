@@ -0,0 +1,403 @@
+#include "encoding.h"
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include <ovarray.h>
+
+#include <string.h>
+
+#include "encoding_cp932.h"
+
+enum {
+  replacement_character = 0xfffd,
+  cp932_default_unicode = 0x30fb,
+  cp932_default_char = 0x3f,
+};
+
+static bool is_ascii_compatible(enum gcmz_encoding const encoding) {
+  return encoding == gcmz_encoding_cp932 || encoding == gcmz_encoding_utf8;
+}
+
+size_t gcmz_encoding_ascii_prefix(char const *const src, size_t const src_len) {
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= src_len; i += sizeof(uint64_t)) {
+    uint64_t v;
+    memcpy(&v, src + i, sizeof(v));
+    if (v & UINT64_C(0x8080808080808080)) {
+      break;
+    }
+  }
+  while (i < src_len && !((uint8_t)src[i] & 0x80)) {
+    ++i;
+  }
+  return i;
+}
+
+/**
+ * @brief Count leading ASCII code units in UTF-16 data
+ *
+ * @param src Source buffer
+ * @param unit_count Number of complete UTF-16 code units in the buffer
+ * @param big_endian true for UTF-16BE, false for UTF-16LE
+ * @return Number of leading code units below 0x80
+ */
+static size_t utf16_ascii_prefix(uint8_t const *const src, size_t const unit_count, bool const big_endian) {
+  uint64_t const mask = big_endian ? UINT64_C(0x80ff80ff80ff80ff) : UINT64_C(0xff80ff80ff80ff80);
+  size_t i = 0;
+  for (; i + 4 <= unit_count; i += 4) {
+    uint64_t v;
+    memcpy(&v, src + i * 2, sizeof(v));
+    if (v & mask) {
+      break;
+    }
+  }
+  size_t const hi = big_endian ? 0 : 1;
+  while (i < unit_count && src[i * 2 + hi] == 0 && src[i * 2 + (1 - hi)] < 0x80) {
+    ++i;
+  }
+  return i;
+}
+
+static size_t decode_cp932(uint8_t const *const s, size_t const len, uint32_t *const cp) {
+  uint8_t const b = s[0];
+  if (b < 0x80) {
+    *cp = b;
+    return 1;
+  }
+  if (b >= 0xa1 && b <= 0xdf) {
+    *cp = 0xff61 + (uint32_t)(b - 0xa1);
+    return 1;
+  }
+  if (b == 0x80) {
+    *cp = 0x80;
+    return 1;
+  }
+  if (b == 0xa0) {
+    *cp = 0xf8f0;
+    return 1;
+  }
+  if (b >= 0xfd) {
+    *cp = 0xf8f1 + (uint32_t)(b - 0xfd);
+    return 1;
+  }
+  // Lead byte: 0x81-0x9f or 0xe0-0xfc
+  if (len < 2 || s[1] < 0x40 || s[1] > 0xfc) {
+    *cp = cp932_default_unicode;
+    return 1;
+  }
+  size_t const lead_index = b <= 0x9f ? (size_t)(b - 0x81) : (size_t)(b - 0xe0 + 31);
+  uint16_t const v = g_cp932_to_utf16[lead_index][(size_t)(s[1] - 0x40)];
+  *cp = v ? v : cp932_default_unicode;
+  return 2;
+}
+
+static size_t decode_utf8(uint8_t const *const s, size_t const len, uint32_t *const cp) {
+  uint8_t const b = s[0];
+  if (b < 0x80) {
+    *cp = b;
+    return 1;
+  }
+  size_t need;
+  uint32_t v;
+  uint32_t min;
+  if (b >= 0xc2 && b <= 0xdf) {
+    need = 1;
+    v = (uint32_t)(b & 0x1f);
+    min = 0x80;
+  } else if (b >= 0xe0 && b <= 0xef) {
+    need = 2;
+    v = (uint32_t)(b & 0x0f);
+    min = 0x800;
+  } else if (b >= 0xf0 && b <= 0xf4) {
+    need = 3;
+    v = (uint32_t)(b & 0x07);
+    min = 0x10000;
+  } else {
+    *cp = replacement_character;
+    return 1;
+  }
+  if (len <= need) {
+    *cp = replacement_character;
+    return 1;
+  }
+  for (size_t i = 1; i <= need; ++i) {
+    if ((s[i] & 0xc0) != 0x80) {
+      *cp = replacement_character;
+      return 1;
+    }
+    v = (v << 6) | (uint32_t)(s[i] & 0x3f);
+  }
+  if (v < min || v > 0x10ffff || (v >= 0xd800 && v <= 0xdfff)) {
+    *cp = replacement_character;
+    return 1;
+  }
+  *cp = v;
+  return need + 1;
+}
+
+static uint32_t read_utf16_unit(uint8_t const *const s, bool const big_endian) {
+  return big_endian ? ((uint32_t)s[0] << 8) | (uint32_t)s[1] : ((uint32_t)s[1] << 8) | (uint32_t)s[0];
+}
+
+static size_t decode_utf16(uint8_t const *const s, size_t const len, bool const big_endian, uint32_t *const cp) {
+  uint32_t const u = read_utf16_unit(s, big_endian);
+  if (u < 0xd800 || u > 0xdfff) {
+    *cp = u;
+    return 2;
+  }
+  if (u <= 0xdbff && len >= 4) {
+    uint32_t const lo = read_utf16_unit(s + 2, big_endian);
+    if (lo >= 0xdc00 && lo <= 0xdfff) {
+      *cp = 0x10000 + ((u - 0xd800) << 10) + (lo - 0xdc00);
+      return 4;
+    }
+  }
+  *cp = replacement_character;
+  return 2;
+}
+
+/**
+ * @brief Encode a character that has no CP932 code of its own
+ *
+ * WideCharToMultiByte substitutes look-alike characters (e.g. U+301C WAVE DASH to 0x8160,
+ * accented Latin letters to their base letter), so the rare characters missing from the table
+ * are passed to it to keep the same result.
+ */
+static size_t encode_cp932_best_fit(uint32_t const cp, uint8_t *const out) {
+  if (cp <= 0xffff && (cp < 0xd800 || cp > 0xdfff)) {
+    wchar_t const wc = (wchar_t)cp;
+    char buf[2];
+    int const n = WideCharToMultiByte(932, 0, &wc, 1, buf, (int)sizeof(buf), NULL, NULL);
+    if (n > 0) {
+      memcpy(out, buf, (size_t)n);
+      return (size_t)n;
+    }
+  }
+  out[0] = cp932_default_char;
+  return 1;
+}
+
+static size_t encode_cp932(uint32_t const cp, uint8_t *const out) {
+  if (cp < 0x80) {
+    out[0] = (uint8_t)cp;
+    return 1;
+  }
+  uint16_t v = 0;
+  if (cp <= 0xffff) {
+    uint8_t const page = g_utf16_to_cp932_index[cp >> 8];
+    if (page) {
+      v = g_utf16_to_cp932_pages[page - 1][cp & 0xff];
+    }
+  }
+  if (!v) {
+    return encode_cp932_best_fit(cp, out);
+  }
+  if (v < 0x100) {
+    out[0] = (uint8_t)v;
+    return 1;
+  }
+  out[0] = (uint8_t)(v >> 8);
+  out[1] = (uint8_t)(v & 0xff);
+  return 2;
+}
+
+static size_t encode_utf8(uint32_t const cp, uint8_t *const out) {
+  if (cp < 0x80) {
+    out[0] = (uint8_t)cp;
+    return 1;
+  }
+  if (cp < 0x800) {
+    out[0] = (uint8_t)(0xc0 | (cp >> 6));
+    out[1] = (uint8_t)(0x80 | (cp & 0x3f));
+    return 2;
+  }
+  if (cp < 0x10000) {
+    out[0] = (uint8_t)(0xe0 | (cp >> 12));
+    out[1] = (uint8_t)(0x80 | ((cp >> 6) & 0x3f));
+    out[2] = (uint8_t)(0x80 | (cp & 0x3f));
+    return 3;
+  }
+  out[0] = (uint8_t)(0xf0 | (cp >> 18));
+  out[1] = (uint8_t)(0x80 | ((cp >> 12) & 0x3f));
+  out[2] = (uint8_t)(0x80 | ((cp >> 6) & 0x3f));
+  out[3] = (uint8_t)(0x80 | (cp & 0x3f));
+  return 4;
+}
+
+static void write_utf16_unit(uint32_t const u, uint8_t *const out, bool const big_endian) {
+  if (big_endian) {
+    out[0] = (uint8_t)(u >> 8);
+    out[1] = (uint8_t)(u & 0xff);
+  } else {
+    out[0] = (uint8_t)(u & 0xff);
+    out[1] = (uint8_t)(u >> 8);
+  }
+}
+
+static size_t encode_utf16(uint32_t const cp, uint8_t *const out, bool const big_endian) {
+  if (cp < 0x10000) {
+    write_utf16_unit(cp, out, big_endian);
+    return 2;
+  }
+  uint32_t const v = cp - 0x10000;
+  write_utf16_unit(0xd800 | (v >> 10), out, big_endian);
+  write_utf16_unit(0xdc00 | (v & 0x3ff), out + 2, big_endian);
+  return 4;
+}
+
+static size_t decode_char(enum gcmz_encoding const encoding, uint8_t const *const s, size_t const len, uint32_t *const cp) {
+  switch (encoding) {
+  case gcmz_encoding_cp932:
+    return decode_cp932(s, len, cp);
+  case gcmz_encoding_utf8:
+    return decode_utf8(s, len, cp);
+  case gcmz_encoding_utf16le:
+    return decode_utf16(s, len, false, cp);
+  case gcmz_encoding_utf16be:
+    return decode_utf16(s, len, true, cp);
+  }
+  *cp = replacement_character;
+  return len;
+}
+
+static size_t encode_char(enum gcmz_encoding const encoding, uint32_t const cp, uint8_t *const out) {
+  switch (encoding) {
+  case gcmz_encoding_cp932:
+    return encode_cp932(cp, out);
+  case gcmz_encoding_utf8:
+    return encode_utf8(cp, out);
+  case gcmz_encoding_utf16le:
+    return encode_utf16(cp, out, false);
+  case gcmz_encoding_utf16be:
+    return encode_utf16(cp, out, true);
+  }
+  return 0;
+}
+
+/**
+ * @brief Copy a leading ASCII run from source to destination
+ *
+ * @param src_encoding Source encoding
+ * @param dest_encoding Destination encoding
+ * @param s Source position
+ * @param len Remaining source bytes
+ * @param out Destination position
+ * @param written [out] Number of bytes written to out
+ * @return Number of source bytes consumed
+ */
+static size_t copy_ascii_run(enum gcmz_encoding const src_encoding,
+                             enum gcmz_encoding const dest_encoding,
+                             uint8_t const *const s,
+                             size_t const len,
+                             uint8_t *const out,
+                             size_t *const written) {
+  bool const src_wide = !is_ascii_compatible(src_encoding);
+  bool const dest_wide = !is_ascii_compatible(dest_encoding);
+  bool const src_be = src_encoding == gcmz_encoding_utf16be;
+  bool const dest_be = dest_encoding == gcmz_encoding_utf16be;
+  size_t const n = src_wide ? utf16_ascii_prefix(s, len / 2, src_be)
+                            : gcmz_encoding_ascii_prefix((char const *)s, len);
+  if (!n) {
+    *written = 0;
+    return 0;
+  }
+  if (!src_wide && !dest_wide) {
+    memcpy(out, s, n);
+    *written = n;
+    return n;
+  }
+  if (src_wide && dest_wide) {
+    if (src_be == dest_be) {
+      memcpy(out, s, n * 2);
+    } else {
+      for (size_t i = 0; i < n; ++i) {
+        out[i * 2] = s[i * 2 + 1];
+        out[i * 2 + 1] = s[i * 2];
+      }
+    }
+    *written = n * 2;
+    return n * 2;
+  }
+  if (src_wide) {
+    size_t const lo = src_be ? 1 : 0;
+    for (size_t i = 0; i < n; ++i) {
+      out[i] = s[i * 2 + lo];
+    }
+    *written = n;
+    return n * 2;
+  }
+  for (size_t i = 0; i < n; ++i) {
+    write_utf16_unit(s[i], out + i * 2, dest_be);
+  }
+  *written = n * 2;
+  return n;
+}
+
+/**
+ * @brief Get the maximum number of output bytes per input byte
+ */
+static size_t max_expansion(enum gcmz_encoding const src_encoding, enum gcmz_encoding const dest_encoding) {
+  switch (dest_encoding) {
+  case gcmz_encoding_cp932:
+    return 1;
+  case gcmz_encoding_utf16le:
+  case gcmz_encoding_utf16be:
+    return 2;
+  case gcmz_encoding_utf8:
+    // Single-byte half-width katakana expands to 3 bytes; UTF-16 expands at most 1.5 times
+    return src_encoding == gcmz_encoding_cp932 ? 3 : 2;
+  }
+  return 4;
+}
+
+bool gcmz_encoding_convert(char const *const src,
+                           size_t const src_len,
+                           enum gcmz_encoding const src_encoding,
+                           enum gcmz_encoding const dest_encoding,
+                           char **const dest,
+                           size_t *const dest_len,
+                           struct ov_error *const err) {
+  if (!src || !dest || !dest_len) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  size_t const expansion = src_encoding == dest_encoding ? 1 : max_expansion(src_encoding, dest_encoding);
+  if (src_len > (SIZE_MAX - 2) / expansion) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+  if (!OV_ARRAY_GROW(dest, src_len * expansion + 2)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+
+  uint8_t const *const s = (uint8_t const *)src;
+  uint8_t *const out = (uint8_t *)*dest;
+  size_t pos = 0;
+
+  if (src_encoding == dest_encoding) {
+    memcpy(out, s, src_len);
+    pos = src_len;
+  } else {
+    size_t i = 0;
+    size_t const min_char = is_ascii_compatible(src_encoding) ? 1 : 2;
+    while (i + min_char <= src_len) {
+      size_t written = 0;
+      i += copy_ascii_run(src_encoding, dest_encoding, s + i, src_len - i, out + pos, &written);
+      pos += written;
+      if (i + min_char > src_len) {
+        break;
+      }
+      uint32_t cp = 0;
+      i += decode_char(src_encoding, s + i, src_len - i, &cp);
+      pos += encode_char(dest_encoding, cp, out + pos);
+    }
+  }
+
+  out[pos] = 0;
+  out[pos + 1] = 0;
+  *dest_len = pos;
+  return true;
+}
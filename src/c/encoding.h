@@ -0,0 +1,57 @@
+#pragma once
+
+#include <ovbase.h>
+
+/**
+ * @brief Encodings supported by the built-in transcoder
+ */
+enum gcmz_encoding {
+  gcmz_encoding_cp932,   ///< Shift_JIS (Windows-31J / CP932)
+  gcmz_encoding_utf8,    ///< UTF-8
+  gcmz_encoding_utf16le, ///< UTF-16 little-endian
+  gcmz_encoding_utf16be, ///< UTF-16 big-endian
+};
+
+/**
+ * @brief Count leading ASCII bytes
+ *
+ * Scans the buffer a machine word at a time and returns the length of the leading run of
+ * bytes below 0x80.
+ *
+ * @param src Source buffer
+ * @param src_len Length of source buffer in bytes
+ * @return Number of leading ASCII bytes
+ */
+size_t gcmz_encoding_ascii_prefix(char const *const src, size_t const src_len);
+
+/**
+ * @brief Convert text between encodings without an intermediate UTF-16 buffer
+ *
+ * Each character is decoded from the source and immediately encoded to the destination.
+ * ASCII runs between ASCII-compatible encodings are copied as a block.
+ *
+ * Invalid or unmapped input follows the behavior of the Windows conversion APIs:
+ * - CP932 sequences that cannot be decoded become U+30FB
+ * - Invalid UTF-8 sequences and unpaired surrogates become U+FFFD
+ * - Characters without a CP932 code get the best-fit substitute of WideCharToMultiByte, or '?' if there is none
+ * - A trailing odd byte in UTF-16 input is ignored
+ *
+ * The result is always followed by a NUL terminator (two bytes for UTF-16) that is not
+ * included in dest_len.
+ *
+ * @param src Source text
+ * @param src_len Length of source text in bytes
+ * @param src_encoding Source encoding
+ * @param dest_encoding Destination encoding
+ * @param dest [in/out] Destination buffer (OV_ARRAY, can be reused)
+ * @param dest_len [out] Length of converted text in bytes
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+NODISCARD bool gcmz_encoding_convert(char const *const src,
+                                     size_t const src_len,
+                                     enum gcmz_encoding const src_encoding,
+                                     enum gcmz_encoding const dest_encoding,
+                                     char **const dest,
+                                     size_t *const dest_len,
+                                     struct ov_error *const err);
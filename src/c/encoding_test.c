@@ -0,0 +1,145 @@
+#include <ovtest.h>
+
+#include "encoding.h"
+
+#include <ovarray.h>
+
+#include <string.h>
+
+// Test helper to convert and compare with expected bytes
+static void check_convert(char const *src,
+                          size_t src_len,
+                          enum gcmz_encoding src_encoding,
+                          enum gcmz_encoding dest_encoding,
+                          char const *expected,
+                          size_t expected_len) {
+  char *dest = NULL;
+  size_t dest_len = 0;
+  struct ov_error err = {0};
+  if (TEST_SUCCEEDED(gcmz_encoding_convert(src, src_len, src_encoding, dest_encoding, &dest, &dest_len, &err), &err)) {
+    TEST_CHECK(dest_len == expected_len);
+    TEST_MSG("want %zu bytes, got %zu bytes", expected_len, dest_len);
+    TEST_CHECK(memcmp(dest, expected, dest_len < expected_len ? dest_len : expected_len) == 0);
+  }
+  if (dest) {
+    OV_ARRAY_DESTROY(&dest);
+  }
+}
+
+#define CHECK_CONVERT(src, src_enc, dest_enc, expected)                                                                \
+  check_convert((src), sizeof(src) - 1, (src_enc), (dest_enc), (expected), sizeof(expected) - 1)
+
+static void test_ascii_prefix(void) {
+  static char const text[] = "0123456789abcdefghij\x82\xa0xyz";
+  TEST_CHECK(gcmz_encoding_ascii_prefix(text, sizeof(text) - 1) == 20);
+  TEST_CHECK(gcmz_encoding_ascii_prefix(text, 5) == 5);
+  TEST_CHECK(gcmz_encoding_ascii_prefix(text + 20, sizeof(text) - 21) == 0);
+  TEST_CHECK(gcmz_encoding_ascii_prefix(text, 0) == 0);
+}
+
+static void test_cp932_to_utf8(void) {
+  // "テスト" / long ASCII run followed by multibyte text
+  CHECK_CONVERT("\x83\x65\x83\x58\x83\x67", gcmz_encoding_cp932, gcmz_encoding_utf8, "テスト");
+  CHECK_CONVERT("exedit object: \x83\x65\x83\x58\x83\x67 end",
+                gcmz_encoding_cp932,
+                gcmz_encoding_utf8,
+                "exedit object: テスト end");
+  // Half-width katakana "ｱ"
+  CHECK_CONVERT("\xb1", gcmz_encoding_cp932, gcmz_encoding_utf8, "ｱ");
+  // NEC special character "①" and IBM extension "髙"
+  CHECK_CONVERT("\x87\x40\xfb\xfc", gcmz_encoding_cp932, gcmz_encoding_utf8, "①髙");
+  // Truncated lead byte and invalid trail byte become U+30FB
+  CHECK_CONVERT("a\x83", gcmz_encoding_cp932, gcmz_encoding_utf8, "a・");
+  CHECK_CONVERT("\x83\x20" "b", gcmz_encoding_cp932, gcmz_encoding_utf8, "・ b");
+}
+
+static void test_utf8_to_cp932(void) {
+  CHECK_CONVERT("テスト", gcmz_encoding_utf8, gcmz_encoding_cp932, "\x83\x65\x83\x58\x83\x67");
+  CHECK_CONVERT("ｱ", gcmz_encoding_utf8, gcmz_encoding_cp932, "\xb1");
+  // Characters with several codes use the same code as WideCharToMultiByte
+  CHECK_CONVERT("≒￢纊", gcmz_encoding_utf8, gcmz_encoding_cp932, "\x81\xe0\x81\xca\xfa\x5c");
+  // Characters without a code of their own get the same best-fit substitutes as WideCharToMultiByte
+  CHECK_CONVERT("〜‖−¢£¬",
+                gcmz_encoding_utf8,
+                gcmz_encoding_cp932,
+                "\x81\x60\x81\x61\x81\x7c\x81\x91\x81\x92\x81\xca");
+  CHECK_CONVERT("café", gcmz_encoding_utf8, gcmz_encoding_cp932, "cafe");
+  // Unmappable characters become '?'
+  CHECK_CONVERT("a😀b", gcmz_encoding_utf8, gcmz_encoding_cp932, "a?b");
+}
+
+static void test_utf16(void) {
+  CHECK_CONVERT("Aテ", gcmz_encoding_utf8, gcmz_encoding_utf16le, "A\0\xc6\x30");
+  CHECK_CONVERT("Aテ", gcmz_encoding_utf8, gcmz_encoding_utf16be, "\0A\x30\xc6");
+  CHECK_CONVERT("A\0\xc6\x30", gcmz_encoding_utf16le, gcmz_encoding_utf8, "Aテ");
+  CHECK_CONVERT("\0A\x30\xc6", gcmz_encoding_utf16be, gcmz_encoding_utf8, "Aテ");
+  CHECK_CONVERT("A\0\xc6\x30", gcmz_encoding_utf16le, gcmz_encoding_utf16be, "\0A\x30\xc6");
+  CHECK_CONVERT("A\0\xc6\x30", gcmz_encoding_utf16le, gcmz_encoding_cp932, "A\x83\x65");
+  CHECK_CONVERT("A\x83\x65", gcmz_encoding_cp932, gcmz_encoding_utf16le, "A\0\xc6\x30");
+  // Surrogate pair
+  CHECK_CONVERT("😀", gcmz_encoding_utf8, gcmz_encoding_utf16le, "\x3d\xd8\x00\xde");
+  CHECK_CONVERT("\x3d\xd8\x00\xde", gcmz_encoding_utf16le, gcmz_encoding_utf8, "😀");
+  // Unpaired surrogate and trailing odd byte
+  CHECK_CONVERT("\x3d\xd8" "a\0" "x", gcmz_encoding_utf16le, gcmz_encoding_utf8, "\xef\xbf\xbd" "a");
+}
+
+static void test_invalid_utf8(void) {
+  CHECK_CONVERT("a\xff" "b", gcmz_encoding_utf8, gcmz_encoding_utf16le, "a\0\xfd\xff" "b\0");
+  // Overlong encoding
+  CHECK_CONVERT("\xc0\xaf", gcmz_encoding_utf8, gcmz_encoding_utf16le, "\xfd\xff\xfd\xff");
+}
+
+static void test_round_trip(void) {
+  static char const text[] = "GCMZDrops ごちゃまぜドロップス ｶﾀｶﾅ ①②③ 髙﨑";
+  char *cp932 = NULL;
+  char *utf8 = NULL;
+  size_t cp932_len = 0;
+  size_t utf8_len = 0;
+  struct ov_error err = {0};
+  if (!TEST_SUCCEEDED(gcmz_encoding_convert(
+                          text, sizeof(text) - 1, gcmz_encoding_utf8, gcmz_encoding_cp932, &cp932, &cp932_len, &err),
+                      &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(
+          gcmz_encoding_convert(cp932, cp932_len, gcmz_encoding_cp932, gcmz_encoding_utf8, &utf8, &utf8_len, &err),
+          &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(utf8_len == sizeof(text) - 1);
+  TEST_CHECK(memcmp(utf8, text, sizeof(text) - 1) == 0);
+  TEST_CHECK(utf8[utf8_len] == '\0');
+
+cleanup:
+  if (utf8) {
+    OV_ARRAY_DESTROY(&utf8);
+  }
+  if (cp932) {
+    OV_ARRAY_DESTROY(&cp932);
+  }
+}
+
+static void test_invalid_arguments(void) {
+  char *dest = NULL;
+  size_t dest_len = 0;
+  struct ov_error err = {0};
+  TEST_FAILED_WITH(gcmz_encoding_convert(NULL, 1, gcmz_encoding_utf8, gcmz_encoding_cp932, &dest, &dest_len, &err),
+                   &err,
+                   ov_error_type_generic,
+                   ov_error_generic_invalid_argument);
+  TEST_FAILED_WITH(gcmz_encoding_convert("a", 1, gcmz_encoding_utf8, gcmz_encoding_cp932, NULL, &dest_len, &err),
+                   &err,
+                   ov_error_type_generic,
+                   ov_error_generic_invalid_argument);
+}
+
+TEST_LIST = {
+    {"ascii_prefix", test_ascii_prefix},
+    {"cp932_to_utf8", test_cp932_to_utf8},
+    {"utf8_to_cp932", test_utf8_to_cp932},
+    {"utf16", test_utf16},
+    {"invalid_utf8", test_invalid_utf8},
+    {"round_trip", test_round_trip},
+    {"invalid_arguments", test_invalid_arguments},
+    {NULL, NULL},
+};
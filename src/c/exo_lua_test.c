@@ -316,10 +316,15 @@ static void test_exo_convert(void) {
   static struct {
     wchar_t const *src;
     wchar_t const *dest;
+    int layer_min;
+    int layer_max;
+    int frame_start;
+    int frame_end;
+    int object_count;
   } const test_cases[] = {
-      {TEST_PATH(L"1-src.exo"), TEST_PATH(L"1-dest.object")},
-      {TEST_PATH(L"2-src.exo"), TEST_PATH(L"2-dest.object")},
-      {TEST_PATH(L"newline-src.exo"), TEST_PATH(L"newline-dest.object")},
+      {TEST_PATH(L"1-src.exo"), TEST_PATH(L"1-dest.object"), 3, 5, 3, 497, 3},
+      {TEST_PATH(L"2-src.exo"), TEST_PATH(L"2-dest.object"), 3, 5, 3, 497, 3},
+      {TEST_PATH(L"newline-src.exo"), TEST_PATH(L"newline-dest.object"), 0, 0, 0, 99, 1},
   };
 
   for (size_t i = 0; i < sizeof(test_cases) / sizeof(test_cases[0]); ++i) {
@@ -373,6 +378,28 @@ static void test_exo_convert(void) {
         goto cleanup;
       }
 
+      // Layout of the generated file is reported along with the entry
+      lua_getfield(g_L, -2, "object_info");
+      if (TEST_CHECK(lua_istable(g_L, -1))) {
+        static char const *const keys[] = {"layer_min", "layer_max", "frame_start", "frame_end", "object_count"};
+        int const want[] = {test_cases[i].layer_min,
+                            test_cases[i].layer_max,
+                            test_cases[i].frame_start,
+                            test_cases[i].frame_end,
+                            test_cases[i].object_count};
+        for (size_t k = 0; k < sizeof(keys) / sizeof(keys[0]); ++k) {
+          lua_getfield(g_L, -1, keys[k]);
+          int const got = (int)lua_tointeger(g_L, -1);
+          TEST_CHECK(got == want[k]);
+          TEST_MSG("%s: want %d, got %d", keys[k], want[k], got);
+          lua_pop(g_L, 1);
+        }
+        lua_getfield(g_L, -1, "filepath");
+        TEST_CHECK(lua_isstring(g_L, -1) && strcmp(lua_tostring(g_L, -1), converted_path) == 0);
+        lua_pop(g_L, 1);
+      }
+      lua_pop(g_L, 1);
+
       // Read the converted file
       char *converted = NULL;
       size_t converted_len = 0;
@@ -1,12 +1,110 @@
 #include "file.h"
 
 #include <ovarray.h>
+#include <ovutf.h>
+
+#include <string.h>
 #include <wchar.h>
 
 struct gcmz_file_list {
   struct gcmz_file *files;
 };
 
+static void file_free(struct gcmz_file *const file) {
+  if (file->path) {
+    OV_ARRAY_DESTROY(&file->path);
+  }
+  if (file->mime_type) {
+    OV_ARRAY_DESTROY(&file->mime_type);
+  }
+  if (file->path_utf8) {
+    OV_ARRAY_DESTROY(&file->path_utf8);
+  }
+  if (file->mime_type_utf8) {
+    OV_ARRAY_DESTROY(&file->mime_type_utf8);
+  }
+}
+
+static NODISCARD bool copy_wstr(wchar_t const *const src, wchar_t **const dest, struct ov_error *const err) {
+  size_t const len = wcslen(src);
+  if (!OV_ARRAY_GROW(dest, len + 1)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+  memcpy(*dest, src, (len + 1) * sizeof(wchar_t));
+  return true;
+}
+
+static NODISCARD bool copy_str(char const *const src, char **const dest, struct ov_error *const err) {
+  size_t const len = strlen(src);
+  if (!OV_ARRAY_GROW(dest, len + 1)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+  memcpy(*dest, src, len + 1);
+  return true;
+}
+
+static NODISCARD bool utf8_to_wstr(char const *const src, wchar_t **const dest, struct ov_error *const err) {
+  size_t const src_len = strlen(src);
+  size_t const dest_len = ov_utf8_to_wchar_len(src, src_len);
+  if (dest_len == 0) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    return false;
+  }
+  if (!OV_ARRAY_GROW(dest, dest_len + 1)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+  if (ov_utf8_to_wchar(src, src_len, *dest, dest_len + 1, NULL) == 0) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    return false;
+  }
+  return true;
+}
+
+static NODISCARD bool wstr_to_utf8(wchar_t const *const src, char **const dest, struct ov_error *const err) {
+  size_t const src_len = wcslen(src);
+  if (src_len == 0) {
+    if (!OV_ARRAY_GROW(dest, 1)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      return false;
+    }
+    (*dest)[0] = '\0';
+    return true;
+  }
+  size_t const dest_len = ov_wchar_to_utf8_len(src, src_len);
+  if (dest_len == 0) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    return false;
+  }
+  if (!OV_ARRAY_GROW(dest, dest_len + 1)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+  if (ov_wchar_to_utf8(src, src_len, *dest, dest_len + 1, NULL) == 0) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Append a fully built entry to the list, taking ownership of its strings
+ */
+static NODISCARD bool
+append_file(struct gcmz_file_list *const list, struct gcmz_file *const file, struct ov_error *const err) {
+  size_t const index = OV_ARRAY_LENGTH(list->files);
+  if (!OV_ARRAY_GROW(&list->files, index + 1)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+  OV_ARRAY_SET_LENGTH(list->files, index + 1);
+  list->files[index] = *file;
+  *file = (struct gcmz_file){0};
+  return true;
+}
+
 struct gcmz_file_list *gcmz_file_list_create(struct ov_error *const err) {
   struct gcmz_file_list *new_list = NULL;
   struct gcmz_file_list *result = NULL;
@@ -38,12 +136,7 @@ void gcmz_file_list_destroy(struct gcmz_file_list **const list) {
   if (l->files) {
     size_t const count = OV_ARRAY_LENGTH(l->files);
     for (size_t i = 0; i < count; i++) {
-      if (l->files[i].path) {
-        OV_ARRAY_DESTROY(&l->files[i].path);
-      }
-      if (l->files[i].mime_type) {
-        OV_ARRAY_DESTROY(&l->files[i].mime_type);
-      }
+      file_free(&l->files[i]);
     }
     OV_ARRAY_DESTROY(&l->files);
   }
@@ -67,42 +160,24 @@ static NODISCARD bool file_list_add(struct gcmz_file_list *const list,
   bool result = false;
 
   {
-    size_t const path_len = wcslen(path);
-    if (!OV_ARRAY_GROW(&file.path, path_len + 1)) {
-      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    if (!copy_wstr(path, &file.path, err)) {
+      OV_ERROR_ADD_TRACE(err);
       goto cleanup;
     }
-    wcscpy(file.path, path);
-
-    if (mime_type) {
-      size_t const mime_len = wcslen(mime_type);
-      if (!OV_ARRAY_GROW(&file.mime_type, mime_len + 1)) {
-        OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
-        goto cleanup;
-      }
-      wcscpy(file.mime_type, mime_type);
+    if (mime_type && !copy_wstr(mime_type, &file.mime_type, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
     }
-
-    size_t const index = OV_ARRAY_LENGTH(list->files);
-    if (!OV_ARRAY_GROW(&list->files, index + 1)) {
-      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    if (!append_file(list, &file, err)) {
+      OV_ERROR_ADD_TRACE(err);
       goto cleanup;
     }
-    OV_ARRAY_SET_LENGTH(list->files, index + 1);
-
-    list->files[index] = file;
-    file = (struct gcmz_file){0};
   }
 
   result = true;
 
 cleanup:
-  if (file.path) {
-    OV_ARRAY_DESTROY(&file.path);
-  }
-  if (file.mime_type) {
-    OV_ARRAY_DESTROY(&file.mime_type);
-  }
+  file_free(&file);
   return result;
 }
 
@@ -120,6 +195,90 @@ NODISCARD bool gcmz_file_list_add_temporary(struct gcmz_file_list *const list,
   return file_list_add(list, path, mime_type, true, err);
 }
 
+NODISCARD bool gcmz_file_list_add_utf8(struct gcmz_file_list *const list,
+                                       char const *const path,
+                                       char const *const mime_type,
+                                       bool const temporary,
+                                       struct ov_error *const err) {
+  if (!list || !path || path[0] == '\0') {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  struct gcmz_file file = {
+      .temporary = temporary,
+  };
+  bool result = false;
+
+  {
+    // Keep the UTF-8 strings so that they can be handed out again without converting back
+    if (!copy_str(path, &file.path_utf8, err) || !utf8_to_wstr(path, &file.path, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    if (mime_type && mime_type[0] != '\0') {
+      if (!copy_str(mime_type, &file.mime_type_utf8, err) || !utf8_to_wstr(mime_type, &file.mime_type, err)) {
+        OV_ERROR_ADD_TRACE(err);
+        goto cleanup;
+      }
+    }
+    if (!append_file(list, &file, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+  }
+
+  result = true;
+
+cleanup:
+  file_free(&file);
+  return result;
+}
+
+NODISCARD bool
+gcmz_file_list_add_copy(struct gcmz_file_list *const list, struct gcmz_file const *const src, struct ov_error *const err) {
+  if (!list || !src || !src->path) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  struct gcmz_file file = {
+      .temporary = src->temporary,
+      .has_object_info = src->has_object_info,
+      .object_info = src->object_info,
+  };
+  bool result = false;
+
+  {
+    if (!copy_wstr(src->path, &file.path, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    if (src->mime_type && !copy_wstr(src->mime_type, &file.mime_type, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    if (src->path_utf8 && !copy_str(src->path_utf8, &file.path_utf8, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    if (src->mime_type_utf8 && !copy_str(src->mime_type_utf8, &file.mime_type_utf8, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    if (!append_file(list, &file, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+  }
+
+  result = true;
+
+cleanup:
+  file_free(&file);
+  return result;
+}
+
 NODISCARD bool
 gcmz_file_list_remove(struct gcmz_file_list *const list, size_t const index, struct ov_error *const err) {
   if (!list) {
@@ -138,12 +297,7 @@ gcmz_file_list_remove(struct gcmz_file_list *const list, size_t const index, str
     return false;
   }
 
-  if (list->files[index].path) {
-    OV_ARRAY_DESTROY(&list->files[index].path);
-  }
-  if (list->files[index].mime_type) {
-    OV_ARRAY_DESTROY(&list->files[index].mime_type);
-  }
+  file_free(&list->files[index]);
 
   for (size_t j = index; j < count - 1; j++) {
     list->files[j] = list->files[j + 1];
@@ -181,12 +335,146 @@ void gcmz_file_list_clear(struct gcmz_file_list *const list) {
 
   size_t const count = OV_ARRAY_LENGTH(list->files);
   for (size_t i = 0; i < count; i++) {
-    if (list->files[i].path) {
-      OV_ARRAY_DESTROY(&list->files[i].path);
+    file_free(&list->files[i]);
+  }
+  OV_ARRAY_SET_LENGTH(list->files, 0);
+}
+
+void gcmz_file_list_swap(struct gcmz_file_list *const a, struct gcmz_file_list *const b) {
+  if (!a || !b) {
+    return;
+  }
+  struct gcmz_file *const files = a->files;
+  a->files = b->files;
+  b->files = files;
+}
+
+bool gcmz_file_get_path_utf8(struct gcmz_file *const file, char const **const path_utf8, struct ov_error *const err) {
+  if (!file || !file->path || !path_utf8) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+  if (!file->path_utf8 && !wstr_to_utf8(file->path, &file->path_utf8, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    if (file->path_utf8) {
+      OV_ARRAY_DESTROY(&file->path_utf8);
     }
-    if (list->files[i].mime_type) {
-      OV_ARRAY_DESTROY(&list->files[i].mime_type);
+    return false;
+  }
+  *path_utf8 = file->path_utf8;
+  return true;
+}
+
+bool gcmz_file_get_mime_type_utf8(struct gcmz_file *const file,
+                                  char const **const mime_type_utf8,
+                                  struct ov_error *const err) {
+  if (!file || !mime_type_utf8) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+  if (!file->mime_type) {
+    *mime_type_utf8 = NULL;
+    return true;
+  }
+  if (!file->mime_type_utf8 && !wstr_to_utf8(file->mime_type, &file->mime_type_utf8, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    if (file->mime_type_utf8) {
+      OV_ARRAY_DESTROY(&file->mime_type_utf8);
     }
+    return false;
   }
-  OV_ARRAY_SET_LENGTH(list->files, 0);
+  *mime_type_utf8 = file->mime_type_utf8;
+  return true;
+}
+
+void gcmz_file_set_path(struct gcmz_file *const file, wchar_t **const path) {
+  if (!file || !path) {
+    return;
+  }
+  if (file->path) {
+    OV_ARRAY_DESTROY(&file->path);
+  }
+  if (file->path_utf8) {
+    OV_ARRAY_DESTROY(&file->path_utf8);
+  }
+  file->path = *path;
+  *path = NULL;
+  // The layout belongs to the file that was replaced
+  file->has_object_info = false;
+  file->object_info = (struct gcmz_object_info){0};
+}
+
+NODISCARD bool
+gcmz_file_set_path_utf8(struct gcmz_file *const file, char const *const path, struct ov_error *const err) {
+  if (!file || !path || path[0] == '\0') {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  wchar_t *new_path = NULL;
+  char *new_path_utf8 = NULL;
+  bool result = false;
+
+  {
+    if (!copy_str(path, &new_path_utf8, err) || !utf8_to_wstr(path, &new_path, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    gcmz_file_set_path(file, &new_path);
+    file->path_utf8 = new_path_utf8;
+    new_path_utf8 = NULL;
+  }
+
+  result = true;
+
+cleanup:
+  if (new_path) {
+    OV_ARRAY_DESTROY(&new_path);
+  }
+  if (new_path_utf8) {
+    OV_ARRAY_DESTROY(&new_path_utf8);
+  }
+  return result;
+}
+
+NODISCARD bool
+gcmz_file_set_mime_type_utf8(struct gcmz_file *const file, char const *const mime_type, struct ov_error *const err) {
+  if (!file) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  wchar_t *new_mime_type = NULL;
+  char *new_mime_type_utf8 = NULL;
+  bool result = false;
+
+  {
+    if (mime_type && mime_type[0] != '\0') {
+      if (!copy_str(mime_type, &new_mime_type_utf8, err) || !utf8_to_wstr(mime_type, &new_mime_type, err)) {
+        OV_ERROR_ADD_TRACE(err);
+        goto cleanup;
+      }
+    }
+    if (file->mime_type) {
+      OV_ARRAY_DESTROY(&file->mime_type);
+    }
+    if (file->mime_type_utf8) {
+      OV_ARRAY_DESTROY(&file->mime_type_utf8);
+    }
+    file->mime_type = new_mime_type;
+    file->mime_type_utf8 = new_mime_type_utf8;
+    new_mime_type = NULL;
+    new_mime_type_utf8 = NULL;
+  }
+
+  result = true;
+
+cleanup:
+  if (new_mime_type) {
+    OV_ARRAY_DESTROY(&new_mime_type);
+  }
+  if (new_mime_type_utf8) {
+    OV_ARRAY_DESTROY(&new_mime_type_utf8);
+  }
+  return result;
 }
@@ -2,10 +2,12 @@
 
 #include <ovbase.h>
 
+#include "object_info.h"
+
 /**
  * @brief File entry structure for GCMZDrops file management
  *
- * Represents a single file entry with path, MIME type, and temporary flag.
+ * Represents a single file entry with path, MIME type, temporary flag and optional .object layout.
  * Used within gcmz_file_list to manage collections of files.
  *
  * @note This structure only manages file metadata. The actual files on disk
@@ -16,6 +18,12 @@ struct gcmz_file {
   wchar_t *path;      ///< Wide character file path (null-terminated), owned by this structure
   wchar_t *mime_type; ///< Wide character MIME type string (null-terminated), owned by this structure, can be NULL
   bool temporary;     ///< Metadata flag indicating this file is temporary. Does NOT trigger automatic file deletion.
+
+  bool has_object_info;                ///< true if object_info was reported by the producer of the file
+  struct gcmz_object_info object_info; ///< Layout of an .object file, valid only when has_object_info is true
+
+  char *path_utf8;      ///< UTF-8 form of path, owned by this structure, NULL until requested or supplied
+  char *mime_type_utf8; ///< UTF-8 form of mime_type, owned by this structure, NULL until requested or supplied
 };
 
 /**
@@ -88,6 +96,39 @@ NODISCARD bool gcmz_file_list_add_temporary(struct gcmz_file_list *const list,
                                             wchar_t const *const mime_type,
                                             struct ov_error *const err);
 
+/**
+ * @brief Add a file from UTF-8 strings to the file list
+ *
+ * Works like gcmz_file_list_add() and gcmz_file_list_add_temporary(), but takes UTF-8 strings.
+ * The UTF-8 strings are kept with the entry, so gcmz_file_get_path_utf8() and
+ * gcmz_file_get_mime_type_utf8() return them without converting back.
+ *
+ * @param list Pointer to file list. Must not be NULL.
+ * @param path UTF-8 file path string. Must not be NULL or empty and must be null-terminated.
+ * @param mime_type UTF-8 MIME type string. Can be NULL. If provided, must be null-terminated.
+ * @param temporary Whether the file is temporary
+ * @param err Pointer to error structure for error information. Can be NULL.
+ * @return true on success, false on failure (check err for details)
+ */
+NODISCARD bool gcmz_file_list_add_utf8(struct gcmz_file_list *const list,
+                                       char const *const path,
+                                       char const *const mime_type,
+                                       bool const temporary,
+                                       struct ov_error *const err);
+
+/**
+ * @brief Add a copy of a file entry to the file list
+ *
+ * Copies every field of the entry, including the object layout and the cached UTF-8 strings.
+ *
+ * @param list Pointer to file list. Must not be NULL.
+ * @param src File entry to copy. Must not be NULL.
+ * @param err Pointer to error structure for error information. Can be NULL.
+ * @return true on success, false on failure (check err for details, typically out of memory)
+ */
+NODISCARD bool
+gcmz_file_list_add_copy(struct gcmz_file_list *const list, struct gcmz_file const *const src, struct ov_error *const err);
+
 /**
  * @brief Remove file entry from the list by index
  *
@@ -137,7 +178,8 @@ struct gcmz_file const *gcmz_file_list_get(struct gcmz_file_list const *const li
  * or the list is destroyed. Use this function when you need to modify file properties.
  *
  * @warning Do not directly modify the path or mime_type pointers. Use appropriate
- *          functions to update these fields to prevent memory leaks.
+ *          functions such as gcmz_file_set_path() to update these fields to prevent
+ *          memory leaks and stale UTF-8 strings.
  *
  * @param list Pointer to file list. Must not be NULL.
  * @param index Zero-based index of the file entry to retrieve. Must be less than the list count.
@@ -157,3 +199,80 @@ struct gcmz_file *gcmz_file_list_get_mutable(struct gcmz_file_list *const list,
  * @param list Pointer to file list. Must not be NULL.
  */
 void gcmz_file_list_clear(struct gcmz_file_list *const list);
+
+/**
+ * @brief Exchange the entries of two file lists
+ *
+ * Swaps the contents without copying any entry. Useful for building a new list
+ * and replacing an existing one in place.
+ *
+ * @param a Pointer to first file list. Must not be NULL.
+ * @param b Pointer to second file list. Must not be NULL.
+ */
+void gcmz_file_list_swap(struct gcmz_file_list *const a, struct gcmz_file_list *const b);
+
+/**
+ * @brief Get the UTF-8 form of a file path
+ *
+ * The string is converted on the first call and cached in the entry;
+ * later calls return the cached string without allocating.
+ *
+ * @param file File entry. Must not be NULL.
+ * @param path_utf8 [out] UTF-8 path, valid until the entry is modified or removed
+ * @param err Pointer to error structure for error information. Can be NULL.
+ * @return true on success, false on failure (check err for details)
+ */
+NODISCARD bool
+gcmz_file_get_path_utf8(struct gcmz_file *const file, char const **const path_utf8, struct ov_error *const err);
+
+/**
+ * @brief Get the UTF-8 form of a file MIME type
+ *
+ * Same as gcmz_file_get_path_utf8() for mime_type. Sets NULL when the entry has no MIME type.
+ *
+ * @param file File entry. Must not be NULL.
+ * @param mime_type_utf8 [out] UTF-8 MIME type or NULL, valid until the entry is modified or removed
+ * @param err Pointer to error structure for error information. Can be NULL.
+ * @return true on success, false on failure (check err for details)
+ */
+NODISCARD bool gcmz_file_get_mime_type_utf8(struct gcmz_file *const file,
+                                            char const **const mime_type_utf8,
+                                            struct ov_error *const err);
+
+/**
+ * @brief Replace the path of a file entry
+ *
+ * Takes ownership of the new path, frees the old one and discards the cached UTF-8 path and object_info.
+ * Use this instead of assigning file->path directly.
+ *
+ * @param file File entry. Must not be NULL.
+ * @param path Pointer to the new path allocated with OV_ARRAY_GROW. Set to NULL on return.
+ */
+void gcmz_file_set_path(struct gcmz_file *const file, wchar_t **const path);
+
+/**
+ * @brief Replace the path of a file entry with a UTF-8 string
+ *
+ * Same as gcmz_file_set_path(), but converts the path and keeps the UTF-8 string with the entry.
+ * The entry is left unchanged on failure.
+ *
+ * @param file File entry. Must not be NULL.
+ * @param path UTF-8 file path string. Must not be NULL or empty.
+ * @param err Pointer to error structure for error information. Can be NULL.
+ * @return true on success, false on failure (check err for details)
+ */
+NODISCARD bool
+gcmz_file_set_path_utf8(struct gcmz_file *const file, char const *const path, struct ov_error *const err);
+
+/**
+ * @brief Replace the MIME type of a file entry with a UTF-8 string
+ *
+ * The entry is left unchanged on failure.
+ *
+ * @param file File entry. Must not be NULL.
+ * @param mime_type UTF-8 MIME type string. NULL or an empty string removes the MIME type.
+ * @param err Pointer to error structure for error information. Can be NULL.
+ * @return true on success, false on failure (check err for details)
+ */
+NODISCARD bool
+gcmz_file_set_mime_type_utf8(struct gcmz_file *const file, char const *const mime_type, struct ov_error *const err);
@@ -1,5 +1,9 @@
 #include <ovtest.h>
 
+#include <ovarray.h>
+
+#include <string.h>
+
 #include "file.h"
 
 static void test_file_list_functionality(void) {
@@ -41,4 +45,118 @@ static void test_file_list_functionality(void) {
   gcmz_file_list_destroy(&list);
 }
 
-TEST_LIST = {{"test_file_list_functionality", test_file_list_functionality}, {NULL, NULL}};
+static void test_file_list_utf8(void) {
+  struct gcmz_file_list *list = NULL;
+  struct gcmz_file_list *copy = NULL;
+  wchar_t *new_path = NULL;
+  struct ov_error err = {0};
+
+  list = gcmz_file_list_create(&err);
+  if (!TEST_SUCCEEDED(list != NULL, &err)) {
+    goto cleanup;
+  }
+
+  // UTF-8 input is kept and returned as is
+  if (!TEST_SUCCEEDED(
+          gcmz_file_list_add_utf8(list, "C:\\test\\\xe7\x94\xbb\xe5\x83\x8f.png", "image/png", true, &err), &err)) {
+    goto cleanup;
+  }
+  {
+    struct gcmz_file *const file = gcmz_file_list_get_mutable(list, 0);
+    char const *path = NULL;
+    char const *mime_type = NULL;
+    TEST_CHECK(wcscmp(file->path, L"C:\\test\\\x753b\x50cf.png") == 0);
+    TEST_CHECK(wcscmp(file->mime_type, L"image/png") == 0);
+    TEST_CHECK(file->temporary);
+    if (TEST_SUCCEEDED(gcmz_file_get_path_utf8(file, &path, &err), &err)) {
+      TEST_CHECK(path == file->path_utf8);
+      TEST_CHECK(strcmp(path, "C:\\test\\\xe7\x94\xbb\xe5\x83\x8f.png") == 0);
+    }
+    if (TEST_SUCCEEDED(gcmz_file_get_mime_type_utf8(file, &mime_type, &err), &err)) {
+      TEST_CHECK(strcmp(mime_type, "image/png") == 0);
+    }
+  }
+
+  // Wide input is converted on first request and cached
+  if (!TEST_SUCCEEDED(gcmz_file_list_add(list, L"C:\\test\\file.txt", NULL, &err), &err)) {
+    goto cleanup;
+  }
+  {
+    struct gcmz_file *const file = gcmz_file_list_get_mutable(list, 1);
+    char const *path = NULL;
+    char const *mime_type = "";
+    TEST_CHECK(file->path_utf8 == NULL);
+    if (TEST_SUCCEEDED(gcmz_file_get_path_utf8(file, &path, &err), &err)) {
+      TEST_CHECK(strcmp(path, "C:\\test\\file.txt") == 0);
+      TEST_CHECK(file->path_utf8 == path);
+    }
+    if (TEST_SUCCEEDED(gcmz_file_get_mime_type_utf8(file, &mime_type, &err), &err)) {
+      TEST_CHECK(mime_type == NULL);
+    }
+
+    // Replacing the path discards the cached UTF-8 path and the layout of the old file
+    if (!TEST_CHECK(OV_ARRAY_GROW(&new_path, 32))) {
+      goto cleanup;
+    }
+    wcscpy(new_path, L"C:\\test\\moved.txt");
+    file->has_object_info = true;
+    file->object_info.layer_max = 2;
+    gcmz_file_set_path(file, &new_path);
+    TEST_CHECK(new_path == NULL);
+    TEST_CHECK(file->path_utf8 == NULL);
+    TEST_CHECK(!file->has_object_info);
+    TEST_CHECK(file->object_info.layer_max == 0);
+    if (TEST_SUCCEEDED(gcmz_file_get_path_utf8(file, &path, &err), &err)) {
+      TEST_CHECK(strcmp(path, "C:\\test\\moved.txt") == 0);
+    }
+
+    // UTF-8 setters keep the given strings
+    if (TEST_SUCCEEDED(gcmz_file_set_path_utf8(file, "C:\\test\\\xe7\x94\xbb.txt", &err), &err)) {
+      TEST_CHECK(wcscmp(file->path, L"C:\\test\\\x753b.txt") == 0);
+      TEST_CHECK(strcmp(file->path_utf8, "C:\\test\\\xe7\x94\xbb.txt") == 0);
+    }
+    if (TEST_SUCCEEDED(gcmz_file_set_mime_type_utf8(file, "text/plain", &err), &err)) {
+      TEST_CHECK(wcscmp(file->mime_type, L"text/plain") == 0);
+      TEST_CHECK(strcmp(file->mime_type_utf8, "text/plain") == 0);
+    }
+    if (TEST_SUCCEEDED(gcmz_file_set_mime_type_utf8(file, "", &err), &err)) {
+      TEST_CHECK(file->mime_type == NULL && file->mime_type_utf8 == NULL);
+    }
+    TEST_FAILED_WITH(
+        gcmz_file_set_path_utf8(file, "", &err), &err, ov_error_type_generic, ov_error_generic_invalid_argument);
+    TEST_CHECK(strcmp(file->path_utf8, "C:\\test\\\xe7\x94\xbb.txt") == 0);
+  }
+
+  // Copies carry the cached strings
+  copy = gcmz_file_list_create(&err);
+  if (!TEST_SUCCEEDED(copy != NULL, &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_file_list_add_copy(copy, gcmz_file_list_get(list, 0), &err), &err)) {
+    goto cleanup;
+  }
+  {
+    struct gcmz_file const *const file = gcmz_file_list_get(copy, 0);
+    TEST_CHECK(file->temporary);
+    TEST_CHECK(file->path_utf8 != NULL && file->path_utf8 != gcmz_file_list_get(list, 0)->path_utf8);
+    TEST_CHECK(wcscmp(file->path, gcmz_file_list_get(list, 0)->path) == 0);
+  }
+
+  TEST_FAILED_WITH(gcmz_file_list_add_utf8(list, "", NULL, false, &err),
+                   &err,
+                   ov_error_type_generic,
+                   ov_error_generic_invalid_argument);
+
+cleanup:
+  if (new_path) {
+    OV_ARRAY_DESTROY(&new_path);
+  }
+  gcmz_file_list_destroy(&copy);
+  gcmz_file_list_destroy(&list);
+}
+
+TEST_LIST = {
+    {"test_file_list_functionality", test_file_list_functionality},
+    {"test_file_list_utf8", test_file_list_utf8},
+    {NULL, NULL},
+};
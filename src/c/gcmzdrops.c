@@ -58,11 +58,12 @@
 #include "error.h"
 #include "file.h"
 #include "gcmz_types.h"
-#include "ini_reader.h"
 #include "logf.h"
 #include "lua.h"
 #include "lua_api.h"
+#include "lua_worker.h"
 #include "luautil.h"
+#include "object_info.h"
 #include "temp.h"
 #include "tray.h"
 #include "version.h"
@@ -136,9 +137,11 @@ struct gcmzdrops {
   struct gcmz_api *api;
   struct gcmz_drop *drop;
   struct gcmz_lua_context *lua_ctx;
+  struct gcmz_lua_worker *lua_worker;
   struct gcmz_tray *tray;
   struct gcmz_window_list *window_list;
   struct gcmz_do_sub *do_sub;
+  struct gcmz_object_info_cache *object_info_cache;
 
   struct aviutl2_edit_handle *edit;
   struct aviutl2_edit_section *current_edit_section; ///< Current edit section when in Lua callback (deadlock avoidance)
@@ -150,100 +153,6 @@ struct gcmzdrops {
   cnd_t init_cond;
 };
 
-/**
- * @brief Calculate the number of layers an .object file occupies
- *
- * Parses the .object file and finds the minimum and maximum layer values
- * to determine how many layers the objects span.
- *
- * @param filepath Path to the .object file
- * @param layer_count [out] Number of layers occupied (max_layer - min_layer + 1)
- * @param err [out] Error information on failure
- * @return true on success, false on failure
- */
-static bool get_object_layer_count(wchar_t const *const filepath, int *const layer_count, struct ov_error *const err) {
-  if (!filepath || !layer_count) {
-    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
-    return false;
-  }
-
-  struct gcmz_ini_reader *reader = NULL;
-  bool result = false;
-  int min_layer = INT_MAX;
-  int max_layer = INT_MIN;
-  bool found_layer = false;
-
-  {
-    if (!gcmz_ini_reader_create(&reader, err)) {
-      OV_ERROR_ADD_TRACE(err);
-      goto cleanup;
-    }
-    if (!gcmz_ini_reader_load_file(reader, filepath, err)) {
-      OV_ERROR_ADD_TRACE(err);
-      goto cleanup;
-    }
-
-    // Iterate through all sections to find layer values
-    // Object sections are named [0], [1], etc. with layer=N entries
-    struct gcmz_ini_iter section_iter = {0};
-    while (gcmz_ini_reader_iter_sections(reader, &section_iter)) {
-      // Check if section name is a number (e.g., "0", "1", "2")
-      // Object sections have format [N] where N is the object index
-      bool is_object_section = true;
-      for (size_t i = 0; i < section_iter.name_len; ++i) {
-        if (section_iter.name[i] < '0' || section_iter.name[i] > '9') {
-          is_object_section = false;
-          break;
-        }
-      }
-      if (!is_object_section || section_iter.name_len == 0) {
-        continue;
-      }
-
-      // Create null-terminated section name for lookup
-      char section_name[32];
-      if (section_iter.name_len >= sizeof(section_name)) {
-        continue;
-      }
-      memcpy(section_name, section_iter.name, section_iter.name_len);
-      section_name[section_iter.name_len] = '\0';
-
-      // Get the layer value from this section
-      struct gcmz_ini_value layer_value = gcmz_ini_reader_get_value(reader, section_name, "layer");
-      if (!layer_value.ptr || layer_value.size == 0) {
-        continue;
-      }
-
-      // Parse the layer number (format: "layer=N" where N is 0-based)
-      int layer = 0;
-      for (size_t i = 0; i < layer_value.size && layer_value.ptr[i] >= '0' && layer_value.ptr[i] <= '9'; ++i) {
-        layer = layer * 10 + (layer_value.ptr[i] - '0');
-      }
-
-      found_layer = true;
-      if (layer < min_layer) {
-        min_layer = layer;
-      }
-      if (layer > max_layer) {
-        max_layer = layer;
-      }
-    }
-
-    if (!found_layer) {
-      // No layers found - treat as single layer
-      *layer_count = 1;
-    } else {
-      *layer_count = max_layer - min_layer + 1;
-    }
-  }
-
-  result = true;
-
-cleanup:
-  gcmz_ini_reader_destroy(&reader);
-  return result;
-}
-
 /**
  * @brief Context for external API drop completion callback
  */
@@ -452,12 +361,14 @@ cleanup:
  * - Other files are skipped with a warning
  *
  * @param file_list List of files to insert
+ * @param object_info_cache Cache of .object layout information, can be NULL
  * @param edit Edit section
  * @param start_layer Starting layer (0-based)
  * @param frame Frame position
  * @return Result first object handle on success, NULL on failure
  */
 static aviutl2_object_handle insert_files_to_timeline(struct gcmz_file_list const *const file_list,
+                                                      struct gcmz_object_info_cache *const object_info_cache,
                                                       struct aviutl2_edit_section *const edit,
                                                       int const start_layer,
                                                       int const frame,
@@ -492,9 +403,15 @@ static aviutl2_object_handle insert_files_to_timeline(struct gcmz_file_list cons
       if (!first_obj) {
         first_obj = obj;
       }
-      int layer_count = 1;
-      if (get_object_layer_count(file->path, &layer_count, NULL)) {
-        current_layer += layer_count;
+      // Prefer the layout reported with the file (e.g. by the EXO converter) over reading it again
+      struct gcmz_object_info info = file->object_info;
+      bool got_info = file->has_object_info;
+      if (!got_info) {
+        got_info = object_info_cache ? gcmz_object_info_cache_get(object_info_cache, file->path, &info, NULL)
+                                     : gcmz_object_info_parse_file(file->path, &info, NULL);
+      }
+      if (got_info) {
+        current_layer += info.layer_count;
       } else {
         ++current_layer;
       }
@@ -547,8 +464,12 @@ static void on_clipboard_paste_completion(struct gcmz_file_list const *const fil
     return;
   }
   struct ov_error err = {0};
-  aviutl2_object_handle obj =
-      insert_files_to_timeline(file_list, paste_ctx->edit, paste_ctx->layer, paste_ctx->frame, &err);
+  aviutl2_object_handle obj = insert_files_to_timeline(file_list,
+                                                       paste_ctx->ctx->object_info_cache,
+                                                       paste_ctx->edit,
+                                                       paste_ctx->layer,
+                                                       paste_ctx->frame,
+                                                       &err);
   if (!obj) {
     gcmz_logf_error(NULL, "%1$hs", "%1$hs", gettext("failed to insert files into timeline"));
     OV_ERROR_DESTROY(&err);
@@ -613,7 +534,8 @@ static void on_drop_completion(struct gcmz_file_list const *const file_list, voi
   }
 
   struct ov_error err = {0};
-  aviutl2_object_handle const obj = insert_files_to_timeline(file_list, edit, layer, frame, &err);
+  aviutl2_object_handle const obj =
+      insert_files_to_timeline(file_list, api_ctx->ctx->object_info_cache, edit, layer, frame, &err);
   if (!obj) {
     gcmz_logf_error(NULL, "%1$hs", "%1$hs", gettext("failed to insert files into timeline"));
     return;
@@ -634,6 +556,28 @@ struct request_api_context {
   gcmz_api_request_complete_func complete;
 };
 
+/**
+ * @brief Convert the layer of an external API request to a 0-based layer
+ *
+ * - layer < 0: relative to display_layer_start (e.g., -1 = first visible layer)
+ * - layer = 0: use currently selected layer
+ * - layer > 0: absolute layer number (1-based input)
+ *
+ * @param layer Layer value from the request
+ * @param info Edit information at the time of the request
+ * @return 0-based layer
+ */
+static int resolve_request_layer(int const layer, struct aviutl2_edit_info const *const info) {
+  if (layer < 0) {
+    // Convert negative (relative) layer to absolute 0-based layer
+    return info->display_layer_start + (-layer) - 1;
+  }
+  if (layer == 0) {
+    return info->layer; // info->layer is already 0-based
+  }
+  return layer - 1; // convert to 0-based
+}
+
 /**
  * @brief Edit section callback for request_api
  *
@@ -649,21 +593,8 @@ static void request_api_edit_section(void *param, struct aviutl2_edit_section *e
   struct gcmz_api_request_params *const params = rac->params;
   struct ov_error err = {0};
 
-  int layer = params->layer;
-  int frame = edit->info->frame;
-
-  // Handle layer value:
-  // - layer < 0: relative to display_layer_start (e.g., -1 = first visible layer)
-  // - layer = 0: use currently selected layer
-  // - layer > 0: absolute layer number (1-based input)
-  if (layer < 0) {
-    // Convert negative (relative) layer to absolute 0-based layer
-    layer = edit->info->display_layer_start + (-layer) - 1;
-  } else if (layer == 0) {
-    layer = edit->info->layer; // edit->info->layer is already 0-based
-  } else {
-    layer = layer - 1; // convert to 0-based
-  }
+  int const layer = resolve_request_layer(params->layer, edit->info);
+  int const frame = edit->info->frame;
 
   ctx->current_edit_section = edit;
   bool const r = gcmz_drop_simulate_drop(ctx->drop,
@@ -691,6 +622,296 @@ static void request_api_edit_section(void *param, struct aviutl2_edit_section *e
   }
 }
 
+static bool copy_file(wchar_t const *source_file, wchar_t **final_file, void *userdata, struct ov_error *const err);
+
+/**
+ * @brief External API request whose handlers run on a Lua worker thread
+ *
+ * The edit information, project path and save path settings are captured when the request arrives,
+ * because the worker thread must not touch the edit handle or the configuration owned by the UI thread.
+ */
+struct async_drop_job {
+  struct gcmzdrops *ctx;                   ///< Parent context
+  struct gcmz_api_request_params *params;  ///< Request params, completed when the job is finished
+  gcmz_api_request_complete_func complete; ///< Callback to signal request completion
+  struct gcmz_lua_context *lua_ctx;        ///< Worker's Lua context (valid while handlers run)
+  struct aviutl2_edit_info edit_info;      ///< Edit information when the request arrived
+  wchar_t *project_path;                   ///< Project path when the request arrived (can be NULL)
+  struct gcmz_config *config;              ///< Save path settings when the request arrived
+  int layer;                               ///< Target layer (0-based)
+  int frame;                               ///< Target frame position
+  bool captured;                           ///< Whether the edit section callback has run
+};
+
+static void async_drop_job_destroy(struct async_drop_job **const job) {
+  if (!job || !*job) {
+    return;
+  }
+  if ((*job)->config) {
+    gcmz_config_destroy(&(*job)->config);
+  }
+  if ((*job)->project_path) {
+    OV_ARRAY_DESTROY(&(*job)->project_path);
+  }
+  OV_FREE(job);
+}
+
+static NATIVE_CHAR *async_drop_get_project_path(void *userdata) {
+  struct async_drop_job const *const job = (struct async_drop_job const *)userdata;
+  if (!job || !job->project_path) {
+    return NULL;
+  }
+  size_t const len = wcslen(job->project_path);
+  NATIVE_CHAR *result = NULL;
+  if (!OV_ARRAY_GROW(&result, len + 1)) {
+    return NULL;
+  }
+  wcscpy(result, job->project_path);
+  return result;
+}
+
+/**
+ * @brief Copy the save path settings so that gcmz.get_save_path can be used from the worker thread
+ *
+ * Must be called on the UI thread after the project path has been captured.
+ */
+static bool async_drop_snapshot_config(struct async_drop_job *const job, struct ov_error *const err) {
+  struct gcmz_config *config = NULL;
+  bool allow_create_directories = false;
+  bool success = false;
+
+  config = gcmz_config_create(
+      &(struct gcmz_config_options){
+          .project_path_provider = async_drop_get_project_path,
+          .userdata = job,
+      },
+      err);
+  if (!config) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+  {
+    wchar_t const *const *const save_paths = gcmz_config_get_save_paths(job->ctx->config);
+    if (!gcmz_config_set_save_paths(config, save_paths, OV_ARRAY_LENGTH(save_paths), err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+  }
+  if (!gcmz_config_get_allow_create_directories(job->ctx->config, &allow_create_directories, err) ||
+      !gcmz_config_set_allow_create_directories(config, allow_create_directories, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+  job->config = config;
+  config = NULL;
+  success = true;
+
+cleanup:
+  if (config) {
+    gcmz_config_destroy(&config);
+  }
+  return success;
+}
+
+static void async_drop_capture_edit_section(void *param, struct aviutl2_edit_section *edit) {
+  struct async_drop_job *const job = (struct async_drop_job *)param;
+  if (!job || !edit) {
+    return;
+  }
+  wchar_t const *const project_path = job->ctx->project_path;
+  if (project_path && project_path[0] != L'\0') {
+    size_t const len = wcslen(project_path);
+    if (!OV_ARRAY_GROW(&job->project_path, len + 1)) {
+      return;
+    }
+    memcpy(job->project_path, project_path, (len + 1) * sizeof(wchar_t));
+  }
+  job->edit_info = *edit->info;
+  job->layer = resolve_request_layer(job->params->layer, edit->info);
+  job->frame = edit->info->frame;
+  job->captured = true;
+}
+
+static bool async_exo_convert_adapter(struct gcmz_file_list *file_list, void *userdata, struct ov_error *const err) {
+  struct async_drop_job *const job = (struct async_drop_job *)userdata;
+  return gcmz_lua_call_exo_convert(job->lua_ctx, file_list, err);
+}
+
+static bool async_drag_enter_adapter(struct gcmz_file_list *file_list,
+                                     uint32_t key_state,
+                                     uint32_t modifier_keys,
+                                     bool from_api,
+                                     void *userdata,
+                                     struct ov_error *const err) {
+  struct async_drop_job *const job = (struct async_drop_job *)userdata;
+  return gcmz_lua_call_drag_enter(job->lua_ctx, file_list, key_state, modifier_keys, from_api, err);
+}
+
+static bool async_drop_adapter(struct gcmz_file_list *file_list,
+                               uint32_t key_state,
+                               uint32_t modifier_keys,
+                               bool from_api,
+                               void *userdata,
+                               struct ov_error *const err) {
+  struct async_drop_job *const job = (struct async_drop_job *)userdata;
+  return gcmz_lua_call_drop(job->lua_ctx, file_list, key_state, modifier_keys, from_api, err);
+}
+
+static bool async_cleanup_adapter(wchar_t const *const path, void *userdata, struct ov_error *const err) {
+  (void)userdata;
+  if (!gcmz_delayed_cleanup_schedule_file(path, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  return true;
+}
+
+static void async_drop_insert_edit_section(void *param, struct aviutl2_edit_section *edit) {
+  struct async_drop_job *const job = (struct async_drop_job *)param;
+  if (!job || !edit) {
+    return;
+  }
+  on_drop_completion(job->params->files,
+                     &(struct external_api_drop_context){
+                         .ctx = job->ctx,
+                         .edit = edit,
+                         .layer = job->layer,
+                         .frame = job->frame,
+                         .frame_advance = job->params->frame_advance,
+                         .margin = job->params->margin,
+                         .request_complete = job->complete,
+                         .request_params = job->params,
+                     });
+}
+
+/**
+ * @brief Copy and insert the files processed on the worker thread
+ *
+ * Runs on the UI thread via gcmz_do, so only the timeline insertion holds the edit section.
+ * File management runs here rather than on the worker because the save path depends on
+ * the configuration and the project path, which are owned by the UI thread.
+ */
+static void async_drop_insert(void *userdata) {
+  struct async_drop_job *job = (struct async_drop_job *)userdata;
+  struct gcmzdrops *const ctx = job->ctx;
+  gcmz_drop_manage_files(
+      &(struct gcmz_drop_options){
+          .cleanup = async_cleanup_adapter,
+          .file_manage = copy_file,
+          .userdata = ctx,
+      },
+      job->params->files);
+  if (ctx->edit && ctx->edit->call_edit_section_param) {
+    ctx->edit->call_edit_section_param(job, async_drop_insert_edit_section);
+  }
+  job->complete(job->params);
+  async_drop_job_destroy(&job);
+}
+
+/**
+ * @brief Run exo_convert, drag_enter and drop handlers on a Lua worker thread
+ */
+static void async_drop_run(struct gcmz_lua_context *const lua_ctx, void *const userdata) {
+  struct async_drop_job *job = (struct async_drop_job *)userdata;
+  struct gcmzdrops *const ctx = job->ctx;
+  struct ov_error err = {0};
+  bool r = false;
+
+  if (!lua_ctx) {
+    gcmz_logf_warn(NULL,
+                   "%1$hs",
+                   "%1$hs",
+                   gettext("external API request was discarded because the background Lua state is not available"));
+    goto cleanup;
+  }
+
+  job->lua_ctx = lua_ctx;
+  r = gcmz_drop_process_files(
+      &(struct gcmz_drop_options){
+          .cleanup = async_cleanup_adapter,
+          .exo_convert = async_exo_convert_adapter,
+          .drag_enter = async_drag_enter_adapter,
+          .drop = async_drop_adapter,
+          .userdata = job,
+      },
+      job->params->files,
+      job->params->use_exo_converter,
+      &err);
+  job->lua_ctx = NULL;
+  if (!r) {
+    OV_ERROR_SET(&err, ov_error_type_generic, ov_error_generic_fail, "simulated drop failed");
+    gcmz_logf_error(&err, "%1$hs", "%1$hs", gettext("failed to drop from external API request"));
+    OV_ERROR_DESTROY(&err);
+    goto cleanup;
+  }
+
+  gcmz_do(async_drop_insert, job);
+  return;
+
+cleanup:
+  job->complete(job->params);
+  async_drop_job_destroy(&job);
+}
+
+/**
+ * @brief Hand an external API request over to the Lua worker threads
+ *
+ * @return true if the request was queued and will be completed by the worker,
+ *         false if it must be processed synchronously
+ */
+static bool post_async_drop(struct gcmzdrops *const ctx,
+                            struct gcmz_api_request_params *const params,
+                            gcmz_api_request_complete_func const complete) {
+  struct async_drop_job *job = NULL;
+  struct ov_error err = {0};
+  bool async_handlers = false;
+  bool success = false;
+
+  if (!ctx->lua_worker) {
+    return false;
+  }
+  if (!gcmz_config_get_async_handlers(ctx->config, &async_handlers, &err)) {
+    OV_ERROR_ADD_TRACE(&err);
+    goto cleanup;
+  }
+  if (!async_handlers) {
+    return false;
+  }
+
+  if (!OV_REALLOC(&job, 1, sizeof(struct async_drop_job))) {
+    OV_ERROR_SET_GENERIC(&err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+  *job = (struct async_drop_job){
+      .ctx = ctx,
+      .params = params,
+      .complete = complete,
+  };
+  ctx->edit->call_edit_section_param(job, async_drop_capture_edit_section);
+  if (!job->captured) {
+    OV_ERROR_SET(&err, ov_error_type_generic, ov_error_generic_fail, "failed to capture edit information");
+    goto cleanup;
+  }
+  if (!async_drop_snapshot_config(job, &err)) {
+    OV_ERROR_ADD_TRACE(&err);
+    goto cleanup;
+  }
+  if (!gcmz_lua_worker_post(ctx->lua_worker, async_drop_run, job, &err)) {
+    OV_ERROR_ADD_TRACE(&err);
+    goto cleanup;
+  }
+  job = NULL;
+  success = true;
+
+cleanup:
+  async_drop_job_destroy(&job);
+  if (!success) {
+    gcmz_logf_warn(&err, "%1$hs", "%1$hs", "running handlers for external API request on the UI thread instead");
+    OV_ERROR_DESTROY(&err);
+  }
+  return success;
+}
+
 static void request_api(struct gcmz_api_request_params *const params, gcmz_api_request_complete_func const complete) {
   if (!params || !complete) {
     return;
@@ -704,6 +925,9 @@ static void request_api(struct gcmz_api_request_params *const params, gcmz_api_r
     complete(params);
     return;
   }
+  if (post_async_drop(ctx, params, complete)) {
+    return;
+  }
   ctx->edit->call_edit_section_param(
       &(struct request_api_context){
           .ctx = ctx,
@@ -922,6 +1146,33 @@ cleanup:
 
 #ifndef NDEBUG
 
+static void debug_output_hook_memory(char const *const name, struct gcmz_lua_alloc_hook_stats const *const stats) {
+  gcmz_logf_info(NULL,
+                 NULL,
+                 "[lua_memory] %s: before: %zu / after: %zu / peak: %zu / alloc: %zu / realloc: %zu / free: %zu",
+                 name,
+                 stats->live_bytes_before,
+                 stats->live_bytes_after,
+                 stats->peak_bytes,
+                 stats->allocations,
+                 stats->reallocations,
+                 stats->frees);
+}
+
+static bool debug_output_handler_stats(struct gcmz_lua_handler_stats const *stats, void *userdata) {
+  (void)userdata;
+  gcmz_logf_info(NULL,
+                 NULL,
+                 "[handler_stats] %s.%s: count: %zu / total: %.3fms / max: %.3fms / p95: %.3fms",
+                 stats->name,
+                 stats->hook,
+                 stats->count,
+                 stats->total_ms,
+                 stats->max_ms,
+                 stats->p95_ms);
+  return true;
+}
+
 static void debug_output_info(struct gcmzdrops *const ctx) {
   gcmz_logf_verbose(NULL, "%1$s", "† verbose output †");
   gcmz_logf_info(NULL, "%1$s", "† info output †");
@@ -959,6 +1210,33 @@ static void debug_output_info(struct gcmzdrops *const ctx) {
   } else {
     gcmz_logf_warn(NULL, NULL, "ctx->edit is not available");
   }
+
+  gcmz_logf_info(NULL, NULL, "--- ctx->lua_ctx (0x%p) ---", (void *)ctx->lua_ctx);
+  struct gcmz_lua_memory_stats mem = {0};
+  if (gcmz_lua_get_memory_stats(ctx->lua_ctx, &mem)) {
+    gcmz_logf_info(NULL,
+                   NULL,
+                   "[lua_memory] live: %zu / peak: %zu / pooled: %zu / alloc: %zu / realloc: %zu / free: %zu",
+                   mem.total.live_bytes,
+                   mem.total.peak_bytes,
+                   mem.total.pooled_bytes,
+                   mem.total.allocations,
+                   mem.total.reallocations,
+                   mem.total.frees);
+    debug_output_hook_memory("drag_enter", &mem.drag_enter);
+    debug_output_hook_memory("drag_leave", &mem.drag_leave);
+    debug_output_hook_memory("drop", &mem.drop);
+    debug_output_hook_memory("exo_convert", &mem.exo_convert);
+  } else {
+    gcmz_logf_warn(NULL, NULL, "Lua memory accounting is not available");
+  }
+  if (ctx->lua_ctx) {
+    struct ov_error err = {0};
+    if (!gcmz_lua_enum_handler_stats(ctx->lua_ctx, debug_output_handler_stats, NULL, &err)) {
+      gcmz_logf_warn(&err, "%1$hs", "%1$hs", "failed to enumerate handler statistics");
+      OV_ERROR_DESTROY(&err);
+    }
+  }
 }
 
 static void tray_menu_debug_output(void *userdata, struct gcmz_tray_callback_event *const event) {
@@ -1255,7 +1533,13 @@ static bool get_project_data_utf8(struct aviutl2_edit_info *edit_info,
     OV_ERROR_SET_GENERIC(err, ov_error_generic_unexpected);
     return false;
   }
-  if (ctx->current_edit_section) {
+  // Handlers running on lua_worker see the state captured when their own request arrived
+  struct async_drop_job const *const job =
+      (struct async_drop_job const *)gcmz_lua_worker_get_current_userdata(ctx->lua_worker);
+  wchar_t const *const source_project_path = job ? job->project_path : ctx->project_path;
+  if (job) {
+    memcpy(edit_info, &job->edit_info, sizeof(*edit_info));
+  } else if (ctx->current_edit_section) {
     memcpy(edit_info, ctx->current_edit_section->info, sizeof(*edit_info));
   } else if (ctx->edit) {
     ctx->edit->get_edit_info(edit_info, sizeof(*edit_info));
@@ -1266,9 +1550,9 @@ static bool get_project_data_utf8(struct aviutl2_edit_info *edit_info,
   bool success = false;
 
   if (project_path) {
-    if (ctx->project_path && ctx->project_path[0] != L'\0') {
-      size_t const len = wcslen(ctx->project_path);
-      size_t const utf8_len = ov_wchar_to_utf8_len(ctx->project_path, len);
+    if (source_project_path && source_project_path[0] != L'\0') {
+      size_t const len = wcslen(source_project_path);
+      size_t const utf8_len = ov_wchar_to_utf8_len(source_project_path, len);
       if (utf8_len == 0) {
         OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
         goto cleanup;
@@ -1277,7 +1561,7 @@ static bool get_project_data_utf8(struct aviutl2_edit_info *edit_info,
         OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
         goto cleanup;
       }
-      ov_wchar_to_utf8(ctx->project_path, len, *project_path, utf8_len + 1, NULL);
+      ov_wchar_to_utf8(source_project_path, len, *project_path, utf8_len + 1, NULL);
     } else {
       *project_path = NULL;
     }
@@ -1532,8 +1816,10 @@ static char *get_save_path_utf8(void *userdata, char const *filename, struct ov_
       goto cleanup;
     }
 
-    // Get save path
-    dest_path_w = gcmz_config_get_save_path(ctx->config, filename_w, err);
+    // Handlers running on lua_worker use the settings captured when their own request arrived
+    struct async_drop_job const *const job =
+        (struct async_drop_job const *)gcmz_lua_worker_get_current_userdata(ctx->lua_worker);
+    dest_path_w = gcmz_config_get_save_path(job ? job->config : ctx->config, filename_w, err);
     if (!dest_path_w) {
       OV_ERROR_ADD_TRACE(err);
       goto cleanup;
@@ -1666,6 +1952,9 @@ static void finalize(void *const userdata) {
   if (ctx->api) {
     gcmz_api_destroy(&ctx->api);
   }
+  if (ctx->lua_worker) {
+    gcmz_lua_worker_destroy(&ctx->lua_worker);
+  }
   if (ctx->drop) {
     gcmz_drop_destroy(&ctx->drop);
   }
@@ -1675,6 +1964,9 @@ static void finalize(void *const userdata) {
   if (ctx->window_list) {
     gcmz_window_list_destroy(&ctx->window_list);
   }
+  if (ctx->object_info_cache) {
+    gcmz_object_info_cache_destroy(&ctx->object_info_cache);
+  }
   if (ctx->project_path) {
     OV_ARRAY_DESTROY(&ctx->project_path);
   }
@@ -1761,6 +2053,56 @@ cleanup:
   return result;
 }
 
+/**
+ * @brief Get (and create if needed) the directory for the Lua bytecode cache
+ *
+ * The cache lives under the local application data folder so it works even when
+ * the script directory is not writable.
+ *
+ * @param cache_dir [out] Cache directory path
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+static bool get_bytecode_cache_directory_path(wchar_t **const cache_dir, struct ov_error *const err) {
+  if (!cache_dir) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  wchar_t local_appdata[MAX_PATH];
+  wchar_t *dir = NULL;
+  bool result = false;
+
+  {
+    HRESULT const hr = SHGetFolderPathW(NULL, CSIDL_LOCAL_APPDATA, NULL, SHGFP_TYPE_CURRENT, local_appdata);
+    if (FAILED(hr)) {
+      OV_ERROR_SET_HRESULT(err, hr);
+      goto cleanup;
+    }
+    if (!gcmz_lua_build_bytecode_cache_dir(local_appdata, &dir, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+
+    int const r = SHCreateDirectoryExW(NULL, dir, NULL);
+    if (r != ERROR_SUCCESS && r != ERROR_ALREADY_EXISTS) {
+      OV_ERROR_SET_HRESULT(err, HRESULT_FROM_WIN32((DWORD)r));
+      goto cleanup;
+    }
+
+    *cache_dir = dir;
+    dir = NULL;
+  }
+
+  result = true;
+
+cleanup:
+  if (dir) {
+    OV_ARRAY_DESTROY(&dir);
+  }
+  return result;
+}
+
 static char *get_script_directory_utf8(void *userdata, struct ov_error *err) {
   (void)userdata;
   wchar_t *script_dir_w = NULL;
@@ -1814,7 +2156,8 @@ get_media_info_utf8(char const *filepath, struct aviutl2_media_info *info, void
     OV_ERROR_SET(err, ov_error_type_generic, ov_error_generic_fail, "edit handle not available");
     return false;
   }
-  if (!ctx->current_edit_section) {
+  // The edit section is held by the UI thread, handlers running on lua_worker cannot use it
+  if (gcmz_lua_worker_is_current_thread(ctx->lua_worker) || !ctx->current_edit_section) {
     OV_ERROR_SET(err, ov_error_type_generic, ov_error_generic_fail, "edit section not available");
     return false;
   }
@@ -1962,6 +2305,7 @@ NODISCARD bool gcmzdrops_create(struct gcmzdrops **const ctx,
 
   struct gcmzdrops *c = NULL;
   wchar_t *script_dir = NULL;
+  wchar_t *bytecode_cache_dir = NULL;
   bool result = false;
 
   {
@@ -2043,6 +2387,12 @@ NODISCARD bool gcmzdrops_create(struct gcmzdrops **const ctx,
       goto cleanup;
     }
 
+    c->object_info_cache = gcmz_object_info_cache_create(err);
+    if (!c->object_info_cache) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+
     if (!get_script_directory_path(&script_dir, err)) {
       OV_ERROR_ADD_TRACE(err);
       goto cleanup;
@@ -2065,16 +2415,43 @@ NODISCARD bool gcmzdrops_create(struct gcmzdrops **const ctx,
       OV_ERROR_SET_GENERIC(err, ov_error_generic_unexpected);
       goto cleanup;
     }
-    if (!gcmz_lua_setup(c->lua_ctx,
-                        &(struct gcmz_lua_options){
-                            .script_dir = script_dir,
-                            .api_register_callback = register_lua_api,
-                            .schedule_cleanup_callback = schedule_cleanup,
-                            .create_temp_file_callback = create_temp_file_utf8,
-                        },
-                        err)) {
-      OV_ERROR_ADD_TRACE(err);
-      goto cleanup;
+    {
+      // The bytecode cache is only an optimization, so start without it if the directory is unavailable
+      struct ov_error cache_err = {0};
+      if (!get_bytecode_cache_directory_path(&bytecode_cache_dir, &cache_err)) {
+        gcmz_logf_warn(&cache_err, "%1$hs", "%1$hs", "failed to prepare Lua bytecode cache directory");
+        OV_ERROR_DESTROY(&cache_err);
+      }
+    }
+    {
+      struct gcmz_lua_options const lua_options = {
+          .script_dir = script_dir,
+          .bytecode_cache_dir = bytecode_cache_dir,
+          .api_register_callback = register_lua_api,
+          .schedule_cleanup_callback = schedule_cleanup,
+          .create_temp_file_callback = create_temp_file_utf8,
+          .slow_handler_threshold_ms = 200,
+          .drag_enter_budget_ms = 500,
+          .drag_leave_budget_ms = 500,
+          .drop_budget_ms = 10000,
+          .exo_convert_budget_ms = 10000,
+          .watch_script_dir = true,
+      };
+      if (!gcmz_lua_setup(c->lua_ctx, &lua_options, err)) {
+        OV_ERROR_ADD_TRACE(err);
+        goto cleanup;
+      }
+
+      // Each worker thread loads its own copy of the handlers when its first request arrives
+      size_t async_handler_states = 1;
+      if (!gcmz_config_get_async_handler_states(c->config, &async_handler_states, err)) {
+        OV_ERROR_ADD_TRACE(err);
+        goto cleanup;
+      }
+      if (!gcmz_lua_worker_create(&c->lua_worker, &lua_options, async_handler_states, err)) {
+        OV_ERROR_ADD_TRACE(err);
+        goto cleanup;
+      }
     }
 
     c->drop = gcmz_drop_create(
@@ -2137,6 +2514,9 @@ NODISCARD bool gcmzdrops_create(struct gcmzdrops **const ctx,
   result = true;
 
 cleanup:
+  if (bytecode_cache_dir) {
+    OV_ARRAY_DESTROY(&bytecode_cache_dir);
+  }
   if (script_dir) {
     OV_ARRAY_DESTROY(&script_dir);
   }
@@ -2282,3 +2662,22 @@ void gcmzdrops_register(struct gcmzdrops *const ctx, struct aviutl2_host_app_tab
     ctx->edit = edit;
   }
 }
+
+bool gcmzdrops_register_script_module(struct gcmzdrops *const ctx,
+                                      struct aviutl2_script_module_table *const table,
+                                      char const *const module_name,
+                                      char const *const source,
+                                      struct ov_error *const err) {
+  if (!ctx || !table || !module_name) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+  if (!ctx->lua_worker) {
+    return true;
+  }
+  if (!gcmz_lua_worker_register_script_module(ctx->lua_worker, table, module_name, source, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  return true;
+}
@@ -7,6 +7,7 @@ struct gcmz_lua_context;
 struct aviutl2_host_app_table;
 struct aviutl2_edit_section;
 struct aviutl2_project_file;
+struct aviutl2_script_module_table;
 
 /**
  * @brief Create and initialize gcmzdrops context
@@ -58,3 +59,21 @@ void gcmzdrops_on_project_load(struct gcmzdrops *const ctx, struct aviutl2_proje
  * @param edit Edit section (must be valid, called from within edit section callback)
  */
 void gcmzdrops_paste_from_clipboard(struct gcmzdrops *const ctx, struct aviutl2_edit_section *const edit);
+
+/**
+ * @brief Make a script module available to the handlers running on the Lua worker threads
+ *
+ * The module must already be registered with the Lua context passed to gcmzdrops_create.
+ *
+ * @param ctx Plugin context
+ * @param table Script module table from external DLL
+ * @param module_name Module name (UTF-8)
+ * @param source Source path indicating where the module came from (UTF-8)
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+NODISCARD bool gcmzdrops_register_script_module(struct gcmzdrops *const ctx,
+                                                struct aviutl2_script_module_table *const table,
+                                                char const *const module_name,
+                                                char const *const source,
+                                                struct ov_error *const err);
@@ -11,6 +11,7 @@
 #endif // __GNUC__
 #include <lauxlib.h>
 #include <lua.h>
+#include <luajit.h>
 #include <lualib.h>
 #ifdef __GNUC__
 #  pragma GCC diagnostic pop
@@ -27,20 +28,44 @@
 
 #include <ovl/path.h>
 
+#include <string.h>
+
 #include <aviutl2_module2.h>
 
 #include "file.h"
 #include "gcmz_types.h"
 #include "logf.h"
+#include "lua_alloc.h"
+#include "lua_file_list_ffi.h"
+#include "lua_json.h"
 #include "lua_script_module_param.h"
 #include "luautil.h"
 
+/**
+ * @brief Deadline of the handler call currently running under a time budget
+ */
+struct watchdog {
+  LARGE_INTEGER deadline;
+  bool armed;
+  bool fired;
+};
+
 struct gcmz_lua_context {
   lua_State *L;
   gcmz_lua_schedule_cleanup_callback schedule_cleanup_callback;
   gcmz_lua_create_temp_file_callback create_temp_file_callback;
   void *userdata;
-  int entrypoint_ref; // Lua registry reference for entrypoint module
+  int entrypoint_ref;                           // Lua registry reference for entrypoint module
+  struct gcmz_file_list *marshal_snapshot;      // Copy of the file list last marshaled into the files table
+  struct gcmz_lua_alloc *alloc;                 // Pooled allocator behind L, NULL if the default allocator is used
+  // Memory counters of the last invocation of each hook.
+  // Hooks receive a const context, so counters they update live behind a pointer.
+  struct gcmz_lua_memory_stats *memory;
+  struct watchdog watchdog;                     // Time budget state referenced from the count hook
+  wchar_t *script_dir;                          // Script directory the handlers were loaded from
+  HANDLE script_watch;                          // Change notification of script_dir, NULL if not watched
+  struct gcmz_lua_file_list_ffi *file_list_ffi; // File list shared with FFI handlers while a hook is running
+  bool file_list_source;                        // Entrypoint takes the file list through set_file_list_source
 };
 
 #define LUA_SET_STRING_FIELD(L, key, value)                                                                            \
@@ -57,66 +82,312 @@ struct gcmz_lua_context {
     lua_settable((L), -3);                                                                                             \
   } while (0)
 
+#define LUA_SET_INT_FIELD(L, key, value)                                                                               \
+  do {                                                                                                                 \
+    lua_pushstring((L), (key));                                                                                        \
+    lua_pushinteger((L), (lua_Integer)(value));                                                                        \
+    lua_settable((L), -3);                                                                                             \
+  } while (0)
+
+static char const marshal_cache_key[] = "gcmz_marshal_cache";
+
+/**
+ * @brief Push the marshal cache table of the current drag session, creating it if needed
+ *
+ * The table keeps the file entry tables handed to Lua so that they can be reused by later hooks
+ * of the same drag session:
+ * @code
+ * {
+ *   generation = 1,                 -- incremented every time the files table is created
+ *   entries = { [i] = entry },      -- file entry table for the i-th file of marshal_snapshot
+ *   filepaths = { [i] = "..." },    -- filepath string as marshaled
+ *   mimetypes = { [i] = "..." },    -- mimetype string as marshaled
+ *   index = { [entry] = i },        -- reverse lookup for entries of the latest files table
+ * }
+ * @endcode
+ *
+ * @param L Lua state
+ */
+static void push_marshal_cache(lua_State *L) {
+  lua_getfield(L, LUA_REGISTRYINDEX, marshal_cache_key);
+  if (lua_istable(L, -1)) {
+    return;
+  }
+  lua_pop(L, 1);
+  lua_createtable(L, 0, 5);
+  lua_pushinteger(L, 0);
+  lua_setfield(L, -2, "generation");
+  lua_newtable(L);
+  lua_setfield(L, -2, "entries");
+  lua_newtable(L);
+  lua_setfield(L, -2, "filepaths");
+  lua_newtable(L);
+  lua_setfield(L, -2, "mimetypes");
+  lua_newtable(L);
+  lua_setfield(L, -2, "index");
+  lua_pushvalue(L, -1);
+  lua_setfield(L, LUA_REGISTRYINDEX, marshal_cache_key);
+}
+
+/**
+ * @brief Discard the marshal cache at the end of a drag session
+ *
+ * @param L Lua state
+ * @param snapshot Copy of the file list last marshaled
+ */
+static void reset_marshal_cache(lua_State *L, struct gcmz_file_list *const snapshot) {
+  lua_pushnil(L);
+  lua_setfield(L, LUA_REGISTRYINDEX, marshal_cache_key);
+  gcmz_file_list_clear(snapshot);
+}
+
+/**
+ * @brief Check whether two file entries can share a marshaled representation
+ */
+static bool is_same_file(struct gcmz_file const *const a, struct gcmz_file const *const b) {
+  if (a->temporary != b->temporary || a->has_object_info || b->has_object_info) {
+    return false;
+  }
+  if (wcscmp(a->path, b->path) != 0) {
+    return false;
+  }
+  if (!a->mime_type || !b->mime_type) {
+    return a->mime_type == b->mime_type;
+  }
+  return wcscmp(a->mime_type, b->mime_type) == 0;
+}
+
+/**
+ * @brief Check whether a cached file entry table is still as marshaled
+ *
+ * The entry must hold exactly the filepath, mimetype and temporary fields,
+ * with the strings that were pushed when it was created.
+ *
+ * @param L Lua state
+ * @param cache_index Stack index of the marshal cache table
+ * @param entry_index Stack index of the file entry table
+ * @param i 1-based index of the entry in the cache
+ * @param temporary Expected value of the temporary field
+ * @return true if the entry has not been modified
+ */
+static bool is_marshaled_entry_clean(lua_State *L, int cache_index, int entry_index, int i, bool temporary) {
+  int const top = lua_gettop(L);
+  bool clean = false;
+
+  // Raw access only: this runs outside of a protected call
+  lua_pushstring(L, "filepath");
+  lua_rawget(L, entry_index);
+  lua_getfield(L, cache_index, "filepaths");
+  lua_rawgeti(L, -1, i);
+  if (!lua_rawequal(L, -1, -3)) {
+    goto cleanup;
+  }
+  lua_settop(L, top);
+
+  lua_pushstring(L, "mimetype");
+  lua_rawget(L, entry_index);
+  lua_getfield(L, cache_index, "mimetypes");
+  lua_rawgeti(L, -1, i);
+  if (!lua_rawequal(L, -1, -3)) {
+    goto cleanup;
+  }
+  lua_settop(L, top);
+
+  lua_pushstring(L, "temporary");
+  lua_rawget(L, entry_index);
+  if (!lua_isboolean(L, -1) || (lua_toboolean(L, -1) != 0) != temporary) {
+    goto cleanup;
+  }
+  lua_settop(L, top);
+
+  {
+    int fields = 0;
+    lua_pushnil(L);
+    while (lua_next(L, entry_index) != 0) {
+      lua_pop(L, 1);
+      ++fields;
+    }
+    clean = fields == 3;
+  }
+
+cleanup:
+  lua_settop(L, top);
+  return clean;
+}
+
+/**
+ * @brief Create a new file entry table for a file and push it onto the stack
+ *
+ * The UTF-8 strings are taken from the entry cache, converting them only on first use.
+ *
+ * @param L Lua state
+ * @param file Source file
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+static bool push_file_entry(lua_State *L, struct gcmz_file *const file, struct ov_error *const err) {
+  char const *path = NULL;
+  char const *mime_type = NULL;
+  if (!gcmz_file_get_path_utf8(file, &path, err) || !gcmz_file_get_mime_type_utf8(file, &mime_type, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+
+  lua_createtable(L, 0, 3);
+  LUA_SET_STRING_FIELD(L, "filepath", path);
+  LUA_SET_STRING_FIELD(L, "mimetype", mime_type);
+  LUA_SET_BOOL_FIELD(L, "temporary", file->temporary);
+
+  if (file->has_object_info) {
+    lua_pushstring(L, "object_info");
+    lua_createtable(L, 0, 6);
+    LUA_SET_STRING_FIELD(L, "filepath", path);
+    LUA_SET_INT_FIELD(L, "layer_min", file->object_info.layer_min);
+    LUA_SET_INT_FIELD(L, "layer_max", file->object_info.layer_max);
+    LUA_SET_INT_FIELD(L, "frame_start", file->object_info.frame_start);
+    LUA_SET_INT_FIELD(L, "frame_end", file->object_info.frame_end);
+    LUA_SET_INT_FIELD(L, "object_count", file->object_info.object_count);
+    lua_settable(L, -3);
+  }
+  return true;
+}
+
 /**
  * @brief Create a Lua table from gcmz_file_list
  *
  * Creates a table with structure:
  * @code
  * {
- *   {filepath = "C:\\Path\\To\\File1.ext", mimetype = "image/png"},
- *   {filepath = "C:\\Path\\To\\File2.ext", mimetype = "audio/wav"},
+ *   {filepath = "C:\\Path\\To\\File1.ext", mimetype = "image/png", temporary = false},
+ *   {filepath = "C:\\Path\\To\\File2.ext", mimetype = "audio/wav", temporary = true},
  *   ...
  * }
  * @endcode
  *
+ * Entries with known .object layout also get an object_info table.
+ *
+ * Within a drag session the entry tables are reused: when a file matches the one marshaled at
+ * the same position by the previous hook and its entry table has not been modified by a handler,
+ * the same table is pushed again without converting the strings. The array itself is always new.
+ *
  * @param L Lua state
+ * @param snapshot Copy of the file list last marshaled, updated to match file_list
  * @param file_list Source file list
+ * @param generation [out] Generation of the marshal cache, passed to update_file_list_from_table
  * @param err [out] Error information on failure
  * @return true on success, false on failure
  */
-static bool create_files_table(lua_State *L, struct gcmz_file_list const *const file_list, struct ov_error *const err) {
-  if (!L || !file_list) {
+static bool create_files_table(lua_State *L,
+                               struct gcmz_file_list *const snapshot,
+                               struct gcmz_file_list *const file_list,
+                               lua_Integer *const generation,
+                               struct ov_error *const err) {
+  if (!L || !snapshot || !file_list || !generation) {
     OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
     return false;
   }
 
-  char *buffer = NULL;
+  int const base_top = lua_gettop(L);
   bool result = false;
 
   size_t const file_count = gcmz_file_list_count(file_list);
+  size_t const snapshot_count = gcmz_file_list_count(snapshot);
+  bool snapshot_matches = file_count == snapshot_count;
+
+  push_marshal_cache(L);
+  int const cache = lua_gettop(L);
+  lua_getfield(L, cache, "generation");
+  *generation = lua_tointeger(L, -1) + 1;
+  lua_pop(L, 1);
+  lua_pushinteger(L, *generation);
+  lua_setfield(L, cache, "generation");
+  lua_getfield(L, cache, "entries");
+  int const entries = lua_gettop(L);
+  lua_getfield(L, cache, "filepaths");
+  int const filepaths = lua_gettop(L);
+  lua_getfield(L, cache, "mimetypes");
+  int const mimetypes = lua_gettop(L);
+  lua_createtable(L, 0, (int)file_count);
+  int const index = lua_gettop(L);
   lua_createtable(L, (int)file_count, 0);
+  int const files = lua_gettop(L);
 
   for (size_t i = 0; i < file_count; i++) {
-    struct gcmz_file const *file = gcmz_file_list_get(file_list, i);
+    struct gcmz_file *const file = gcmz_file_list_get_mutable(file_list, i);
     if (!file) {
       OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
       goto cleanup;
     }
+    int const n = (int)(i + 1);
+
+    bool reused = false;
+    struct gcmz_file const *const cached = i < snapshot_count ? gcmz_file_list_get(snapshot, i) : NULL;
+    if (cached && is_same_file(file, cached)) {
+      lua_rawgeti(L, entries, n);
+      reused = lua_istable(L, -1) && is_marshaled_entry_clean(L, cache, lua_gettop(L), n, file->temporary);
+      if (!reused) {
+        lua_pop(L, 1);
+      }
+    } else {
+      snapshot_matches = false;
+    }
 
-    lua_createtable(L, 0, 2);
-
-    if (!gcmz_wchar_to_utf8(file->path, &buffer, err)) {
-      OV_ERROR_ADD_TRACE(err);
-      goto cleanup;
+    if (!reused) {
+      if (!push_file_entry(L, file, err)) {
+        OV_ERROR_ADD_TRACE(err);
+        goto cleanup;
+      }
+      if (file->has_object_info) {
+        lua_pushnil(L);
+        lua_rawseti(L, entries, n);
+      } else {
+        lua_pushvalue(L, -1);
+        lua_rawseti(L, entries, n);
+        lua_pushstring(L, "filepath");
+        lua_rawget(L, -2);
+        lua_rawseti(L, filepaths, n);
+        lua_pushstring(L, "mimetype");
+        lua_rawget(L, -2);
+        lua_rawseti(L, mimetypes, n);
+      }
     }
-    LUA_SET_STRING_FIELD(L, "filepath", buffer);
 
-    if (!gcmz_wchar_to_utf8(file->mime_type, &buffer, err)) {
-      OV_ERROR_ADD_TRACE(err);
-      goto cleanup;
+    if (!file->has_object_info) {
+      lua_pushvalue(L, -1);
+      lua_pushinteger(L, n);
+      lua_rawset(L, index);
     }
-    LUA_SET_STRING_FIELD(L, "mimetype", buffer);
+    lua_rawseti(L, files, n);
+  }
 
-    lua_rawseti(L, -2, (int)(i + 1));
+  for (size_t i = file_count; i < snapshot_count; i++) {
+    lua_pushnil(L);
+    lua_rawseti(L, entries, (int)(i + 1));
+  }
+  lua_pushvalue(L, index);
+  lua_setfield(L, cache, "index");
+
+  if (!snapshot_matches) {
+    gcmz_file_list_clear(snapshot);
+    for (size_t i = 0; i < file_count; i++) {
+      struct gcmz_file const *const file = gcmz_file_list_get(file_list, i);
+      bool const added = file->temporary ? gcmz_file_list_add_temporary(snapshot, file->path, file->mime_type, err)
+                                         : gcmz_file_list_add(snapshot, file->path, file->mime_type, err);
+      if (!added) {
+        OV_ERROR_ADD_TRACE(err);
+        goto cleanup;
+      }
+    }
   }
+
+  lua_replace(L, base_top + 1);
+  lua_settop(L, base_top + 1);
   result = true;
 
 cleanup:
-  if (buffer) {
-    OV_ARRAY_DESTROY(&buffer);
-  }
   if (!result) {
-    lua_pop(L, 1);
+    lua_settop(L, base_top);
+    reset_marshal_cache(L, snapshot);
   }
   return result;
 }
@@ -153,93 +424,87 @@ static bool lua_get_bool_field(lua_State *L, char const *const key, bool default
 }
 
 /**
- * @brief Free collected paths array
+ * @brief Get integer field from Lua table at stack top
+ *
+ * @param L Lua state
+ * @param key Field name
+ * @param value [out] Integer value
+ * @return true if the field is a number, false otherwise
  */
-static void free_collected_paths(wchar_t ***const paths, size_t count) {
-  if (!paths || !*paths) {
-    return;
-  }
-  for (size_t i = 0; i < count; i++) {
-    if ((*paths)[i]) {
-      OV_ARRAY_DESTROY(&(*paths)[i]);
-    }
+static bool lua_get_int_field(lua_State *L, char const *const key, int *const value) {
+  lua_pushstring(L, key);
+  lua_gettable(L, -2);
+  bool const found = lua_type(L, -1) == LUA_TNUMBER;
+  if (found) {
+    *value = (int)lua_tointeger(L, -1);
   }
-  OV_ARRAY_DESTROY(paths);
+  lua_pop(L, 1);
+  return found;
 }
 
 /**
- * @brief Collect file paths from Lua table
+ * @brief Get .object layout from the object_info field of the Lua table at stack top
+ *
+ * Expects a table with structure:
+ * @code
+ * {filepath = "C:\\Path\\To\\File.object", layer_min = 0, layer_max = 2, frame_start = 0, frame_end = 99,
+ *  object_count = 3}
+ * @endcode
+ *
+ * filepath, layer_min and layer_max are required; the other fields default to 0.
+ * The table is ignored when its filepath is not the path of the entry,
+ * so a handler that replaces filepath without replacing object_info does not carry over the old layout.
  *
  * @param L Lua state
- * @param table_index Stack index of the Lua table
- * @param out_paths [out] Array of collected paths
- * @param out_count [out] Number of paths collected
- * @param err [out] Error information on failure
- * @return true on success, false on failure
+ * @param filepath Path of the file entry
+ * @param info [out] Layout information
+ * @return true if a valid object_info table for filepath is present, false otherwise
  */
-static bool collect_paths_from_table(
-    lua_State *L, int table_index, wchar_t ***const out_paths, size_t *const out_count, struct ov_error *const err) {
-  size_t const table_len = lua_objlen(L, table_index);
-  if (table_len == 0) {
-    *out_paths = NULL;
-    *out_count = 0;
-    return true;
-  }
-
-  wchar_t **paths = NULL;
-  size_t count = 0;
-  bool result = false;
-
-  if (!OV_ARRAY_GROW(&paths, table_len)) {
-    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+static bool lua_get_object_info_field(lua_State *L, char const *const filepath, struct gcmz_object_info *const info) {
+  lua_pushstring(L, "object_info");
+  lua_gettable(L, -2);
+  if (!lua_istable(L, -1)) {
+    lua_pop(L, 1);
     return false;
   }
-  for (size_t i = 0; i < table_len; i++) {
-    paths[i] = NULL;
-  }
-
-  for (size_t i = 1; i <= table_len; i++) {
-    lua_rawgeti(L, table_index, (int)i);
-    if (!lua_istable(L, -1)) {
-      lua_pop(L, 1);
-      continue;
-    }
-
-    char const *const filepath = lua_get_string_field(L, "filepath");
-    lua_pop(L, 1); // Pop file entry table
-
-    if (!filepath) {
-      continue;
-    }
-
-    wchar_t *path_w = NULL;
-    if (!gcmz_utf8_to_wchar(filepath, &path_w, err)) {
-      OV_ERROR_ADD_TRACE(err);
-      goto cleanup;
-    }
-    if (path_w) {
-      paths[count++] = path_w;
-    }
+  char const *const described = lua_get_string_field(L, "filepath");
+  if (!described || strcmp(described, filepath) != 0) {
+    lua_pop(L, 1);
+    return false;
   }
-
-  result = true;
-
-cleanup:
-  if (result) {
-    *out_paths = paths;
-    *out_count = count;
-  } else {
-    free_collected_paths(&paths, count);
+  int layer_min = 0;
+  int layer_max = 0;
+  int frame_start = 0;
+  int frame_end = 0;
+  int object_count = 0;
+  bool const valid = lua_get_int_field(L, "layer_min", &layer_min) && lua_get_int_field(L, "layer_max", &layer_max) &&
+                     layer_min >= 0 && layer_min <= layer_max;
+  lua_get_int_field(L, "frame_start", &frame_start);
+  lua_get_int_field(L, "frame_end", &frame_end);
+  lua_get_int_field(L, "object_count", &object_count);
+  lua_pop(L, 1);
+  if (!valid) {
+    return false;
   }
-  return result;
+  *info = (struct gcmz_object_info){
+      .layer_min = layer_min,
+      .layer_max = layer_max,
+      .layer_count = layer_max - layer_min + 1,
+      .frame_start = frame_start,
+      .frame_end = frame_end,
+      .object_count = object_count > 0 ? (size_t)object_count : 0,
+  };
+  return true;
 }
 
 /**
- * @brief Check if path exists in path array
+ * @brief Check if path exists in file list
  */
-static bool path_exists_in_array(wchar_t const *const path, wchar_t **const paths, size_t count) {
+static bool path_exists_in_list(wchar_t const *const path, struct gcmz_file_list const *const list) {
+  size_t const count = gcmz_file_list_count(list);
   for (size_t i = 0; i < count; i++) {
-    if (paths[i] && wcscmp(path, paths[i]) == 0) {
+    struct gcmz_file const *const file = gcmz_file_list_get(list, i);
+    if (file && file->path && wcscmp(path, file->path) == 0) {
       return true;
     }
   }
@@ -250,16 +515,14 @@ static bool path_exists_in_array(wchar_t const *const path, wchar_t **const path
  * @brief Schedule cleanup for removed temporary files
  *
  * @param file_list Existing file list
- * @param new_paths New collected paths
- * @param new_paths_count Number of new collected paths
+ * @param new_list New file list
  * @param callback Cleanup scheduling callback
  * @param userdata User data passed to callback
  * @param err [out] Error information on failure
  * @return true on success, false on failure
  */
 static bool schedule_removed_temp_files_cleanup(struct gcmz_file_list const *const file_list,
-                                                wchar_t **const new_paths,
-                                                size_t new_paths_count,
+                                                struct gcmz_file_list const *const new_list,
                                                 gcmz_lua_schedule_cleanup_callback callback,
                                                 void *userdata,
                                                 struct ov_error *const err) {
@@ -274,7 +537,7 @@ static bool schedule_removed_temp_files_cleanup(struct gcmz_file_list const *con
       continue;
     }
 
-    if (!path_exists_in_array(file->path, new_paths, new_paths_count)) {
+    if (!path_exists_in_list(file->path, new_list)) {
       if (!callback(file->path, userdata, err)) {
         OV_ERROR_ADD_TRACE(err);
         return false;
@@ -287,61 +550,36 @@ static bool schedule_removed_temp_files_cleanup(struct gcmz_file_list const *con
 /**
  * @brief Parse single file entry from Lua table and add to file list
  *
+ * The UTF-8 strings are stored with the entry, so marshaling it again does not convert them back.
+ *
  * @param L Lua state (file entry table at stack top)
  * @param file_list File list to add to
- * @param path_buffer [in/out] Buffer for path wchar_t conversion (reused)
- * @param mime_buffer [in/out] Buffer for mime wchar_t conversion (reused)
  * @param err [out] Error information on failure
  * @return true on success, false on failure
  */
-static bool parse_and_add_file_entry(lua_State *L,
-                                     struct gcmz_file_list *const file_list,
-                                     wchar_t **const path_buffer,
-                                     wchar_t **const mime_buffer,
-                                     struct ov_error *const err) {
+static bool parse_and_add_file_entry(lua_State *L, struct gcmz_file_list *const file_list, struct ov_error *const err) {
   char const *const filepath = lua_get_string_field(L, "filepath");
   if (!filepath) {
     OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
     return false;
   }
-
-  bool result = false;
-  wchar_t *mime = NULL;
-
-  {
-    if (!gcmz_utf8_to_wchar(filepath, path_buffer, err)) {
-      OV_ERROR_ADD_TRACE(err);
-      goto cleanup;
-    }
-    if (!*path_buffer) {
-      OV_ERROR_SET_GENERIC(err, ov_error_generic_unexpected);
-      goto cleanup;
-    }
-    char const *const mimetype = lua_get_string_field(L, "mimetype");
-    if (mimetype) {
-      if (!gcmz_utf8_to_wchar(mimetype, mime_buffer, err)) {
-        OV_ERROR_ADD_TRACE(err);
-        goto cleanup;
-      }
-      mime = *mime_buffer;
-    }
-    if (lua_get_bool_field(L, "temporary", false)) {
-      if (!gcmz_file_list_add_temporary(file_list, *path_buffer, mime, err)) {
-        OV_ERROR_ADD_TRACE(err);
-        goto cleanup;
-      }
-    } else {
-      if (!gcmz_file_list_add(file_list, *path_buffer, mime, err)) {
-        OV_ERROR_ADD_TRACE(err);
-        goto cleanup;
-      }
+  if (!gcmz_file_list_add_utf8(file_list,
+                               filepath,
+                               lua_get_string_field(L, "mimetype"),
+                               lua_get_bool_field(L, "temporary", false),
+                               err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  struct gcmz_object_info info = {0};
+  if (lua_get_object_info_field(L, filepath, &info)) {
+    struct gcmz_file *const file = gcmz_file_list_get_mutable(file_list, gcmz_file_list_count(file_list) - 1);
+    if (file) {
+      file->object_info = info;
+      file->has_object_info = true;
     }
   }
-
-  result = true;
-
-cleanup:
-  return result;
+  return true;
 }
 
 /**
@@ -352,14 +590,19 @@ cleanup:
  * {
  *   {filepath = "C:\\Path\\To\\File1.ext", mimetype = "image/png", temporary = false},
  *   {filepath = "C:\\Path\\To\\File2.ext", mimetype = "audio/wav", temporary = true},
+ *   {filepath = "C:\\Path\\To\\File3.object", temporary = true,
+ *    object_info = {filepath = "C:\\Path\\To\\File3.object", layer_min = 0, layer_max = 2}},
  *   ...
  * }
  * @endcode
  *
+ * Entry tables created by create_files_table with the given generation that were not modified by
+ * handlers are copied from file_list as is; only new or modified entries are converted from UTF-8.
  * Temporary files removed from the list are scheduled for delayed cleanup.
  *
  * @param L Lua state
  * @param table_index Stack index of the Lua table
+ * @param generation Generation returned by create_files_table for file_list
  * @param file_list File list to update
  * @param schedule_cleanup_callback Callback for scheduling cleanup (can be NULL)
  * @param userdata User data passed to callback
@@ -368,6 +611,7 @@ cleanup:
  */
 static bool update_file_list_from_table(lua_State *L,
                                         int table_index,
+                                        lua_Integer const generation,
                                         struct gcmz_file_list *const file_list,
                                         gcmz_lua_schedule_cleanup_callback schedule_cleanup_callback,
                                         void *userdata,
@@ -381,46 +625,79 @@ static bool update_file_list_from_table(lua_State *L,
     return true; // Not a table, no update needed
   }
 
-  wchar_t **new_paths = NULL;
-  size_t new_paths_count = 0;
-  wchar_t *path_buffer = NULL;
-  wchar_t *mime_buffer = NULL;
+  int const base_top = lua_gettop(L);
+  if (table_index < 0) {
+    table_index = base_top + table_index + 1;
+  }
+
+  struct gcmz_file_list *new_list = NULL;
+  int cache = 0;
+  int index = 0;
   bool result = false;
 
-  if (!collect_paths_from_table(L, table_index, &new_paths, &new_paths_count, err)) {
+  new_list = gcmz_file_list_create(err);
+  if (!new_list) {
     OV_ERROR_ADD_TRACE(err);
     goto cleanup;
   }
-  if (!schedule_removed_temp_files_cleanup(
-          file_list, new_paths, new_paths_count, schedule_cleanup_callback, userdata, err)) {
-    OV_ERROR_ADD_TRACE(err);
-    goto cleanup;
+
+  // The reverse index is only valid for the files table created from file_list
+  lua_getfield(L, LUA_REGISTRYINDEX, marshal_cache_key);
+  if (lua_istable(L, -1)) {
+    cache = lua_gettop(L);
+    lua_getfield(L, cache, "generation");
+    bool const current = lua_tointeger(L, -1) == generation;
+    lua_pop(L, 1);
+    if (current) {
+      lua_getfield(L, cache, "index");
+      index = lua_gettop(L);
+    }
   }
-  gcmz_file_list_clear(file_list);
+
   for (size_t i = 1, len = lua_objlen(L, table_index); i <= len; ++i) {
     lua_rawgeti(L, table_index, (int)i);
     if (!lua_istable(L, -1)) {
       lua_pop(L, 1);
       continue;
     }
-    if (!parse_and_add_file_entry(L, file_list, &path_buffer, &mime_buffer, err)) {
-      OV_ERROR_ADD_TRACE(err);
+    struct gcmz_file const *source = NULL;
+    if (index) {
+      lua_pushvalue(L, -1);
+      lua_rawget(L, index);
+      lua_Integer const n = lua_tointeger(L, -1);
       lua_pop(L, 1);
+      if (n > 0) {
+        source = gcmz_file_list_get(file_list, (size_t)(n - 1));
+        if (source && !is_marshaled_entry_clean(L, cache, lua_gettop(L), (int)n, source->temporary)) {
+          source = NULL;
+        }
+      }
+    }
+    if (source) {
+      if (!gcmz_file_list_add_copy(new_list, source, err)) {
+        OV_ERROR_ADD_TRACE(err);
+        goto cleanup;
+      }
+    } else if (!parse_and_add_file_entry(L, new_list, err)) {
+      OV_ERROR_ADD_TRACE(err);
       goto cleanup;
     }
     lua_pop(L, 1);
   }
 
+  if (!schedule_removed_temp_files_cleanup(file_list, new_list, schedule_cleanup_callback, userdata, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+  gcmz_file_list_swap(file_list, new_list);
+
   result = true;
 
 cleanup:
-  if (path_buffer) {
-    OV_ARRAY_DESTROY(&path_buffer);
-  }
-  if (mime_buffer) {
-    OV_ARRAY_DESTROY(&mime_buffer);
+  lua_settop(L, base_top);
+  if (new_list) {
+    gcmz_file_list_destroy(&new_list);
   }
-  free_collected_paths(&new_paths, new_paths_count);
   return result;
 }
 
@@ -455,20 +732,93 @@ static bool create_state_table(
   return true;
 }
 
+/**
+ * @brief Update the newest last write time with everything under a directory
+ *
+ * Creating, deleting or renaming an entry updates the last write time of its parent directory,
+ * so removed files are noticed as well. Errors are ignored; the stamp is only a hint.
+ *
+ * @param path [in/out] Directory path (OV_ARRAY, reused as a work buffer)
+ * @param path_len Length of the directory path in path
+ * @param newest [in/out] Newest last write time found so far
+ */
+static void update_newest_write_time(wchar_t **const path, size_t const path_len, FILETIME *const newest) {
+  if (!OV_ARRAY_GROW(path, path_len + 3)) {
+    return;
+  }
+  wcscpy(*path + path_len, L"\\*");
+  WIN32_FIND_DATAW find_data;
+  HANDLE const h = FindFirstFileW(*path, &find_data);
+  if (h == INVALID_HANDLE_VALUE) {
+    return;
+  }
+  do {
+    if (wcscmp(find_data.cFileName, L".") == 0 || wcscmp(find_data.cFileName, L"..") == 0) {
+      continue;
+    }
+    if (CompareFileTime(&find_data.ftLastWriteTime, newest) > 0) {
+      *newest = find_data.ftLastWriteTime;
+    }
+    if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+      size_t const name_len = wcslen(find_data.cFileName);
+      if (!OV_ARRAY_GROW(path, path_len + 1 + name_len + 3)) {
+        break;
+      }
+      (*path)[path_len] = L'\\';
+      wcscpy(*path + path_len + 1, find_data.cFileName);
+      update_newest_write_time(path, path_len + 1 + name_len, newest);
+    }
+  } while (FindNextFileW(h, &find_data));
+  FindClose(h);
+}
+
+/**
+ * @brief Push the stamp of a module found in the script directory
+ *
+ * The stamp changes whenever the module is modified, so entrypoint.reload_handlers can tell which modules to reload.
+ * A single file module is stamped with its size and last write time.
+ * A directory module is stamped with the newest last write time of all files and directories inside it.
+ *
+ * @param L Lua state
+ * @param find_data Entry of the module in the script directory
+ * @param dirpath [in/out] Path of the module directory (OV_ARRAY, reused as a work buffer), ignored for files
+ * @param dirpath_len Length of the directory path in dirpath
+ */
+static void push_module_stamp(lua_State *L,
+                              WIN32_FIND_DATAW const *const find_data,
+                              wchar_t **const dirpath,
+                              size_t const dirpath_len) {
+  if (find_data->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+    FILETIME newest = find_data->ftLastWriteTime;
+    update_newest_write_time(dirpath, dirpath_len, &newest);
+    lua_pushfstring(L, "%d:%d", (int)newest.dwHighDateTime, (int)newest.dwLowDateTime);
+    return;
+  }
+  lua_pushfstring(L,
+                  "%d:%d:%d",
+                  (int)find_data->ftLastWriteTime.dwHighDateTime,
+                  (int)find_data->ftLastWriteTime.dwLowDateTime,
+                  (int)find_data->nFileSizeLow);
+}
+
 /**
  * @brief Setup plugin loading paths and load modules from script directory
  *
  * Collects .lua file paths, directory/init.lua paths, and .dll paths,
- * then calls entrypoint.load_handlers to load them.
+ * then calls the given entrypoint function (load_handlers or reload_handlers) with them.
  * Note: package.path and package.cpath should already be configured before calling this.
  *
  * @param ctx Lua context (must have entrypoint_ref set)
  * @param script_dir Directory containing script modules
+ * @param loader Name of the entrypoint function receiving the module info
  * @param err [out] Error information on failure
  * @return true on success, false on failure
  */
-static bool setup_plugin_loading(struct gcmz_lua_context *ctx, wchar_t const *script_dir, struct ov_error *const err) {
-  if (!ctx || !ctx->L || !script_dir || ctx->entrypoint_ref == LUA_NOREF) {
+static bool setup_plugin_loading(struct gcmz_lua_context const *ctx,
+                                 wchar_t const *script_dir,
+                                 char const *const loader,
+                                 struct ov_error *const err) {
+  if (!ctx || !ctx->L || !script_dir || !loader || ctx->entrypoint_ref == LUA_NOREF) {
     OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
     return false;
   }
@@ -484,14 +834,14 @@ static bool setup_plugin_loading(struct gcmz_lua_context *ctx, wchar_t const *sc
   int file_count = 0;
 
   {
-    // Get entrypoint.load_handlers function
+    // Get entrypoint.load_handlers or entrypoint.reload_handlers function
     lua_rawgeti(L, LUA_REGISTRYINDEX, ctx->entrypoint_ref);
     if (!lua_istable(L, -1)) {
       lua_pop(L, 1);
       OV_ERROR_SET_GENERIC(err, ov_error_generic_unexpected);
       goto cleanup;
     }
-    lua_getfield(L, -1, "load_handlers");
+    lua_getfield(L, -1, loader);
     if (!lua_isfunction(L, -1)) {
       lua_pop(L, 2);
       OV_ERROR_SET_GENERIC(err, ov_error_generic_unexpected);
@@ -499,7 +849,7 @@ static bool setup_plugin_loading(struct gcmz_lua_context *ctx, wchar_t const *sc
     }
     lua_remove(L, -2); // Remove entrypoint, keep function
 
-    // Create table for module info: { { name = "modname", path = "filepath" }, ... }
+    // Create table for module info: { { name = "modname", path = "filepath", stamp = "..." }, ... }
     lua_newtable(L);
 
     // MAX_PATH is enough to avoid unnecessary reallocs
@@ -515,7 +865,7 @@ static bool setup_plugin_loading(struct gcmz_lua_context *ctx, wchar_t const *sc
     WIN32_FIND_DATAW find_data;
     find_handle = FindFirstFileW(filepath, &find_data);
     if (find_handle == INVALID_HANDLE_VALUE) {
-      // No files found, call load_handlers with empty table
+      // No files found, call the loader with empty table
       if (!gcmz_lua_pcall(L, 1, 0, err)) {
         OV_ERROR_ADD_TRACE(err);
         goto cleanup;
@@ -559,12 +909,14 @@ static bool setup_plugin_loading(struct gcmz_lua_context *ctx, wchar_t const *sc
             OV_ERROR_ADD_TRACE(err);
             goto cleanup;
           }
-          // Create { name = "modname", path = "filepath" }
+          // Create { name = "modname", path = "filepath", stamp = "..." }
           lua_newtable(L);
           lua_pushstring(L, utf8_modname);
           lua_setfield(L, -2, "name");
           lua_pushstring(L, utf8_path);
           lua_setfield(L, -2, "path");
+          push_module_stamp(L, &find_data, &filepath, script_dir_len + 1 + filename_len);
+          lua_setfield(L, -2, "stamp");
           lua_rawseti(L, -2, ++file_count);
         }
       } else {
@@ -594,17 +946,19 @@ static bool setup_plugin_loading(struct gcmz_lua_context *ctx, wchar_t const *sc
           OV_ERROR_ADD_TRACE(err);
           goto cleanup;
         }
-        // Create { name = "modname", path = "filepath" }
+        // Create { name = "modname", path = "filepath", stamp = "..." }
         lua_newtable(L);
         lua_pushstring(L, utf8_modname);
         lua_setfield(L, -2, "name");
         lua_pushstring(L, utf8_path);
         lua_setfield(L, -2, "path");
+        push_module_stamp(L, &find_data, NULL, 0);
+        lua_setfield(L, -2, "stamp");
         lua_rawseti(L, -2, ++file_count);
       }
     } while (FindNextFileW(find_handle, &find_data));
 
-    // Call load_handlers(modinfo)
+    // Call load_handlers(modinfo) or reload_handlers(modinfo)
     if (!gcmz_lua_pcall(L, 1, 0, err)) {
       OV_ERROR_ADD_TRACE(err);
       goto cleanup;
@@ -624,78 +978,438 @@ cleanup:
   if (utf8_path) {
     OV_ARRAY_DESTROY(&utf8_path);
   }
-  if (utf8_modname) {
-    OV_ARRAY_DESTROY(&utf8_modname);
+  if (utf8_modname) {
+    OV_ARRAY_DESTROY(&utf8_modname);
+  }
+  return result;
+}
+
+/**
+ * @brief Panic handler for states created without luaL_newstate
+ */
+static int panic_handler(lua_State *L) {
+  char const *const msg = lua_tostring(L, -1);
+  OutputDebugStringA("PANIC: unprotected error in call to Lua API: ");
+  OutputDebugStringA(msg ? msg : "(error object is not a string)");
+  OutputDebugStringA("\n");
+  return 0;
+}
+
+NODISCARD bool gcmz_lua_create(struct gcmz_lua_context **const ctx, struct ov_error *const err) {
+  if (!ctx || *ctx) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  struct gcmz_lua_context *c = NULL;
+  bool result = false;
+
+  {
+    if (!OV_REALLOC(&c, 1, sizeof(struct gcmz_lua_context))) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    *c = (struct gcmz_lua_context){.entrypoint_ref = LUA_NOREF};
+
+    c->marshal_snapshot = gcmz_file_list_create(err);
+    if (!c->marshal_snapshot) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+
+    c->file_list_ffi = gcmz_lua_file_list_ffi_create(err);
+    if (!c->file_list_ffi) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+
+    if (!OV_REALLOC(&c->memory, 1, sizeof(struct gcmz_lua_memory_stats))) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    *c->memory = (struct gcmz_lua_memory_stats){0};
+
+    c->alloc = gcmz_lua_alloc_create(err);
+    if (!c->alloc) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    c->L = lua_newstate(gcmz_lua_alloc_func, c->alloc);
+    if (c->L) {
+      lua_atpanic(c->L, panic_handler);
+    } else {
+      // 64-bit LuaJIT without GC64 cannot use a custom allocator, so run without memory accounting
+      gcmz_lua_alloc_destroy(&c->alloc);
+      c->L = luaL_newstate();
+    }
+    if (!c->L) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    luaL_openlibs(c->L);
+    gcmz_lua_setup_utf8_funcs(c->L);
+    gcmz_lua_json_register(c->L);
+
+    // Initialize math.randomseed
+    lua_getglobal(c->L, "math");
+    if (lua_istable(c->L, -1)) {
+      lua_getfield(c->L, -1, "randomseed");
+      if (lua_isfunction(c->L, -1)) {
+        uint64_t const seed = ov_rand_get_global_hint();
+        lua_pushnumber(c->L, (lua_Number)seed);
+        lua_call(c->L, 1, 0);
+      } else {
+        lua_pop(c->L, 1); // Pop non-function
+      }
+    }
+    lua_pop(c->L, 1); // Pop math
+  }
+
+  *ctx = c;
+  c = NULL;
+  result = true;
+
+cleanup:
+  if (c) {
+    if (c->L) {
+      lua_close(c->L);
+    }
+    gcmz_lua_alloc_destroy(&c->alloc);
+    if (c->memory) {
+      OV_FREE(&c->memory);
+    }
+    if (c->marshal_snapshot) {
+      gcmz_file_list_destroy(&c->marshal_snapshot);
+    }
+    gcmz_lua_file_list_ffi_destroy(&c->file_list_ffi);
+    OV_FREE(&c);
+  }
+  return result;
+}
+
+void gcmz_lua_destroy(struct gcmz_lua_context **const ctx) {
+  if (!ctx || !*ctx) {
+    return;
+  }
+
+  struct gcmz_lua_context *c = *ctx;
+  if (c->script_watch) {
+    FindCloseChangeNotification(c->script_watch);
+  }
+  if (c->script_dir) {
+    OV_ARRAY_DESTROY(&c->script_dir);
+  }
+  if (c->L) {
+    if (c->entrypoint_ref != LUA_NOREF) {
+      luaL_unref(c->L, LUA_REGISTRYINDEX, c->entrypoint_ref);
+    }
+    lua_close(c->L);
+  }
+  gcmz_lua_alloc_destroy(&c->alloc);
+  if (c->memory) {
+    OV_FREE(&c->memory);
+  }
+  if (c->marshal_snapshot) {
+    gcmz_file_list_destroy(&c->marshal_snapshot);
+  }
+  gcmz_lua_file_list_ffi_destroy(&c->file_list_ffi);
+  OV_FREE(ctx);
+}
+
+/**
+ * @brief Lua function returning a high-resolution timestamp in seconds
+ */
+static int profiler_clock(lua_State *L) {
+  static LARGE_INTEGER freq;
+  if (freq.QuadPart == 0) {
+    QueryPerformanceFrequency(&freq);
+  }
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  lua_pushnumber(L, (lua_Number)counter.QuadPart / (lua_Number)freq.QuadPart);
+  return 1;
+}
+
+/**
+ * @brief Configure the handler profiler of the entrypoint module
+ *
+ * @param ctx Lua context with the entrypoint module loaded
+ * @param slow_handler_threshold_ms Threshold for logging slow handler calls, 0 to disable
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+static bool setup_profiler(struct gcmz_lua_context *const ctx,
+                           int const slow_handler_threshold_ms,
+                           struct ov_error *const err) {
+  lua_State *L = ctx->L;
+  int base_top = lua_gettop(L);
+  bool result = false;
+
+  lua_rawgeti(L, LUA_REGISTRYINDEX, ctx->entrypoint_ref);
+  lua_getfield(L, -1, "set_profiler");
+  if (!lua_isfunction(L, -1)) {
+    result = true;
+    goto cleanup;
+  }
+  lua_pushcfunction(L, profiler_clock);
+  lua_pushinteger(L, slow_handler_threshold_ms);
+  if (!gcmz_lua_pcall(L, 2, 0, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+
+  result = true;
+
+cleanup:
+  lua_settop(L, base_top);
+  return result;
+}
+
+static char const watchdog_key[] = "gcmz_watchdog";
+
+enum {
+  // Number of VM instructions between deadline checks
+  watchdog_instruction_interval = 1000,
+};
+
+/**
+ * @brief Count hook that aborts the running handler once its deadline has passed
+ *
+ * Compiled traces do not call hooks, so the JIT compiler is turned off while the watchdog is armed.
+ * Traces compiled before that, outside of any handler call, still run unchecked.
+ */
+static void watchdog_hook(lua_State *L, lua_Debug *ar) {
+  (void)ar;
+  lua_getfield(L, LUA_REGISTRYINDEX, watchdog_key);
+  struct watchdog *const w = (struct watchdog *)lua_touserdata(L, -1);
+  lua_pop(L, 1);
+  if (!w || !w->armed) {
+    return;
+  }
+  LARGE_INTEGER now;
+  QueryPerformanceCounter(&now);
+  if (now.QuadPart < w->deadline.QuadPart) {
+    return;
+  }
+  w->fired = true;
+  lua_pushstring(L, "handler exceeded its time budget");
+  lua_error(L);
+}
+
+/**
+ * @brief Get whether the JIT compiler is currently on, as reported by jit.status()
+ */
+static bool jit_is_on(lua_State *L) {
+  bool on = false;
+  lua_getfield(L, LUA_REGISTRYINDEX, "_LOADED");
+  lua_getfield(L, -1, "jit");
+  if (lua_istable(L, -1)) {
+    lua_getfield(L, -1, "status");
+    if (lua_isfunction(L, -1)) {
+      lua_call(L, 0, 1);
+      on = lua_toboolean(L, -1) != 0;
+    }
+    lua_pop(L, 1);
   }
-  return result;
+  lua_pop(L, 2);
+  return on;
 }
 
-NODISCARD bool gcmz_lua_create(struct gcmz_lua_context **const ctx, struct ov_error *const err) {
-  if (!ctx || *ctx) {
-    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
-    return false;
+/**
+ * @brief Lua function calling a handler under a time budget
+ *
+ * guarded_pcall(ms, fn, ...) -> ok, result, timed_out
+ *
+ * Behaves like pcall(fn, ...) returning one result, and additionally returns true
+ * if the call was aborted because it ran longer than ms milliseconds.
+ * The hook is only installed while fn runs, so the caller's own code is never aborted.
+ * Only the outermost armed call turns the JIT compiler off and replaces the debug hook;
+ * both are put back as they were when it returns. A nested call never extends the
+ * deadline of the call it runs in.
+ *
+ * Upvalue 1: struct watchdog (lightuserdata)
+ */
+static int watchdog_pcall(lua_State *L) {
+  struct watchdog *const w = (struct watchdog *)lua_touserdata(L, lua_upvalueindex(1));
+  lua_Number const ms = luaL_checknumber(L, 1);
+  luaL_checktype(L, 2, LUA_TFUNCTION);
+  int const nargs = lua_gettop(L) - 2;
+
+  struct watchdog const outer = *w;
+  bool const arm = ms > 0;
+  bool const install = arm && !outer.armed;
+  lua_Hook prev_hook = NULL;
+  int prev_mask = 0;
+  int prev_count = 0;
+  bool prev_jit = false;
+  if (arm) {
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&w->deadline);
+    w->deadline.QuadPart += (LONGLONG)(ms * (lua_Number)freq.QuadPart / 1000);
+    if (outer.armed && outer.deadline.QuadPart < w->deadline.QuadPart) {
+      w->deadline = outer.deadline;
+    }
+    w->armed = true;
+    w->fired = false;
+  }
+  if (install) {
+    prev_hook = lua_gethook(L);
+    prev_mask = lua_gethookmask(L);
+    prev_count = lua_gethookcount(L);
+    prev_jit = jit_is_on(L);
+    if (prev_jit) {
+      luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_OFF);
+    }
+    lua_sethook(L, watchdog_hook, LUA_MASKCOUNT, watchdog_instruction_interval);
+  }
+  int const status = lua_pcall(L, nargs, 1, 0);
+  bool const fired = arm && w->fired;
+  if (install) {
+    lua_sethook(L, prev_hook, prev_mask, prev_count);
+    if (prev_jit) {
+      luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_ON);
+    }
+  }
+  if (arm) {
+    *w = outer;
   }
 
-  struct gcmz_lua_context *c = NULL;
-  bool result = false;
+  // Stack: ms, result
+  lua_pushboolean(L, status == 0);
+  lua_insert(L, -2);
+  lua_pushboolean(L, fired);
+  return 3;
+}
 
-  {
-    if (!OV_REALLOC(&c, 1, sizeof(struct gcmz_lua_context))) {
-      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
-      goto cleanup;
-    }
-    *c = (struct gcmz_lua_context){.entrypoint_ref = LUA_NOREF};
+/**
+ * @brief Configure the handler time budgets of the entrypoint module
+ *
+ * @param ctx Lua context with the entrypoint module loaded
+ * @param options Options containing the time budgets
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+static bool setup_watchdog(struct gcmz_lua_context *const ctx,
+                           struct gcmz_lua_options const *const options,
+                           struct ov_error *const err) {
+  lua_State *L = ctx->L;
+  int base_top = lua_gettop(L);
+  bool result = false;
 
-    c->L = luaL_newstate();
-    if (!c->L) {
-      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
-      goto cleanup;
-    }
-    luaL_openlibs(c->L);
-    gcmz_lua_setup_utf8_funcs(c->L);
+  ctx->watchdog = (struct watchdog){0};
+  lua_pushlightuserdata(L, &ctx->watchdog);
+  lua_setfield(L, LUA_REGISTRYINDEX, watchdog_key);
 
-    // Initialize math.randomseed
-    lua_getglobal(c->L, "math");
-    if (lua_istable(c->L, -1)) {
-      lua_getfield(c->L, -1, "randomseed");
-      if (lua_isfunction(c->L, -1)) {
-        uint64_t const seed = ov_rand_get_global_hint();
-        lua_pushnumber(c->L, (lua_Number)seed);
-        lua_call(c->L, 1, 0);
-      } else {
-        lua_pop(c->L, 1); // Pop non-function
-      }
-    }
-    lua_pop(c->L, 1); // Pop math
+  lua_rawgeti(L, LUA_REGISTRYINDEX, ctx->entrypoint_ref);
+  lua_getfield(L, -1, "set_watchdog");
+  if (!lua_isfunction(L, -1)) {
+    result = true;
+    goto cleanup;
+  }
+  lua_pushlightuserdata(L, &ctx->watchdog);
+  lua_pushcclosure(L, watchdog_pcall, 1);
+  lua_createtable(L, 0, 4);
+  LUA_SET_INT_FIELD(L, "drag_enter", options->drag_enter_budget_ms);
+  LUA_SET_INT_FIELD(L, "drag_leave", options->drag_leave_budget_ms);
+  LUA_SET_INT_FIELD(L, "drop", options->drop_budget_ms);
+  LUA_SET_INT_FIELD(L, "exo_convert", options->exo_convert_budget_ms);
+  if (!gcmz_lua_pcall(L, 2, 0, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
   }
 
-  *ctx = c;
-  c = NULL;
   result = true;
 
 cleanup:
-  if (c) {
-    if (c->L) {
-      lua_close(c->L);
-    }
-    OV_FREE(&c);
-  }
+  lua_settop(L, base_top);
   return result;
 }
 
-void gcmz_lua_destroy(struct gcmz_lua_context **const ctx) {
-  if (!ctx || !*ctx) {
-    return;
+/**
+ * @brief Lua function creating the files table from the file list of the running hook
+ *
+ * to_table() -> files, generation
+ *
+ * Upvalue 1: struct gcmz_lua_context (lightuserdata)
+ */
+static int file_list_to_table(lua_State *L) {
+  struct gcmz_lua_context const *const ctx = (struct gcmz_lua_context const *)lua_touserdata(L, lua_upvalueindex(1));
+  struct gcmz_file_list *const file_list = gcmz_lua_file_list_ffi_get_list(ctx->file_list_ffi);
+  if (!file_list) {
+    return luaL_error(L, "file list is only available while a hook is running");
+  }
+  struct ov_error err = {0};
+  lua_Integer generation = 0;
+  if (!create_files_table(L, ctx->marshal_snapshot, file_list, &generation, &err)) {
+    return gcmz_luafn_err(L, &err);
+  }
+  lua_pushinteger(L, generation);
+  return 2;
+}
+
+/**
+ * @brief Lua function writing a files table back to the file list of the running hook
+ *
+ * from_table(files, generation)
+ *
+ * Upvalue 1: struct gcmz_lua_context (lightuserdata)
+ */
+static int file_list_from_table(lua_State *L) {
+  struct gcmz_lua_context const *const ctx = (struct gcmz_lua_context const *)lua_touserdata(L, lua_upvalueindex(1));
+  struct gcmz_file_list *const file_list = gcmz_lua_file_list_ffi_get_list(ctx->file_list_ffi);
+  if (!file_list) {
+    return luaL_error(L, "file list is only available while a hook is running");
+  }
+  luaL_checktype(L, 1, LUA_TTABLE);
+  lua_Integer const generation = luaL_optinteger(L, 2, 0);
+  struct ov_error err = {0};
+  if (!update_file_list_from_table(L, 1, generation, file_list, ctx->schedule_cleanup_callback, ctx->userdata, &err)) {
+    return gcmz_luafn_err(L, &err);
   }
+  return 0;
+}
 
-  struct gcmz_lua_context *c = *ctx;
-  if (c->L) {
-    if (c->entrypoint_ref != LUA_NOREF) {
-      luaL_unref(c->L, LUA_REGISTRYINDEX, c->entrypoint_ref);
-    }
-    lua_close(c->L);
+/**
+ * @brief Hand the file list of hooks to the entrypoint module
+ *
+ * The entrypoint creates the files table only when a handler needs it, and passes handlers
+ * that opt in a LuaJIT FFI view of the file list instead.
+ * An entrypoint without set_file_list_source keeps receiving the files table.
+ *
+ * @param ctx Lua context with the entrypoint module loaded
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+static bool setup_file_list_source(struct gcmz_lua_context *const ctx, struct ov_error *const err) {
+  lua_State *L = ctx->L;
+  int base_top = lua_gettop(L);
+  bool result = false;
+
+  ctx->file_list_source = false;
+  lua_rawgeti(L, LUA_REGISTRYINDEX, ctx->entrypoint_ref);
+  lua_getfield(L, -1, "set_file_list_source");
+  if (!lua_isfunction(L, -1)) {
+    result = true;
+    goto cleanup;
   }
-  OV_FREE(ctx);
+  lua_pushlightuserdata(L, ctx);
+  lua_pushcclosure(L, file_list_to_table, 1);
+  lua_pushlightuserdata(L, ctx);
+  lua_pushcclosure(L, file_list_from_table, 1);
+  lua_pushlightuserdata(L, ov_deconster_(gcmz_lua_file_list_ffi_get_api()));
+  lua_pushlightuserdata(L, ctx->file_list_ffi);
+  if (!gcmz_lua_pcall(L, 4, 0, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+  ctx->file_list_source = true;
+
+  result = true;
+
+cleanup:
+  lua_settop(L, base_top);
+  return result;
 }
 
 NODISCARD bool gcmz_lua_setup(struct gcmz_lua_context *const ctx,
@@ -720,6 +1434,11 @@ NODISCARD bool gcmz_lua_setup(struct gcmz_lua_context *const ctx,
     }
   }
 
+  if (!gcmz_lua_set_bytecode_cache_dir(ctx->L, options->bytecode_cache_dir, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+
   // Setup package.path and package.cpath first (needed for require to work)
   if (!gcmz_wchar_to_utf8(options->script_dir, &utf8_dir, err)) {
     OV_ERROR_ADD_TRACE(err);
@@ -755,7 +1474,44 @@ NODISCARD bool gcmz_lua_setup(struct gcmz_lua_context *const ctx,
     goto cleanup;
   }
   ctx->entrypoint_ref = luaL_ref(ctx->L, LUA_REGISTRYINDEX);
-  if (!setup_plugin_loading(ctx, options->script_dir, err)) {
+  if (!setup_profiler(ctx, options->slow_handler_threshold_ms, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+  if (!setup_watchdog(ctx, options, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+  if (!setup_file_list_source(ctx, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+
+  {
+    size_t const script_dir_len = wcslen(options->script_dir);
+    if (!OV_ARRAY_GROW(&ctx->script_dir, script_dir_len + 1)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    wcscpy(ctx->script_dir, options->script_dir);
+  }
+  // Start watching before loading so that no change made in between is missed
+  if (options->watch_script_dir) {
+    HANDLE const h = FindFirstChangeNotificationW(
+        options->script_dir,
+        TRUE,
+        FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE);
+    if (h == INVALID_HANDLE_VALUE) {
+      // Handlers still work, they are just not reloaded automatically
+      struct ov_error watch_err = {0};
+      OV_ERROR_SET_HRESULT(&watch_err, HRESULT_FROM_WIN32(GetLastError()));
+      OV_ERROR_REPORT(&watch_err, "failed to watch the script directory for changes");
+    } else {
+      ctx->script_watch = h;
+    }
+  }
+
+  if (!setup_plugin_loading(ctx, options->script_dir, "load_handlers", err)) {
     OV_ERROR_ADD_TRACE(err);
     goto cleanup;
   }
@@ -776,6 +1532,54 @@ struct lua_State *gcmz_lua_get_state(struct gcmz_lua_context const *const ctx) {
   return ctx->L;
 }
 
+bool gcmz_lua_get_memory_stats(struct gcmz_lua_context const *const ctx, struct gcmz_lua_memory_stats *const stats) {
+  if (!ctx || !ctx->alloc || !stats) {
+    return false;
+  }
+  *stats = *ctx->memory;
+  gcmz_lua_alloc_get_stats(ctx->alloc, &stats->total);
+  return true;
+}
+
+NODISCARD bool gcmz_lua_reload_handlers(struct gcmz_lua_context const *const ctx, struct ov_error *const err) {
+  if (!ctx || !ctx->L) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+  if (ctx->entrypoint_ref == LUA_NOREF || !ctx->script_dir) {
+    return true; // Not set up, nothing to reload
+  }
+  // Handlers may require modules that were added since the directories were indexed
+  gcmz_lua_clear_module_search_cache(ctx->L);
+  if (!setup_plugin_loading(ctx, ctx->script_dir, "reload_handlers", err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Reload the handlers if the script directory changed since the last check
+ *
+ * Only called at the start of a drag session, when no handler is in the middle of a session.
+ * Failures are logged and the handlers that are already loaded stay in use.
+ *
+ * @param ctx Lua context
+ */
+static void reload_changed_handlers(struct gcmz_lua_context const *const ctx) {
+  if (!ctx->script_watch || WaitForSingleObject(ctx->script_watch, 0) != WAIT_OBJECT_0) {
+    return;
+  }
+  // Rearm before scanning so that changes made during the scan are caught next time
+  if (!FindNextChangeNotification(ctx->script_watch)) {
+    return;
+  }
+  struct ov_error err = {0};
+  if (!gcmz_lua_reload_handlers(ctx, &err)) {
+    OV_ERROR_REPORT(&err, "failed to reload handler scripts");
+  }
+}
+
 /**
  * Call drag_enter hook via Lua entrypoint module
  */
@@ -795,8 +1599,15 @@ NODISCARD bool gcmz_lua_call_drag_enter(struct gcmz_lua_context const *const ctx
 
   lua_State *L = ctx->L;
   int base_top = lua_gettop(L);
+  lua_Integer generation = 0;
   bool result = false;
 
+  // A new drag session starts here, so handlers can be replaced before any of them sees it
+  reload_changed_handlers(ctx);
+
+  gcmz_lua_alloc_hook_begin(ctx->alloc, &ctx->memory->drag_enter);
+  gcmz_lua_file_list_ffi_begin(ctx->file_list_ffi, file_list, ctx->schedule_cleanup_callback, ctx->userdata);
+
   // Get entrypoint.drag_enter from registry
   lua_rawgeti(L, LUA_REGISTRYINDEX, ctx->entrypoint_ref);
   if (!lua_istable(L, -1)) {
@@ -812,8 +1623,10 @@ NODISCARD bool gcmz_lua_call_drag_enter(struct gcmz_lua_context const *const ctx
   }
   lua_remove(L, -2); // Remove entrypoint, keep function
 
-  // Create files table
-  if (!create_files_table(L, file_list, err)) {
+  // Create files table, or pass nil to let the entrypoint take the file list when a handler needs it
+  if (ctx->file_list_source) {
+    lua_pushnil(L);
+  } else if (!create_files_table(L, ctx->marshal_snapshot, file_list, &generation, err)) {
     OV_ERROR_ADD_TRACE(err);
     goto cleanup;
   }
@@ -830,8 +1643,9 @@ NODISCARD bool gcmz_lua_call_drag_enter(struct gcmz_lua_context const *const ctx
     goto cleanup;
   }
 
-  // Update file_list from returned files table
-  if (!update_file_list_from_table(L, -1, file_list, ctx->schedule_cleanup_callback, ctx->userdata, err)) {
+  // Update file_list from returned files table, nil means the entrypoint has already updated it
+  if (!update_file_list_from_table(
+          L, -1, generation, file_list, ctx->schedule_cleanup_callback, ctx->userdata, err)) {
     OV_ERROR_ADD_TRACE(err);
     goto cleanup;
   }
@@ -840,6 +1654,8 @@ NODISCARD bool gcmz_lua_call_drag_enter(struct gcmz_lua_context const *const ctx
 
 cleanup:
   lua_settop(L, base_top);
+  gcmz_lua_file_list_ffi_end(ctx->file_list_ffi);
+  gcmz_lua_alloc_hook_end(ctx->alloc, &ctx->memory->drag_enter);
   return result;
 }
 
@@ -857,29 +1673,37 @@ NODISCARD bool gcmz_lua_call_drag_leave(struct gcmz_lua_context const *const ctx
 
   lua_State *L = ctx->L;
   int base_top = lua_gettop(L);
+  bool result = false;
+  gcmz_lua_alloc_hook_begin(ctx->alloc, &ctx->memory->drag_leave);
+
+  // The drag session ends here
+  reset_marshal_cache(L, ctx->marshal_snapshot);
 
   // Get entrypoint.drag_leave from registry
   lua_rawgeti(L, LUA_REGISTRYINDEX, ctx->entrypoint_ref);
   if (!lua_istable(L, -1)) {
-    lua_settop(L, base_top);
-    return true;
+    result = true;
+    goto cleanup;
   }
   lua_getfield(L, -1, "drag_leave");
   if (!lua_isfunction(L, -1)) {
-    lua_settop(L, base_top);
-    return true;
+    result = true;
+    goto cleanup;
   }
   lua_remove(L, -2); // Remove entrypoint, keep function
 
   // Call drag_leave()
   if (!gcmz_lua_pcall(L, 0, 0, err)) {
     OV_ERROR_ADD_TRACE(err);
-    lua_settop(L, base_top);
-    return false;
+    goto cleanup;
   }
 
+  result = true;
+
+cleanup:
   lua_settop(L, base_top);
-  return true;
+  gcmz_lua_alloc_hook_end(ctx->alloc, &ctx->memory->drag_leave);
+  return result;
 }
 
 /**
@@ -901,7 +1725,10 @@ NODISCARD bool gcmz_lua_call_drop(struct gcmz_lua_context const *const ctx,
 
   lua_State *L = ctx->L;
   int base_top = lua_gettop(L);
+  lua_Integer generation = 0;
   bool result = false;
+  gcmz_lua_alloc_hook_begin(ctx->alloc, &ctx->memory->drop);
+  gcmz_lua_file_list_ffi_begin(ctx->file_list_ffi, file_list, ctx->schedule_cleanup_callback, ctx->userdata);
 
   // Get entrypoint.drop from registry
   lua_rawgeti(L, LUA_REGISTRYINDEX, ctx->entrypoint_ref);
@@ -918,8 +1745,10 @@ NODISCARD bool gcmz_lua_call_drop(struct gcmz_lua_context const *const ctx,
   }
   lua_remove(L, -2); // Remove entrypoint, keep function
 
-  // Create files table
-  if (!create_files_table(L, file_list, err)) {
+  // Create files table, or pass nil to let the entrypoint take the file list when a handler needs it
+  if (ctx->file_list_source) {
+    lua_pushnil(L);
+  } else if (!create_files_table(L, ctx->marshal_snapshot, file_list, &generation, err)) {
     OV_ERROR_ADD_TRACE(err);
     goto cleanup;
   }
@@ -936,8 +1765,9 @@ NODISCARD bool gcmz_lua_call_drop(struct gcmz_lua_context const *const ctx,
     goto cleanup;
   }
 
-  // Update file_list from returned files table
-  if (!update_file_list_from_table(L, -1, file_list, ctx->schedule_cleanup_callback, ctx->userdata, err)) {
+  // Update file_list from returned files table, nil means the entrypoint has already updated it
+  if (!update_file_list_from_table(
+          L, -1, generation, file_list, ctx->schedule_cleanup_callback, ctx->userdata, err)) {
     OV_ERROR_ADD_TRACE(err);
     goto cleanup;
   }
@@ -946,6 +1776,10 @@ NODISCARD bool gcmz_lua_call_drop(struct gcmz_lua_context const *const ctx,
 
 cleanup:
   lua_settop(L, base_top);
+  gcmz_lua_file_list_ffi_end(ctx->file_list_ffi);
+  // The drag session ends with the drop
+  reset_marshal_cache(L, ctx->marshal_snapshot);
+  gcmz_lua_alloc_hook_end(ctx->alloc, &ctx->memory->drop);
   return result;
 }
 
@@ -965,7 +1799,9 @@ NODISCARD bool gcmz_lua_call_exo_convert(struct gcmz_lua_context const *const ct
 
   lua_State *L = ctx->L;
   int base_top = lua_gettop(L);
+  lua_Integer generation = 0;
   bool result = false;
+  gcmz_lua_alloc_hook_begin(ctx->alloc, &ctx->memory->exo_convert);
 
   // Get entrypoint.exo_convert from registry
   lua_rawgeti(L, LUA_REGISTRYINDEX, ctx->entrypoint_ref);
@@ -983,7 +1819,7 @@ NODISCARD bool gcmz_lua_call_exo_convert(struct gcmz_lua_context const *const ct
   lua_remove(L, -2); // Remove entrypoint, keep function
 
   // Create files table
-  if (!create_files_table(L, file_list, err)) {
+  if (!create_files_table(L, ctx->marshal_snapshot, file_list, &generation, err)) {
     OV_ERROR_ADD_TRACE(err);
     goto cleanup;
   }
@@ -995,7 +1831,8 @@ NODISCARD bool gcmz_lua_call_exo_convert(struct gcmz_lua_context const *const ct
   }
 
   // Update file_list from returned files table
-  if (!update_file_list_from_table(L, -1, file_list, ctx->schedule_cleanup_callback, ctx->userdata, err)) {
+  if (!update_file_list_from_table(
+          L, -1, generation, file_list, ctx->schedule_cleanup_callback, ctx->userdata, err)) {
     OV_ERROR_ADD_TRACE(err);
     goto cleanup;
   }
@@ -1004,6 +1841,7 @@ NODISCARD bool gcmz_lua_call_exo_convert(struct gcmz_lua_context const *const ct
 
 cleanup:
   lua_settop(L, base_top);
+  gcmz_lua_alloc_hook_end(ctx->alloc, &ctx->memory->exo_convert);
   return result;
 }
 
@@ -1174,6 +2012,86 @@ cleanup:
   return result;
 }
 
+/**
+ * @brief Callback wrapper for enum_handler_stats Lua call
+ */
+struct enum_handler_stats_context {
+  gcmz_lua_handler_stats_enum_callback callback;
+  void *userdata;
+  bool continue_enum;
+};
+
+static int enum_handler_stats_callback(lua_State *L) {
+  struct enum_handler_stats_context *ctx =
+      (struct enum_handler_stats_context *)lua_touserdata(L, lua_upvalueindex(1));
+  if (!ctx || !ctx->callback || !ctx->continue_enum) {
+    return 0;
+  }
+
+  struct gcmz_lua_handler_stats const stats = {
+      .name = lua_isstring(L, 1) ? lua_tostring(L, 1) : "",
+      .hook = lua_isstring(L, 2) ? lua_tostring(L, 2) : "",
+      .count = lua_isnumber(L, 3) ? (size_t)lua_tonumber(L, 3) : 0,
+      .total_ms = lua_isnumber(L, 4) ? (double)lua_tonumber(L, 4) : 0.0,
+      .max_ms = lua_isnumber(L, 5) ? (double)lua_tonumber(L, 5) : 0.0,
+      .p95_ms = lua_isnumber(L, 6) ? (double)lua_tonumber(L, 6) : 0.0,
+  };
+  if (!ctx->callback(&stats, ctx->userdata)) {
+    ctx->continue_enum = false;
+  }
+  return 0;
+}
+
+NODISCARD bool gcmz_lua_enum_handler_stats(struct gcmz_lua_context const *const ctx,
+                                           gcmz_lua_handler_stats_enum_callback callback,
+                                           void *userdata,
+                                           struct ov_error *const err) {
+  if (!ctx || !ctx->L || !callback || ctx->entrypoint_ref == LUA_NOREF) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  lua_State *L = ctx->L;
+  int base_top = lua_gettop(L);
+  bool result = false;
+
+  {
+    // Call entrypoint.enum_handler_stats(callback_fn)
+    lua_rawgeti(L, LUA_REGISTRYINDEX, ctx->entrypoint_ref);
+    if (!lua_istable(L, -1)) {
+      lua_pop(L, 1);
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_unexpected);
+      goto cleanup;
+    }
+    lua_getfield(L, -1, "enum_handler_stats");
+    if (!lua_isfunction(L, -1)) {
+      lua_pop(L, 2);
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_unexpected);
+      goto cleanup;
+    }
+    lua_remove(L, -2); // Remove entrypoint, keep function
+
+    struct enum_handler_stats_context enum_ctx = {
+        .callback = callback,
+        .userdata = userdata,
+        .continue_enum = true,
+    };
+    lua_pushlightuserdata(L, &enum_ctx);
+    lua_pushcclosure(L, enum_handler_stats_callback, 1);
+
+    if (!gcmz_lua_pcall(L, 1, 0, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+  }
+
+  result = true;
+
+cleanup:
+  lua_settop(L, base_top);
+  return result;
+}
+
 static char const script_modules_key[] = "gcmz_script_modules";
 static char const script_module_mt[] = "gcmz_script_module_mt";
 
@@ -1183,11 +2101,12 @@ char const *gcmz_lua_get_script_modules_key(void) { return script_modules_key; }
  * @brief C closure that wraps a script module function
  *
  * Upvalue 1: function pointer (lightuserdata)
+ * Upvalue 2: whether numeric arrays are returned as FFI arrays (boolean)
  */
 static int script_module_function_wrapper(lua_State *const L) {
   void (*func)(struct aviutl2_script_module_param *) =
       (void (*)(struct aviutl2_script_module_param *))lua_touserdata(L, lua_upvalueindex(1));
-  return script_module_param_call(L, func);
+  return script_module_param_call(L, func, lua_toboolean(L, lua_upvalueindex(2)) != 0);
 }
 
 /**
@@ -1241,8 +2160,10 @@ bool gcmz_lua_register_script_module(struct gcmz_lua_context *const ctx,
     // Stack: [modules_table, wrapper_table]
 
     // Create the module table (the actual table that holds functions)
+    // and its variant that returns numeric arrays as FFI arrays
+    lua_newtable(L);
     lua_newtable(L);
-    // Stack: [modules_table, wrapper_table, module_table]
+    // Stack: [modules_table, wrapper_table, module_table, ffi_module_table]
 
     // Add functions to the module table
     for (struct aviutl2_script_module_function const *f = table->functions; f && f->name; ++f) {
@@ -1264,12 +2185,17 @@ bool gcmz_lua_register_script_module(struct gcmz_lua_context *const ctx,
       }
       ov_wchar_to_utf8(f->name, wlen, func_name_utf8, utf8_len + 1, NULL);
 
-      // Create closure with function pointer as upvalue
+      // Create closures with function pointer as upvalue
+      lua_pushlightuserdata(L, (void *)f->func);
+      lua_pushboolean(L, 0);
+      lua_pushcclosure(L, script_module_function_wrapper, 2);
+      lua_setfield(L, -3, func_name_utf8);
       lua_pushlightuserdata(L, (void *)f->func);
-      lua_pushcclosure(L, script_module_function_wrapper, 1);
+      lua_pushboolean(L, 1);
+      lua_pushcclosure(L, script_module_function_wrapper, 2);
       lua_setfield(L, -2, func_name_utf8);
     }
-    // Stack: [modules_table, wrapper_table, module_table]
+    // Stack: [modules_table, wrapper_table, module_table, ffi_module_table]
 
     // Create metatable for protection
     luaL_getmetatable(L, script_module_mt);
@@ -1282,10 +2208,13 @@ bool gcmz_lua_register_script_module(struct gcmz_lua_context *const ctx,
       lua_pushboolean(L, 0);
       lua_setfield(L, -2, "__metatable");
     }
-    lua_setmetatable(L, -2);
-    // Stack: [modules_table, wrapper_table, module_table (with metatable)]
+    lua_pushvalue(L, -1);
+    lua_setmetatable(L, -3);
+    lua_setmetatable(L, -3);
+    // Stack: [modules_table, wrapper_table, module_table, ffi_module_table (with metatable)]
 
-    // Store module_table in wrapper_table.table
+    // Store ffi_module_table in wrapper_table.ffi_table and module_table in wrapper_table.table
+    lua_setfield(L, -3, "ffi_table");
     lua_setfield(L, -2, "table");
     // Stack: [modules_table, wrapper_table]
 
@@ -2,6 +2,8 @@
 
 #include <ovbase.h>
 
+#include "lua_alloc.h"
+
 struct gcmz_file_list;
 struct gcmz_lua_context;
 struct lua_State;
@@ -50,7 +52,8 @@ typedef char *(*gcmz_lua_create_temp_file_callback)(void *userdata, char const *
  * @brief Options for creating Lua context
  */
 struct gcmz_lua_options {
-  wchar_t const *script_dir; ///< Directory path to scan for requireable modules (can be NULL for no plugins)
+  wchar_t const *script_dir;         ///< Directory path to scan for requireable modules (can be NULL for no plugins)
+  wchar_t const *bytecode_cache_dir; ///< Existing directory for compiled script cache (can be NULL to disable)
   gcmz_lua_api_register_callback
       api_register_callback; ///< Callback function to register APIs (can be NULL to skip API registration)
   gcmz_lua_schedule_cleanup_callback
@@ -58,6 +61,12 @@ struct gcmz_lua_options {
   gcmz_lua_create_temp_file_callback
       create_temp_file_callback; ///< Callback for creating temporary files (required for EXO conversion)
   void *userdata;                ///< User data passed to all callback functions
+  int slow_handler_threshold_ms; ///< Handler calls taking at least this long are logged via debug_print (0 to disable)
+  int drag_enter_budget_ms;      ///< Time budget of a single drag_enter handler call (0 for no limit)
+  int drag_leave_budget_ms;      ///< Time budget of a single drag_leave handler call (0 for no limit)
+  int drop_budget_ms;            ///< Time budget of a single drop handler call (0 for no limit)
+  int exo_convert_budget_ms;     ///< Time budget of the EXO conversion (0 for no limit)
+  bool watch_script_dir;         ///< Reload changed handler scripts when the next drag session starts
 };
 
 /**
@@ -96,10 +105,49 @@ void gcmz_lua_destroy(struct gcmz_lua_context **const ctx);
  */
 struct lua_State *gcmz_lua_get_state(struct gcmz_lua_context const *const ctx);
 
+/**
+ * @brief Memory usage of the Lua state
+ */
+struct gcmz_lua_memory_stats {
+  struct gcmz_lua_alloc_stats total;            ///< Counters since the context was created
+  struct gcmz_lua_alloc_hook_stats drag_enter;  ///< Last drag_enter invocation
+  struct gcmz_lua_alloc_hook_stats drag_leave;  ///< Last drag_leave invocation
+  struct gcmz_lua_alloc_hook_stats drop;        ///< Last drop invocation
+  struct gcmz_lua_alloc_hook_stats exo_convert; ///< Last exo_convert invocation
+};
+
+/**
+ * @brief Get memory counters of the Lua state
+ *
+ * Counters are only available when the state runs on the pooled allocator.
+ * LuaJIT builds that cannot use a custom allocator fall back to the default one without accounting.
+ *
+ * @param ctx Lua context instance
+ * @param stats [out] Memory counters
+ * @return true if counters are available, false otherwise
+ */
+bool gcmz_lua_get_memory_stats(struct gcmz_lua_context const *const ctx, struct gcmz_lua_memory_stats *const stats);
+
+/**
+ * @brief Reload the handler modules that changed in the script directory
+ *
+ * Rescans the script directory and reloads only the modules that were added, modified or removed
+ * since they were loaded, clearing their package.loaded entries first.
+ * Other handlers keep their module tables and state, and handlers added from scripts are not affected.
+ * Must not be called in the middle of a drag session.
+ *
+ * @param ctx Lua context instance
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+NODISCARD bool gcmz_lua_reload_handlers(struct gcmz_lua_context const *const ctx, struct ov_error *const err);
+
 /**
  * @brief Call drag_enter hook on all loaded modules in priority order
  *
  * Modules can modify the file list by returning a new file table.
+ * When watch_script_dir is set and the script directory changed, the changed handlers are reloaded first.
+ * A handler running longer than drag_enter_budget_ms is aborted and skipped for the rest of the drag session.
  *
  * @param ctx Lua context instance
  * @param file_list File list from drop operation (will be modified in-place if modules return new files)
@@ -228,6 +276,44 @@ NODISCARD bool gcmz_lua_enum_handlers(struct gcmz_lua_context const *const ctx,
                                       void *userdata,
                                       struct ov_error *const err);
 
+/**
+ * @brief Execution statistics of a handler hook
+ */
+struct gcmz_lua_handler_stats {
+  char const *name; ///< Handler name (UTF-8)
+  char const *hook; ///< Hook name such as "drag_enter" or "drop"
+  size_t count;     ///< Number of calls
+  double total_ms;  ///< Total execution time in milliseconds
+  double max_ms;    ///< Longest execution time in milliseconds
+  double p95_ms;    ///< 95th percentile of recent execution times in milliseconds
+};
+
+/**
+ * @brief Callback function type for enumerating handler execution statistics
+ *
+ * @param stats Statistics of a handler hook, valid only during the callback
+ * @param userdata User-defined context
+ * @return true to continue enumeration, false to stop
+ */
+typedef bool (*gcmz_lua_handler_stats_enum_callback)(struct gcmz_lua_handler_stats const *stats, void *userdata);
+
+/**
+ * @brief Enumerate execution statistics of the handler modules
+ *
+ * Every call of drag_enter, drag_leave, drop and exo_convert made through the entrypoint module is timed.
+ * Entries are enumerated sorted by handler name and hook name.
+ *
+ * @param ctx Lua context instance
+ * @param callback Callback function to call for each handler hook
+ * @param userdata User-defined context passed to callback
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+NODISCARD bool gcmz_lua_enum_handler_stats(struct gcmz_lua_context const *const ctx,
+                                           gcmz_lua_handler_stats_enum_callback callback,
+                                           void *userdata,
+                                           struct ov_error *const err);
+
 /**
  * @brief Get the registry key for script modules table
  *
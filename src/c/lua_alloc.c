@@ -0,0 +1,222 @@
+#include "lua_alloc.h"
+
+#include <ovarray.h>
+
+#include <string.h>
+
+enum {
+  granularity = 16,
+  max_pooled_size = 512,
+  class_count = max_pooled_size / granularity,
+  slab_size = 64 * 1024,
+  slab_header_size = 16, // Keeps blocks aligned to granularity
+};
+
+struct block {
+  struct block *next;
+};
+
+struct slab {
+  struct slab *next;
+};
+
+struct gcmz_lua_alloc {
+  struct block *free_lists[class_count];
+  struct slab *slabs;
+  char *cursor; // Unused part of the newest slab
+  char *end;
+
+  void **adopted; // Heap blocks kept for a pooled size when a shrink could not move them, freed on destroy
+
+  struct gcmz_lua_alloc_stats stats;
+  size_t hook_peak_bytes;
+};
+
+static inline bool is_pooled(size_t const size) { return size <= max_pooled_size; }
+
+static inline size_t size_class(size_t const size) { return (size - 1) / granularity; }
+
+static bool add_slab(struct gcmz_lua_alloc *const a) {
+  struct slab *s = NULL;
+  if (!OV_REALLOC(&s, 1, slab_size)) {
+    return false;
+  }
+  s->next = a->slabs;
+  a->slabs = s;
+  a->cursor = (char *)s + slab_header_size;
+  a->end = (char *)s + slab_size;
+  a->stats.pooled_bytes += slab_size;
+  return true;
+}
+
+static void *acquire(struct gcmz_lua_alloc *const a, size_t const size) {
+  if (!is_pooled(size)) {
+    void *p = NULL;
+    if (!OV_REALLOC(&p, size, 1)) {
+      return NULL;
+    }
+    return p;
+  }
+  size_t const cls = size_class(size);
+  struct block *const b = a->free_lists[cls];
+  if (b) {
+    a->free_lists[cls] = b->next;
+    return b;
+  }
+  size_t const block_size = (cls + 1) * granularity;
+  if ((size_t)(a->end - a->cursor) < block_size) {
+    // The tail of the previous slab is abandoned, it is smaller than max_pooled_size
+    if (!add_slab(a)) {
+      return NULL;
+    }
+  }
+  void *const p = a->cursor;
+  a->cursor += block_size;
+  return p;
+}
+
+static void release(struct gcmz_lua_alloc *const a, void *ptr, size_t const size) {
+  if (!is_pooled(size)) {
+    OV_FREE(&ptr);
+    return;
+  }
+  size_t const cls = size_class(size);
+  struct block *const b = (struct block *)ptr;
+  b->next = a->free_lists[cls];
+  a->free_lists[cls] = b;
+}
+
+static inline void update_live_bytes(struct gcmz_lua_alloc *const a, size_t const osize, size_t const nsize) {
+  a->stats.live_bytes = a->stats.live_bytes - osize + nsize;
+  if (a->stats.live_bytes > a->stats.peak_bytes) {
+    a->stats.peak_bytes = a->stats.live_bytes;
+  }
+  if (a->stats.live_bytes > a->hook_peak_bytes) {
+    a->hook_peak_bytes = a->stats.live_bytes;
+  }
+}
+
+void *gcmz_lua_alloc_func(void *ud, void *ptr, size_t osize, size_t nsize) {
+  struct gcmz_lua_alloc *const a = (struct gcmz_lua_alloc *)ud;
+  if (nsize == 0) {
+    if (ptr) {
+      release(a, ptr, osize);
+      update_live_bytes(a, osize, 0);
+      ++a->stats.frees;
+    }
+    return NULL;
+  }
+  if (!ptr) {
+    void *const p = acquire(a, nsize);
+    if (p) {
+      update_live_bytes(a, 0, nsize);
+      ++a->stats.allocations;
+    }
+    return p;
+  }
+
+  void *p = NULL;
+  if (is_pooled(osize) && is_pooled(nsize) && size_class(osize) == size_class(nsize)) {
+    p = ptr;
+  } else if (!is_pooled(osize) && !is_pooled(nsize)) {
+    p = ptr;
+    if (!OV_REALLOC(&p, nsize, 1)) {
+      if (nsize > osize) {
+        return NULL;
+      }
+      p = ptr;
+    }
+  } else {
+    p = acquire(a, nsize);
+    if (p) {
+      memcpy(p, ptr, osize < nsize ? osize : nsize);
+      release(a, ptr, osize);
+    } else if (nsize > osize) {
+      return NULL;
+    } else {
+      // lua_Alloc must not fail when shrinking, so keep the block where it is.
+      // A smaller pooled size is fine, the block is at least as large as its new class.
+      // A heap block now belongs to the pool; it is remembered so destroy can free it.
+      // If even that bookkeeping fails, the block stays in the pool until the process exits.
+      p = ptr;
+      if (!is_pooled(osize)) {
+        size_t const n = OV_ARRAY_LENGTH(a->adopted);
+        if (OV_ARRAY_GROW(&a->adopted, n + 1)) {
+          a->adopted[n] = ptr;
+          OV_ARRAY_SET_LENGTH(a->adopted, n + 1);
+        }
+      }
+    }
+  }
+  update_live_bytes(a, osize, nsize);
+  ++a->stats.reallocations;
+  return p;
+}
+
+NODISCARD struct gcmz_lua_alloc *gcmz_lua_alloc_create(struct ov_error *const err) {
+  struct gcmz_lua_alloc *a = NULL;
+  if (!OV_REALLOC(&a, 1, sizeof(struct gcmz_lua_alloc))) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return NULL;
+  }
+  *a = (struct gcmz_lua_alloc){0};
+  return a;
+}
+
+void gcmz_lua_alloc_destroy(struct gcmz_lua_alloc **const alloc) {
+  if (!alloc || !*alloc) {
+    return;
+  }
+  struct gcmz_lua_alloc *const a = *alloc;
+  while (a->slabs) {
+    struct slab *s = a->slabs;
+    a->slabs = s->next;
+    OV_FREE(&s);
+  }
+  if (a->adopted) {
+    size_t const n = OV_ARRAY_LENGTH(a->adopted);
+    for (size_t i = 0; i < n; ++i) {
+      OV_FREE(&a->adopted[i]);
+    }
+    OV_ARRAY_DESTROY(&a->adopted);
+  }
+  OV_FREE(alloc);
+}
+
+void gcmz_lua_alloc_get_stats(struct gcmz_lua_alloc const *const alloc, struct gcmz_lua_alloc_stats *const stats) {
+  if (!alloc || !stats) {
+    return;
+  }
+  *stats = alloc->stats;
+}
+
+void gcmz_lua_alloc_hook_begin(struct gcmz_lua_alloc *const alloc, struct gcmz_lua_alloc_hook_stats *const stats) {
+  if (!alloc || !stats) {
+    return;
+  }
+  // Counters hold the starting values until gcmz_lua_alloc_hook_end turns them into differences.
+  // peak_bytes holds the peak of an enclosing measurement, which is restored at the end so calls can nest.
+  *stats = (struct gcmz_lua_alloc_hook_stats){
+      .live_bytes_before = alloc->stats.live_bytes,
+      .peak_bytes = alloc->hook_peak_bytes,
+      .allocations = alloc->stats.allocations,
+      .reallocations = alloc->stats.reallocations,
+      .frees = alloc->stats.frees,
+  };
+  alloc->hook_peak_bytes = alloc->stats.live_bytes;
+}
+
+void gcmz_lua_alloc_hook_end(struct gcmz_lua_alloc *const alloc, struct gcmz_lua_alloc_hook_stats *const stats) {
+  if (!alloc || !stats) {
+    return;
+  }
+  size_t const outer_peak_bytes = stats->peak_bytes;
+  stats->live_bytes_after = alloc->stats.live_bytes;
+  stats->peak_bytes = alloc->hook_peak_bytes;
+  if (outer_peak_bytes > alloc->hook_peak_bytes) {
+    alloc->hook_peak_bytes = outer_peak_bytes;
+  }
+  stats->allocations = alloc->stats.allocations - stats->allocations;
+  stats->reallocations = alloc->stats.reallocations - stats->reallocations;
+  stats->frees = alloc->stats.frees - stats->frees;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <ovbase.h>
+
+struct gcmz_lua_alloc;
+
+/**
+ * @brief Memory counters of a pooled Lua allocator
+ *
+ * Byte counts are the sizes requested by Lua, not including pool overhead.
+ */
+struct gcmz_lua_alloc_stats {
+  size_t live_bytes;    ///< Bytes currently held by the Lua state
+  size_t peak_bytes;    ///< Highest live_bytes observed since creation
+  size_t pooled_bytes;  ///< Bytes reserved for small blocks
+  size_t allocations;   ///< Number of blocks allocated
+  size_t reallocations; ///< Number of blocks resized
+  size_t frees;         ///< Number of blocks freed
+};
+
+/**
+ * @brief Memory counters of a single hook invocation
+ */
+struct gcmz_lua_alloc_hook_stats {
+  size_t live_bytes_before; ///< live_bytes when the hook started
+  size_t live_bytes_after;  ///< live_bytes when the hook finished
+  size_t peak_bytes;        ///< Highest live_bytes observed while the hook was running
+  size_t allocations;       ///< Number of blocks allocated while the hook was running
+  size_t reallocations;     ///< Number of blocks resized while the hook was running
+  size_t frees;             ///< Number of blocks freed while the hook was running
+};
+
+/**
+ * @brief Create a pooled allocator for a Lua state
+ *
+ * Small blocks are served from size-class free lists carved out of larger slabs,
+ * so the strings and tables churned by handlers do not hit the system heap each time.
+ * Larger blocks are passed through to the system heap.
+ * Slabs are only released when the allocator is destroyed.
+ *
+ * The allocator is not thread-safe; it must be used by a single Lua state.
+ *
+ * @param err [out] Error information on failure
+ * @return Created allocator, NULL on failure
+ */
+NODISCARD struct gcmz_lua_alloc *gcmz_lua_alloc_create(struct ov_error *const err);
+
+/**
+ * @brief Destroy a pooled allocator
+ *
+ * The Lua state using the allocator must be closed beforehand.
+ *
+ * @param alloc [in,out] Allocator to destroy, set to NULL on return
+ */
+void gcmz_lua_alloc_destroy(struct gcmz_lua_alloc **const alloc);
+
+/**
+ * @brief Allocation function compatible with lua_Alloc
+ *
+ * Pass this to lua_newstate together with the allocator as the userdata.
+ *
+ * @param ud Allocator created by gcmz_lua_alloc_create
+ * @param ptr Block to resize or free, NULL to allocate
+ * @param osize Current size of ptr
+ * @param nsize Requested size, 0 to free
+ * @return Allocated block, or NULL when freed or on failure
+ */
+void *gcmz_lua_alloc_func(void *ud, void *ptr, size_t osize, size_t nsize);
+
+/**
+ * @brief Get the counters accumulated since the allocator was created
+ *
+ * @param alloc Allocator instance
+ * @param stats [out] Counters
+ */
+void gcmz_lua_alloc_get_stats(struct gcmz_lua_alloc const *const alloc, struct gcmz_lua_alloc_stats *const stats);
+
+/**
+ * @brief Start measuring a hook invocation
+ *
+ * Records the current counters into stats and restarts peak tracking.
+ * Must be paired with gcmz_lua_alloc_hook_end on the same stats.
+ * Measurements may nest; the enclosing one still sees the peak reached by the inner one.
+ *
+ * @param alloc Allocator instance
+ * @param stats [out] Measurement in progress
+ */
+void gcmz_lua_alloc_hook_begin(struct gcmz_lua_alloc *const alloc, struct gcmz_lua_alloc_hook_stats *const stats);
+
+/**
+ * @brief Finish measuring a hook invocation
+ *
+ * @param alloc Allocator instance
+ * @param stats [in,out] Measurement started by gcmz_lua_alloc_hook_begin, completed on return
+ */
+void gcmz_lua_alloc_hook_end(struct gcmz_lua_alloc *const alloc, struct gcmz_lua_alloc_hook_stats *const stats);
@@ -0,0 +1,160 @@
+#include <ovtest.h>
+
+#include <string.h>
+
+#include "lua_alloc.h"
+
+static void test_lua_alloc_pool(void) {
+  struct gcmz_lua_alloc *alloc = NULL;
+  struct ov_error err = {0};
+
+  alloc = gcmz_lua_alloc_create(&err);
+  if (!TEST_SUCCEEDED(alloc != NULL, &err)) {
+    return;
+  }
+
+  // Freed small blocks are reused for the same size class
+  void *const a = gcmz_lua_alloc_func(alloc, NULL, 0, 24);
+  void *const b = gcmz_lua_alloc_func(alloc, NULL, 0, 24);
+  if (!TEST_CHECK(a != NULL && b != NULL && a != b)) {
+    goto cleanup;
+  }
+  memset(a, 0xaa, 24);
+  memset(b, 0xbb, 24);
+  TEST_CHECK(gcmz_lua_alloc_func(alloc, a, 24, 0) == NULL);
+  void *const c = gcmz_lua_alloc_func(alloc, NULL, 0, 30);
+  TEST_CHECK(c == a);
+
+  // Resizing within the same size class keeps the block
+  TEST_CHECK(gcmz_lua_alloc_func(alloc, c, 30, 32) == c);
+
+  // Resizing across size classes moves the contents
+  void *const d = gcmz_lua_alloc_func(alloc, b, 24, 4096);
+  if (!TEST_CHECK(d != NULL)) {
+    goto cleanup;
+  }
+  TEST_CHECK(((unsigned char *)d)[0] == 0xbb && ((unsigned char *)d)[23] == 0xbb);
+  void *const e = gcmz_lua_alloc_func(alloc, d, 4096, 8192);
+  if (!TEST_CHECK(e != NULL)) {
+    goto cleanup;
+  }
+  TEST_CHECK(((unsigned char *)e)[23] == 0xbb);
+
+  {
+    struct gcmz_lua_alloc_stats stats = {0};
+    gcmz_lua_alloc_get_stats(alloc, &stats);
+    TEST_CHECK(stats.live_bytes == 32 + 8192);
+    TEST_MSG("want %zu, got %zu", (size_t)(32 + 8192), stats.live_bytes);
+    TEST_CHECK(stats.peak_bytes == 32 + 8192);
+    TEST_CHECK(stats.allocations == 3);
+    TEST_CHECK(stats.reallocations == 3);
+    TEST_CHECK(stats.frees == 1);
+    TEST_CHECK(stats.pooled_bytes > 0);
+  }
+
+  TEST_CHECK(gcmz_lua_alloc_func(alloc, c, 32, 0) == NULL);
+  TEST_CHECK(gcmz_lua_alloc_func(alloc, e, 8192, 0) == NULL);
+
+  {
+    struct gcmz_lua_alloc_stats stats = {0};
+    gcmz_lua_alloc_get_stats(alloc, &stats);
+    TEST_CHECK(stats.live_bytes == 0);
+    TEST_CHECK(stats.peak_bytes == 32 + 8192);
+    TEST_CHECK(stats.frees == 3);
+  }
+
+cleanup:
+  gcmz_lua_alloc_destroy(&alloc);
+  TEST_CHECK(alloc == NULL);
+}
+
+static void test_lua_alloc_hook_stats(void) {
+  struct gcmz_lua_alloc *alloc = NULL;
+  struct ov_error err = {0};
+  void *blocks[200] = {0};
+
+  alloc = gcmz_lua_alloc_create(&err);
+  if (!TEST_SUCCEEDED(alloc != NULL, &err)) {
+    return;
+  }
+
+  void *const kept = gcmz_lua_alloc_func(alloc, NULL, 0, 100);
+  if (!TEST_CHECK(kept != NULL)) {
+    goto cleanup;
+  }
+
+  {
+    struct gcmz_lua_alloc_hook_stats hook = {0};
+    gcmz_lua_alloc_hook_begin(alloc, &hook);
+    // Enough blocks to need more than one slab
+    for (size_t i = 0; i < sizeof(blocks) / sizeof(blocks[0]); ++i) {
+      blocks[i] = gcmz_lua_alloc_func(alloc, NULL, 0, 500);
+      if (!TEST_CHECK(blocks[i] != NULL)) {
+        goto cleanup;
+      }
+    }
+    for (size_t i = 0; i < sizeof(blocks) / sizeof(blocks[0]); ++i) {
+      TEST_CHECK(gcmz_lua_alloc_func(alloc, blocks[i], 500, 0) == NULL);
+      blocks[i] = NULL;
+    }
+    gcmz_lua_alloc_hook_end(alloc, &hook);
+
+    TEST_CHECK(hook.live_bytes_before == 100);
+    TEST_CHECK(hook.live_bytes_after == 100);
+    TEST_CHECK(hook.peak_bytes == 100 + 500 * 200);
+    TEST_MSG("want %zu, got %zu", (size_t)(100 + 500 * 200), hook.peak_bytes);
+    TEST_CHECK(hook.allocations == 200);
+    TEST_CHECK(hook.reallocations == 0);
+    TEST_CHECK(hook.frees == 200);
+  }
+
+  {
+    // Peak tracking restarts for every hook
+    struct gcmz_lua_alloc_hook_stats hook = {0};
+    gcmz_lua_alloc_hook_begin(alloc, &hook);
+    gcmz_lua_alloc_hook_end(alloc, &hook);
+    TEST_CHECK(hook.peak_bytes == 100);
+    TEST_CHECK(hook.allocations == 0);
+  }
+
+  {
+    // A nested measurement does not hide the inner peak from the outer one
+    struct gcmz_lua_alloc_hook_stats outer = {0};
+    struct gcmz_lua_alloc_hook_stats inner = {0};
+    gcmz_lua_alloc_hook_begin(alloc, &outer);
+    void *const before = gcmz_lua_alloc_func(alloc, NULL, 0, 1000);
+    gcmz_lua_alloc_hook_begin(alloc, &inner);
+    void *const nested = gcmz_lua_alloc_func(alloc, NULL, 0, 2000);
+    gcmz_lua_alloc_func(alloc, nested, 2000, 0);
+    gcmz_lua_alloc_hook_end(alloc, &inner);
+    gcmz_lua_alloc_func(alloc, before, 1000, 0);
+    gcmz_lua_alloc_hook_end(alloc, &outer);
+    TEST_CHECK(inner.peak_bytes == 100 + 1000 + 2000);
+    TEST_CHECK(outer.peak_bytes == 100 + 1000 + 2000);
+    TEST_MSG("want %zu, got %zu", (size_t)(100 + 1000 + 2000), outer.peak_bytes);
+    TEST_CHECK(outer.allocations == 2 && inner.allocations == 1);
+
+    // Only the peak of the outer measurement is kept after the inner one ends
+    gcmz_lua_alloc_hook_begin(alloc, &outer);
+    gcmz_lua_alloc_hook_begin(alloc, &inner);
+    gcmz_lua_alloc_hook_end(alloc, &inner);
+    gcmz_lua_alloc_hook_end(alloc, &outer);
+    TEST_CHECK(outer.peak_bytes == 100);
+  }
+
+  TEST_CHECK(gcmz_lua_alloc_func(alloc, kept, 100, 0) == NULL);
+
+cleanup:
+  for (size_t i = 0; i < sizeof(blocks) / sizeof(blocks[0]); ++i) {
+    if (blocks[i]) {
+      gcmz_lua_alloc_func(alloc, blocks[i], 500, 0);
+    }
+  }
+  gcmz_lua_alloc_destroy(&alloc);
+}
+
+TEST_LIST = {
+    {"test_lua_alloc_pool", test_lua_alloc_pool},
+    {"test_lua_alloc_hook_stats", test_lua_alloc_hook_stats},
+    {NULL, NULL},
+};
@@ -13,7 +13,10 @@
 
 #include <aviutl2_plugin2.h>
 
+#include "copy.h"
+#include "encoding.h"
 #include "luautil.h"
+#include "sniffer.h"
 
 #ifdef __GNUC__
 #  ifndef __has_warning
@@ -134,6 +137,31 @@ static int get_codepage_from_name(char const *name) {
   return -1;
 }
 
+/**
+ * @brief Map a codepage to an encoding supported by the built-in transcoder
+ *
+ * @param codepage Codepage value
+ * @param encoding [out] Built-in encoding
+ * @return true if the codepage is handled by the built-in transcoder
+ */
+static bool get_builtin_encoding(int const codepage, enum gcmz_encoding *const encoding) {
+  switch (codepage) {
+  case ENCODING_SJIS:
+    *encoding = gcmz_encoding_cp932;
+    return true;
+  case ENCODING_UTF8:
+    *encoding = gcmz_encoding_utf8;
+    return true;
+  case ENCODING_UTF16LE:
+    *encoding = gcmz_encoding_utf16le;
+    return true;
+  case ENCODING_UTF16BE:
+    *encoding = gcmz_encoding_utf16be;
+    return true;
+  }
+  return false;
+}
+
 static bool convert_encoding_internal(char const *src_text,
                                       size_t src_len,
                                       int src_codepage,
@@ -162,6 +190,35 @@ static bool convert_encoding_internal(char const *src_text,
       success = true;
       goto cleanup;
     }
+
+    // Shift_JIS, UTF-8 and UTF-16 are converted directly without an intermediate wide buffer
+    enum gcmz_encoding src_encoding;
+    enum gcmz_encoding dest_encoding;
+    if (get_builtin_encoding(src_codepage, &src_encoding) && get_builtin_encoding(dest_codepage, &dest_encoding)) {
+      if (!gcmz_encoding_convert(src_text, src_len, src_encoding, dest_encoding, result, result_len, err)) {
+        OV_ERROR_ADD_TRACE(err);
+        goto cleanup;
+      }
+      success = true;
+      goto cleanup;
+    }
+
+    // Pure ASCII text is identical in all remaining ASCII-compatible codepages.
+    // ISO-2022-JP is 7-bit, so its escape sequences and Japanese text pass the ASCII check and must be decoded.
+    if (src_codepage != ENCODING_UTF16LE && src_codepage != ENCODING_UTF16BE && src_codepage != ENCODING_ISO2022JP &&
+        dest_codepage != ENCODING_UTF16LE && dest_codepage != ENCODING_UTF16BE &&
+        gcmz_encoding_ascii_prefix(src_text, src_len) == src_len) {
+      if (!OV_ARRAY_GROW(result, src_len + 1)) {
+        OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+        goto cleanup;
+      }
+      memcpy(*result, src_text, src_len);
+      (*result)[src_len] = '\0';
+      *result_len = src_len;
+      success = true;
+      goto cleanup;
+    }
+
     // Step 1: Convert source to wide characters
     int wide_len;
     if (src_codepage == ENCODING_UTF16LE) {
@@ -256,7 +313,8 @@ cleanup:
 }
 
 static int gcmz_lua_convert_encoding(lua_State *L) {
-  char const *src_text = luaL_checkstring(L, 1);
+  size_t src_len = 0;
+  char const *src_text = luaL_checklstring(L, 1, &src_len);
   char const *src_encoding = luaL_checkstring(L, 2);
   char const *dest_encoding = luaL_checkstring(L, 3);
 
@@ -277,7 +335,6 @@ static int gcmz_lua_convert_encoding(lua_State *L) {
   struct ov_error err = {0};
   char *result = NULL;
   size_t result_len = 0;
-  size_t src_len = strlen(src_text);
 
   if (!convert_encoding_internal(src_text, src_len, src_codepage, dest_codepage, &result, &result_len, &err)) {
     if (result) {
@@ -437,17 +494,291 @@ cleanup:
   return result < 0 ? gcmz_luafn_result_err(L, &err) : result;
 }
 
-static int parse_hex_digit(char c) {
-  if (c >= '0' && c <= '9') {
-    return c - '0';
+static int gcmz_lua_read_file(lua_State *L) {
+  char const *const path = luaL_checkstring(L, 1);
+  lua_Integer const offset = luaL_optinteger(L, 2, 0);
+  if (offset < 0) {
+    return luaL_argerror(L, 2, "offset must not be negative");
+  }
+  bool const has_len = !lua_isnoneornil(L, 3);
+  lua_Integer const len = luaL_optinteger(L, 3, 0);
+  if (len < 0) {
+    return luaL_argerror(L, 3, "len must not be negative");
+  }
+
+  struct ov_error err = {0};
+  wchar_t *path_w = NULL;
+  HANDLE h = INVALID_HANDLE_VALUE;
+  char *data = NULL;
+  int result = -1;
+
+  {
+    if (!gcmz_utf8_to_wchar(path, &path_w, &err)) {
+      OV_ERROR_ADD_TRACE(&err);
+      goto cleanup;
+    }
+    h = CreateFileW(path_w,
+                    GENERIC_READ,
+                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                    NULL,
+                    OPEN_EXISTING,
+                    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                    NULL);
+    if (h == INVALID_HANDLE_VALUE) {
+      OV_ERROR_SET_HRESULT(&err, HRESULT_FROM_WIN32(GetLastError()));
+      goto cleanup;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(h, &file_size)) {
+      OV_ERROR_SET_HRESULT(&err, HRESULT_FROM_WIN32(GetLastError()));
+      goto cleanup;
+    }
+
+    // Clamp the range to the file, reading past the end yields an empty string like file:read
+    uint64_t const size = (uint64_t)file_size.QuadPart;
+    uint64_t const start = (uint64_t)offset < size ? (uint64_t)offset : size;
+    uint64_t to_read = size - start;
+    if (has_len && (uint64_t)len < to_read) {
+      to_read = (uint64_t)len;
+    }
+    if (to_read > SIZE_MAX) {
+      OV_ERROR_SET_GENERIC(&err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    if (to_read == 0) {
+      lua_pushliteral(L, "");
+      result = 1;
+      goto cleanup;
+    }
+    if (!OV_ARRAY_GROW(&data, (size_t)to_read)) {
+      OV_ERROR_SET_GENERIC(&err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+
+    // Positional reads, one call unless the range exceeds what a single ReadFile can transfer
+    size_t total = 0;
+    while (total < (size_t)to_read) {
+      uint64_t const pos = start + total;
+      OVERLAPPED ov = {.Offset = (DWORD)(pos & 0xffffffff), .OffsetHigh = (DWORD)(pos >> 32)};
+      size_t const chunk = (size_t)to_read - total;
+      DWORD bytes_read = 0;
+      if (!ReadFile(h, data + total, chunk > MAXDWORD ? MAXDWORD : (DWORD)chunk, &bytes_read, &ov)) {
+        OV_ERROR_SET_HRESULT(&err, HRESULT_FROM_WIN32(GetLastError()));
+        goto cleanup;
+      }
+      if (bytes_read == 0) {
+        break;
+      }
+      total += bytes_read;
+    }
+    lua_pushlstring(L, data, total);
+  }
+
+  result = 1;
+
+cleanup:
+  if (data) {
+    OV_ARRAY_DESTROY(&data);
+  }
+  if (h != INVALID_HANDLE_VALUE) {
+    CloseHandle(h);
+  }
+  if (path_w) {
+    OV_ARRAY_DESTROY(&path_w);
+  }
+  return result < 0 ? gcmz_luafn_result_err(L, &err) : result;
+}
+
+/**
+ * @brief Push a 64-bit hash as a 16 digit lowercase hex string
+ *
+ * The last 8 digits are the ones gcmz.save_file and the drop cache put in file names.
+ */
+static void push_hash(lua_State *L, uint64_t const hash) {
+  static char const hex_chars[] = "0123456789abcdef";
+  char buf[16];
+  for (int i = 0; i < 16; ++i) {
+    buf[i] = hex_chars[(hash >> ((15 - i) * 4)) & 0xf];
   }
-  if (c >= 'A' && c <= 'F') {
-    return c - 'A' + 10;
+  lua_pushlstring(L, buf, sizeof(buf));
+}
+
+static int gcmz_lua_hash_file(lua_State *L) {
+  char const *const path = luaL_checkstring(L, 1);
+
+  struct ov_error err = {0};
+  wchar_t *path_w = NULL;
+  int result = -1;
+
+  {
+    if (!gcmz_utf8_to_wchar(path, &path_w, &err)) {
+      OV_ERROR_ADD_TRACE(&err);
+      goto cleanup;
+    }
+    uint64_t hash = 0;
+    if (!gcmz_copy_calc_file_hash(path_w, &hash, &err)) {
+      OV_ERROR_ADD_TRACE(&err);
+      goto cleanup;
+    }
+    push_hash(L, hash);
   }
-  if (c >= 'a' && c <= 'f') {
-    return c - 'a' + 10;
+
+  result = 1;
+
+cleanup:
+  if (path_w) {
+    OV_ARRAY_DESTROY(&path_w);
   }
-  return -1;
+  return result < 0 ? gcmz_luafn_result_err(L, &err) : result;
+}
+
+static int gcmz_lua_hash_string(lua_State *L) {
+  size_t len = 0;
+  char const *const s = luaL_checklstring(L, 1, &len);
+  push_hash(L, gcmz_copy_calc_hash(s, len));
+  return 1;
+}
+
+/**
+ * @brief Sniff the type of a file from its leading bytes
+ *
+ * Reads at most 1445 bytes, the resource header length of the WHATWG MIME Sniffing Standard.
+ *
+ * @param path UTF-8 file path
+ * @param mime [out] MIME type, NULL if the format was not recognized
+ * @param ext [out] File extension, NULL if the format was not recognized
+ * @param err [out] Error information on failure
+ * @return true on success, false if the file could not be read
+ */
+static NODISCARD bool sniff_file(char const *const path,
+                                 wchar_t const **const mime,
+                                 wchar_t const **const ext,
+                                 struct ov_error *const err) {
+  wchar_t *path_w = NULL;
+  HANDLE h = INVALID_HANDLE_VALUE;
+  bool result = false;
+
+  {
+    if (!gcmz_utf8_to_wchar(path, &path_w, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    h = CreateFileW(path_w,
+                    GENERIC_READ,
+                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                    NULL,
+                    OPEN_EXISTING,
+                    FILE_ATTRIBUTE_NORMAL,
+                    NULL);
+    if (h == INVALID_HANDLE_VALUE) {
+      OV_ERROR_SET_HRESULT(err, HRESULT_FROM_WIN32(GetLastError()));
+      goto cleanup;
+    }
+    uint8_t header[1445];
+    DWORD bytes_read = 0;
+    if (!ReadFile(h, header, sizeof(header), &bytes_read, NULL)) {
+      OV_ERROR_SET_HRESULT(err, HRESULT_FROM_WIN32(GetLastError()));
+      goto cleanup;
+    }
+    if (!gcmz_sniff(header, bytes_read, mime, ext)) {
+      *mime = NULL;
+      *ext = NULL;
+    }
+  }
+
+  result = true;
+
+cleanup:
+  if (h != INVALID_HANDLE_VALUE) {
+    CloseHandle(h);
+  }
+  if (path_w) {
+    OV_ARRAY_DESTROY(&path_w);
+  }
+  return result;
+}
+
+/**
+ * @brief Push a sniffer result string, which is always ASCII
+ */
+static void push_sniffed_string(lua_State *L, wchar_t const *const ws) {
+  char buf[128];
+  size_t len = 0;
+  while (ws[len] && len < sizeof(buf)) {
+    buf[len] = (char)ws[len];
+    ++len;
+  }
+  lua_pushlstring(L, buf, len);
+}
+
+static int gcmz_lua_sniff(lua_State *L) {
+  struct ov_error err = {0};
+  wchar_t const *mime = NULL;
+  wchar_t const *ext = NULL;
+  int result = -1;
+
+  if (lua_type(L, 1) != LUA_TTABLE) {
+    size_t len = 0;
+    char const *const value = luaL_checklstring(L, 1, &len);
+    if (lua_toboolean(L, 2)) {
+      if (!gcmz_sniff(value, len, &mime, &ext)) {
+        mime = NULL;
+      }
+    } else if (!sniff_file(value, &mime, &ext, &err)) {
+      OV_ERROR_ADD_TRACE(&err);
+      goto cleanup;
+    }
+    if (!mime) {
+      lua_pushnil(L);
+      result = 1;
+      goto cleanup;
+    }
+    push_sniffed_string(L, mime);
+    push_sniffed_string(L, ext);
+    result = 2;
+    goto cleanup;
+  }
+
+  {
+    // Batch: paths or file entries with a filepath field, unreadable or unrecognized files map to false
+    lua_newtable(L);
+    int const out_idx = lua_gettop(L);
+    lua_pushnil(L);
+    while (lua_next(L, 1) != 0) {
+      if (lua_type(L, -1) == LUA_TTABLE) {
+        lua_getfield(L, -1, "filepath");
+        lua_replace(L, -2);
+      }
+      if (lua_type(L, -1) != LUA_TSTRING) {
+        OV_ERROR_SET(&err, ov_error_type_generic, ov_error_generic_invalid_argument, "file path expected in table");
+        goto cleanup;
+      }
+      bool const ok = sniff_file(lua_tostring(L, -1), &mime, &ext, &err);
+      if (!ok) {
+        OV_ERROR_DESTROY(&err);
+      }
+      lua_pop(L, 1);
+      lua_pushvalue(L, -1);
+      if (ok && mime) {
+        lua_createtable(L, 0, 2);
+        push_sniffed_string(L, mime);
+        lua_setfield(L, -2, "mime");
+        push_sniffed_string(L, ext);
+        lua_setfield(L, -2, "ext");
+      } else {
+        lua_pushboolean(L, 0);
+      }
+      lua_settable(L, out_idx);
+    }
+  }
+
+  result = 1;
+
+cleanup:
+  if (result < 0) {
+    lua_settop(L, 1);
+  }
+  return result < 0 ? gcmz_luafn_result_err(L, &err) : result;
 }
 
 static int gcmz_lua_get_versions(lua_State *L) {
@@ -545,6 +876,129 @@ cleanup:
   return result < 0 ? gcmz_luafn_result_err(L, &err) : result;
 }
 
+// Hex digit lookup table: 0x00-0x0f for valid digits, 0xff for anything else
+static uint8_t const g_hex_values[256] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, // 0x00
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, // 0x10
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, // 0x20
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, // 0x30
+    0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, // 0x40
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, // 0x50
+    0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, // 0x60
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, // 0x70
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, // 0x80
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, // 0x90
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, // 0xa0
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, // 0xb0
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, // 0xc0
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, // 0xd0
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, // 0xe0
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, // 0xf0
+};
+
+/**
+ * @brief Decode one hex-encoded UTF-16LE code unit
+ *
+ * @param p Pointer to 4 hex digits (low byte first)
+ * @return Code unit value (0x0000-0xffff), or -1 if any digit is invalid
+ */
+static int decode_hex_unit(char const *const p) {
+  uint8_t const d0 = g_hex_values[(uint8_t)p[0]];
+  uint8_t const d1 = g_hex_values[(uint8_t)p[1]];
+  uint8_t const d2 = g_hex_values[(uint8_t)p[2]];
+  uint8_t const d3 = g_hex_values[(uint8_t)p[3]];
+  if ((d0 | d1 | d2 | d3) & 0xf0) {
+    return -1;
+  }
+  return (d2 << 12) | (d3 << 8) | (d0 << 4) | d1;
+}
+
+/**
+ * @brief Decode EXO text field (hex-encoded UTF-16LE) directly to UTF-8
+ *
+ * Decodes in a single pass without an intermediate UTF-16 buffer.
+ * ASCII code units are copied as-is; other units are encoded to UTF-8 in place.
+ * Decoding stops at the first NUL code unit. Unpaired surrogates are replaced with U+FFFD.
+ *
+ * @param hex Hex string
+ * @param hex_len Length of hex string in bytes (must be a multiple of 4)
+ * @param dest [in/out] Destination buffer (OV_ARRAY, can be reused)
+ * @param dest_len [out] Length of decoded UTF-8 string
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+static NODISCARD bool decode_exo_text(char const *const hex,
+                                      size_t const hex_len,
+                                      char **const dest,
+                                      size_t *const dest_len,
+                                      struct ov_error *const err) {
+  if (hex_len % 4 != 0) {
+    OV_ERROR_SET(
+        err, ov_error_type_generic, ov_error_generic_invalid_argument, "invalid hex string length (must be multiple of 4)");
+    return false;
+  }
+
+  size_t const unit_count = hex_len / 4;
+  // Each UTF-16 code unit produces at most 3 bytes of UTF-8 (surrogate pairs produce 4 bytes from 2 units)
+  if (!OV_ARRAY_GROW(dest, unit_count * 3 + 1)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+
+  uint8_t *const out = (uint8_t *)*dest;
+  size_t pos = 0;
+  for (size_t i = 0; i < unit_count; ++i) {
+    int const u = decode_hex_unit(hex + i * 4);
+    if (u < 0) {
+      OV_ERROR_SET(err, ov_error_type_generic, ov_error_generic_invalid_argument, "invalid hex character in string");
+      return false;
+    }
+    // Stop at null terminator
+    if (u == 0) {
+      break;
+    }
+    // ASCII fast path
+    if (u < 0x80) {
+      out[pos++] = (uint8_t)u;
+      continue;
+    }
+    if (u < 0x800) {
+      out[pos++] = (uint8_t)(0xc0 | (u >> 6));
+      out[pos++] = (uint8_t)(0x80 | (u & 0x3f));
+      continue;
+    }
+    if (u >= 0xd800 && u <= 0xdbff && i + 1 < unit_count) {
+      int const lo = decode_hex_unit(hex + (i + 1) * 4);
+      if (lo < 0) {
+        OV_ERROR_SET(err, ov_error_type_generic, ov_error_generic_invalid_argument, "invalid hex character in string");
+        return false;
+      }
+      if (lo >= 0xdc00 && lo <= 0xdfff) {
+        uint32_t const cp = 0x10000 + (((uint32_t)u - 0xd800) << 10) + ((uint32_t)lo - 0xdc00);
+        out[pos++] = (uint8_t)(0xf0 | (cp >> 18));
+        out[pos++] = (uint8_t)(0x80 | ((cp >> 12) & 0x3f));
+        out[pos++] = (uint8_t)(0x80 | ((cp >> 6) & 0x3f));
+        out[pos++] = (uint8_t)(0x80 | (cp & 0x3f));
+        ++i;
+        continue;
+      }
+    }
+    if (u >= 0xd800 && u <= 0xdfff) {
+      // Unpaired surrogate
+      out[pos++] = 0xef;
+      out[pos++] = 0xbf;
+      out[pos++] = 0xbd;
+      continue;
+    }
+    out[pos++] = (uint8_t)(0xe0 | (u >> 12));
+    out[pos++] = (uint8_t)(0x80 | ((u >> 6) & 0x3f));
+    out[pos++] = (uint8_t)(0x80 | (u & 0x3f));
+  }
+  out[pos] = '\0';
+  *dest_len = pos;
+  return true;
+}
+
 // Decode EXO text field (hex-encoded UTF-16LE) to UTF-8
 // EXO text format: each UTF-16LE code unit is represented as 4 hex digits (little-endian byte order)
 // Example: "41004200" = "AB" (0x0041 = 'A', 0x0042 = 'B')
@@ -560,68 +1014,58 @@ static int gcmz_lua_decode_exo_text(lua_State *L) {
   }
 
   struct ov_error err = {0};
-  wchar_t *wide_chars = NULL;
   char *utf8_result = NULL;
+  size_t utf8_len = 0;
   int result = -1;
 
   {
-    if (hex_len % 4 != 0) {
-      OV_ERROR_SET(&err,
-                   ov_error_type_generic,
-                   ov_error_generic_invalid_argument,
-                   "invalid hex string length (must be multiple of 4)");
-      goto cleanup;
-    }
-
-    size_t const wide_count = hex_len / 4;
-    if (!OV_ARRAY_GROW(&wide_chars, wide_count + 1)) {
-      OV_ERROR_SET_GENERIC(&err, ov_error_generic_out_of_memory);
+    if (!decode_exo_text(hex_str, hex_len, &utf8_result, &utf8_len, &err)) {
+      OV_ERROR_ADD_TRACE(&err);
       goto cleanup;
     }
+    lua_pushlstring(L, utf8_result, utf8_len);
+  }
 
-    // Parse hex pairs to UTF-16LE code units
-    size_t actual_len = 0;
-    for (size_t i = 0; i < wide_count; ++i) {
-      // Parse 4 hex digits: low byte first (little-endian)
-      int d0 = parse_hex_digit(hex_str[i * 4 + 0]);
-      int d1 = parse_hex_digit(hex_str[i * 4 + 1]);
-      int d2 = parse_hex_digit(hex_str[i * 4 + 2]);
-      int d3 = parse_hex_digit(hex_str[i * 4 + 3]);
-
-      if (d0 < 0 || d1 < 0 || d2 < 0 || d3 < 0) {
-        OV_ERROR_SET(&err, ov_error_type_generic, ov_error_generic_invalid_argument, "invalid hex character in string");
-        goto cleanup;
-      }
+  result = 1;
 
-      uint8_t low_byte = (uint8_t)((d0 << 4) | d1);
-      uint8_t high_byte = (uint8_t)((d2 << 4) | d3);
-      wchar_t codepoint = (wchar_t)((high_byte << 8) | low_byte);
+cleanup:
+  if (utf8_result) {
+    OV_ARRAY_DESTROY(&utf8_result);
+  }
+  return result < 0 ? gcmz_luafn_result_err(L, &err) : result;
+}
 
-      // Stop at null terminator
-      if (codepoint == 0) {
-        break;
-      }
+// Decode multiple EXO text fields at once
+// Takes a table of hex strings and returns a new table with the same keys and decoded UTF-8 values.
+// A single work buffer is reused for all entries.
+static int gcmz_lua_decode_exo_texts(lua_State *L) {
+  luaL_checktype(L, 1, LUA_TTABLE);
 
-      wide_chars[actual_len++] = codepoint;
-    }
-    wide_chars[actual_len] = L'\0';
+  struct ov_error err = {0};
+  char *utf8_result = NULL;
+  int result = -1;
 
-    if (actual_len == 0) {
-      lua_pushliteral(L, "");
-      result = 1;
-      goto cleanup;
-    }
-    size_t const utf8_len = ov_wchar_to_utf8_len(wide_chars, actual_len);
-    if (utf8_len == 0) {
-      OV_ERROR_SET_GENERIC(&err, ov_error_generic_fail);
-      goto cleanup;
-    }
-    if (!OV_ARRAY_GROW(&utf8_result, utf8_len + 1)) {
-      OV_ERROR_SET_GENERIC(&err, ov_error_generic_out_of_memory);
-      goto cleanup;
+  {
+    lua_newtable(L);
+    int const out_idx = lua_gettop(L);
+    lua_pushnil(L);
+    while (lua_next(L, 1) != 0) {
+      if (lua_type(L, -1) != LUA_TSTRING) {
+        OV_ERROR_SET(&err, ov_error_type_generic, ov_error_generic_invalid_argument, "hex string expected in table");
+        goto cleanup;
+      }
+      size_t hex_len = 0;
+      char const *const hex_str = lua_tolstring(L, -1, &hex_len);
+      size_t utf8_len = 0;
+      if (!decode_exo_text(hex_str, hex_len, &utf8_result, &utf8_len, &err)) {
+        OV_ERROR_ADD_TRACE(&err);
+        goto cleanup;
+      }
+      lua_pop(L, 1);
+      lua_pushvalue(L, -1);
+      lua_pushlstring(L, utf8_result, utf8_len);
+      lua_settable(L, out_idx);
     }
-    ov_wchar_to_utf8(wide_chars, actual_len, utf8_result, utf8_len + 1, NULL);
-    lua_pushlstring(L, utf8_result, utf8_len);
   }
 
   result = 1;
@@ -630,8 +1074,8 @@ cleanup:
   if (utf8_result) {
     OV_ARRAY_DESTROY(&utf8_result);
   }
-  if (wide_chars) {
-    OV_ARRAY_DESTROY(&wide_chars);
+  if (result < 0) {
+    lua_settop(L, 1);
   }
   return result < 0 ? gcmz_luafn_result_err(L, &err) : result;
 }
@@ -658,6 +1102,8 @@ static int global_lua_debug_print(lua_State *L) {
 static char g_i18n_preferred_langs_key = 0; // Cached preferred LANGIDs (userdata)
 static char g_i18n_toLCID_key = 0;          // Cached LocaleNameToLCID function pointer (lightuserdata)
 static char g_i18n_kernel32_key = 0;        // Cached kernel32 handle (lightuserdata)
+static char g_i18n_langids_key = 0;         // Cached LANGIDs of language tags (table)
+static char g_i18n_resolved_key = 0;        // Chosen keys of text tables for system preference (weak-keyed table)
 
 // Helper: Get LCID from locale name using Windows API
 typedef LCID(WINAPI *LocaleNameToLCIDProc)(LPCWSTR lpName, DWORD dwFlags);
@@ -685,6 +1131,15 @@ struct i18n_cache {
   WORD preferred_langs[256];
 };
 
+// Per-call view of the i18n cache
+struct i18n_context {
+  struct i18n_cache const *cache;
+  LocaleNameToLCIDProc toLCID;
+  int langids_idx;  // Stack index of the LANGID table
+  int resolved_idx; // Stack index of the resolved key table
+  wchar_t *tag_w;   // Conversion buffer, reused between tags
+};
+
 // Initialize i18n cache (called once per Lua state)
 static bool
 i18n_init_cache(lua_State *L, struct i18n_cache **out_cache, LocaleNameToLCIDProc *out_toLCID, struct ov_error *err) {
@@ -731,11 +1186,6 @@ i18n_init_cache(lua_State *L, struct i18n_cache **out_cache, LocaleNameToLCIDPro
     lua_pushlightuserdata(L, (void *)hKernel32);
     lua_rawset(L, LUA_REGISTRYINDEX);
 
-    // Store toLCID function pointer
-    lua_pushlightuserdata(L, (void *)&g_i18n_toLCID_key);
-    lua_pushlightuserdata(L, (void *)toLCID);
-    lua_rawset(L, LUA_REGISTRYINDEX);
-
     // Get preferred languages from system
     if (!mo_get_preferred_ui_languages(&preferred_w, err)) {
       OV_ERROR_ADD_TRACE(err);
@@ -764,6 +1214,25 @@ i18n_init_cache(lua_State *L, struct i18n_cache **out_cache, LocaleNameToLCIDPro
     lua_rawset(L, LUA_REGISTRYINDEX);
     lua_pop(L, 1); // Pop cache userdata
 
+    // Language tag to LANGID table
+    lua_pushlightuserdata(L, (void *)&g_i18n_langids_key);
+    lua_newtable(L);
+    lua_rawset(L, LUA_REGISTRYINDEX);
+
+    // Text table to chosen key table, entries go away with the text tables
+    lua_pushlightuserdata(L, (void *)&g_i18n_resolved_key);
+    lua_newtable(L);
+    lua_createtable(L, 0, 1);
+    lua_pushstring(L, "k");
+    lua_setfield(L, -2, "__mode");
+    lua_setmetatable(L, -2);
+    lua_rawset(L, LUA_REGISTRYINDEX);
+
+    // Store toLCID function pointer last, it marks the cache as initialized
+    lua_pushlightuserdata(L, (void *)&g_i18n_toLCID_key);
+    lua_pushlightuserdata(L, (void *)toLCID);
+    lua_rawset(L, LUA_REGISTRYINDEX);
+
     *out_cache = cache;
     *out_toLCID = toLCID;
   }
@@ -777,6 +1246,212 @@ cleanup:
   return result;
 }
 
+/**
+ * @brief Prepare the i18n cache and push its lookup tables
+ *
+ * Pushes the LANGID table and the resolved key table, which stay on the stack
+ * until the caller returns.
+ */
+static bool i18n_begin(lua_State *L, struct i18n_context *const ctx, struct ov_error *const err) {
+  struct i18n_cache *cache = NULL;
+  if (!i18n_init_cache(L, &cache, &ctx->toLCID, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  ctx->cache = cache;
+  lua_pushlightuserdata(L, (void *)&g_i18n_langids_key);
+  lua_rawget(L, LUA_REGISTRYINDEX);
+  ctx->langids_idx = lua_gettop(L);
+  lua_pushlightuserdata(L, (void *)&g_i18n_resolved_key);
+  lua_rawget(L, LUA_REGISTRYINDEX);
+  ctx->resolved_idx = lua_gettop(L);
+  return true;
+}
+
+static void i18n_end(struct i18n_context *const ctx) {
+  if (ctx->tag_w) {
+    OV_ARRAY_DESTROY(&ctx->tag_w);
+  }
+}
+
+/**
+ * @brief Convert the language tag at the top of the stack to a LANGID
+ *
+ * Results are memoized per Lua state, so LocaleNameToLCID runs once per distinct tag.
+ * Tags that are not a locale name yield 0.
+ */
+static bool i18n_get_langid(lua_State *L, struct i18n_context *const ctx, WORD *const out, struct ov_error *const err) {
+  lua_pushvalue(L, -1);
+  lua_rawget(L, ctx->langids_idx);
+  if (lua_isnumber(L, -1)) {
+    *out = (WORD)lua_tointeger(L, -1);
+    lua_pop(L, 1);
+    return true;
+  }
+  lua_pop(L, 1);
+
+  size_t tag_len = 0;
+  char const *const tag = lua_tolstring(L, -1, &tag_len);
+  WORD lang = 0;
+  if (tag_len > 0 && tag_len < 32) {
+    size_t const tag_wlen = ov_utf8_to_wchar_len(tag, tag_len);
+    if (tag_wlen > 0) {
+      if (!OV_ARRAY_GROW(&ctx->tag_w, tag_wlen + 1)) {
+        OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+        return false;
+      }
+      ov_utf8_to_wchar(tag, tag_len, ctx->tag_w, tag_wlen + 1, NULL);
+      // Replace '_' with '-' for Windows locale API
+      for (size_t i = 0; i < tag_wlen; ++i) {
+        if (ctx->tag_w[i] == L'_') {
+          ctx->tag_w[i] = L'-';
+        }
+      }
+      lang = LANGIDFROMLCID(ctx->toLCID(ctx->tag_w, 0));
+    }
+    // Longer strings are not language tags and are not worth remembering
+    lua_pushvalue(L, -1);
+    lua_pushinteger(L, lang);
+    lua_rawset(L, ctx->langids_idx);
+  }
+  *out = lang;
+  return true;
+}
+
+/**
+ * @brief Choose the key of the text table that matches the current language best
+ *
+ * Pushes the chosen key, or nil if the table has no language keys.
+ *
+ * @param tbl_idx Absolute stack index of the text table
+ * @param override_idx Absolute stack index of the preferred language tag, 0 to use system preference only
+ */
+static bool i18n_choose_key(lua_State *L,
+                            struct i18n_context *const ctx,
+                            int const tbl_idx,
+                            int const override_idx,
+                            struct ov_error *const err) {
+  // Check for optional override language
+  WORD override_langs[1] = {0};
+  size_t num_override = 0;
+  if (override_idx) {
+    lua_pushvalue(L, override_idx);
+    bool const ok = i18n_get_langid(L, ctx, &override_langs[0], err);
+    lua_pop(L, 1);
+    if (!ok) {
+      OV_ERROR_ADD_TRACE(err);
+      return false;
+    }
+    num_override = override_langs[0] ? 1 : 0;
+  }
+
+  enum {
+    buf_size = 256,
+  };
+
+  // Collect keys from table and convert to LANGIDs.
+  // Keys that are not locale names can never be chosen and are left out.
+  WORD table_langs[buf_size] = {0};
+  size_t num_table_langs = 0;
+  lua_pushnil(L);
+  while (lua_next(L, tbl_idx) != 0) {
+    lua_pop(L, 1); // Pop value, keep key
+    if (lua_type(L, -1) != LUA_TSTRING || num_table_langs >= buf_size) {
+      continue;
+    }
+    WORD lang = 0;
+    if (!i18n_get_langid(L, ctx, &lang, err)) {
+      lua_pop(L, 1);
+      OV_ERROR_ADD_TRACE(err);
+      return false;
+    }
+    if (lang) {
+      table_langs[num_table_langs++] = lang;
+    }
+  }
+
+  // Try override language first, then fall back to system preferences, en_US and the first key
+  size_t chosen_idx = 0;
+  if (num_override > 0) {
+    chosen_idx = choose_language(override_langs, num_override, table_langs, num_table_langs);
+  }
+  if (!chosen_idx) {
+    chosen_idx =
+        choose_language(ctx->cache->preferred_langs, ctx->cache->num_preferred, table_langs, num_table_langs);
+  }
+  for (size_t i = 0; i < num_table_langs && !chosen_idx; ++i) {
+    if (table_langs[i] == MAKELANGID(LANG_ENGLISH, SUBLANG_ENGLISH_US)) {
+      chosen_idx = i + 1;
+    }
+  }
+  if (!chosen_idx && num_table_langs > 0) {
+    chosen_idx = 1;
+  }
+  if (!chosen_idx) {
+    lua_pushnil(L);
+    return true;
+  }
+
+  // Walk the keys again in the same order to find the chosen one, LANGIDs are cached by now
+  size_t n = 0;
+  lua_pushnil(L);
+  while (lua_next(L, tbl_idx) != 0) {
+    lua_pop(L, 1); // Pop value, keep key
+    if (lua_type(L, -1) != LUA_TSTRING) {
+      continue;
+    }
+    lua_pushvalue(L, -1);
+    lua_rawget(L, ctx->langids_idx);
+    lua_Integer const lang = lua_tointeger(L, -1);
+    lua_pop(L, 1);
+    if (lang && ++n == chosen_idx) {
+      return true; // Leave the key on the stack
+    }
+  }
+  lua_pushnil(L);
+  return true;
+}
+
+/**
+ * @brief Push the text chosen from a text table
+ *
+ * The chosen key is remembered per table when no override language is given,
+ * so repeated lookups with the same table are a single table access.
+ * A remembered key is used as long as the table still has a value for it.
+ */
+static bool i18n_push_text(lua_State *L,
+                           struct i18n_context *const ctx,
+                           int const tbl_idx,
+                           int const override_idx,
+                           struct ov_error *const err) {
+  if (!override_idx) {
+    lua_pushvalue(L, tbl_idx);
+    lua_rawget(L, ctx->resolved_idx);
+    if (!lua_isnil(L, -1)) {
+      lua_gettable(L, tbl_idx);
+      if (!lua_isnil(L, -1)) {
+        return true;
+      }
+    }
+    lua_pop(L, 1);
+  }
+
+  if (!i18n_choose_key(L, ctx, tbl_idx, override_idx, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  if (lua_isnil(L, -1)) {
+    return true;
+  }
+  if (!override_idx) {
+    lua_pushvalue(L, tbl_idx);
+    lua_pushvalue(L, -2);
+    lua_rawset(L, ctx->resolved_idx);
+  }
+  lua_gettable(L, tbl_idx);
+  return true;
+}
+
 /**
  * @brief Global Lua function: i18n
  *
@@ -790,170 +1465,81 @@ static int global_lua_i18n(lua_State *L) {
   }
 
   struct ov_error err = {0};
-  wchar_t *key_w = NULL;
-  wchar_t *override_lang_w = NULL;
+  struct i18n_context ctx = {0};
   int result = -1;
 
   {
-    // Get or initialize cache
-    struct i18n_cache *cache = NULL;
-    LocaleNameToLCIDProc toLCID = NULL;
-    if (!i18n_init_cache(L, &cache, &toLCID, &err)) {
+    if (!i18n_begin(L, &ctx, &err)) {
       OV_ERROR_ADD_TRACE(&err);
       goto cleanup;
     }
-
-    // Check for optional override language (second argument)
-    WORD override_langs[1] = {0};
-    size_t num_override = 0;
-    if (lua_isstring(L, 2)) {
-      char const *override_lang = lua_tostring(L, 2);
-      size_t override_len = strlen(override_lang);
-      if (override_len > 0 && override_len < 32) {
-        size_t override_wlen = ov_utf8_to_wchar_len(override_lang, override_len);
-        if (override_wlen > 0) {
-          if (!OV_ARRAY_GROW(&override_lang_w, override_wlen + 1)) {
-            OV_ERROR_SET_GENERIC(&err, ov_error_generic_out_of_memory);
-            goto cleanup;
-          }
-          ov_utf8_to_wchar(override_lang, override_len, override_lang_w, override_wlen + 1, NULL);
-          // Replace '_' with '-' for Windows locale API
-          for (size_t i = 0; i < override_wlen; ++i) {
-            if (override_lang_w[i] == L'_') {
-              override_lang_w[i] = L'-';
-            }
-          }
-          WORD const lang = LANGIDFROMLCID(toLCID(override_lang_w, 0));
-          if (lang != 0) {
-            override_langs[0] = lang;
-            num_override = 1;
-          }
-        }
-      }
+    if (!i18n_push_text(L, &ctx, 1, lua_type(L, 2) == LUA_TSTRING ? 2 : 0, &err)) {
+      OV_ERROR_ADD_TRACE(&err);
+      goto cleanup;
     }
+  }
 
-    enum {
-      buf_size = 256,
-    };
-
-    // Collect keys from table and convert to LANGIDs
-    WORD table_langs[buf_size] = {0};
-    size_t num_table_langs = 0;
-
-    // We also need to track the actual key strings for later access
-    lua_newtable(L); // Stack: tbl, [lang], keys_array
-    int keys_array_idx = lua_gettop(L);
-
-    lua_pushnil(L); // Stack: tbl, [lang], keys_array, nil
-    while (lua_next(L, 1) != 0) {
-      // Stack: tbl, [lang], keys_array, key, value
-      lua_pop(L, 1); // Pop value, keep key
-
-      if (lua_type(L, -1) != LUA_TSTRING) {
-        continue;
-      }
-
-      if (num_table_langs >= buf_size) {
-        continue;
-      }
-
-      char const *key = lua_tostring(L, -1);
-      size_t key_len = strlen(key);
-      if (key_len == 0 || key_len >= 32) {
-        continue;
-      }
-
-      // Store key in keys_array
-      lua_pushvalue(L, -1);                                     // Duplicate key
-      lua_rawseti(L, keys_array_idx, (int)num_table_langs + 1); // keys_array[num_table_langs+1] = key
+  result = 1;
 
-      // Convert key to wchar_t (replace '_' with '-' for Windows API)
-      size_t key_wlen = ov_utf8_to_wchar_len(key, key_len);
-      if (key_wlen == 0) {
-        continue;
-      }
-      if (!OV_ARRAY_GROW(&key_w, key_wlen + 1)) {
-        OV_ERROR_SET_GENERIC(&err, ov_error_generic_out_of_memory);
-        goto cleanup;
-      }
-      ov_utf8_to_wchar(key, key_len, key_w, key_wlen + 1, NULL);
+cleanup:
+  i18n_end(&ctx);
+  return result < 0 ? gcmz_luafn_result_err(L, &err) : result;
+}
 
-      // Replace '_' with '-' for Windows locale API
-      for (size_t i = 0; i < key_wlen; ++i) {
-        if (key_w[i] == L'_') {
-          key_w[i] = L'-';
-        }
-      }
+/**
+ * @brief Global Lua function: i18n_compile
+ *
+ * Resolves every text table in a message table at once and returns a table
+ * that maps each message name to the chosen text.
+ * Values that are not tables are copied as they are.
+ * Optional second argument: preferred language code, as in i18n.
+ */
+static int global_lua_i18n_compile(lua_State *L) {
+  if (!lua_istable(L, 1)) {
+    return luaL_error(L, "i18n_compile requires a table argument");
+  }
 
-      WORD const lang = LANGIDFROMLCID(toLCID(key_w, 0));
-      table_langs[num_table_langs++] = lang;
-    }
-    // Stack: tbl, [lang], keys_array
+  struct ov_error err = {0};
+  struct i18n_context ctx = {0};
+  int result = -1;
 
-    if (num_table_langs == 0) {
-      // No valid keys found, return nil
-      lua_pushnil(L);
-      result = 1;
+  {
+    int const override_idx = lua_type(L, 2) == LUA_TSTRING ? 2 : 0;
+    if (!i18n_begin(L, &ctx, &err)) {
+      OV_ERROR_ADD_TRACE(&err);
       goto cleanup;
     }
-
-    // Find the best match
-    size_t en_us_idx = 0, first_idx = 0;
-    for (size_t i = 0; i < num_table_langs && (!en_us_idx || !first_idx); ++i) {
-      if (!en_us_idx && table_langs[i] == MAKELANGID(LANG_ENGLISH, SUBLANG_ENGLISH_US)) {
-        en_us_idx = i + 1;
-      }
-      if (!first_idx && table_langs[i]) {
-        first_idx = i + 1;
+    lua_newtable(L);
+    int const compiled_idx = lua_gettop(L);
+    lua_pushnil(L);
+    while (lua_next(L, 1) != 0) {
+      // Stack: ..., compiled, name, value
+      if (lua_istable(L, -1)) {
+        if (!i18n_push_text(L, &ctx, lua_gettop(L), override_idx, &err)) {
+          OV_ERROR_ADD_TRACE(&err);
+          goto cleanup;
+        }
+        lua_replace(L, -2);
       }
+      lua_pushvalue(L, -2);
+      lua_insert(L, -2);
+      lua_rawset(L, compiled_idx);
     }
-
-    // Try override language first, then fall back to system preferences
-    size_t chosen_idx = 0;
-    if (num_override > 0) {
-      chosen_idx = choose_language(override_langs, num_override, table_langs, num_table_langs);
-    }
-    if (!chosen_idx) {
-      chosen_idx = choose_language(cache->preferred_langs, cache->num_preferred, table_langs, num_table_langs);
-    }
-    if (!chosen_idx) {
-      chosen_idx = en_us_idx;
-    }
-    if (!chosen_idx) {
-      chosen_idx = first_idx;
-    }
-
-    if (!chosen_idx) {
-      lua_pushnil(L);
-      result = 1;
-      goto cleanup;
-    }
-
-    // Get the key at chosen_idx from keys_array
-    lua_rawgeti(L, keys_array_idx, (int)chosen_idx); // Stack: tbl, [lang], keys_array, chosen_key
-    char const *chosen_key = lua_tostring(L, -1);
-
-    // Get the value from original table
-    lua_getfield(L, 1, chosen_key); // Stack: tbl, [lang], keys_array, chosen_key, value
   }
 
   result = 1;
 
 cleanup:
-  if (override_lang_w) {
-    OV_ARRAY_DESTROY(&override_lang_w);
-  }
-  if (key_w) {
-    OV_ARRAY_DESTROY(&key_w);
-  }
+  i18n_end(&ctx);
   return result < 0 ? gcmz_luafn_result_err(L, &err) : result;
 }
 
 /**
- * @brief gcmz.get_script_module(module_name) -> module table or nil
+ * @brief gcmz.get_script_module(module_name, options) -> module table or nil
  *
  * Returns a script module table from the Lua registry.
  * Module tables are registered via gcmz_lua_register_script_module() from lua.c.
+ * With options.ffi set, the returned table returns numeric arrays as LuaJIT FFI arrays.
  */
 static int gcmz_lua_get_script_module(lua_State *const L) {
   if (!g_lua_api_options.script_modules_key) {
@@ -962,6 +1548,13 @@ static int gcmz_lua_get_script_module(lua_State *const L) {
   }
 
   char const *const module_name = luaL_checkstring(L, 1);
+  bool use_ffi = false;
+  if (!lua_isnoneornil(L, 2)) {
+    luaL_checktype(L, 2, LUA_TTABLE);
+    lua_getfield(L, 2, "ffi");
+    use_ffi = lua_toboolean(L, -1) != 0;
+    lua_pop(L, 1);
+  }
 
   // Get modules table from registry
   lua_getfield(L, LUA_REGISTRYINDEX, g_lua_api_options.script_modules_key);
@@ -974,13 +1567,35 @@ static int gcmz_lua_get_script_module(lua_State *const L) {
   // Get the module by name
   lua_getfield(L, -1, module_name);
   if (lua_istable(L, -1)) {
-    lua_getfield(L, -1, "table");
+    lua_getfield(L, -1, use_ffi ? "ffi_table" : "table");
     lua_remove(L, -2); // Remove wrapper table
   }
   lua_remove(L, -2); // Remove modules table, keep module table or nil
   return 1;
 }
 
+/**
+ * @brief gcmz.get_handler_stats() -> table
+ *
+ * Returns execution statistics of the handler modules collected by the entrypoint module.
+ */
+static int gcmz_lua_get_handler_stats(lua_State *const L) {
+  lua_getglobal(L, "require");
+  lua_pushstring(L, "entrypoint");
+  lua_call(L, 1, 1);
+  if (!lua_istable(L, -1)) {
+    lua_newtable(L);
+    return 1;
+  }
+  lua_getfield(L, -1, "get_handler_stats");
+  if (!lua_isfunction(L, -1)) {
+    lua_newtable(L);
+    return 1;
+  }
+  lua_call(L, 0, 1);
+  return 1;
+}
+
 /**
  * @brief Register all gcmz Lua APIs to the given Lua state
  *
@@ -1005,6 +1620,10 @@ bool gcmz_lua_api_register(struct lua_State *const L, struct ov_error *const err
   lua_setfield(L, -2, "convert_encoding");
   lua_pushcfunction(L, gcmz_lua_decode_exo_text);
   lua_setfield(L, -2, "decode_exo_text");
+  lua_pushcfunction(L, gcmz_lua_decode_exo_texts);
+  lua_setfield(L, -2, "decode_exo_texts");
+  lua_pushcfunction(L, gcmz_lua_get_handler_stats);
+  lua_setfield(L, -2, "get_handler_stats");
   lua_pushcfunction(L, gcmz_lua_get_media_info);
   lua_setfield(L, -2, "get_media_info");
   lua_pushcfunction(L, gcmz_lua_get_project_data);
@@ -1015,8 +1634,16 @@ bool gcmz_lua_api_register(struct lua_State *const L, struct ov_error *const err
   lua_setfield(L, -2, "get_script_module");
   lua_pushcfunction(L, gcmz_lua_get_versions);
   lua_setfield(L, -2, "get_versions");
+  lua_pushcfunction(L, gcmz_lua_hash_file);
+  lua_setfield(L, -2, "hash_file");
+  lua_pushcfunction(L, gcmz_lua_hash_string);
+  lua_setfield(L, -2, "hash_string");
+  lua_pushcfunction(L, gcmz_lua_read_file);
+  lua_setfield(L, -2, "read_file");
   lua_pushcfunction(L, gcmz_lua_save_file);
   lua_setfield(L, -2, "save_file");
+  lua_pushcfunction(L, gcmz_lua_sniff);
+  lua_setfield(L, -2, "sniff");
   lua_setglobal(L, "gcmz");
 
   // Register global helper functions
@@ -1024,6 +1651,8 @@ bool gcmz_lua_api_register(struct lua_State *const L, struct ov_error *const err
   lua_setglobal(L, "debug_print");
   lua_pushcfunction(L, global_lua_i18n);
   lua_setglobal(L, "i18n");
+  lua_pushcfunction(L, global_lua_i18n_compile);
+  lua_setglobal(L, "i18n_compile");
 
   return true;
 }
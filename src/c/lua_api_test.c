@@ -119,6 +119,23 @@ static void test_convert_encoding(void) {
   TEST_CHECK(strcmp(lua_tostring(L, -1), "テスト") == 0);
   lua_pop(L, 1);
 
+  // ISO-2022-JP is 7-bit, Japanese text must still be decoded ("テスト" in JIS X 0208)
+  result = luaL_dostring(L, "return gcmz.convert_encoding('\\27$B%F%9%H\\27(B', 'iso2022jp', 'utf8')");
+  TEST_CHECK(result == LUA_OK);
+  TEST_CHECK(lua_isstring(L, -1));
+  TEST_CHECK(strcmp(lua_tostring(L, -1), "テスト") == 0);
+  TEST_MSG("got %s", lua_tostring(L, -1));
+  lua_pop(L, 1);
+
+  result = luaL_dostring(L,
+                         "local s = gcmz.convert_encoding('テストABC', 'utf8', 'iso2022jp')\n"
+                         "assert(s:find('\\27', 1, true) and not s:find('[\\128-\\255]'))\n"
+                         "return gcmz.convert_encoding(s, 'iso2022jp', 'utf8')");
+  TEST_CHECK(result == LUA_OK);
+  TEST_CHECK(lua_isstring(L, -1));
+  TEST_CHECK(strcmp(lua_tostring(L, -1), "テストABC") == 0);
+  lua_pop(L, 1);
+
   // Test invalid source encoding
   result = luaL_dostring(L, "return pcall(gcmz.convert_encoding, 'test', 'invalid', 'utf8')");
   TEST_CHECK(result == LUA_OK);
@@ -213,6 +230,45 @@ static void test_decode_exo_text(void) {
   TEST_CHECK(strcmp(lua_tostring(L, -1), "a") == 0);
   lua_pop(L, 1);
 
+  // Test surrogate pair: U+1F600 = D83D DE00 -> "3dd800de"
+  result = luaL_dostring(L, "return gcmz.decode_exo_text('3dd800de')");
+  TEST_CHECK(result == LUA_OK);
+  TEST_CHECK(lua_isstring(L, -1));
+  TEST_CHECK(strcmp(lua_tostring(L, -1), "\xf0\x9f\x98\x80") == 0);
+  lua_pop(L, 1);
+
+  // Test unpaired surrogate is replaced with U+FFFD
+  result = luaL_dostring(L, "return gcmz.decode_exo_text('3dd86100')");
+  TEST_CHECK(result == LUA_OK);
+  TEST_CHECK(lua_isstring(L, -1));
+  TEST_CHECK(strcmp(lua_tostring(L, -1), "\xef\xbf\xbd" "a") == 0);
+  lua_pop(L, 1);
+
+  // Test invalid hex character returns nil, errmsg
+  result = luaL_dostring(L, "return gcmz.decode_exo_text('61x0')");
+  TEST_CHECK(result == LUA_OK);
+  TEST_CHECK(lua_isnil(L, -2));
+  TEST_CHECK(lua_isstring(L, -1));
+  lua_pop(L, 2);
+
+  // Test batch decoding keeps keys
+  result = luaL_dostring(L,
+                         "local t = gcmz.decode_exo_texts({ a = '610062006300', [2] = 'c630b930c830', e = '' })\n"
+                         "return t.a .. ',' .. t[2] .. ',' .. t.e");
+  if (TEST_CHECK(result == LUA_OK)) {
+    TEST_CHECK(lua_isstring(L, -1));
+    TEST_CHECK(strcmp(lua_tostring(L, -1), "abc,テスト,") == 0);
+    TEST_MSG("got %s", lua_tostring(L, -1));
+  }
+  lua_pop(L, 1);
+
+  // Test batch decoding with an invalid entry returns nil, errmsg
+  result = luaL_dostring(L, "return gcmz.decode_exo_texts({ '6100', '610' })");
+  TEST_CHECK(result == LUA_OK);
+  TEST_CHECK(lua_isnil(L, -2));
+  TEST_CHECK(lua_isstring(L, -1));
+  lua_pop(L, 2);
+
   lua_close(L);
   gcmz_lua_api_set_options(NULL);
 }
@@ -366,6 +422,138 @@ static void test_get_script_directory_no_provider(void) {
   gcmz_lua_api_set_options(NULL);
 }
 
+static void test_read_file(void) {
+  lua_State *L = luaL_newstate();
+  TEST_ASSERT(L != NULL);
+
+  luaL_openlibs(L);
+
+  gcmz_lua_api_set_options(&(struct gcmz_lua_api_options){
+      .get_project_data = mock_get_project_data,
+      .userdata = NULL,
+  });
+
+  struct ov_error err = {0};
+  if (!TEST_SUCCEEDED(gcmz_lua_api_register(L, &err), &err)) {
+    lua_close(L);
+    gcmz_lua_api_set_options(NULL);
+    return;
+  }
+
+  int result = luaL_dostring(L,
+                             "local path = 'test_read_file.bin' "
+                             "local f = assert(io.open(path, 'wb')) "
+                             "f:write('0123456789\\0abc') "
+                             "f:close() "
+                             "local all = gcmz.read_file(path) "
+                             "local mid = gcmz.read_file(path, 3, 4) "
+                             "local tail = gcmz.read_file(path, 8) "
+                             "local past = gcmz.read_file(path, 100, 4) "
+                             "local clamped = gcmz.read_file(path, 12, 100) "
+                             "os.remove(path) "
+                             "assert(all == '0123456789\\0abc', 'all') "
+                             "assert(mid == '3456', 'mid: ' .. tostring(mid)) "
+                             "assert(tail == '89\\0abc', 'tail') "
+                             "assert(past == '', 'past') "
+                             "assert(clamped == 'bc', 'clamped: ' .. tostring(clamped)) "
+                             "local missing, msg = gcmz.read_file(path) "
+                             "assert(missing == nil and type(msg) == 'string', 'missing file') "
+                             "assert(not pcall(gcmz.read_file, path, -1), 'negative offset')");
+  if (!TEST_CHECK(result == LUA_OK)) {
+    TEST_MSG("read_file error: %s", lua_tostring(L, -1));
+  }
+
+  lua_close(L);
+  gcmz_lua_api_set_options(NULL);
+}
+
+static void test_sniff(void) {
+  lua_State *L = luaL_newstate();
+  TEST_ASSERT(L != NULL);
+
+  luaL_openlibs(L);
+
+  gcmz_lua_api_set_options(&(struct gcmz_lua_api_options){
+      .get_project_data = mock_get_project_data,
+      .userdata = NULL,
+  });
+
+  struct ov_error err = {0};
+  if (!TEST_SUCCEEDED(gcmz_lua_api_register(L, &err), &err)) {
+    lua_close(L);
+    gcmz_lua_api_set_options(NULL);
+    return;
+  }
+
+  int result = luaL_dostring(L,
+                             "local png = '\\137PNG\\r\\n\\26\\n' .. string.rep('\\0', 16) "
+                             "local mime, ext = gcmz.sniff(png, true) "
+                             "assert(mime == 'image/png' and ext == '.png', 'bytes: ' .. tostring(mime)) "
+                             "assert(gcmz.sniff('plain text', true) == nil, 'unknown bytes') "
+                             "local path = 'test_sniff.bin' "
+                             "local f = assert(io.open(path, 'wb')) "
+                             "f:write('GIF89a', string.rep('\\0', 4000)) "
+                             "f:close() "
+                             "mime, ext = gcmz.sniff(path) "
+                             "assert(mime == 'image/gif' and ext == '.gif', 'path: ' .. tostring(mime)) "
+                             "local results = gcmz.sniff({path, {filepath = path}, 'test_sniff_missing.bin'}) "
+                             "os.remove(path) "
+                             "assert(results[1].mime == 'image/gif' and results[1].ext == '.gif', 'batch path') "
+                             "assert(results[2].mime == 'image/gif', 'batch entry') "
+                             "assert(results[3] == false, 'batch missing') "
+                             "local missing, msg = gcmz.sniff('test_sniff_missing.bin') "
+                             "assert(missing == nil and type(msg) == 'string', 'missing file') "
+                             "local invalid, msg2 = gcmz.sniff({42}) "
+                             "assert(invalid == nil and type(msg2) == 'string', 'invalid batch item')");
+  if (!TEST_CHECK(result == LUA_OK)) {
+    TEST_MSG("sniff error: %s", lua_tostring(L, -1));
+  }
+
+  lua_close(L);
+  gcmz_lua_api_set_options(NULL);
+}
+
+static void test_hash(void) {
+  lua_State *L = luaL_newstate();
+  TEST_ASSERT(L != NULL);
+
+  luaL_openlibs(L);
+
+  gcmz_lua_api_set_options(&(struct gcmz_lua_api_options){
+      .get_project_data = mock_get_project_data,
+      .userdata = NULL,
+  });
+
+  struct ov_error err = {0};
+  if (!TEST_SUCCEEDED(gcmz_lua_api_register(L, &err), &err)) {
+    lua_close(L);
+    gcmz_lua_api_set_options(NULL);
+    return;
+  }
+
+  int result = luaL_dostring(L,
+                             "local content = 'hello\\0world' "
+                             "local h = gcmz.hash_string(content) "
+                             "assert(type(h) == 'string' and h:match('^%x+$') and #h == 16, 'format: ' .. tostring(h)) "
+                             "assert(h == gcmz.hash_string(content), 'stable') "
+                             "assert(h ~= gcmz.hash_string('hello'), 'different content') "
+                             "local path = 'test_hash.bin' "
+                             "local f = assert(io.open(path, 'wb')) "
+                             "f:write(content) "
+                             "f:close() "
+                             "local fh = gcmz.hash_file(path) "
+                             "os.remove(path) "
+                             "assert(fh == h, 'file hash matches string hash') "
+                             "local missing, msg = gcmz.hash_file(path) "
+                             "assert(missing == nil and type(msg) == 'string', 'missing file')");
+  if (!TEST_CHECK(result == LUA_OK)) {
+    TEST_MSG("hash error: %s", lua_tostring(L, -1));
+  }
+
+  lua_close(L);
+  gcmz_lua_api_set_options(NULL);
+}
+
 static void test_i18n(void) {
   lua_State *L = luaL_newstate();
   TEST_ASSERT(L != NULL);
@@ -453,6 +641,73 @@ static void test_i18n(void) {
   gcmz_lua_api_set_options(NULL);
 }
 
+static void test_i18n_cache(void) {
+  lua_State *L = luaL_newstate();
+  TEST_ASSERT(L != NULL);
+
+  luaL_openlibs(L);
+
+  gcmz_lua_api_set_options(&(struct gcmz_lua_api_options){
+      .get_project_data = mock_get_project_data,
+      .userdata = NULL,
+  });
+
+  struct ov_error err = {0};
+  if (!TEST_SUCCEEDED(gcmz_lua_api_register(L, &err), &err)) {
+    lua_close(L);
+    gcmz_lua_api_set_options(NULL);
+    return;
+  }
+
+  // Repeated lookups with the same table return the same text
+  int result = luaL_dostring(L,
+                             "local t = { ['en_US'] = 'Hello', ['ja_JP'] = 'こんにちは' }\n"
+                             "local first = i18n(t)\n"
+                             "for i = 1, 10 do assert(i18n(t) == first) end\n"
+                             "assert(i18n(t, 'en_US') == 'Hello')\n"
+                             "assert(i18n(t, 'ja_JP') == 'こんにちは')\n"
+                             "return first");
+  TEST_CHECK(result == LUA_OK);
+  TEST_CHECK(lua_isstring(L, -1));
+  lua_pop(L, 1);
+
+  // A remembered key that was removed from the table is chosen again
+  result = luaL_dostring(L,
+                         "local t = { ['en_US'] = 'Hello', ['ja_JP'] = 'こんにちは', ['zh_CN'] = '你好' }\n"
+                         "local first = i18n(t)\n"
+                         "for k, v in pairs(t) do if v == first then t[k] = nil end end\n"
+                         "local second = i18n(t)\n"
+                         "return second ~= nil and second ~= first");
+  TEST_CHECK(result == LUA_OK);
+  TEST_CHECK(lua_toboolean(L, -1));
+  lua_pop(L, 1);
+
+  // i18n_compile resolves each text table and copies other values
+  result = luaL_dostring(L,
+                         "local m = i18n_compile({\n"
+                         "  hello = { ['en_US'] = 'Hello', ['ja_JP'] = 'こんにちは' },\n"
+                         "  bye = { ['en_US'] = 'Bye', ['ja_JP'] = 'さようなら' },\n"
+                         "  empty = {},\n"
+                         "  count = 3,\n"
+                         "}, 'ja_JP')\n"
+                         "assert(m.hello == 'こんにちは' and m.bye == 'さようなら')\n"
+                         "assert(m.empty == nil and m.count == 3)\n"
+                         "m = i18n_compile({ hello = { ['en_US'] = 'Hello', ['ja_JP'] = 'こんにちは' } }, 'en_US')\n"
+                         "return m.hello");
+  TEST_CHECK(result == LUA_OK);
+  TEST_CHECK(lua_isstring(L, -1));
+  TEST_CHECK(strcmp(lua_tostring(L, -1), "Hello") == 0);
+  lua_pop(L, 1);
+
+  result = luaL_dostring(L, "return pcall(i18n_compile, 'not a table')");
+  TEST_CHECK(result == LUA_OK);
+  TEST_CHECK(!lua_toboolean(L, -2));
+  lua_pop(L, 2);
+
+  lua_close(L);
+  gcmz_lua_api_set_options(NULL);
+}
+
 TEST_LIST = {
     {"api_register", test_api_register},
     {"convert_encoding", test_convert_encoding},
@@ -462,5 +717,9 @@ TEST_LIST = {
     {"get_script_directory", test_get_script_directory},
     {"get_script_directory_no_provider", test_get_script_directory_no_provider},
     {"i18n", test_i18n},
+    {"i18n_cache", test_i18n_cache},
+    {"read_file", test_read_file},
+    {"sniff", test_sniff},
+    {"hash", test_hash},
     {NULL, NULL},
 };
@@ -0,0 +1,234 @@
+#include "lua_file_list_ffi.h"
+
+#include <wchar.h>
+
+#include "file.h"
+
+struct gcmz_lua_file_list_ffi {
+  struct gcmz_file_list *list;    // File list of the running hook, NULL outside of hooks
+  struct gcmz_file_list *dropped; // Temporary files removed or renamed during the hook
+  gcmz_lua_schedule_cleanup_callback schedule_cleanup_callback;
+  void *userdata;
+};
+
+static struct gcmz_file *get_file(struct gcmz_lua_file_list_ffi *const ffi, size_t const index) {
+  if (!ffi) {
+    return NULL;
+  }
+  return gcmz_file_list_get_mutable(ffi->list, index);
+}
+
+/**
+ * @brief Remember a temporary file that is about to leave the list
+ *
+ * The entry is copied so that its cleanup can be decided once the hook has finished.
+ */
+static bool remember_dropped(struct gcmz_lua_file_list_ffi *const ffi,
+                             struct gcmz_file const *const file,
+                             struct ov_error *const err) {
+  if (!file->temporary || !ffi->schedule_cleanup_callback) {
+    return true;
+  }
+  if (!gcmz_file_list_add_copy(ffi->dropped, file, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  return true;
+}
+
+static size_t ffi_count(struct gcmz_lua_file_list_ffi *const ffi) {
+  return ffi ? gcmz_file_list_count(ffi->list) : 0;
+}
+
+static char const *ffi_get_path(struct gcmz_lua_file_list_ffi *const ffi, size_t const index) {
+  struct gcmz_file *const file = get_file(ffi, index);
+  if (!file) {
+    return NULL;
+  }
+  struct ov_error err = {0};
+  char const *path = NULL;
+  if (!gcmz_file_get_path_utf8(file, &path, &err)) {
+    OV_ERROR_REPORT(&err, NULL);
+    return NULL;
+  }
+  return path;
+}
+
+static char const *ffi_get_mime_type(struct gcmz_lua_file_list_ffi *const ffi, size_t const index) {
+  struct gcmz_file *const file = get_file(ffi, index);
+  if (!file) {
+    return NULL;
+  }
+  struct ov_error err = {0};
+  char const *mime_type = NULL;
+  if (!gcmz_file_get_mime_type_utf8(file, &mime_type, &err)) {
+    OV_ERROR_REPORT(&err, NULL);
+    return NULL;
+  }
+  return mime_type ? mime_type : "";
+}
+
+static bool ffi_get_temporary(struct gcmz_lua_file_list_ffi *const ffi, size_t const index) {
+  struct gcmz_file const *const file = get_file(ffi, index);
+  return file && file->temporary;
+}
+
+static bool ffi_set_path(struct gcmz_lua_file_list_ffi *const ffi, size_t const index, char const *const path) {
+  struct gcmz_file *const file = get_file(ffi, index);
+  if (!file || !path) {
+    return false;
+  }
+  struct ov_error err = {0};
+  if (!remember_dropped(ffi, file, &err) || !gcmz_file_set_path_utf8(file, path, &err)) {
+    OV_ERROR_REPORT(&err, NULL);
+    return false;
+  }
+  return true;
+}
+
+static bool
+ffi_set_mime_type(struct gcmz_lua_file_list_ffi *const ffi, size_t const index, char const *const mime_type) {
+  struct gcmz_file *const file = get_file(ffi, index);
+  if (!file) {
+    return false;
+  }
+  struct ov_error err = {0};
+  if (!gcmz_file_set_mime_type_utf8(file, mime_type, &err)) {
+    OV_ERROR_REPORT(&err, NULL);
+    return false;
+  }
+  return true;
+}
+
+static bool ffi_set_temporary(struct gcmz_lua_file_list_ffi *const ffi, size_t const index, bool const temporary) {
+  struct gcmz_file *const file = get_file(ffi, index);
+  if (!file) {
+    return false;
+  }
+  file->temporary = temporary;
+  return true;
+}
+
+static bool ffi_append(struct gcmz_lua_file_list_ffi *const ffi,
+                       char const *const path,
+                       char const *const mime_type,
+                       bool const temporary) {
+  if (!ffi || !ffi->list) {
+    return false;
+  }
+  struct ov_error err = {0};
+  if (!gcmz_file_list_add_utf8(ffi->list, path, mime_type, temporary, &err)) {
+    OV_ERROR_REPORT(&err, NULL);
+    return false;
+  }
+  return true;
+}
+
+static bool ffi_remove(struct gcmz_lua_file_list_ffi *const ffi, size_t const index) {
+  struct gcmz_file const *const file = get_file(ffi, index);
+  if (!file) {
+    return false;
+  }
+  struct ov_error err = {0};
+  if (!remember_dropped(ffi, file, &err) || !gcmz_file_list_remove(ffi->list, index, &err)) {
+    OV_ERROR_REPORT(&err, NULL);
+    return false;
+  }
+  return true;
+}
+
+struct gcmz_lua_file_list_ffi_api const *gcmz_lua_file_list_ffi_get_api(void) {
+  static struct gcmz_lua_file_list_ffi_api const api = {
+      .count = ffi_count,
+      .get_path = ffi_get_path,
+      .get_mime_type = ffi_get_mime_type,
+      .get_temporary = ffi_get_temporary,
+      .set_path = ffi_set_path,
+      .set_mime_type = ffi_set_mime_type,
+      .set_temporary = ffi_set_temporary,
+      .append = ffi_append,
+      .remove = ffi_remove,
+  };
+  return &api;
+}
+
+struct gcmz_lua_file_list_ffi *gcmz_lua_file_list_ffi_create(struct ov_error *const err) {
+  struct gcmz_lua_file_list_ffi *ffi = NULL;
+  struct gcmz_lua_file_list_ffi *result = NULL;
+
+  {
+    if (!OV_REALLOC(&ffi, 1, sizeof(*ffi))) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    *ffi = (struct gcmz_lua_file_list_ffi){0};
+    ffi->dropped = gcmz_file_list_create(err);
+    if (!ffi->dropped) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    result = ffi;
+    ffi = NULL;
+  }
+
+cleanup:
+  if (ffi) {
+    gcmz_lua_file_list_ffi_destroy(&ffi);
+  }
+  return result;
+}
+
+void gcmz_lua_file_list_ffi_destroy(struct gcmz_lua_file_list_ffi **const ffi) {
+  if (!ffi || !*ffi) {
+    return;
+  }
+  gcmz_file_list_destroy(&(*ffi)->dropped);
+  OV_FREE(ffi);
+}
+
+void gcmz_lua_file_list_ffi_begin(struct gcmz_lua_file_list_ffi *const ffi,
+                                  struct gcmz_file_list *const list,
+                                  gcmz_lua_schedule_cleanup_callback schedule_cleanup_callback,
+                                  void *userdata) {
+  if (!ffi) {
+    return;
+  }
+  ffi->list = list;
+  ffi->schedule_cleanup_callback = schedule_cleanup_callback;
+  ffi->userdata = userdata;
+  gcmz_file_list_clear(ffi->dropped);
+}
+
+void gcmz_lua_file_list_ffi_end(struct gcmz_lua_file_list_ffi *const ffi) {
+  if (!ffi) {
+    return;
+  }
+  size_t const dropped_count = gcmz_file_list_count(ffi->dropped);
+  size_t const count = gcmz_file_list_count(ffi->list);
+  for (size_t i = 0; i < dropped_count; i++) {
+    struct gcmz_file const *const dropped = gcmz_file_list_get(ffi->dropped, i);
+    bool found = false;
+    for (size_t j = 0; j < count && !found; j++) {
+      found = wcscmp(dropped->path, gcmz_file_list_get(ffi->list, j)->path) == 0;
+    }
+    // The same file may have been dropped twice, schedule it only for its first occurrence
+    for (size_t j = 0; j < i && !found; j++) {
+      found = wcscmp(dropped->path, gcmz_file_list_get(ffi->dropped, j)->path) == 0;
+    }
+    if (found) {
+      continue;
+    }
+    struct ov_error err = {0};
+    if (!ffi->schedule_cleanup_callback(dropped->path, ffi->userdata, &err)) {
+      OV_ERROR_REPORT(&err, NULL);
+    }
+  }
+  gcmz_file_list_clear(ffi->dropped);
+  ffi->list = NULL;
+  ffi->schedule_cleanup_callback = NULL;
+  ffi->userdata = NULL;
+}
+
+struct gcmz_file_list *gcmz_lua_file_list_ffi_get_list(struct gcmz_lua_file_list_ffi const *const ffi) {
+  return ffi ? ffi->list : NULL;
+}
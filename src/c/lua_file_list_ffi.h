@@ -0,0 +1,93 @@
+#pragma once
+
+#include <ovbase.h>
+
+#include "lua.h"
+
+struct gcmz_file_list;
+
+/**
+ * @brief File list shared with LuaJIT FFI handlers during a hook call
+ *
+ * Handlers that opt in receive a pointer to this structure as a cdata object and read or modify
+ * the file list in place through gcmz_lua_file_list_ffi_api, without building a files table.
+ * The list is only attached while a hook is running; outside of hooks every accessor fails.
+ */
+struct gcmz_lua_file_list_ffi;
+
+/**
+ * @brief Accessor functions called from Lua through the FFI
+ *
+ * The layout must match the declaration in entrypoint.lua.
+ * Indices are 0-based. Strings are UTF-8 and returned strings stay valid until the entry is modified or removed.
+ * Functions returning bool return false on failure; the error is reported and not passed to Lua.
+ */
+struct gcmz_lua_file_list_ffi_api {
+  size_t (*count)(struct gcmz_lua_file_list_ffi *const ffi);
+  char const *(*get_path)(struct gcmz_lua_file_list_ffi *const ffi, size_t const index); ///< NULL on failure
+  char const *(*get_mime_type)(struct gcmz_lua_file_list_ffi *const ffi,
+                               size_t const index); ///< Empty string if not set, NULL on failure
+  bool (*get_temporary)(struct gcmz_lua_file_list_ffi *const ffi, size_t const index);
+  bool (*set_path)(struct gcmz_lua_file_list_ffi *const ffi, size_t const index, char const *const path);
+  bool (*set_mime_type)(struct gcmz_lua_file_list_ffi *const ffi, size_t const index, char const *const mime_type);
+  bool (*set_temporary)(struct gcmz_lua_file_list_ffi *const ffi, size_t const index, bool const temporary);
+  bool (*append)(struct gcmz_lua_file_list_ffi *const ffi,
+                 char const *const path,
+                 char const *const mime_type,
+                 bool const temporary);
+  bool (*remove)(struct gcmz_lua_file_list_ffi *const ffi, size_t const index);
+};
+
+/**
+ * @brief Create the shared file list state of a Lua context
+ *
+ * @param err [out] Error information on failure
+ * @return Created state, NULL on failure
+ */
+NODISCARD struct gcmz_lua_file_list_ffi *gcmz_lua_file_list_ffi_create(struct ov_error *const err);
+
+/**
+ * @brief Destroy the shared file list state
+ *
+ * @param ffi [in,out] State to destroy, set to NULL on return
+ */
+void gcmz_lua_file_list_ffi_destroy(struct gcmz_lua_file_list_ffi **const ffi);
+
+/**
+ * @brief Get the accessor functions handed to Lua
+ *
+ * @return Accessor function table with static storage duration
+ */
+struct gcmz_lua_file_list_ffi_api const *gcmz_lua_file_list_ffi_get_api(void);
+
+/**
+ * @brief Attach the file list of the hook that is about to run
+ *
+ * @param ffi Shared file list state
+ * @param list File list of the hook, modified in place by the accessors
+ * @param schedule_cleanup_callback Callback for scheduling cleanup of removed temporary files (can be NULL)
+ * @param userdata User data passed to the callback
+ */
+void gcmz_lua_file_list_ffi_begin(struct gcmz_lua_file_list_ffi *const ffi,
+                                  struct gcmz_file_list *const list,
+                                  gcmz_lua_schedule_cleanup_callback schedule_cleanup_callback,
+                                  void *userdata);
+
+/**
+ * @brief Detach the file list when the hook has finished
+ *
+ * Temporary files that were removed or renamed through the accessors and are no longer
+ * in the list are scheduled for cleanup here, so that a file removed and added back by
+ * different handlers is kept. Failures are reported and do not fail the hook.
+ *
+ * @param ffi Shared file list state
+ */
+void gcmz_lua_file_list_ffi_end(struct gcmz_lua_file_list_ffi *const ffi);
+
+/**
+ * @brief Get the file list attached by gcmz_lua_file_list_ffi_begin
+ *
+ * @param ffi Shared file list state
+ * @return Attached file list, NULL outside of hooks
+ */
+struct gcmz_file_list *gcmz_lua_file_list_ffi_get_list(struct gcmz_lua_file_list_ffi const *const ffi);
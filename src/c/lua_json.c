@@ -0,0 +1,523 @@
+#include "lua_json.h"
+
+#ifdef __GNUC__
+#  ifndef __has_warning
+#    define __has_warning(x) 0
+#  endif
+#  pragma GCC diagnostic push
+#  if __has_warning("-Wreserved-macro-identifier")
+#    pragma GCC diagnostic ignored "-Wreserved-macro-identifier"
+#  endif
+#endif // __GNUC__
+#include <lauxlib.h>
+#include <lua.h>
+#ifdef __GNUC__
+#  pragma GCC diagnostic pop
+#endif // __GNUC__
+
+#include <math.h>
+
+#include "json.h"
+
+static char const json_document_key[] = "gcmz_json_document";
+
+enum {
+  max_depth = 1000,
+};
+
+/**
+ * @brief yyjson resources owned by a userdata, so they are released even if a Lua error interrupts the conversion
+ */
+struct json_document {
+  yyjson_doc *doc;
+  yyjson_mut_doc *mut_doc;
+  char *written;
+};
+
+static void json_document_release(struct json_document *const d) {
+  if (d->doc) {
+    yyjson_doc_free(d->doc);
+    d->doc = NULL;
+  }
+  if (d->mut_doc) {
+    yyjson_mut_doc_free(d->mut_doc);
+    d->mut_doc = NULL;
+  }
+  if (d->written) {
+    OV_FREE(&d->written);
+  }
+}
+
+static int json_document_gc(lua_State *L) {
+  struct json_document *const d = (struct json_document *)luaL_checkudata(L, 1, json_document_key);
+  json_document_release(d);
+  return 0;
+}
+
+/**
+ * @brief Push a new empty json_document userdata
+ */
+static struct json_document *push_json_document(lua_State *L) {
+  struct json_document *const d = (struct json_document *)lua_newuserdata(L, sizeof(struct json_document));
+  *d = (struct json_document){0};
+  luaL_getmetatable(L, json_document_key);
+  lua_setmetatable(L, -2);
+  return d;
+}
+
+/**
+ * @brief Raise a decode error in the same format as json.lua ("msg at line N col M")
+ *
+ * The message is chosen from the yyjson error code rather than taken from yyjson, so it does not change
+ * with the yyjson version. It uses json.lua's wording where an error code has a json.lua counterpart.
+ */
+static int decode_error(lua_State *L, char const *const str, size_t const len, yyjson_read_err const *const err) {
+  int line = 1;
+  int col = 1;
+  size_t const pos = err->pos < len ? err->pos : len;
+  for (size_t i = 0; i < pos; ++i) {
+    if (str[i] == '\n') {
+      ++line;
+      col = 1;
+    } else {
+      ++col;
+    }
+  }
+  yyjson_read_code const code = err->code;
+  if (code == YYJSON_READ_ERROR_UNEXPECTED_CHARACTER && pos < len && str[pos] > ' ' && str[pos] < 0x7f) {
+    return luaL_error(L, "unexpected character '%c' at line %d col %d", str[pos], line, col);
+  }
+  char const *msg = "invalid JSON";
+  if (code == YYJSON_READ_ERROR_MEMORY_ALLOCATION) {
+    msg = "out of memory";
+  } else if (code == YYJSON_READ_ERROR_EMPTY_CONTENT || code == YYJSON_READ_ERROR_UNEXPECTED_END ||
+             (code == YYJSON_READ_ERROR_INVALID_PARAMETER && len == 0)) {
+    msg = "unexpected end of input";
+  } else if (code == YYJSON_READ_ERROR_UNEXPECTED_CONTENT) {
+    msg = "trailing garbage";
+  } else if (code == YYJSON_READ_ERROR_UNEXPECTED_CHARACTER) {
+    msg = "unexpected character";
+  } else if (code == YYJSON_READ_ERROR_INVALID_NUMBER) {
+    msg = "invalid number";
+  } else if (code == YYJSON_READ_ERROR_INVALID_STRING) {
+    msg = "invalid string";
+  } else if (code == YYJSON_READ_ERROR_LITERAL) {
+    msg = "invalid literal";
+  }
+  return luaL_error(L, "%s at line %d col %d", msg, line, col);
+}
+
+/**
+ * @brief Parse a JSON string into a document owned by the json_document userdata
+ */
+static void parse_document(lua_State *L, struct json_document *const d, char const *const str, size_t const len) {
+  yyjson_read_err err = {0};
+  // Invalid UTF-8 is passed through like json.lua does; sidecar files are not always clean
+  d->doc = yyjson_read_opts(
+      (char *)ov_deconster_(str), len, YYJSON_READ_ALLOW_INVALID_UNICODE, gcmz_json_get_alc(), &err);
+  if (!d->doc) {
+    decode_error(L, str, len, &err);
+  }
+}
+
+/**
+ * @brief Push the Lua value of a JSON value, converting containers recursively
+ *
+ * null becomes nil, like json.lua.
+ */
+static void push_value(lua_State *L, yyjson_val *const val, int const depth) {
+  switch (yyjson_get_type(val)) {
+  case YYJSON_TYPE_BOOL:
+    lua_pushboolean(L, yyjson_get_bool(val));
+    return;
+  case YYJSON_TYPE_NUM:
+    switch (yyjson_get_subtype(val)) {
+    case YYJSON_SUBTYPE_UINT:
+      lua_pushnumber(L, (lua_Number)yyjson_get_uint(val));
+      return;
+    case YYJSON_SUBTYPE_SINT:
+      lua_pushnumber(L, (lua_Number)yyjson_get_sint(val));
+      return;
+    default:
+      lua_pushnumber(L, (lua_Number)yyjson_get_real(val));
+      return;
+    }
+  case YYJSON_TYPE_STR:
+    lua_pushlstring(L, yyjson_get_str(val), yyjson_get_len(val));
+    return;
+  case YYJSON_TYPE_ARR: {
+    if (depth >= max_depth) {
+      luaL_error(L, "too deeply nested");
+      return;
+    }
+    luaL_checkstack(L, 2, "too deeply nested");
+    lua_createtable(L, (int)yyjson_arr_size(val), 0);
+    size_t idx, max;
+    yyjson_val *item;
+    yyjson_arr_foreach(val, idx, max, item) {
+      push_value(L, item, depth + 1);
+      lua_rawseti(L, -2, (int)idx + 1);
+    }
+    return;
+  }
+  case YYJSON_TYPE_OBJ: {
+    if (depth >= max_depth) {
+      luaL_error(L, "too deeply nested");
+      return;
+    }
+    luaL_checkstack(L, 3, "too deeply nested");
+    lua_createtable(L, 0, (int)yyjson_obj_size(val));
+    size_t idx, max;
+    yyjson_val *key;
+    yyjson_val *item;
+    yyjson_obj_foreach(val, idx, max, key, item) {
+      lua_pushlstring(L, yyjson_get_str(key), yyjson_get_len(key));
+      push_value(L, item, depth + 1);
+      lua_rawset(L, -3);
+    }
+    return;
+  }
+  default:
+    lua_pushnil(L);
+    return;
+  }
+}
+
+/**
+ * @brief json.decode(str) - Parse a JSON string into Lua values
+ */
+static int json_decode(lua_State *L) {
+  if (lua_type(L, 1) != LUA_TSTRING) {
+    return luaL_error(L, "expected argument of type string, got %s", luaL_typename(L, 1));
+  }
+  size_t len = 0;
+  char const *const str = lua_tolstring(L, 1, &len);
+  struct json_document *const d = push_json_document(L);
+  parse_document(L, d, str, len);
+  push_value(L, yyjson_doc_get_root(d->doc), 0);
+  // The tables are built, the document is no longer needed
+  json_document_release(d);
+  return 1;
+}
+
+static yyjson_mut_val *
+encode_value(lua_State *L, yyjson_mut_doc *const doc, int const idx, int const seen, int const depth);
+
+/**
+ * @brief Convert a Lua table to a JSON array or object
+ *
+ * Follows the rules of json.lua: a table with [1] or without any key is an array, which must not be sparse;
+ * any other table is an object, which must only have string keys.
+ */
+static yyjson_mut_val *
+encode_table(lua_State *L, yyjson_mut_doc *const doc, int const idx, int const seen, int const depth) {
+  if (depth >= max_depth) {
+    luaL_error(L, "too deeply nested");
+    return NULL;
+  }
+  luaL_checkstack(L, 4, "too deeply nested");
+
+  lua_pushvalue(L, idx);
+  lua_rawget(L, seen);
+  if (lua_toboolean(L, -1)) {
+    luaL_error(L, "circular reference");
+    return NULL;
+  }
+  lua_pop(L, 1);
+  lua_pushvalue(L, idx);
+  lua_pushboolean(L, 1);
+  lua_rawset(L, seen);
+
+  lua_rawgeti(L, idx, 1);
+  bool is_array = !lua_isnil(L, -1);
+  lua_pop(L, 1);
+  if (!is_array) {
+    lua_pushnil(L);
+    if (lua_next(L, idx) == 0) {
+      is_array = true;
+    } else {
+      lua_pop(L, 2);
+    }
+  }
+
+  yyjson_mut_val *result = NULL;
+  if (is_array) {
+    size_t n = 0;
+    lua_pushnil(L);
+    while (lua_next(L, idx) != 0) {
+      if (lua_type(L, -2) != LUA_TNUMBER) {
+        luaL_error(L, "invalid table: mixed or invalid key types");
+        return NULL;
+      }
+      ++n;
+      lua_pop(L, 1);
+    }
+    size_t const len = lua_objlen(L, idx);
+    if (n != len) {
+      luaL_error(L, "invalid table: sparse array");
+      return NULL;
+    }
+    result = yyjson_mut_arr(doc);
+    if (!result) {
+      luaL_error(L, "not enough memory");
+      return NULL;
+    }
+    for (size_t i = 1; i <= len; ++i) {
+      lua_rawgeti(L, idx, (int)i);
+      yyjson_mut_val *const v = encode_value(L, doc, lua_gettop(L), seen, depth + 1);
+      if (!yyjson_mut_arr_append(result, v)) {
+        luaL_error(L, "not enough memory");
+        return NULL;
+      }
+      lua_pop(L, 1);
+    }
+  } else {
+    result = yyjson_mut_obj(doc);
+    if (!result) {
+      luaL_error(L, "not enough memory");
+      return NULL;
+    }
+    lua_pushnil(L);
+    while (lua_next(L, idx) != 0) {
+      if (lua_type(L, -2) != LUA_TSTRING) {
+        luaL_error(L, "invalid table: mixed or invalid key types");
+        return NULL;
+      }
+      size_t key_len = 0;
+      char const *const key_str = lua_tolstring(L, -2, &key_len);
+      // The strings stay referenced by the table while the document is written, so they are not copied
+      yyjson_mut_val *const key = yyjson_mut_strn(doc, key_str, key_len);
+      yyjson_mut_val *const v = encode_value(L, doc, lua_gettop(L), seen, depth + 1);
+      if (!key || !yyjson_mut_obj_add(result, key, v)) {
+        luaL_error(L, "not enough memory");
+        return NULL;
+      }
+      lua_pop(L, 1);
+    }
+  }
+
+  lua_pushvalue(L, idx);
+  lua_pushnil(L);
+  lua_rawset(L, seen);
+  return result;
+}
+
+/**
+ * @brief Convert the Lua value at idx to a JSON value, raising a Lua error for values json.lua rejects
+ */
+static yyjson_mut_val *
+encode_value(lua_State *L, yyjson_mut_doc *const doc, int const idx, int const seen, int const depth) {
+  yyjson_mut_val *v = NULL;
+  switch (lua_type(L, idx)) {
+  case LUA_TNIL:
+    v = yyjson_mut_null(doc);
+    break;
+  case LUA_TBOOLEAN:
+    v = yyjson_mut_bool(doc, lua_toboolean(L, idx) != 0);
+    break;
+  case LUA_TNUMBER: {
+    lua_Number const n = lua_tonumber(L, idx);
+    if (n != n || n <= -HUGE_VAL || n >= HUGE_VAL) {
+      luaL_error(L, "unexpected number value '%f'", n);
+      return NULL;
+    }
+    // Integral values are written without a fraction, like the "%.14g" format of json.lua
+    if (n == floor(n) && n >= -9007199254740992.0 && n <= 9007199254740992.0) {
+      v = yyjson_mut_sint(doc, (int64_t)n);
+    } else {
+      v = yyjson_mut_real(doc, (double)n);
+    }
+    break;
+  }
+  case LUA_TSTRING: {
+    size_t len = 0;
+    char const *const str = lua_tolstring(L, idx, &len);
+    v = yyjson_mut_strn(doc, str, len);
+    break;
+  }
+  case LUA_TTABLE:
+    return encode_table(L, doc, idx, seen, depth);
+  default:
+    luaL_error(L, "unexpected type '%s'", luaL_typename(L, idx));
+    return NULL;
+  }
+  if (!v) {
+    luaL_error(L, "not enough memory");
+  }
+  return v;
+}
+
+/**
+ * @brief json.encode(value) - Convert a Lua value to a JSON string
+ */
+static int json_encode(lua_State *L) {
+  lua_settop(L, 1);
+  struct json_document *const d = push_json_document(L);
+  lua_newtable(L); // Tables being converted, to detect circular references
+  int const seen = lua_gettop(L);
+
+  d->mut_doc = yyjson_mut_doc_new(gcmz_json_get_alc());
+  if (!d->mut_doc) {
+    return luaL_error(L, "not enough memory");
+  }
+  yyjson_mut_doc_set_root(d->mut_doc, encode_value(L, d->mut_doc, 1, seen, 0));
+
+  size_t len = 0;
+  yyjson_write_err err = {0};
+  d->written = yyjson_mut_write_opts(d->mut_doc, YYJSON_WRITE_ALLOW_INVALID_UNICODE, gcmz_json_get_alc(), &len, &err);
+  if (!d->written) {
+    return luaL_error(L, "%s", err.msg ? err.msg : "failed to write JSON");
+  }
+  lua_pushlstring(L, d->written, len);
+  json_document_release(d);
+  return 1;
+}
+
+/**
+ * @brief Get the open document of a json_document userdata, raising an error if it was closed
+ */
+static yyjson_doc *check_open_document(lua_State *L) {
+  struct json_document *const d = (struct json_document *)luaL_checkudata(L, 1, json_document_key);
+  if (!d->doc) {
+    luaL_error(L, "attempt to use a closed JSON document");
+    return NULL;
+  }
+  return d->doc;
+}
+
+/**
+ * @brief Look up the value at the JSON Pointer given as the second argument (the root if omitted)
+ */
+static yyjson_val *lookup_pointer(lua_State *L, yyjson_doc *const doc) {
+  size_t len = 0;
+  char const *const ptr = luaL_optlstring(L, 2, "", &len);
+  if (len == 0) {
+    return yyjson_doc_get_root(doc);
+  }
+  return yyjson_doc_ptr_getn(doc, ptr, len);
+}
+
+/**
+ * @brief doc:get([pointer]) - Convert the value at a JSON Pointer to Lua values
+ *
+ * Only the addressed value and its descendants are converted.
+ * Returns nil if the pointer does not resolve.
+ */
+static int json_document_get(lua_State *L) {
+  yyjson_val *const val = lookup_pointer(L, check_open_document(L));
+  if (!val) {
+    lua_pushnil(L);
+    return 1;
+  }
+  push_value(L, val, 0);
+  return 1;
+}
+
+/**
+ * @brief doc:len([pointer]) - Number of elements of the array or object at a JSON Pointer
+ *
+ * Returns nil if the pointer does not resolve to an array or an object.
+ */
+static int json_document_len(lua_State *L) {
+  yyjson_val *const val = lookup_pointer(L, check_open_document(L));
+  if (yyjson_is_arr(val)) {
+    lua_pushnumber(L, (lua_Number)yyjson_arr_size(val));
+  } else if (yyjson_is_obj(val)) {
+    lua_pushnumber(L, (lua_Number)yyjson_obj_size(val));
+  } else {
+    lua_pushnil(L);
+  }
+  return 1;
+}
+
+/**
+ * @brief doc:keys([pointer]) - Keys of the object at a JSON Pointer in document order
+ *
+ * Returns nil if the pointer does not resolve to an object.
+ */
+static int json_document_keys(lua_State *L) {
+  yyjson_val *const val = lookup_pointer(L, check_open_document(L));
+  if (!yyjson_is_obj(val)) {
+    lua_pushnil(L);
+    return 1;
+  }
+  lua_createtable(L, (int)yyjson_obj_size(val), 0);
+  size_t idx, max;
+  yyjson_val *key;
+  yyjson_val *item;
+  yyjson_obj_foreach(val, idx, max, key, item) {
+    (void)item;
+    lua_pushlstring(L, yyjson_get_str(key), yyjson_get_len(key));
+    lua_rawseti(L, -2, (int)idx + 1);
+  }
+  return 1;
+}
+
+/**
+ * @brief doc:close() - Release the parsed document without waiting for the garbage collector
+ */
+static int json_document_close(lua_State *L) {
+  struct json_document *const d = (struct json_document *)luaL_checkudata(L, 1, json_document_key);
+  json_document_release(d);
+  return 0;
+}
+
+/**
+ * @brief json.decode_lazy(str) - Parse a JSON string into a document converted on demand
+ */
+static int json_decode_lazy(lua_State *L) {
+  if (lua_type(L, 1) != LUA_TSTRING) {
+    return luaL_error(L, "expected argument of type string, got %s", luaL_typename(L, 1));
+  }
+  size_t len = 0;
+  char const *const str = lua_tolstring(L, 1, &len);
+  struct json_document *const d = push_json_document(L);
+  parse_document(L, d, str, len);
+  return 1;
+}
+
+/**
+ * @brief Loader of the json module, stored in package.preload
+ */
+static int json_open(lua_State *L) {
+  if (luaL_newmetatable(L, json_document_key)) {
+    lua_pushcfunction(L, json_document_get);
+    lua_setfield(L, -2, "get");
+    lua_pushcfunction(L, json_document_len);
+    lua_setfield(L, -2, "len");
+    lua_pushcfunction(L, json_document_keys);
+    lua_setfield(L, -2, "keys");
+    lua_pushcfunction(L, json_document_close);
+    lua_setfield(L, -2, "close");
+    lua_pushcfunction(L, json_document_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "__index");
+  }
+  lua_pop(L, 1);
+
+  lua_createtable(L, 0, 3);
+  lua_pushcfunction(L, json_decode);
+  lua_setfield(L, -2, "decode");
+  lua_pushcfunction(L, json_decode_lazy);
+  lua_setfield(L, -2, "decode_lazy");
+  lua_pushcfunction(L, json_encode);
+  lua_setfield(L, -2, "encode");
+  return 1;
+}
+
+void gcmz_lua_json_register(struct lua_State *const L) {
+  if (!L) {
+    return;
+  }
+  lua_getglobal(L, "package");
+  if (lua_istable(L, -1)) {
+    lua_getfield(L, -1, "preload");
+    if (lua_istable(L, -1)) {
+      lua_pushcfunction(L, json_open);
+      lua_setfield(L, -2, "json");
+    }
+    lua_pop(L, 1); // Pop preload
+  }
+  lua_pop(L, 1); // Pop package
+}
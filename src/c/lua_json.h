@@ -0,0 +1,14 @@
+#pragma once
+
+struct lua_State;
+
+/**
+ * @brief Register the native json module
+ *
+ * Adds the module to package.preload so that require("json") returns it instead of a json.lua found on
+ * package.path. The module provides json.decode and json.encode backed by yyjson, and json.decode_lazy
+ * which parses a document once and converts only the parts that are looked up.
+ *
+ * @param L Lua state
+ */
+void gcmz_lua_json_register(struct lua_State *const L);
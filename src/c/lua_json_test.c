@@ -0,0 +1,170 @@
+#include <ovtest.h>
+
+#include <string.h>
+
+#include "lua_json.h"
+
+#ifdef __GNUC__
+#  ifndef __has_warning
+#    define __has_warning(x) 0
+#  endif
+#  pragma GCC diagnostic push
+#  if __has_warning("-Wreserved-macro-identifier")
+#    pragma GCC diagnostic ignored "-Wreserved-macro-identifier"
+#  endif
+#endif // __GNUC__
+#include <lauxlib.h>
+#include <lua.h>
+#include <lualib.h>
+#ifdef __GNUC__
+#  pragma GCC diagnostic pop
+#endif // __GNUC__
+
+static lua_State *create_state(void) {
+  lua_State *L = luaL_newstate();
+  if (!L) {
+    return NULL;
+  }
+  luaL_openlibs(L);
+  gcmz_lua_json_register(L);
+  if (luaL_dostring(L, "json = require('json')") != LUA_OK) {
+    lua_close(L);
+    return NULL;
+  }
+  return L;
+}
+
+// Run a chunk and leave its first result on the stack
+static bool run(lua_State *L, char const *const code) {
+  if (luaL_loadstring(L, code) != LUA_OK || lua_pcall(L, 0, 1, 0) != LUA_OK) {
+    TEST_MSG("%s: %s", code, lua_tostring(L, -1));
+    lua_pop(L, 1);
+    return false;
+  }
+  return true;
+}
+
+// Run a chunk that is expected to fail and check that the error message contains the given text
+static void check_error(lua_State *L, char const *const code, char const *const want) {
+  bool const failed = luaL_loadstring(L, code) == LUA_OK && lua_pcall(L, 0, 0, 0) != LUA_OK;
+  if (!TEST_CHECK(failed)) {
+    TEST_MSG("%s: expected an error", code);
+    return;
+  }
+  char const *const msg = lua_tostring(L, -1);
+  TEST_CHECK(msg != NULL && strstr(msg, want) != NULL);
+  TEST_MSG("%s: want error containing '%s', got '%s'", code, want, msg ? msg : "(null)");
+  lua_pop(L, 1);
+}
+
+static void check_encode(lua_State *L, char const *const code, char const *const want) {
+  if (!TEST_CHECK(run(L, code))) {
+    return;
+  }
+  char const *const got = lua_tostring(L, -1);
+  TEST_CHECK(got != NULL && strcmp(got, want) == 0);
+  TEST_MSG("%s: want %s, got %s", code, want, got ? got : "(null)");
+  lua_pop(L, 1);
+}
+
+static void test_lua_json_decode(void) {
+  lua_State *L = create_state();
+  if (!TEST_CHECK(L != NULL)) {
+    return;
+  }
+
+  TEST_CHECK(run(L, "local v = json.decode('{\"name\":\"\\\\u592a\\\\u90ce\",\"age\":25,\"ok\":true,\"none\":null}')\n"
+                    "assert(v.name == '\\229\\164\\170\\233\\131\\142')\n"
+                    "assert(v.age == 25)\n"
+                    "assert(v.ok == true)\n"
+                    "assert(v.none == nil)\n"
+                    "return true"));
+  lua_settop(L, 0);
+
+  TEST_CHECK(run(L, "local v = json.decode(' [1, -2.5, \"four\", [], {\"id\": 1e2}] ')\n"
+                    "assert(#v == 5)\n"
+                    "assert(v[1] == 1 and v[2] == -2.5 and v[3] == 'four')\n"
+                    "assert(type(v[4]) == 'table' and next(v[4]) == nil)\n"
+                    "assert(v[5].id == 100)\n"
+                    "return true"));
+  lua_settop(L, 0);
+
+  TEST_CHECK(run(L, "assert(json.decode('null') == nil)\n"
+                    "assert(json.decode('\"\\\\ud83d\\\\ude00\"') == '\\240\\159\\152\\128')\n"
+                    "return true"));
+  lua_settop(L, 0);
+
+  check_error(L, "json.decode('{\\n  \"a\": tru\\n}')", "invalid literal at line 2 col");
+  check_error(L, "json.decode('[1, 2')", "unexpected end of input at line 1 col");
+  check_error(L, "json.decode('')", "unexpected end of input at line 1 col 1");
+  check_error(L, "json.decode('[1] 2')", "trailing garbage at line 1 col");
+  check_error(L, "json.decode('{\"a\" 1}')", "unexpected character '1' at line 1 col 6");
+  check_error(L, "json.decode('[01]')", "invalid number at line 1 col");
+  check_error(L, "json.decode('\"\\\\q\"')", "invalid string at line 1 col");
+  check_error(L, "json.decode(42)", "expected argument of type string, got number");
+
+  lua_close(L);
+}
+
+static void test_lua_json_encode(void) {
+  lua_State *L = create_state();
+  if (!TEST_CHECK(L != NULL)) {
+    return;
+  }
+
+  check_encode(L, "return json.encode({1, 2, 3})", "[1,2,3]");
+  check_encode(L, "return json.encode({})", "[]");
+  check_encode(L, "return json.encode({a = {b = true}})", "{\"a\":{\"b\":true}}");
+  check_encode(L, "return json.encode(0.5)", "0.5");
+  check_encode(L, "return json.encode(-3)", "-3");
+  check_encode(L, "return json.encode('a\"b\\n')", "\"a\\\"b\\n\"");
+  check_encode(L, "return json.encode(nil)", "null");
+
+  // Round trip keeps the structure
+  TEST_CHECK(run(L, "local v = json.decode(json.encode({items = {{id = 1}, {id = 2}}, title = 'x'}))\n"
+                    "assert(v.items[2].id == 2 and v.title == 'x')\n"
+                    "return true"));
+  lua_settop(L, 0);
+
+  check_error(L, "local t = {} t.self = t json.encode(t)", "circular reference");
+  check_error(L, "json.encode({1, nil, 3, n = 4})", "invalid table");
+  check_error(L, "json.encode({[1] = 1, [3] = 3})", "invalid table: sparse array");
+  check_error(L, "json.encode({[true] = 1})", "invalid table: mixed or invalid key types");
+  check_error(L, "json.encode(0/0)", "unexpected number value");
+  check_error(L, "json.encode(print)", "unexpected type 'function'");
+
+  lua_close(L);
+}
+
+static void test_lua_json_decode_lazy(void) {
+  lua_State *L = create_state();
+  if (!TEST_CHECK(L != NULL)) {
+    return;
+  }
+
+  TEST_CHECK(run(L, "local doc = json.decode_lazy('{\"title\":\"cue\",\"items\":[{\"id\":1},{\"id\":2,\"a/b\":3}]}')\n"
+                    "assert(doc:get('/title') == 'cue')\n"
+                    "assert(doc:len('/items') == 2)\n"
+                    "assert(doc:get('/items/1/id') == 2)\n"
+                    "assert(doc:get('/items/1/a~1b') == 3)\n"
+                    "assert(doc:get('/items/5') == nil)\n"
+                    "assert(doc:len('/title') == nil)\n"
+                    "local keys = doc:keys()\n"
+                    "assert(#keys == 2 and keys[1] == 'title' and keys[2] == 'items')\n"
+                    "assert(doc:get().items[1].id == 1)\n"
+                    "doc:close()\n"
+                    "return true"));
+  lua_settop(L, 0);
+
+  check_error(L, "local doc = json.decode_lazy('[]') doc:close() doc:get()", "closed JSON document");
+  check_error(L, "json.decode_lazy('{')", "at line 1 col");
+
+  lua_close(L);
+}
+
+TEST_LIST = {
+    {"test_lua_json_decode", test_lua_json_decode},
+    {"test_lua_json_encode", test_lua_json_encode},
+    {"test_lua_json_decode_lazy", test_lua_json_decode_lazy},
+    {NULL, NULL},
+};
@@ -9,16 +9,44 @@
 
 #include <string.h>
 
+// LuaJIT reports cdata objects with this type, lua.h has no name for it
+enum {
+  lua_type_cdata = 10,
+};
+
+static char const ffi_helpers_key[] = "gcmz_script_module_ffi";
+
+enum ffi_helper {
+  ffi_helper_sizeof = 1,
+  ffi_helper_istype = 2,
+  ffi_helper_double_array = 3,
+  ffi_helper_int_array = 4,
+};
+
+enum typed_array_type {
+  typed_array_none,
+  typed_array_double,
+  typed_array_int,
+};
+
 struct script_module_param_context {
   lua_State *L;
   int base;
   int num_args;
   int num_pushed;
   bool has_error;
+  bool typed_arrays;
   char *error_msg;
+
+  // Last array argument looked up by get_typed_array
+  int array_index;
+  enum typed_array_type array_type;
+  void const *array_data;
+  int array_num;
 };
 
-static struct script_module_param_context *g_ctx = NULL;
+// Script module callbacks take no context, and handlers on the Lua worker threads call them as well as the UI thread
+static _Thread_local struct script_module_param_context *g_ctx = NULL;
 
 static int param_get_num(void) {
   if (!g_ctx) {
@@ -65,66 +93,179 @@ static bool param_get_boolean(int index) {
   return lua_toboolean(g_ctx->L, g_ctx->base + index) != 0;
 }
 
-static int param_get_table_int(int index, char const *key) {
+/**
+ * @brief Push a field of a table argument without invoking metamethods
+ *
+ * @return true if the field was pushed, false if the argument is not a table
+ */
+static bool push_table_field(int index, char const *key) {
   if (!g_ctx || index < 0 || index >= g_ctx->num_args || !key) {
-    return 0;
+    return false;
   }
   int const stack_index = g_ctx->base + index;
   if (!lua_istable(g_ctx->L, stack_index)) {
+    return false;
+  }
+  lua_pushstring(g_ctx->L, key);
+  lua_rawget(g_ctx->L, stack_index);
+  return true;
+}
+
+static int param_get_table_int(int index, char const *key) {
+  if (!push_table_field(index, key)) {
     return 0;
   }
-  lua_getfield(g_ctx->L, stack_index, key);
   int const result = (int)lua_tointeger(g_ctx->L, -1);
   lua_pop(g_ctx->L, 1);
   return result;
 }
 
 static double param_get_table_double(int index, char const *key) {
-  if (!g_ctx || index < 0 || index >= g_ctx->num_args || !key) {
+  if (!push_table_field(index, key)) {
     return 0.0;
   }
-  int const stack_index = g_ctx->base + index;
-  if (!lua_istable(g_ctx->L, stack_index)) {
-    return 0.0;
-  }
-  lua_getfield(g_ctx->L, stack_index, key);
   double const result = lua_tonumber(g_ctx->L, -1);
   lua_pop(g_ctx->L, 1);
   return result;
 }
 
 static char const *param_get_table_string(int index, char const *key) {
-  if (!g_ctx || index < 0 || index >= g_ctx->num_args || !key) {
-    return NULL;
-  }
-  int const stack_index = g_ctx->base + index;
-  if (!lua_istable(g_ctx->L, stack_index)) {
+  if (!push_table_field(index, key)) {
     return NULL;
   }
-  lua_getfield(g_ctx->L, stack_index, key);
   char const *const result = lua_tostring(g_ctx->L, -1);
   lua_pop(g_ctx->L, 1);
   return result;
 }
 
 static bool param_get_table_boolean(int index, char const *key) {
-  if (!g_ctx || index < 0 || index >= g_ctx->num_args || !key) {
-    return false;
-  }
-  int const stack_index = g_ctx->base + index;
-  if (!lua_istable(g_ctx->L, stack_index)) {
+  if (!push_table_field(index, key)) {
     return false;
   }
-  lua_getfield(g_ctx->L, stack_index, key);
   bool const result = lua_toboolean(g_ctx->L, -1) != 0;
   lua_pop(g_ctx->L, 1);
   return result;
 }
 
+static void param_set_error(char const *message);
+
+/**
+ * @brief Call an FFI helper in protected mode
+ *
+ * A Lua error must not unwind through the native script module function that is running,
+ * so a failure is recorded as the error of the call and the message is popped.
+ * Stack: [fn, args...] -> [results...] on success, [] on failure.
+ *
+ * @return true on success
+ */
+static bool call_ffi_helper(lua_State *const L, int const nargs, int const nresults) {
+  if (lua_pcall(L, nargs, nresults, 0) == 0) {
+    return true;
+  }
+  char const *const message = lua_tostring(L, -1);
+  param_set_error(message ? message : "typed array operation failed");
+  lua_pop(L, 1);
+  return false;
+}
+
+/**
+ * @brief Push the FFI helpers used for typed arrays
+ *
+ * The helpers are created on first use and kept in the registry.
+ * Stack: [] -> [helpers] on success, unchanged on failure.
+ */
+static bool push_ffi_helpers(lua_State *const L) {
+  lua_getfield(L, LUA_REGISTRYINDEX, ffi_helpers_key);
+  if (lua_istable(L, -1)) {
+    return true;
+  }
+  lua_pop(L, 1);
+  static char const code[] = "local ffi = require('ffi')\n"
+                             "return { ffi.sizeof, ffi.istype, ffi.typeof('double[?]'), ffi.typeof('int[?]') }\n";
+  if (luaL_loadbuffer(L, code, sizeof(code) - 1, "=script_module_ffi") != 0 || lua_pcall(L, 0, 1, 0) != 0 ||
+      !lua_istable(L, -1)) {
+    lua_pop(L, 1);
+    return false;
+  }
+  lua_pushvalue(L, -1);
+  lua_setfield(L, LUA_REGISTRYINDEX, ffi_helpers_key);
+  return true;
+}
+
+/**
+ * @brief Look up a typed array argument
+ *
+ * Accepts arrays created with ffi.new("double[?]", n) or ffi.new("int[?]", n).
+ * The result is cached for the last looked up argument, so reading the elements
+ * one by one costs a pointer access instead of a table lookup each.
+ *
+ * @return true if the argument is a typed array
+ */
+static bool get_typed_array(int index) {
+  if (g_ctx->array_index == index) {
+    return g_ctx->array_type != typed_array_none;
+  }
+  lua_State *const L = g_ctx->L;
+  int const stack_index = g_ctx->base + index;
+  g_ctx->array_index = index;
+  g_ctx->array_type = typed_array_none;
+  g_ctx->array_data = NULL;
+  g_ctx->array_num = 0;
+  if (lua_type(L, stack_index) != lua_type_cdata || !push_ffi_helpers(L)) {
+    return false;
+  }
+  int const helpers = lua_gettop(L);
+  static struct {
+    enum typed_array_type type;
+    int ctype;
+    size_t element_size;
+  } const types[] = {
+      {typed_array_double, ffi_helper_double_array, sizeof(double)},
+      {typed_array_int, ffi_helper_int_array, sizeof(int)},
+  };
+  for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+    lua_rawgeti(L, helpers, ffi_helper_istype);
+    lua_rawgeti(L, helpers, types[i].ctype);
+    lua_pushvalue(L, stack_index);
+    if (!call_ffi_helper(L, 2, 1)) {
+      break;
+    }
+    bool const matched = lua_toboolean(L, -1) != 0;
+    lua_pop(L, 1);
+    if (!matched) {
+      continue;
+    }
+    lua_rawgeti(L, helpers, ffi_helper_sizeof);
+    lua_pushvalue(L, stack_index);
+    if (!call_ffi_helper(L, 1, 1)) {
+      break;
+    }
+    g_ctx->array_type = types[i].type;
+    g_ctx->array_data = lua_topointer(L, stack_index);
+    g_ctx->array_num = (int)((size_t)lua_tointeger(L, -1) / types[i].element_size);
+    break;
+  }
+  lua_settop(L, helpers - 1);
+  return g_ctx->array_type != typed_array_none;
+}
+
+static double get_typed_array_element(int key) {
+  if (key < 0 || key >= g_ctx->array_num) {
+    return 0.0;
+  }
+  if (g_ctx->array_type == typed_array_int) {
+    return ((int const *)g_ctx->array_data)[key];
+  }
+  return ((double const *)g_ctx->array_data)[key];
+}
+
 static int param_get_array_num(int index) {
   if (!g_ctx || index < 0 || index >= g_ctx->num_args) {
     return 0;
   }
+  if (get_typed_array(index)) {
+    return g_ctx->array_num;
+  }
   int const stack_index = g_ctx->base + index;
   if (!lua_istable(g_ctx->L, stack_index)) {
     return 0;
@@ -136,6 +277,9 @@ static int param_get_array_int(int index, int key) {
   if (!g_ctx || index < 0 || index >= g_ctx->num_args) {
     return 0;
   }
+  if (get_typed_array(index)) {
+    return (int)get_typed_array_element(key);
+  }
   int const stack_index = g_ctx->base + index;
   if (!lua_istable(g_ctx->L, stack_index)) {
     return 0;
@@ -150,6 +294,9 @@ static double param_get_array_double(int index, int key) {
   if (!g_ctx || index < 0 || index >= g_ctx->num_args) {
     return 0.0;
   }
+  if (get_typed_array(index)) {
+    return get_typed_array_element(key);
+  }
   int const stack_index = g_ctx->base + index;
   if (!lua_istable(g_ctx->L, stack_index)) {
     return 0.0;
@@ -225,8 +372,9 @@ static void param_push_table_int(char const **keys, int *values, int num) {
   lua_createtable(g_ctx->L, 0, num);
   for (int i = 0; i < num; i++) {
     if (keys[i]) {
+      lua_pushstring(g_ctx->L, keys[i]);
       lua_pushinteger(g_ctx->L, values[i]);
-      lua_setfield(g_ctx->L, -2, keys[i]);
+      lua_rawset(g_ctx->L, -3);
     }
   }
   g_ctx->num_pushed++;
@@ -239,8 +387,9 @@ static void param_push_table_double(char const **keys, double *values, int num)
   lua_createtable(g_ctx->L, 0, num);
   for (int i = 0; i < num; i++) {
     if (keys[i]) {
+      lua_pushstring(g_ctx->L, keys[i]);
       lua_pushnumber(g_ctx->L, values[i]);
-      lua_setfield(g_ctx->L, -2, keys[i]);
+      lua_rawset(g_ctx->L, -3);
     }
   }
   g_ctx->num_pushed++;
@@ -252,22 +401,44 @@ static void param_push_table_string(char const **keys, char const **values, int
   }
   lua_createtable(g_ctx->L, 0, num);
   for (int i = 0; i < num; i++) {
-    if (keys[i]) {
-      if (values[i]) {
-        lua_pushstring(g_ctx->L, values[i]);
-      } else {
-        lua_pushnil(g_ctx->L);
-      }
-      lua_setfield(g_ctx->L, -2, keys[i]);
+    if (keys[i] && values[i]) {
+      lua_pushstring(g_ctx->L, keys[i]);
+      lua_pushstring(g_ctx->L, values[i]);
+      lua_rawset(g_ctx->L, -3);
     }
   }
   g_ctx->num_pushed++;
 }
 
+/**
+ * @brief Push a typed array created by the FFI and fill it with values
+ *
+ * @return true on success, false if the FFI is not available or the array could not be created
+ */
+static bool push_typed_array(enum ffi_helper const ctype, void const *const values, int const num, size_t const size) {
+  lua_State *const L = g_ctx->L;
+  if (!push_ffi_helpers(L)) {
+    return false;
+  }
+  lua_rawgeti(L, -1, (int)ctype);
+  lua_pushinteger(L, num);
+  if (!call_ffi_helper(L, 1, 1)) {
+    lua_pop(L, 1);
+    return false;
+  }
+  memcpy(ov_deconster_(lua_topointer(L, -1)), values, size);
+  lua_remove(L, -2);
+  return true;
+}
+
 static void param_push_array_int(int *values, int num) {
   if (!g_ctx || !values || num <= 0) {
     return;
   }
+  if (g_ctx->typed_arrays && push_typed_array(ffi_helper_int_array, values, num, sizeof(int) * (size_t)num)) {
+    g_ctx->num_pushed++;
+    return;
+  }
   lua_createtable(g_ctx->L, num, 0);
   for (int i = 0; i < num; i++) {
     lua_pushinteger(g_ctx->L, values[i]);
@@ -280,6 +451,10 @@ static void param_push_array_double(double *values, int num) {
   if (!g_ctx || !values || num <= 0) {
     return;
   }
+  if (g_ctx->typed_arrays && push_typed_array(ffi_helper_double_array, values, num, sizeof(double) * (size_t)num)) {
+    g_ctx->num_pushed++;
+    return;
+  }
   lua_createtable(g_ctx->L, num, 0);
   for (int i = 0; i < num; i++) {
     lua_pushnumber(g_ctx->L, values[i]);
@@ -320,7 +495,9 @@ static void param_set_error(char const *message) {
   }
 }
 
-int script_module_param_call(lua_State *const L, void (*func)(struct aviutl2_script_module_param *)) {
+int script_module_param_call(lua_State *const L,
+                             void (*func)(struct aviutl2_script_module_param *),
+                             bool const typed_arrays) {
   if (!func) {
     return luaL_error(L, "script module function is invalid");
   }
@@ -332,7 +509,9 @@ int script_module_param_call(lua_State *const L, void (*func)(struct aviutl2_scr
       .num_args = lua_gettop(L),
       .num_pushed = 0,
       .has_error = false,
+      .typed_arrays = typed_arrays,
       .error_msg = NULL,
+      .array_index = -1,
   };
   g_ctx = &ctx;
 
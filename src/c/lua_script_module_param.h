@@ -17,8 +17,14 @@ struct aviutl2_script_module_param;
  * - Pushing results to Lua stack (push_result_*)
  * - Error handling (set_error)
  *
+ * Array parameters can also be passed as LuaJIT FFI arrays created with
+ * ffi.new("double[?]", n) or ffi.new("int[?]", n), which are read without table lookups.
+ *
  * @param L Lua state
  * @param func The script module function to call
+ * @param typed_arrays Return numeric arrays as FFI arrays instead of tables
  * @return Number of return values, or raises Lua error on failure
  */
-int script_module_param_call(struct lua_State *const L, void (*func)(struct aviutl2_script_module_param *));
+int script_module_param_call(struct lua_State *const L,
+                             void (*func)(struct aviutl2_script_module_param *),
+                             bool const typed_arrays);
@@ -432,6 +432,10 @@ static void register_module_lookup(lua_State *L) {
                 "function get_test_module(name)\n"
                 "  local wrapper = _script_modules and _script_modules[name]\n"
                 "  return wrapper and wrapper.table\n"
+                "end\n"
+                "function get_test_ffi_module(name)\n"
+                "  local wrapper = _script_modules and _script_modules[name]\n"
+                "  return wrapper and wrapper.ffi_table\n"
                 "end\n");
 }
 
@@ -966,6 +970,162 @@ static void test_return_array_string(void) {
   gcmz_lua_destroy(&ctx);
 }
 
+static void test_table_param_ignores_metatable(void) {
+  struct gcmz_lua_context *ctx = NULL;
+  struct ov_error err = {0};
+
+  if (!TEST_SUCCEEDED(gcmz_lua_create(&ctx, &err), &err)) {
+    return;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_register_script_module(ctx, &g_test_module, "testmod", NULL, &err), &err)) {
+    gcmz_lua_destroy(&ctx);
+    return;
+  }
+
+  lua_State *L = gcmz_lua_get_state(ctx);
+  register_module_lookup(L);
+  clear_captured();
+
+  // Fields are read with raw access, so __index is not consulted
+  TEST_CHECK(run_lua_code(L,
+                          "local m = get_test_module('testmod')\n"
+                          "local t = setmetatable({int_field = 7}, {__index = function() error('called') end})\n"
+                          "assert(m.table_param(t) == 1)\n",
+                          "table param raw access"));
+  TEST_CHECK(g_captured.table_int_values[0] == 7);
+  TEST_CHECK(g_captured.table_double_values[0] == 0.0);
+  TEST_CHECK(g_captured.table_bool_values[0] == false);
+
+  gcmz_lua_destroy(&ctx);
+}
+
+static void test_call_function_with_typed_array(void) {
+  struct gcmz_lua_context *ctx = NULL;
+  struct ov_error err = {0};
+
+  if (!TEST_SUCCEEDED(gcmz_lua_create(&ctx, &err), &err)) {
+    return;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_register_script_module(ctx, &g_test_module, "testmod", NULL, &err), &err)) {
+    gcmz_lua_destroy(&ctx);
+    return;
+  }
+
+  lua_State *L = gcmz_lua_get_state(ctx);
+  register_module_lookup(L);
+  clear_captured();
+
+  TEST_CHECK(run_lua_code(L,
+                          "local ffi = require('ffi')\n"
+                          "local m = get_test_module('testmod')\n"
+                          "local a = ffi.new('double[?]', 3, {1.5, 2.5, 3.5})\n"
+                          "assert(m.array_double_param(a) == 3)\n",
+                          "typed array double"));
+  TEST_CHECK(g_captured.array_num == 3);
+  TEST_CHECK(fabs(g_captured.array_double_values[0] - 1.5) < 0.001);
+  TEST_CHECK(fabs(g_captured.array_double_values[1] - 2.5) < 0.001);
+  TEST_CHECK(fabs(g_captured.array_double_values[2] - 3.5) < 0.001);
+
+  clear_captured();
+  TEST_CHECK(run_lua_code(L,
+                          "local ffi = require('ffi')\n"
+                          "local m = get_test_module('testmod')\n"
+                          "assert(m.array_param(ffi.new('int[?]', 2, {10, 20})) == 2)\n",
+                          "typed array int"));
+  TEST_CHECK(g_captured.array_num == 2);
+  TEST_CHECK(g_captured.array_int_values[0] == 10);
+  TEST_CHECK(g_captured.array_int_values[1] == 20);
+
+  // Other cdata types are not arrays
+  clear_captured();
+  TEST_CHECK(run_lua_code(L,
+                          "local ffi = require('ffi')\n"
+                          "local m = get_test_module('testmod')\n"
+                          "assert(m.array_param(ffi.new('float[?]', 2)) == 0)\n",
+                          "typed array unsupported type"));
+  TEST_CHECK(g_captured.array_num == 0);
+
+  gcmz_lua_destroy(&ctx);
+}
+
+static void test_return_typed_array(void) {
+  struct gcmz_lua_context *ctx = NULL;
+  struct ov_error err = {0};
+
+  if (!TEST_SUCCEEDED(gcmz_lua_create(&ctx, &err), &err)) {
+    return;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_register_script_module(ctx, &g_test_module, "testmod", NULL, &err), &err)) {
+    gcmz_lua_destroy(&ctx);
+    return;
+  }
+
+  lua_State *L = gcmz_lua_get_state(ctx);
+  register_module_lookup(L);
+  clear_captured();
+
+  TEST_CHECK(run_lua_code(L,
+                          "local ffi = require('ffi')\n"
+                          "local m = get_test_ffi_module('testmod')\n"
+                          "local arr = m.return_array_double()\n"
+                          "assert(ffi.istype('double[?]', arr))\n"
+                          "assert(ffi.sizeof(arr) == 3 * ffi.sizeof('double'))\n"
+                          "assert(arr[0] == 1.5 and arr[1] == 2.5 and arr[2] == 3.5)\n"
+                          "local ints = m.return_array_int()\n"
+                          "assert(ffi.istype('int[?]', ints))\n"
+                          "assert(ints[0] == 1 and ints[4] == 5)\n"
+                          "assert(type(m.return_array_string()) == 'table')\n"
+                          "assert(m.array_double_param(arr) == 3)\n",
+                          "return typed array"));
+  TEST_CHECK(g_captured.array_num == 3);
+  TEST_CHECK(fabs(g_captured.array_double_values[2] - 3.5) < 0.001);
+
+  // The plain module table still returns tables
+  TEST_CHECK(run_lua_code(L,
+                          "local m = get_test_module('testmod')\n"
+                          "assert(type(m.return_array_double()) == 'table')\n",
+                          "return table array"));
+
+  gcmz_lua_destroy(&ctx);
+}
+
+static void test_typed_array_helper_error(void) {
+  struct gcmz_lua_context *ctx = NULL;
+  struct ov_error err = {0};
+
+  if (!TEST_SUCCEEDED(gcmz_lua_create(&ctx, &err), &err)) {
+    return;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_register_script_module(ctx, &g_test_module, "testmod", NULL, &err), &err)) {
+    gcmz_lua_destroy(&ctx);
+    return;
+  }
+
+  lua_State *L = gcmz_lua_get_state(ctx);
+  register_module_lookup(L);
+
+  // Replace the cached FFI helpers with ones that raise, errors must come back as the error of the call
+  TEST_CHECK(run_lua_code(L,
+                          "local function fail() error('helper failed') end\n"
+                          "FAILING_HELPERS = {fail, fail, fail, fail}\n",
+                          "failing helpers"));
+  lua_getglobal(L, "FAILING_HELPERS");
+  lua_setfield(L, LUA_REGISTRYINDEX, "gcmz_script_module_ffi");
+
+  TEST_CHECK(run_lua_code(L,
+                          "local ffi = require('ffi')\n"
+                          "local m = get_test_module('testmod')\n"
+                          "local ok, errmsg = pcall(m.array_double_param, ffi.new('double[?]', 3))\n"
+                          "assert(not ok and string.find(errmsg, 'helper failed'), tostring(errmsg))\n"
+                          "local f = get_test_ffi_module('testmod')\n"
+                          "ok, errmsg = pcall(f.return_array_double)\n"
+                          "assert(not ok and string.find(errmsg, 'helper failed'), tostring(errmsg))\n"
+                          "assert(m.array_param({1, 2}) == 2)\n",
+                          "typed array helper error"));
+
+  gcmz_lua_destroy(&ctx);
+}
+
 static void test_error_handling(void) {
   struct gcmz_lua_context *ctx = NULL;
   struct ov_error err = {0};
@@ -1336,11 +1496,13 @@ TEST_LIST = {
 
     // Table parameter tests
     {"call_function_with_table", test_call_function_with_table},
+    {"table_param_ignores_metatable", test_table_param_ignores_metatable},
 
     // Array parameter tests
     {"call_function_with_array", test_call_function_with_array},
     {"call_function_with_array_doubles", test_call_function_with_array_doubles},
     {"call_function_with_array_strings", test_call_function_with_array_strings},
+    {"call_function_with_typed_array", test_call_function_with_typed_array},
 
     // Return value tests
     {"multi_return", test_multi_return},
@@ -1350,6 +1512,8 @@ TEST_LIST = {
     {"return_array_int", test_return_array_int},
     {"return_array_double", test_return_array_double},
     {"return_array_string", test_return_array_string},
+    {"return_typed_array", test_return_typed_array},
+    {"typed_array_helper_error", test_typed_array_helper_error},
 
     // Error handling tests
     {"error_handling", test_error_handling},
@@ -17,6 +17,7 @@
 #define STRINGIZE(x) STRINGIZE2(x)
 #define LUA_SRC_DIR STRINGIZE(SOURCE_DIR) L"/../lua"
 #define LUA_PLUGIN_TEST_DIR STRINGIZE(BINARY_DIR) L"/test_data/lua_plugin"
+#define LUA_RELOAD_TEST_DIR STRINGIZE(BINARY_DIR) L"/test_data/lua_reload"
 
 #ifdef __GNUC__
 #  ifndef __has_warning
@@ -463,6 +464,9 @@ static void test_hook_functions_null_context(void) {
   TEST_FAILED_WITH(
       gcmz_lua_call_drag_leave(NULL, &err), &err, ov_error_type_generic, ov_error_generic_invalid_argument);
 
+  TEST_FAILED_WITH(
+      gcmz_lua_reload_handlers(NULL, &err), &err, ov_error_type_generic, ov_error_generic_invalid_argument);
+
   TEST_FAILED_WITH(gcmz_lua_call_drop(NULL, file_list, 0, 0, false, &err),
                    &err,
                    ov_error_type_generic,
@@ -679,6 +683,402 @@ static void test_add_handler_script(void) {
   gcmz_lua_destroy(&ctx);
 }
 
+static void test_indexed_dispatch(void) {
+  struct gcmz_lua_context *ctx = NULL;
+  struct gcmz_file_list *file_list = NULL;
+  struct ov_error err = {0};
+  lua_State *L = NULL;
+
+  if (!TEST_SUCCEEDED(gcmz_lua_create(&ctx, &err), &err)) {
+    return;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_setup(ctx, &(struct gcmz_lua_options){.script_dir = LUA_SRC_DIR}, &err), &err)) {
+    goto cleanup;
+  }
+  L = gcmz_lua_get_state(ctx);
+
+  static char const png_script[] = "return {\n"
+                                   "  name = 'png', priority = 100,\n"
+                                   "  accepts = { extensions = { 'PNG' } },\n"
+                                   "  drag_enter = function() CALLS = (CALLS or '') .. 'p' end,\n"
+                                   "}\n";
+  static char const image_script[] = "return {\n"
+                                     "  name = 'image', priority = 200,\n"
+                                     "  accepts = { mimetypes = { 'image/*' } },\n"
+                                     "  drag_enter = function() CALLS = (CALLS or '') .. 'i' end,\n"
+                                     "}\n";
+  static char const any_script[] = "return {\n"
+                                   "  name = 'any', priority = 300,\n"
+                                   "  drag_enter = function() CALLS = (CALLS or '') .. 'a' end,\n"
+                                   "}\n";
+  if (!TEST_SUCCEEDED(gcmz_lua_add_handler_script(ctx, any_script, sizeof(any_script) - 1, "test://any", &err),
+                      &err) ||
+      !TEST_SUCCEEDED(gcmz_lua_add_handler_script(ctx, image_script, sizeof(image_script) - 1, "test://image", &err),
+                      &err) ||
+      !TEST_SUCCEEDED(gcmz_lua_add_handler_script(ctx, png_script, sizeof(png_script) - 1, "test://png", &err),
+                      &err)) {
+    goto cleanup;
+  }
+
+  file_list = gcmz_file_list_create(&err);
+  if (!TEST_SUCCEEDED(file_list != NULL, &err)) {
+    goto cleanup;
+  }
+
+  // Only handlers without filters are called for unrelated files
+  if (!TEST_SUCCEEDED(gcmz_file_list_add(file_list, L"C:\\test\\file.txt", L"text/plain", &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_call_drag_enter(ctx, file_list, 0, 0, false, &err), &err)) {
+    goto cleanup;
+  }
+  lua_getglobal(L, "CALLS");
+  TEST_CHECK(lua_isstring(L, -1) && strcmp(lua_tostring(L, -1), "a") == 0);
+  TEST_MSG("got %s", lua_tostring(L, -1));
+  lua_pop(L, 1);
+  if (!TEST_SUCCEEDED(gcmz_lua_call_drag_leave(ctx, &err), &err)) {
+    goto cleanup;
+  }
+
+  // Extension and media type matches are merged in priority order
+  lua_pushnil(L);
+  lua_setglobal(L, "CALLS");
+  if (!TEST_SUCCEEDED(gcmz_file_list_add(file_list, L"C:\\test\\image.png", L"image/png", &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_call_drag_enter(ctx, file_list, 0, 0, false, &err), &err)) {
+    goto cleanup;
+  }
+  lua_getglobal(L, "CALLS");
+  TEST_CHECK(lua_isstring(L, -1) && strcmp(lua_tostring(L, -1), "pia") == 0);
+  TEST_MSG("got %s", lua_tostring(L, -1));
+  lua_pop(L, 1);
+  if (!TEST_SUCCEEDED(gcmz_lua_call_drag_leave(ctx, &err), &err)) {
+    goto cleanup;
+  }
+
+cleanup:
+  gcmz_file_list_destroy(&file_list);
+  gcmz_lua_destroy(&ctx);
+}
+
+static void test_files_table_reuse(void) {
+  struct gcmz_lua_context *ctx = NULL;
+  struct gcmz_file_list *file_list = NULL;
+  struct ov_error err = {0};
+  lua_State *L = NULL;
+
+  if (!TEST_SUCCEEDED(gcmz_lua_create(&ctx, &err), &err)) {
+    return;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_setup(ctx, &(struct gcmz_lua_options){.script_dir = LUA_SRC_DIR}, &err), &err)) {
+    goto cleanup;
+  }
+  L = gcmz_lua_get_state(ctx);
+
+  static char const script[] = "return {\n"
+                               "  name = 'reuse',\n"
+                               "  drag_enter = function(files) ENTER_FILE = files[1] return true end,\n"
+                               "  drop = function(files)\n"
+                               "    SAME = rawequal(files[1], ENTER_FILE)\n"
+                               "    TEMP = files[1].temporary\n"
+                               "    files[2].filepath = 'C:\\\\test\\\\renamed.txt'\n"
+                               "  end,\n"
+                               "}\n";
+  if (!TEST_SUCCEEDED(gcmz_lua_add_handler_script(ctx, script, sizeof(script) - 1, "test://reuse", &err), &err)) {
+    goto cleanup;
+  }
+
+  file_list = gcmz_file_list_create(&err);
+  if (!TEST_SUCCEEDED(file_list != NULL, &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_file_list_add_temporary(file_list, L"C:\\test\\image.png", L"image/png", &err), &err) ||
+      !TEST_SUCCEEDED(gcmz_file_list_add(file_list, L"C:\\test\\file.txt", L"text/plain", &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_call_drag_enter(ctx, file_list, 0, 0, false, &err), &err)) {
+    goto cleanup;
+  }
+
+  // The drop sees the entry tables marshaled in drag_enter
+  gcmz_file_list_destroy(&file_list);
+  file_list = gcmz_file_list_create(&err);
+  if (!TEST_SUCCEEDED(file_list != NULL, &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_file_list_add_temporary(file_list, L"C:\\test\\image.png", L"image/png", &err), &err) ||
+      !TEST_SUCCEEDED(gcmz_file_list_add(file_list, L"C:\\test\\file.txt", L"text/plain", &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_call_drop(ctx, file_list, 0, 0, false, &err), &err)) {
+    goto cleanup;
+  }
+  lua_getglobal(L, "SAME");
+  TEST_CHECK(lua_toboolean(L, -1));
+  lua_pop(L, 1);
+  lua_getglobal(L, "TEMP");
+  TEST_CHECK(lua_toboolean(L, -1));
+  lua_pop(L, 1);
+
+  // Unmodified entries keep their flags, modified entries are converted back
+  if (TEST_CHECK(gcmz_file_list_count(file_list) == 2)) {
+    struct gcmz_file const *const file0 = gcmz_file_list_get(file_list, 0);
+    struct gcmz_file const *const file1 = gcmz_file_list_get(file_list, 1);
+    TEST_CHECK(wcscmp(file0->path, L"C:\\test\\image.png") == 0);
+    TEST_CHECK(file0->temporary);
+    TEST_CHECK(wcscmp(file1->path, L"C:\\test\\renamed.txt") == 0);
+    TEST_CHECK(wcscmp(file1->mime_type, L"text/plain") == 0);
+    TEST_CHECK(!file1->temporary);
+  }
+
+cleanup:
+  gcmz_file_list_destroy(&file_list);
+  gcmz_lua_destroy(&ctx);
+}
+
+static bool record_cleanup(wchar_t const *const path, void *userdata, struct ov_error *const err) {
+  (void)err;
+  int *const count = (int *)userdata;
+  TEST_CHECK(wcscmp(path, L"C:\\test\\image.png") == 0);
+  TEST_MSG("unexpected cleanup of %ls", path);
+  ++*count;
+  return true;
+}
+
+static void test_ffi_file_list(void) {
+  struct gcmz_lua_context *ctx = NULL;
+  struct gcmz_file_list *file_list = NULL;
+  struct ov_error err = {0};
+  lua_State *L = NULL;
+  int cleanup_count = 0;
+
+  if (!TEST_SUCCEEDED(gcmz_lua_create(&ctx, &err), &err)) {
+    return;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_setup(ctx,
+                                     &(struct gcmz_lua_options){
+                                         .script_dir = LUA_SRC_DIR,
+                                         .schedule_cleanup_callback = record_cleanup,
+                                         .userdata = &cleanup_count,
+                                     },
+                                     &err),
+                      &err)) {
+    goto cleanup;
+  }
+  L = gcmz_lua_get_state(ctx);
+
+  static char const ffi_script[] = "return {\n"
+                                   "  name = 'ffi',\n"
+                                   "  priority = 100,\n"
+                                   "  use_ffi = true,\n"
+                                   "  drag_enter = function(files)\n"
+                                   "    VIEW_TYPE = type(files)\n"
+                                   "    ENTER_COUNT = #files\n"
+                                   "    ENTER_PATH = files:get_filepath(1)\n"
+                                   "    ENTER_TEMP = files:is_temporary(1)\n"
+                                   "    return true\n"
+                                   "  end,\n"
+                                   "  drop = function(files)\n"
+                                   "    files:set_filepath(1, 'C:\\\\test\\\\converted.txt')\n"
+                                   "    files:set_mimetype(1, 'text/plain')\n"
+                                   "    files:append('C:\\\\test\\\\extra.wav', 'audio/wav', true)\n"
+                                   "    files:set_temporary(2, false)\n"
+                                   "    RANGE_OK = pcall(files.get_filepath, files, 10)\n"
+                                   "  end,\n"
+                                   "}\n";
+  static char const table_script[] = "return {\n"
+                                     "  name = 'table',\n"
+                                     "  priority = 200,\n"
+                                     "  drag_enter = function(files) return true end,\n"
+                                     "  drop = function(files)\n"
+                                     "    SEEN = files[1].filepath .. '|' .. files[3].mimetype\n"
+                                     "    table.remove(files, 2)\n"
+                                     "  end,\n"
+                                     "}\n";
+  if (!TEST_SUCCEEDED(gcmz_lua_add_handler_script(ctx, ffi_script, sizeof(ffi_script) - 1, "test://ffi", &err),
+                      &err) ||
+      !TEST_SUCCEEDED(gcmz_lua_add_handler_script(ctx, table_script, sizeof(table_script) - 1, "test://table", &err),
+                      &err)) {
+    goto cleanup;
+  }
+
+  file_list = gcmz_file_list_create(&err);
+  if (!TEST_SUCCEEDED(file_list != NULL, &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_file_list_add_temporary(file_list, L"C:\\test\\image.png", L"image/png", &err), &err) ||
+      !TEST_SUCCEEDED(gcmz_file_list_add(file_list, L"C:\\test\\file.txt", L"text/plain", &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_call_drag_enter(ctx, file_list, 0, 0, false, &err), &err)) {
+    goto cleanup;
+  }
+  lua_getglobal(L, "VIEW_TYPE");
+  TEST_CHECK(strcmp(lua_tostring(L, -1), "cdata") == 0);
+  lua_getglobal(L, "ENTER_COUNT");
+  TEST_CHECK(lua_tointeger(L, -1) == 2);
+  lua_getglobal(L, "ENTER_PATH");
+  TEST_CHECK(strcmp(lua_tostring(L, -1), "C:\\test\\image.png") == 0);
+  lua_getglobal(L, "ENTER_TEMP");
+  TEST_CHECK(lua_toboolean(L, -1));
+  lua_pop(L, 4);
+
+  // The FFI handler edits the list in place, the table handler sees its changes
+  if (!TEST_SUCCEEDED(gcmz_lua_call_drop(ctx, file_list, 0, 0, false, &err), &err)) {
+    goto cleanup;
+  }
+  lua_getglobal(L, "SEEN");
+  TEST_CHECK(strcmp(lua_tostring(L, -1), "C:\\test\\converted.txt|audio/wav") == 0);
+  TEST_MSG("got %s", lua_tostring(L, -1));
+  lua_getglobal(L, "RANGE_OK");
+  TEST_CHECK(!lua_toboolean(L, -1));
+  lua_pop(L, 2);
+
+  if (TEST_CHECK(gcmz_file_list_count(file_list) == 2)) {
+    struct gcmz_file const *const file0 = gcmz_file_list_get(file_list, 0);
+    struct gcmz_file const *const file1 = gcmz_file_list_get(file_list, 1);
+    TEST_CHECK(wcscmp(file0->path, L"C:\\test\\converted.txt") == 0);
+    TEST_CHECK(wcscmp(file0->mime_type, L"text/plain") == 0);
+    TEST_CHECK(file0->temporary);
+    TEST_CHECK(wcscmp(file1->path, L"C:\\test\\extra.wav") == 0);
+    TEST_CHECK(file1->temporary);
+  }
+  // The temporary file replaced through set_filepath is cleaned up, the removed non-temporary file is not
+  TEST_CHECK(cleanup_count == 1);
+
+cleanup:
+  gcmz_file_list_destroy(&file_list);
+  gcmz_lua_destroy(&ctx);
+}
+
+static void test_hook_memory_stats(void) {
+  struct gcmz_lua_context *ctx = NULL;
+  struct gcmz_file_list *file_list = NULL;
+  struct ov_error err = {0};
+  struct gcmz_lua_memory_stats stats = {0};
+
+  if (!TEST_SUCCEEDED(gcmz_lua_create(&ctx, &err), &err)) {
+    return;
+  }
+  if (!gcmz_lua_get_memory_stats(ctx, &stats)) {
+    TEST_MSG("memory accounting is not available in this LuaJIT build");
+    goto cleanup;
+  }
+  TEST_CHECK(stats.total.live_bytes > 0);
+  TEST_CHECK(stats.total.peak_bytes >= stats.total.live_bytes);
+  TEST_CHECK(stats.total.pooled_bytes > 0);
+
+  if (!TEST_SUCCEEDED(gcmz_lua_setup(ctx, &(struct gcmz_lua_options){.script_dir = LUA_SRC_DIR}, &err), &err)) {
+    goto cleanup;
+  }
+  static char const script[] = "return {\n"
+                               "  name = 'memory',\n"
+                               "  drag_enter = function(files)\n"
+                               "    local t = {}\n"
+                               "    for i = 1, 1000 do t[i] = 'item' .. i end\n"
+                               "    return true\n"
+                               "  end,\n"
+                               "}\n";
+  if (!TEST_SUCCEEDED(gcmz_lua_add_handler_script(ctx, script, sizeof(script) - 1, "test://memory", &err), &err)) {
+    goto cleanup;
+  }
+  file_list = gcmz_file_list_create(&err);
+  if (!TEST_SUCCEEDED(file_list != NULL, &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_file_list_add(file_list, L"C:\\test\\file.txt", L"text/plain", &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_call_drag_enter(ctx, file_list, 0, 0, false, &err), &err)) {
+    goto cleanup;
+  }
+
+  if (TEST_CHECK(gcmz_lua_get_memory_stats(ctx, &stats))) {
+    TEST_CHECK(stats.drag_enter.allocations >= 1000);
+    TEST_MSG("want >= 1000, got %zu", stats.drag_enter.allocations);
+    TEST_CHECK(stats.drag_enter.peak_bytes >= stats.drag_enter.live_bytes_before);
+    TEST_CHECK(stats.drag_enter.peak_bytes >= stats.drag_enter.live_bytes_after);
+    TEST_CHECK(stats.drop.allocations == 0);
+  }
+
+cleanup:
+  gcmz_file_list_destroy(&file_list);
+  gcmz_lua_destroy(&ctx);
+}
+
+struct handler_stats_result {
+  size_t drag_enter_count;
+  size_t drop_count;
+  double drop_max_ms;
+  double drop_p95_ms;
+};
+
+static bool collect_handler_stats(struct gcmz_lua_handler_stats const *stats, void *userdata) {
+  struct handler_stats_result *const r = (struct handler_stats_result *)userdata;
+  if (strcmp(stats->name, "timed") != 0) {
+    return true;
+  }
+  if (strcmp(stats->hook, "drag_enter") == 0) {
+    r->drag_enter_count = stats->count;
+  } else if (strcmp(stats->hook, "drop") == 0) {
+    r->drop_count = stats->count;
+    r->drop_max_ms = stats->max_ms;
+    r->drop_p95_ms = stats->p95_ms;
+  }
+  return true;
+}
+
+static void test_handler_stats(void) {
+  struct gcmz_lua_context *ctx = NULL;
+  struct gcmz_file_list *file_list = NULL;
+  struct ov_error err = {0};
+  struct handler_stats_result r = {0};
+
+  if (!TEST_SUCCEEDED(gcmz_lua_create(&ctx, &err), &err)) {
+    return;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_setup(ctx, &(struct gcmz_lua_options){.script_dir = LUA_SRC_DIR}, &err), &err)) {
+    goto cleanup;
+  }
+  static char const script[] = "return {\n"
+                               "  name = 'timed',\n"
+                               "  drag_enter = function() return true end,\n"
+                               "  drop = function() end,\n"
+                               "}\n";
+  if (!TEST_SUCCEEDED(gcmz_lua_add_handler_script(ctx, script, sizeof(script) - 1, "test://timed", &err), &err)) {
+    goto cleanup;
+  }
+  file_list = gcmz_file_list_create(&err);
+  if (!TEST_SUCCEEDED(file_list != NULL, &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_file_list_add(file_list, L"C:\\test\\file.txt", L"text/plain", &err), &err)) {
+    goto cleanup;
+  }
+  for (int i = 0; i < 3; ++i) {
+    if (!TEST_SUCCEEDED(gcmz_lua_call_drag_enter(ctx, file_list, 0, 0, false, &err), &err)) {
+      goto cleanup;
+    }
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_call_drop(ctx, file_list, 0, 0, false, &err), &err)) {
+    goto cleanup;
+  }
+
+  if (!TEST_SUCCEEDED(gcmz_lua_enum_handler_stats(ctx, collect_handler_stats, &r, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(r.drag_enter_count == 3);
+  TEST_MSG("want 3, got %zu", r.drag_enter_count);
+  TEST_CHECK(r.drop_count == 1);
+  TEST_CHECK(r.drop_max_ms >= 0.0);
+  TEST_CHECK(r.drop_p95_ms == r.drop_max_ms);
+
+cleanup:
+  gcmz_file_list_destroy(&file_list);
+  gcmz_lua_destroy(&ctx);
+}
+
 static void test_add_handler_script_file(void) {
   struct gcmz_lua_context *ctx = NULL;
   struct ov_error err = {0};
@@ -1098,6 +1498,85 @@ static void test_plugin_loading_all_types(void) {
   gcmz_lua_destroy(&ctx);
 }
 
+// Test that a handler declaring a filter in its manifest is loaded on first matching drag
+static void test_lazy_handler_loading(void) {
+  struct gcmz_lua_context *ctx = NULL;
+  struct gcmz_file_list *file_list = NULL;
+  struct ov_error err = {0};
+  lua_State *L = NULL;
+
+  if (!TEST_SUCCEEDED(gcmz_lua_create(&ctx, &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_setup(ctx,
+                                     &(struct gcmz_lua_options){
+                                         .script_dir = LUA_PLUGIN_TEST_DIR,
+                                         .api_register_callback = test_api_register_callback,
+                                     },
+                                     &err),
+                      &err)) {
+    goto cleanup;
+  }
+  L = gcmz_lua_get_state(ctx);
+
+  // Registered but not loaded yet
+  lua_getglobal(L, "_LAZY_HANDLER_DRAG_ENTER");
+  TEST_CHECK(lua_isnil(L, -1));
+  lua_pop(L, 1);
+
+  file_list = gcmz_file_list_create(&err);
+  if (!TEST_SUCCEEDED(file_list != NULL, &err)) {
+    goto cleanup;
+  }
+
+  // Non-matching files do not load the handler
+  if (!TEST_SUCCEEDED(gcmz_file_list_add(file_list, L"C:\\test\\file.txt", NULL, &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_call_drag_enter(ctx, file_list, 0, 0, false, &err), &err)) {
+    goto cleanup;
+  }
+  lua_getglobal(L, "_LAZY_HANDLER_DRAG_ENTER");
+  TEST_CHECK(lua_isnil(L, -1));
+  lua_pop(L, 1);
+  if (!TEST_SUCCEEDED(gcmz_lua_call_drag_leave(ctx, &err), &err)) {
+    goto cleanup;
+  }
+
+  // Matching extension loads the handler and calls it
+  if (!TEST_SUCCEEDED(gcmz_file_list_add(file_list, L"C:\\test\\file.LazyTest", NULL, &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_call_drag_enter(ctx, file_list, 0, 0, false, &err), &err)) {
+    goto cleanup;
+  }
+  lua_getglobal(L, "_LAZY_HANDLER_DRAG_ENTER");
+  TEST_CHECK(lua_tointeger(L, -1) == 1);
+  lua_pop(L, 1);
+  if (!TEST_SUCCEEDED(gcmz_lua_call_drag_leave(ctx, &err), &err)) {
+    goto cleanup;
+  }
+
+  // Once loaded, the filter still decides whether the handler is called
+  if (!TEST_SUCCEEDED(gcmz_file_list_remove(file_list, 1, &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_call_drag_enter(ctx, file_list, 0, 0, false, &err), &err)) {
+    goto cleanup;
+  }
+  lua_getglobal(L, "_LAZY_HANDLER_DRAG_ENTER");
+  TEST_CHECK(lua_tointeger(L, -1) == 1);
+  lua_pop(L, 1);
+  if (!TEST_SUCCEEDED(gcmz_lua_call_drag_leave(ctx, &err), &err)) {
+    goto cleanup;
+  }
+
+cleanup:
+  clear_debug_messages();
+  gcmz_file_list_destroy(&file_list);
+  gcmz_lua_destroy(&ctx);
+}
+
 static void test_handler_script_integration(void) {
   struct gcmz_lua_context *ctx = NULL;
   struct gcmz_file_list *file_list = NULL;
@@ -1183,6 +1662,87 @@ cleanup:
   gcmz_lua_destroy(&ctx);
 }
 
+static void test_handler_time_budget(void) {
+  struct gcmz_lua_context *ctx = NULL;
+  struct gcmz_file_list *file_list = NULL;
+  struct ov_error err = {0};
+  lua_State *L = NULL;
+
+  if (!TEST_SUCCEEDED(gcmz_lua_create(&ctx, &err), &err)) {
+    return;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_setup(ctx,
+                                     &(struct gcmz_lua_options){
+                                         .script_dir = LUA_SRC_DIR,
+                                         .api_register_callback = test_api_register_callback,
+                                         .drag_enter_budget_ms = 50,
+                                     },
+                                     &err),
+                      &err)) {
+    goto cleanup;
+  }
+  L = gcmz_lua_get_state(ctx);
+
+  static char const looping[] = "return {\n"
+                                "  name = 'looping',\n"
+                                "  priority = 1,\n"
+                                "  drag_enter = function() while true do end end,\n"
+                                "  drop = function() LOOPING_DROPPED = true end,\n"
+                                "}\n";
+  static char const quick[] = "return {\n"
+                              "  name = 'quick',\n"
+                              "  priority = 2,\n"
+                              "  drag_enter = function() return true end,\n"
+                              "  drop = function() QUICK_DROPPED = true end,\n"
+                              "}\n";
+  if (!TEST_SUCCEEDED(gcmz_lua_add_handler_script(ctx, looping, sizeof(looping) - 1, "test://looping", &err), &err) ||
+      !TEST_SUCCEEDED(gcmz_lua_add_handler_script(ctx, quick, sizeof(quick) - 1, "test://quick", &err), &err)) {
+    goto cleanup;
+  }
+  file_list = gcmz_file_list_create(&err);
+  if (!TEST_SUCCEEDED(file_list != NULL, &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_file_list_add(file_list, L"C:\\test\\file.txt", L"text/plain", &err), &err)) {
+    goto cleanup;
+  }
+
+  // The looping handler is aborted and the following handlers still run
+  clear_debug_messages();
+  if (!TEST_SUCCEEDED(gcmz_lua_call_drag_enter(ctx, file_list, 0, 0, false, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(g_debug_messages != NULL && strstr(g_debug_messages, "looping.drag_enter exceeded the time budget") != NULL);
+  TEST_MSG("got: %s", g_debug_messages ? g_debug_messages : "(null)");
+
+  // The aborted handler is skipped for the rest of the drag session
+  if (!TEST_SUCCEEDED(gcmz_lua_call_drop(ctx, file_list, 0, 0, false, &err), &err)) {
+    goto cleanup;
+  }
+  lua_getglobal(L, "LOOPING_DROPPED");
+  TEST_CHECK(lua_isnil(L, -1));
+  lua_pop(L, 1);
+  lua_getglobal(L, "QUICK_DROPPED");
+  TEST_CHECK(lua_toboolean(L, -1));
+  lua_pop(L, 1);
+
+  // The JIT compiler is left as it was before the budgeted calls
+  TEST_CHECK(luaL_dostring(L, "return jit.status()") == LUA_OK && lua_toboolean(L, -1));
+  lua_settop(L, 0);
+  TEST_CHECK(luaL_dostring(L, "jit.off()") == LUA_OK);
+  if (!TEST_SUCCEEDED(gcmz_lua_call_drag_enter(ctx, file_list, 0, 0, false, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(luaL_dostring(L, "return jit.status()") == LUA_OK && !lua_toboolean(L, -1));
+  lua_settop(L, 0);
+  TEST_CHECK(luaL_dostring(L, "jit.on()") == LUA_OK);
+
+cleanup:
+  clear_debug_messages();
+  gcmz_file_list_destroy(&file_list);
+  gcmz_lua_destroy(&ctx);
+}
+
 // Test error reporting in load_handlers
 static void test_load_handlers_error_reporting(void) {
   struct gcmz_lua_context *ctx = NULL;
@@ -1245,6 +1805,194 @@ cleanup:
   gcmz_lua_destroy(&ctx);
 }
 
+static void test_object_info_follows_filepath(void) {
+  struct gcmz_lua_context *ctx = NULL;
+  struct gcmz_file_list *file_list = NULL;
+  struct ov_error err = {0};
+
+  if (!TEST_SUCCEEDED(gcmz_lua_create(&ctx, &err), &err)) {
+    return;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_setup(ctx, &(struct gcmz_lua_options){.script_dir = LUA_SRC_DIR}, &err), &err)) {
+    goto cleanup;
+  }
+
+  static char const script[] = "return {\n"
+                               "  name = 'object_info',\n"
+                               "  drag_enter = function(files)\n"
+                               "    for _, f in ipairs(files) do\n"
+                               "      f.object_info = {filepath = f.filepath, layer_min = 0, layer_max = 2}\n"
+                               "    end\n"
+                               "    files[2].filepath = 'C:\\\\test\\\\other.object'\n"
+                               "    return true\n"
+                               "  end,\n"
+                               "  drop = function(files)\n"
+                               "    INFO_PATH = files[1].object_info and files[1].object_info.filepath\n"
+                               "    files[1].filepath = 'C:\\\\test\\\\renamed.object'\n"
+                               "  end,\n"
+                               "}\n";
+  if (!TEST_SUCCEEDED(gcmz_lua_add_handler_script(ctx, script, sizeof(script) - 1, "test://object_info", &err),
+                      &err)) {
+    goto cleanup;
+  }
+
+  file_list = gcmz_file_list_create(&err);
+  if (!TEST_SUCCEEDED(file_list != NULL, &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_file_list_add(file_list, L"C:\\test\\a.object", NULL, &err), &err) ||
+      !TEST_SUCCEEDED(gcmz_file_list_add(file_list, L"C:\\test\\b.object", NULL, &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_call_drag_enter(ctx, file_list, 0, 0, false, &err), &err)) {
+    goto cleanup;
+  }
+  // The layout set for b.object does not describe the file that replaced it
+  if (TEST_CHECK(gcmz_file_list_count(file_list) == 2)) {
+    struct gcmz_file const *const file0 = gcmz_file_list_get(file_list, 0);
+    struct gcmz_file const *const file1 = gcmz_file_list_get(file_list, 1);
+    TEST_CHECK(file0->has_object_info);
+    TEST_CHECK(file0->object_info.layer_max == 2);
+    TEST_CHECK(wcscmp(file1->path, L"C:\\test\\other.object") == 0);
+    TEST_CHECK(!file1->has_object_info);
+  }
+
+  // The layout marshaled from the previous hook is dropped when the handler replaces the file
+  if (!TEST_SUCCEEDED(gcmz_lua_call_drop(ctx, file_list, 0, 0, false, &err), &err)) {
+    goto cleanup;
+  }
+  {
+    lua_State *const L = gcmz_lua_get_state(ctx);
+    lua_getglobal(L, "INFO_PATH");
+    TEST_CHECK(lua_isstring(L, -1) && strcmp(lua_tostring(L, -1), "C:\\test\\a.object") == 0);
+    lua_pop(L, 1);
+  }
+  if (TEST_CHECK(gcmz_file_list_count(file_list) == 2)) {
+    struct gcmz_file const *const file0 = gcmz_file_list_get(file_list, 0);
+    TEST_CHECK(wcscmp(file0->path, L"C:\\test\\renamed.object") == 0);
+    TEST_CHECK(!file0->has_object_info);
+  }
+
+cleanup:
+  gcmz_file_list_destroy(&file_list);
+  gcmz_lua_destroy(&ctx);
+}
+
+static bool write_text_file(wchar_t const *const path, char const *const text) {
+  HANDLE const h = CreateFileW(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (h == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  DWORD const len = (DWORD)strlen(text);
+  DWORD written = 0;
+  bool const ok = WriteFile(h, text, len, &written, NULL) && written == len;
+  CloseHandle(h);
+  return ok;
+}
+
+// Get the module table of a registered handler, NULL if no handler has that name
+static void const *get_handler_module(lua_State *L, char const *const name) {
+  int const top = lua_gettop(L);
+  void const *found = NULL;
+  lua_getglobal(L, "require");
+  lua_pushstring(L, "entrypoint");
+  if (lua_pcall(L, 1, 1, 0) == LUA_OK) {
+    int const entrypoint = lua_gettop(L);
+    for (int i = 1;; ++i) {
+      lua_getfield(L, entrypoint, "get_module");
+      lua_pushinteger(L, i);
+      if (lua_pcall(L, 1, 1, 0) != LUA_OK || !lua_istable(L, -1)) {
+        break;
+      }
+      lua_getfield(L, -1, "name");
+      char const *const n = lua_tostring(L, -1);
+      if (n && strcmp(n, name) == 0) {
+        lua_getfield(L, -2, "module");
+        found = lua_topointer(L, -1);
+        break;
+      }
+      lua_pop(L, 2);
+    }
+  }
+  lua_settop(L, top);
+  return found;
+}
+
+// Test that only the changed handlers are reloaded from the script directory
+static void test_reload_handlers(void) {
+  static wchar_t const dir[] = LUA_RELOAD_TEST_DIR;
+  static wchar_t const entrypoint_path[] = LUA_RELOAD_TEST_DIR L"/entrypoint.lua";
+  static wchar_t const a_path[] = LUA_RELOAD_TEST_DIR L"/reload_a.lua";
+  static wchar_t const b_path[] = LUA_RELOAD_TEST_DIR L"/reload_b.lua";
+  static wchar_t const c_path[] = LUA_RELOAD_TEST_DIR L"/reload_c.lua";
+  struct gcmz_lua_context *ctx = NULL;
+  struct ov_error err = {0};
+  lua_State *L = NULL;
+
+  CreateDirectoryW(dir, NULL);
+  if (!TEST_CHECK(CopyFileW(LUA_SRC_DIR L"/entrypoint.lua", entrypoint_path, FALSE)) ||
+      !TEST_CHECK(write_text_file(a_path, "return { name = 'reload_a' }")) ||
+      !TEST_CHECK(write_text_file(b_path, "return { name = 'reload_b' }"))) {
+    goto cleanup;
+  }
+
+  if (!TEST_SUCCEEDED(gcmz_lua_create(&ctx, &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_setup(ctx,
+                                     &(struct gcmz_lua_options){
+                                         .script_dir = dir,
+                                         .api_register_callback = test_api_register_callback,
+                                     },
+                                     &err),
+                      &err)) {
+    goto cleanup;
+  }
+  L = gcmz_lua_get_state(ctx);
+
+  void const *const a = get_handler_module(L, "reload_a");
+  void const *const b = get_handler_module(L, "reload_b");
+  TEST_CHECK(a != NULL);
+  TEST_CHECK(b != NULL);
+
+  // Nothing changed, nothing is reloaded
+  if (!TEST_SUCCEEDED(gcmz_lua_reload_handlers(ctx, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(get_handler_module(L, "reload_a") == a);
+  TEST_CHECK(get_handler_module(L, "reload_b") == b);
+
+  // A modified handler is required again, a new one is added, the others keep their tables
+  if (!TEST_CHECK(write_text_file(a_path, "return { name = 'reload_a_modified' }")) ||
+      !TEST_CHECK(write_text_file(c_path, "return { name = 'reload_c' }"))) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_reload_handlers(ctx, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(get_handler_module(L, "reload_a") == NULL);
+  TEST_CHECK(get_handler_module(L, "reload_a_modified") != NULL);
+  TEST_CHECK(get_handler_module(L, "reload_b") == b);
+  TEST_CHECK(get_handler_module(L, "reload_c") != NULL);
+
+  // A removed handler is unregistered
+  TEST_CHECK(DeleteFileW(c_path));
+  if (!TEST_SUCCEEDED(gcmz_lua_reload_handlers(ctx, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(get_handler_module(L, "reload_c") == NULL);
+  TEST_CHECK(get_handler_module(L, "reload_b") == b);
+
+cleanup:
+  clear_debug_messages();
+  gcmz_lua_destroy(&ctx);
+  DeleteFileW(entrypoint_path);
+  DeleteFileW(a_path);
+  DeleteFileW(b_path);
+  DeleteFileW(c_path);
+  RemoveDirectoryW(dir);
+}
+
 TEST_LIST = {
     {"create_destroy", test_create_destroy},
     {"standard_libraries", test_standard_libraries},
@@ -1260,13 +2008,22 @@ TEST_LIST = {
     {"hook_functions_null_file_list", test_hook_functions_null_file_list},
     {"drag_session_workflow", test_drag_session_workflow},
     {"add_handler_script", test_add_handler_script},
+    {"object_info_follows_filepath", test_object_info_follows_filepath},
+    {"indexed_dispatch", test_indexed_dispatch},
+    {"files_table_reuse", test_files_table_reuse},
+    {"ffi_file_list", test_ffi_file_list},
+    {"hook_memory_stats", test_hook_memory_stats},
+    {"handler_stats", test_handler_stats},
+    {"handler_time_budget", test_handler_time_budget},
     {"add_handler_script_file", test_add_handler_script_file},
     {"add_handler_script_priority_sorting", test_add_handler_script_priority_sorting},
     {"add_handler_script_invalid_args", test_add_handler_script_invalid_args},
     {"lua_setup", test_lua_setup},
     {"package_path_init_lua_style", test_package_path_init_lua_style},
     {"plugin_loading_all_types", test_plugin_loading_all_types},
+    {"lazy_handler_loading", test_lazy_handler_loading},
     {"handler_script_integration", test_handler_script_integration},
     {"load_handlers_error_reporting", test_load_handlers_error_reporting},
+    {"reload_handlers", test_reload_handlers},
     {NULL, NULL},
 };
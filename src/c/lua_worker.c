@@ -0,0 +1,429 @@
+#include "lua_worker.h"
+
+#include <ovarray.h>
+#include <ovthreads.h>
+
+#include <string.h>
+
+#include "lua.h"
+
+enum thread_state {
+  thread_state_stopped,
+  thread_state_mtx_created,
+  thread_state_cnd_created,
+  thread_state_running,
+  thread_state_stopping,
+};
+
+struct job {
+  gcmz_lua_worker_job_func func;
+  void *userdata;
+};
+
+struct script_module {
+  struct aviutl2_script_module_table *table;
+  char *name;
+  char *source;
+};
+
+struct worker_thread {
+  struct gcmz_lua_worker *worker;
+  thrd_t thread;
+
+  // Only touched by this thread once it is running
+  struct gcmz_lua_context *lua_ctx;
+  void *current_userdata;
+  size_t num_script_modules; ///< Number of script_modules already registered into lua_ctx
+};
+
+struct gcmz_lua_worker {
+  struct job *queue;
+  mtx_t queue_mutex;
+  cnd_t wake_condition;
+  enum thread_state thread_state;
+  struct worker_thread *threads;
+  size_t num_threads;
+  size_t num_started;
+  struct script_module *script_modules; ///< Guarded by queue_mutex
+
+  // Read-only once the threads are running
+  struct gcmz_lua_options options;
+  wchar_t *script_dir;
+  wchar_t *bytecode_cache_dir;
+};
+
+static NODISCARD bool copy_string(wchar_t **const dest, wchar_t const *const src, struct ov_error *const err) {
+  if (!src) {
+    return true;
+  }
+  size_t const len = wcslen(src);
+  if (!OV_ARRAY_GROW(dest, len + 1)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+  memcpy(*dest, src, (len + 1) * sizeof(wchar_t));
+  return true;
+}
+
+static NODISCARD bool copy_utf8_string(char **const dest, char const *const src, struct ov_error *const err) {
+  size_t const len = src ? strlen(src) : 0;
+  if (!OV_ARRAY_GROW(dest, len + 1)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+  if (len) {
+    memcpy(*dest, src, len);
+  }
+  (*dest)[len] = '\0';
+  return true;
+}
+
+/**
+ * @brief Register the script modules that lua_ctx does not have yet
+ *
+ * Runs on the worker thread so that each Lua context is only touched by its own thread.
+ */
+static void register_pending_script_modules(struct worker_thread *const t, struct gcmz_lua_context *const lua_ctx) {
+  struct gcmz_lua_worker *const w = t->worker;
+  if (mtx_lock(&w->queue_mutex) != thrd_success) {
+    return;
+  }
+  size_t const n = OV_ARRAY_LENGTH(w->script_modules);
+  for (; t->num_script_modules < n; ++t->num_script_modules) {
+    struct script_module const *const m = &w->script_modules[t->num_script_modules];
+    struct ov_error err = {0};
+    if (!gcmz_lua_register_script_module(lua_ctx, m->table, m->name, m->source, &err)) {
+      OV_ERROR_REPORT(&err, NULL);
+    }
+  }
+  mtx_unlock(&w->queue_mutex);
+}
+
+static struct gcmz_lua_context *prepare_lua_context(struct worker_thread *const t) {
+  if (t->lua_ctx) {
+    register_pending_script_modules(t, t->lua_ctx);
+    return t->lua_ctx;
+  }
+
+  struct gcmz_lua_context *lua_ctx = NULL;
+  struct ov_error err = {0};
+  bool success = false;
+
+  if (!gcmz_lua_create(&lua_ctx, &err)) {
+    OV_ERROR_ADD_TRACE(&err);
+    goto cleanup;
+  }
+  // Registered before the handlers are loaded, as on the UI thread
+  t->num_script_modules = 0;
+  register_pending_script_modules(t, lua_ctx);
+  if (!gcmz_lua_setup(lua_ctx, &t->worker->options, &err)) {
+    OV_ERROR_ADD_TRACE(&err);
+    goto cleanup;
+  }
+  t->lua_ctx = lua_ctx;
+  lua_ctx = NULL;
+  success = true;
+
+cleanup:
+  if (lua_ctx) {
+    gcmz_lua_destroy(&lua_ctx);
+  }
+  if (!success) {
+    // Retried on the next job, the scripts may have been fixed in the meantime
+    OV_ERROR_REPORT(&err, NULL);
+  }
+  return t->lua_ctx;
+}
+
+static int worker_thread_proc(void *arg) {
+  struct worker_thread *const t = (struct worker_thread *)arg;
+  if (!t) {
+    return -1;
+  }
+  struct gcmz_lua_worker *const w = t->worker;
+  if (mtx_lock(&w->queue_mutex) != thrd_success) {
+    return -1;
+  }
+  while (w->thread_state == thread_state_running) {
+    if (OV_ARRAY_LENGTH(w->queue) == 0) {
+      cnd_wait(&w->wake_condition, &w->queue_mutex);
+      continue;
+    }
+    struct job const job = w->queue[0];
+    size_t const remaining = OV_ARRAY_LENGTH(w->queue) - 1;
+    memmove(w->queue, w->queue + 1, remaining * sizeof(struct job));
+    OV_ARRAY_SET_LENGTH(w->queue, remaining);
+    mtx_unlock(&w->queue_mutex);
+
+    t->current_userdata = job.userdata;
+    job.func(prepare_lua_context(t), job.userdata);
+    t->current_userdata = NULL;
+
+    if (mtx_lock(&w->queue_mutex) != thrd_success) {
+      return -1;
+    }
+  }
+
+  // Cancel the jobs that did not get a chance to run, gcmz_lua_worker_post rejects new ones from here on.
+  // The first thread to stop takes the whole queue, the others find it empty.
+  struct job *cancelled = w->queue;
+  w->queue = NULL;
+  mtx_unlock(&w->queue_mutex);
+  if (cancelled) {
+    size_t const ln = OV_ARRAY_LENGTH(cancelled);
+    for (size_t i = 0; i < ln; ++i) {
+      cancelled[i].func(NULL, cancelled[i].userdata);
+    }
+    OV_ARRAY_DESTROY(&cancelled);
+  }
+
+  if (t->lua_ctx) {
+    gcmz_lua_destroy(&t->lua_ctx);
+  }
+  return 0;
+}
+
+void gcmz_lua_worker_destroy(struct gcmz_lua_worker **const worker) {
+  if (!worker || !*worker) {
+    return;
+  }
+  struct gcmz_lua_worker *const w = *worker;
+
+  bool has_running_thread = false;
+  if (w->thread_state >= thread_state_cnd_created && mtx_lock(&w->queue_mutex) == thrd_success) {
+    has_running_thread = w->thread_state == thread_state_running;
+    if (has_running_thread) {
+      w->thread_state = thread_state_stopping;
+      cnd_broadcast(&w->wake_condition);
+    }
+    mtx_unlock(&w->queue_mutex);
+  }
+  if (has_running_thread) {
+    for (size_t i = 0; i < w->num_started; ++i) {
+      thrd_join(w->threads[i].thread, NULL);
+    }
+  }
+  if (w->thread_state >= thread_state_cnd_created) {
+    cnd_destroy(&w->wake_condition);
+  }
+  if (w->thread_state >= thread_state_mtx_created) {
+    mtx_destroy(&w->queue_mutex);
+  }
+  if (w->queue) {
+    OV_ARRAY_DESTROY(&w->queue);
+  }
+  if (w->script_modules) {
+    size_t const ln = OV_ARRAY_LENGTH(w->script_modules);
+    for (size_t i = 0; i < ln; ++i) {
+      if (w->script_modules[i].name) {
+        OV_ARRAY_DESTROY(&w->script_modules[i].name);
+      }
+      if (w->script_modules[i].source) {
+        OV_ARRAY_DESTROY(&w->script_modules[i].source);
+      }
+    }
+    OV_ARRAY_DESTROY(&w->script_modules);
+  }
+  if (w->threads) {
+    OV_FREE(&w->threads);
+  }
+  if (w->script_dir) {
+    OV_ARRAY_DESTROY(&w->script_dir);
+  }
+  if (w->bytecode_cache_dir) {
+    OV_ARRAY_DESTROY(&w->bytecode_cache_dir);
+  }
+  OV_FREE(worker);
+}
+
+NODISCARD bool gcmz_lua_worker_create(struct gcmz_lua_worker **const worker,
+                                      struct gcmz_lua_options const *const options,
+                                      size_t const num_threads,
+                                      struct ov_error *const err) {
+  if (!worker || *worker || !options || num_threads == 0) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  struct gcmz_lua_worker *w = NULL;
+  bool result = false;
+
+  {
+    if (!OV_REALLOC(&w, 1, sizeof(struct gcmz_lua_worker))) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    *w = (struct gcmz_lua_worker){.options = *options};
+
+    if (!copy_string(&w->script_dir, options->script_dir, err) ||
+        !copy_string(&w->bytecode_cache_dir, options->bytecode_cache_dir, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    w->options.script_dir = w->script_dir;
+    w->options.bytecode_cache_dir = w->bytecode_cache_dir;
+
+    if (!OV_REALLOC(&w->threads, num_threads, sizeof(struct worker_thread))) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    for (size_t i = 0; i < num_threads; ++i) {
+      w->threads[i] = (struct worker_thread){.worker = w};
+    }
+    w->num_threads = num_threads;
+
+    if (mtx_init(&w->queue_mutex, mtx_plain) != thrd_success) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+      goto cleanup;
+    }
+    w->thread_state = thread_state_mtx_created;
+
+    if (cnd_init(&w->wake_condition) != thrd_success) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+      goto cleanup;
+    }
+    w->thread_state = thread_state_cnd_created;
+
+    if (mtx_lock(&w->queue_mutex) != thrd_success) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+      goto cleanup;
+    }
+    while (w->num_started < w->num_threads &&
+           thrd_create(&w->threads[w->num_started].thread, worker_thread_proc, &w->threads[w->num_started]) ==
+               thrd_success) {
+      ++w->num_started;
+    }
+    if (w->num_started > 0) {
+      // Threads that did start are stopped by gcmz_lua_worker_destroy if the others failed
+      w->thread_state = thread_state_running;
+    }
+    mtx_unlock(&w->queue_mutex);
+
+    if (w->num_started != w->num_threads) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+      goto cleanup;
+    }
+  }
+
+  *worker = w;
+  w = NULL;
+  result = true;
+
+cleanup:
+  if (w) {
+    gcmz_lua_worker_destroy(&w);
+  }
+  return result;
+}
+
+NODISCARD bool gcmz_lua_worker_post(struct gcmz_lua_worker *const worker,
+                                    gcmz_lua_worker_job_func const func,
+                                    void *const userdata,
+                                    struct ov_error *const err) {
+  if (!worker || !func) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+  if (mtx_lock(&worker->queue_mutex) != thrd_success) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    return false;
+  }
+
+  bool result = false;
+
+  {
+    if (worker->thread_state != thread_state_running) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+      goto cleanup;
+    }
+    size_t const ln = OV_ARRAY_LENGTH(worker->queue);
+    if (!OV_ARRAY_GROW(&worker->queue, ln + 1)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    worker->queue[ln] = (struct job){.func = func, .userdata = userdata};
+    OV_ARRAY_SET_LENGTH(worker->queue, ln + 1);
+    cnd_signal(&worker->wake_condition);
+  }
+  result = true;
+
+cleanup:
+  mtx_unlock(&worker->queue_mutex);
+  return result;
+}
+
+NODISCARD bool gcmz_lua_worker_register_script_module(struct gcmz_lua_worker *const worker,
+                                                      struct aviutl2_script_module_table *const table,
+                                                      char const *const module_name,
+                                                      char const *const source,
+                                                      struct ov_error *const err) {
+  if (!worker || !table || !module_name || !*module_name) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  struct script_module m = {.table = table};
+  bool result = false;
+
+  {
+    if (!copy_utf8_string(&m.name, module_name, err) || !copy_utf8_string(&m.source, source, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    if (mtx_lock(&worker->queue_mutex) != thrd_success) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+      goto cleanup;
+    }
+    size_t const ln = OV_ARRAY_LENGTH(worker->script_modules);
+    if (!OV_ARRAY_GROW(&worker->script_modules, ln + 1)) {
+      mtx_unlock(&worker->queue_mutex);
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    worker->script_modules[ln] = m;
+    OV_ARRAY_SET_LENGTH(worker->script_modules, ln + 1);
+    mtx_unlock(&worker->queue_mutex);
+    m = (struct script_module){0};
+  }
+  result = true;
+
+cleanup:
+  if (m.name) {
+    OV_ARRAY_DESTROY(&m.name);
+  }
+  if (m.source) {
+    OV_ARRAY_DESTROY(&m.source);
+  }
+  return result;
+}
+
+static struct worker_thread *find_current_thread(struct gcmz_lua_worker *const worker) {
+  if (!worker) {
+    return NULL;
+  }
+  // thread_state and the thread handles are written under the lock while the threads are started and stopped
+  if (mtx_lock(&worker->queue_mutex) != thrd_success) {
+    return NULL;
+  }
+  struct worker_thread *result = NULL;
+  if (worker->thread_state >= thread_state_running) {
+    thrd_t const current = thrd_current();
+    for (size_t i = 0; i < worker->num_started; ++i) {
+      if (thrd_equal(current, worker->threads[i].thread)) {
+        result = &worker->threads[i];
+        break;
+      }
+    }
+  }
+  mtx_unlock(&worker->queue_mutex);
+  return result;
+}
+
+bool gcmz_lua_worker_is_current_thread(struct gcmz_lua_worker *const worker) {
+  return find_current_thread(worker) != NULL;
+}
+
+void *gcmz_lua_worker_get_current_userdata(struct gcmz_lua_worker *const worker) {
+  struct worker_thread const *const t = find_current_thread(worker);
+  return t ? t->current_userdata : NULL;
+}
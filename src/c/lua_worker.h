@@ -0,0 +1,101 @@
+#pragma once
+
+#include <ovbase.h>
+
+struct aviutl2_script_module_table;
+struct gcmz_lua_context;
+struct gcmz_lua_options;
+struct gcmz_lua_worker;
+
+/**
+ * @brief Job function executed on a worker thread
+ *
+ * @param lua_ctx Lua context owned by the worker thread running the job, or NULL if the job was cancelled or the context is unavailable
+ * @param userdata User data passed to gcmz_lua_worker_post
+ */
+typedef void (*gcmz_lua_worker_job_func)(struct gcmz_lua_context *const lua_ctx, void *const userdata);
+
+/**
+ * @brief Create a pool of worker threads that each own their own Lua context
+ *
+ * Each Lua context is created and set up with the given options on its worker thread
+ * when that thread receives its first job, so handlers are not loaded until they are needed.
+ * The Lua contexts share no Lua state and are only ever used on their own worker thread.
+ *
+ * String options are copied; callbacks and userdata must stay valid until the worker is destroyed
+ * and must be safe to call from several worker threads at once.
+ *
+ * @param worker [out] Pointer to store the created worker
+ * @param options Options passed to gcmz_lua_setup
+ * @param num_threads Number of worker threads, and therefore Lua contexts (must be at least 1)
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+NODISCARD bool gcmz_lua_worker_create(struct gcmz_lua_worker **const worker,
+                                      struct gcmz_lua_options const *const options,
+                                      size_t const num_threads,
+                                      struct ov_error *const err);
+
+/**
+ * @brief Stop the worker threads and destroy their Lua contexts
+ *
+ * Waits for the running jobs to finish.
+ * Jobs that have not started yet are called with a NULL Lua context so they can release their resources.
+ *
+ * @param worker [in,out] Worker to destroy, set to NULL on return
+ */
+void gcmz_lua_worker_destroy(struct gcmz_lua_worker **const worker);
+
+/**
+ * @brief Queue a job to run on a worker thread
+ *
+ * Jobs are started in the order they were posted by the first idle worker thread.
+ * With more than one thread, jobs can run at the same time and finish in any order.
+ * This function is thread-safe and can be called from any thread.
+ *
+ * @param worker Worker instance
+ * @param func Job function
+ * @param userdata User data passed to the job function
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+NODISCARD bool gcmz_lua_worker_post(struct gcmz_lua_worker *const worker,
+                                    gcmz_lua_worker_job_func const func,
+                                    void *const userdata,
+                                    struct ov_error *const err);
+
+/**
+ * @brief Make a script module available to the Lua contexts of the worker threads
+ *
+ * Each worker thread registers the module into its own Lua context before running its next job,
+ * so the module functions are called from the worker threads and must be safe to call from them.
+ * This function is thread-safe and can be called from any thread.
+ *
+ * @param worker Worker instance
+ * @param table Script module table from external DLL (must stay valid until the worker is destroyed)
+ * @param module_name Module name (UTF-8)
+ * @param source Source path indicating where the module came from (UTF-8, can be NULL)
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+NODISCARD bool gcmz_lua_worker_register_script_module(struct gcmz_lua_worker *const worker,
+                                                      struct aviutl2_script_module_table *const table,
+                                                      char const *const module_name,
+                                                      char const *const source,
+                                                      struct ov_error *const err);
+
+/**
+ * @brief Check whether the calling thread is one of the worker threads
+ *
+ * @param worker Worker instance
+ * @return true if called from a worker thread, false otherwise
+ */
+bool gcmz_lua_worker_is_current_thread(struct gcmz_lua_worker *const worker);
+
+/**
+ * @brief Get the user data of the job running on the calling thread
+ *
+ * @param worker Worker instance
+ * @return User data passed to gcmz_lua_worker_post, or NULL if not called from a job on a worker thread
+ */
+void *gcmz_lua_worker_get_current_userdata(struct gcmz_lua_worker *const worker);
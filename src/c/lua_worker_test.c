@@ -0,0 +1,297 @@
+#include <ovtest.h>
+
+#include <stdatomic.h>
+
+#include <ovthreads.h>
+
+#include <aviutl2_module2.h>
+#include <lua.h>
+
+#include "lua.h"
+#include "lua_worker.h"
+
+#define STRINGIZE2(x) L## #x
+#define STRINGIZE(x) STRINGIZE2(x)
+#define LUA_SRC_DIR STRINGIZE(SOURCE_DIR) L"/../lua"
+
+struct job_record {
+  struct gcmz_lua_worker *worker;
+  atomic_int *sequence;
+  int order;
+  bool on_worker_thread;
+  bool sees_own_userdata;
+  bool cancelled;
+  struct gcmz_lua_context *lua_ctx;
+  atomic_bool started;
+  atomic_bool done;
+};
+
+static void record_job(struct gcmz_lua_context *const lua_ctx, void *const userdata) {
+  struct job_record *const r = (struct job_record *)userdata;
+  atomic_store(&r->started, true);
+  r->on_worker_thread = gcmz_lua_worker_is_current_thread(r->worker);
+  r->sees_own_userdata = gcmz_lua_worker_get_current_userdata(r->worker) == r;
+  r->cancelled = lua_ctx == NULL;
+  r->lua_ctx = lua_ctx;
+  r->order = atomic_fetch_add(r->sequence, 1);
+  atomic_store(&r->done, true);
+}
+
+static void slow_job(struct gcmz_lua_context *const lua_ctx, void *const userdata) {
+  struct job_record *const r = (struct job_record *)userdata;
+  atomic_store(&r->started, true);
+  thrd_sleep(&(struct timespec){.tv_sec = 0, .tv_nsec = 200000000}, NULL);
+  r->cancelled = lua_ctx == NULL;
+  r->order = atomic_fetch_add(r->sequence, 1);
+  atomic_store(&r->done, true);
+}
+
+static void wait_flag(atomic_bool *const flag) {
+  for (int i = 0; i < 500 && !atomic_load(flag); ++i) {
+    thrd_sleep(&(struct timespec){.tv_sec = 0, .tv_nsec = 10000000}, NULL);
+  }
+}
+
+static void test_lua_worker_runs_jobs_in_order(void) {
+  struct gcmz_lua_worker *worker = NULL;
+  struct ov_error err = {0};
+  atomic_int sequence = 0;
+  struct job_record records[3] = {0};
+
+  if (!TEST_SUCCEEDED(gcmz_lua_worker_create(&worker, &(struct gcmz_lua_options){.script_dir = LUA_SRC_DIR}, 1, &err),
+                      &err)) {
+    return;
+  }
+  TEST_CHECK(!gcmz_lua_worker_is_current_thread(worker));
+  TEST_CHECK(gcmz_lua_worker_get_current_userdata(worker) == NULL);
+
+  for (size_t i = 0; i < 3; ++i) {
+    records[i].worker = worker;
+    records[i].sequence = &sequence;
+    if (!TEST_SUCCEEDED(gcmz_lua_worker_post(worker, record_job, &records[i], &err), &err)) {
+      goto cleanup;
+    }
+  }
+  wait_flag(&records[2].done);
+
+  for (int i = 0; i < 3; ++i) {
+    TEST_CHECK(atomic_load(&records[i].done));
+    TEST_CHECK(records[i].order == i);
+    TEST_CHECK(records[i].on_worker_thread);
+    TEST_CHECK(records[i].sees_own_userdata);
+    TEST_CHECK(!records[i].cancelled);
+    // The same Lua context is kept for all jobs
+    TEST_CHECK(records[i].lua_ctx == records[0].lua_ctx);
+  }
+
+cleanup:
+  gcmz_lua_worker_destroy(&worker);
+  TEST_CHECK(worker == NULL);
+}
+
+static void test_lua_worker_cancels_pending_jobs(void) {
+  struct gcmz_lua_worker *worker = NULL;
+  struct ov_error err = {0};
+  atomic_int sequence = 0;
+  struct job_record slow = {0};
+  struct job_record pending[2] = {0};
+
+  if (!TEST_SUCCEEDED(gcmz_lua_worker_create(&worker, &(struct gcmz_lua_options){.script_dir = LUA_SRC_DIR}, 1, &err),
+                      &err)) {
+    return;
+  }
+
+  slow.worker = worker;
+  slow.sequence = &sequence;
+  if (!TEST_SUCCEEDED(gcmz_lua_worker_post(worker, slow_job, &slow, &err), &err)) {
+    goto cleanup;
+  }
+  for (size_t i = 0; i < 2; ++i) {
+    pending[i].worker = worker;
+    pending[i].sequence = &sequence;
+    if (!TEST_SUCCEEDED(gcmz_lua_worker_post(worker, record_job, &pending[i], &err), &err)) {
+      goto cleanup;
+    }
+  }
+  wait_flag(&slow.started);
+
+  // Waits for the running job, then hands the rest a NULL context
+  gcmz_lua_worker_destroy(&worker);
+
+  TEST_CHECK(atomic_load(&slow.done));
+  TEST_CHECK(!slow.cancelled);
+  TEST_CHECK(slow.order == 0);
+  for (int i = 0; i < 2; ++i) {
+    TEST_CHECK(atomic_load(&pending[i].done));
+    TEST_CHECK(pending[i].cancelled);
+    TEST_CHECK(pending[i].order == i + 1);
+  }
+
+cleanup:
+  gcmz_lua_worker_destroy(&worker);
+}
+
+struct parallel_record {
+  struct gcmz_lua_worker *worker;
+  atomic_int *running;
+  atomic_int *max_running;
+  struct gcmz_lua_context *lua_ctx;
+  bool sees_own_userdata;
+  atomic_bool done;
+};
+
+static void parallel_job(struct gcmz_lua_context *const lua_ctx, void *const userdata) {
+  struct parallel_record *const r = (struct parallel_record *)userdata;
+  int const running = atomic_fetch_add(r->running, 1) + 1;
+  int max_running = atomic_load(r->max_running);
+  while (running > max_running && !atomic_compare_exchange_weak(r->max_running, &max_running, running)) {
+  }
+  thrd_sleep(&(struct timespec){.tv_sec = 0, .tv_nsec = 200000000}, NULL);
+  r->lua_ctx = lua_ctx;
+  r->sees_own_userdata = gcmz_lua_worker_get_current_userdata(r->worker) == r;
+  atomic_fetch_sub(r->running, 1);
+  atomic_store(&r->done, true);
+}
+
+static void test_lua_worker_runs_jobs_in_parallel(void) {
+  struct gcmz_lua_worker *worker = NULL;
+  struct ov_error err = {0};
+  atomic_int running = 0;
+  atomic_int max_running = 0;
+  struct parallel_record records[2] = {0};
+
+  if (!TEST_SUCCEEDED(gcmz_lua_worker_create(&worker, &(struct gcmz_lua_options){.script_dir = LUA_SRC_DIR}, 2, &err),
+                      &err)) {
+    return;
+  }
+
+  for (size_t i = 0; i < 2; ++i) {
+    records[i].worker = worker;
+    records[i].running = &running;
+    records[i].max_running = &max_running;
+    if (!TEST_SUCCEEDED(gcmz_lua_worker_post(worker, parallel_job, &records[i], &err), &err)) {
+      goto cleanup;
+    }
+  }
+  wait_flag(&records[0].done);
+  wait_flag(&records[1].done);
+
+  TEST_CHECK(atomic_load(&max_running) == 2);
+  for (int i = 0; i < 2; ++i) {
+    TEST_CHECK(atomic_load(&records[i].done));
+    TEST_CHECK(records[i].sees_own_userdata);
+    TEST_CHECK(records[i].lua_ctx != NULL);
+  }
+  // Each thread owns its own Lua context
+  TEST_CHECK(records[0].lua_ctx != records[1].lua_ctx);
+
+cleanup:
+  gcmz_lua_worker_destroy(&worker);
+}
+
+struct script_module_record {
+  char const *name;
+  bool found;
+  atomic_bool done;
+};
+
+static void find_script_module_job(struct gcmz_lua_context *const lua_ctx, void *const userdata) {
+  struct script_module_record *const r = (struct script_module_record *)userdata;
+  if (lua_ctx) {
+    lua_State *const L = gcmz_lua_get_state(lua_ctx);
+    lua_getfield(L, LUA_REGISTRYINDEX, gcmz_lua_get_script_modules_key());
+    if (lua_istable(L, -1)) {
+      lua_getfield(L, -1, r->name);
+      r->found = lua_istable(L, -1);
+      lua_pop(L, 1);
+    }
+    lua_pop(L, 1);
+  }
+  atomic_store(&r->done, true);
+}
+
+static void noop_module_func(struct aviutl2_script_module_param *param) { (void)param; }
+
+static struct aviutl2_script_module_function g_worker_test_functions[] = {
+    {L"noop", noop_module_func},
+    {NULL, NULL},
+};
+
+static struct aviutl2_script_module_table g_worker_test_module = {
+    .information = L"Worker Test Module",
+    .functions = g_worker_test_functions,
+};
+
+static void test_lua_worker_registers_script_modules(void) {
+  struct gcmz_lua_worker *worker = NULL;
+  struct ov_error err = {0};
+  struct script_module_record first = {.name = "first"};
+  struct script_module_record second = {.name = "second"};
+
+  if (!TEST_SUCCEEDED(gcmz_lua_worker_create(&worker, &(struct gcmz_lua_options){.script_dir = LUA_SRC_DIR}, 1, &err),
+                      &err)) {
+    return;
+  }
+
+  // Registered before the Lua context exists
+  if (!TEST_SUCCEEDED(
+          gcmz_lua_worker_register_script_module(worker, &g_worker_test_module, "first", "test.dll", &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_worker_post(worker, find_script_module_job, &first, &err), &err)) {
+    goto cleanup;
+  }
+  wait_flag(&first.done);
+  TEST_CHECK(first.found);
+
+  // Registered after the Lua context was created
+  if (!TEST_SUCCEEDED(
+          gcmz_lua_worker_register_script_module(worker, &g_worker_test_module, "second", NULL, &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_lua_worker_post(worker, find_script_module_job, &second, &err), &err)) {
+    goto cleanup;
+  }
+  wait_flag(&second.done);
+  TEST_CHECK(second.found);
+
+cleanup:
+  gcmz_lua_worker_destroy(&worker);
+}
+
+static void test_lua_worker_invalid_args(void) {
+  struct gcmz_lua_worker *worker = NULL;
+  struct ov_error err = {0};
+
+  TEST_FAILED_WITH(gcmz_lua_worker_create(NULL, &(struct gcmz_lua_options){0}, 1, &err),
+                   &err,
+                   ov_error_type_generic,
+                   ov_error_generic_invalid_argument);
+  TEST_FAILED_WITH(
+      gcmz_lua_worker_create(&worker, NULL, 1, &err), &err, ov_error_type_generic, ov_error_generic_invalid_argument);
+  TEST_FAILED_WITH(gcmz_lua_worker_create(&worker, &(struct gcmz_lua_options){0}, 0, &err),
+                   &err,
+                   ov_error_type_generic,
+                   ov_error_generic_invalid_argument);
+  TEST_FAILED_WITH(gcmz_lua_worker_post(NULL, record_job, NULL, &err),
+                   &err,
+                   ov_error_type_generic,
+                   ov_error_generic_invalid_argument);
+  TEST_FAILED_WITH(gcmz_lua_worker_register_script_module(NULL, &g_worker_test_module, "name", NULL, &err),
+                   &err,
+                   ov_error_type_generic,
+                   ov_error_generic_invalid_argument);
+  TEST_CHECK(!gcmz_lua_worker_is_current_thread(NULL));
+  TEST_CHECK(gcmz_lua_worker_get_current_userdata(NULL) == NULL);
+  gcmz_lua_worker_destroy(NULL);
+  gcmz_lua_worker_destroy(&worker);
+}
+
+TEST_LIST = {
+    {"test_lua_worker_runs_jobs_in_order", test_lua_worker_runs_jobs_in_order},
+    {"test_lua_worker_cancels_pending_jobs", test_lua_worker_cancels_pending_jobs},
+    {"test_lua_worker_runs_jobs_in_parallel", test_lua_worker_runs_jobs_in_parallel},
+    {"test_lua_worker_registers_script_modules", test_lua_worker_registers_script_modules},
+    {"test_lua_worker_invalid_args", test_lua_worker_invalid_args},
+    {NULL, NULL},
+};
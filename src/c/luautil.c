@@ -11,6 +11,7 @@
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -221,22 +222,305 @@ static char const *lua_file_reader(struct lua_State *const L, void *const ud, si
   return buf;
 }
 
-static bool lua_loadfile_w(struct lua_State *const L, NATIVE_CHAR const *const filepath, struct ov_error *const err) {
-  if (!L || !filepath || filepath[0] == L'\0') {
+static char const bytecode_cache_dir_key[] = "gcmz_bytecode_cache_dir";
+
+enum { max_bytecode_cache_size = 64 * 1024 * 1024 };
+
+NODISCARD bool gcmz_lua_build_bytecode_cache_dir(wchar_t const *const base_dir,
+                                                 wchar_t **const dest,
+                                                 struct ov_error *const err) {
+  if (!base_dir || !dest) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  static wchar_t const subdir[] = L"\\gcmzdrops\\luacache";
+  size_t base_len = wcslen(base_dir);
+  if (base_len > 0 && (base_dir[base_len - 1] == L'\\' || base_dir[base_len - 1] == L'/')) {
+    --base_len;
+  }
+  size_t const subdir_len = sizeof(subdir) / sizeof(wchar_t) - 1;
+  if (!OV_ARRAY_GROW(dest, base_len + subdir_len + 1)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+  memcpy(*dest, base_dir, base_len * sizeof(wchar_t));
+  wcscpy(*dest + base_len, subdir);
+  OV_ARRAY_SET_LENGTH(*dest, base_len + subdir_len);
+  return true;
+}
+
+NODISCARD bool gcmz_lua_set_bytecode_cache_dir(struct lua_State *const L,
+                                               wchar_t const *const cache_dir,
+                                               struct ov_error *const err) {
+  if (!L) {
     OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
     return false;
   }
+  if (!cache_dir || cache_dir[0] == L'\0') {
+    lua_pushnil(L);
+    lua_setfield(L, LUA_REGISTRYINDEX, bytecode_cache_dir_key);
+    return true;
+  }
+
+  char *utf8_dir = NULL;
+  if (!gcmz_wchar_to_utf8(cache_dir, &utf8_dir, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  lua_pushstring(L, utf8_dir);
+  lua_setfield(L, LUA_REGISTRYINDEX, bytecode_cache_dir_key);
+  OV_ARRAY_DESTROY(&utf8_dir);
+  return true;
+}
+
+static void format_hex64(char *const dest, uint64_t value) {
+  static char const digits[] = "0123456789abcdef";
+  for (int i = 15; i >= 0; --i) {
+    dest[i] = digits[value & 0xf];
+    value >>= 4;
+  }
+  dest[16] = '\0';
+}
+
+/**
+ * @brief Build the bytecode cache entry path and header for a source file
+ *
+ * The header identifies the source by chunk name, size and last write time, and the
+ * compiler by LuaJIT version and architecture. A cache entry is only used when its
+ * header matches exactly.
+ *
+ * @param L Lua state
+ * @param filepath Source file path
+ * @param chunkname Chunk name of the source ("@" + UTF-8 path)
+ * @param cache_path [in/out] Cache entry path (OV_ARRAY, can be reused)
+ * @param header [in/out] Cache entry header, NUL-terminated (OV_ARRAY, can be reused)
+ * @return true if the cache is enabled and the key was built, false otherwise
+ */
+static bool build_bytecode_cache_key(struct lua_State *const L,
+                                     NATIVE_CHAR const *const filepath,
+                                     char const *const chunkname,
+                                     wchar_t **const cache_path,
+                                     char **const header) {
+  int const top = lua_gettop(L);
+  bool result = false;
+
+  {
+    lua_getfield(L, LUA_REGISTRYINDEX, bytecode_cache_dir_key);
+    char const *const dir = lua_tostring(L, -1);
+    if (!dir) {
+      goto cleanup;
+    }
+    lua_getglobal(L, "jit");
+    if (!lua_istable(L, -1)) {
+      goto cleanup;
+    }
+    lua_getfield(L, -1, "version");
+    lua_getfield(L, -2, "arch");
+    char const *const version = lua_tostring(L, -2);
+    char const *const arch = lua_tostring(L, -1);
+    if (!version || !arch) {
+      goto cleanup;
+    }
+
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    if (!GetFileAttributesExW(filepath, GetFileExInfoStandard, &fad)) {
+      goto cleanup;
+    }
+    char size_hex[17];
+    char mtime_hex[17];
+    format_hex64(size_hex, ((uint64_t)fad.nFileSizeHigh << 32) | (uint64_t)fad.nFileSizeLow);
+    format_hex64(mtime_hex,
+                 ((uint64_t)fad.ftLastWriteTime.dwHighDateTime << 32) | (uint64_t)fad.ftLastWriteTime.dwLowDateTime);
+
+    lua_pushfstring(L, "GCMZLBC1\n%s %s\n%s %s\n%s\n", version, arch, size_hex, mtime_hex, chunkname);
+    size_t header_len = 0;
+    char const *const h = lua_tolstring(L, -1, &header_len);
+    if (!OV_ARRAY_GROW(header, header_len + 1)) {
+      goto cleanup;
+    }
+    memcpy(*header, h, header_len + 1);
+
+    // Entry file name is the FNV-1a hash of the chunk name
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (char const *p = chunkname; *p; ++p) {
+      hash = (hash ^ (uint64_t)(unsigned char)*p) * 0x100000001b3ULL;
+    }
+    char hash_hex[17];
+    format_hex64(hash_hex, hash);
+    lua_pushfstring(L, "%s\\%s.luac", dir, hash_hex);
+    if (!gcmz_utf8_to_wchar(lua_tostring(L, -1), cache_path, NULL)) {
+      goto cleanup;
+    }
+  }
+
+  result = true;
+
+cleanup:
+  lua_settop(L, top);
+  return result;
+}
 
+/**
+ * @brief Load a chunk from the bytecode cache
+ *
+ * @param L Lua state
+ * @param cache_path Cache entry path
+ * @param header Expected cache entry header
+ * @param chunkname Chunk name of the source
+ * @return true if the chunk was loaded and pushed, false on cache miss
+ */
+static bool load_cached_bytecode(struct lua_State *const L,
+                                 wchar_t const *const cache_path,
+                                 char const *const header,
+                                 char const *const chunkname) {
   struct ovl_file *file = NULL;
-  char *chunkname = NULL;
+  char *buf = NULL;
   bool result = false;
 
   {
-    if (!ovl_file_open(filepath, &file, err)) {
-      OV_ERROR_ADD_TRACE(err);
+    if (!ovl_file_open(cache_path, &file, NULL)) {
+      goto cleanup;
+    }
+    uint64_t file_size = 0;
+    if (!ovl_file_size(file, &file_size, NULL)) {
+      goto cleanup;
+    }
+    size_t const header_len = strlen(header);
+    if (file_size <= header_len || file_size > max_bytecode_cache_size) {
+      goto cleanup;
+    }
+    size_t const size = (size_t)file_size;
+    if (!OV_ARRAY_GROW(&buf, size)) {
+      goto cleanup;
+    }
+    size_t total = 0;
+    while (total < size) {
+      size_t read = 0;
+      if (!ovl_file_read(file, buf + total, size - total, &read, NULL) || read == 0) {
+        goto cleanup;
+      }
+      total += read;
+    }
+    if (memcmp(buf, header, header_len) != 0) {
+      goto cleanup;
+    }
+    if (luaL_loadbuffer(L, buf + header_len, size - header_len, chunkname) != LUA_OK) {
+      lua_pop(L, 1);
+      goto cleanup;
+    }
+  }
+
+  result = true;
+
+cleanup:
+  if (buf) {
+    OV_ARRAY_DESTROY(&buf);
+  }
+  if (file) {
+    ovl_file_close(file);
+  }
+  return result;
+}
+
+static int bytecode_writer(struct lua_State *const L, void const *const p, size_t const sz, void *const ud) {
+  (void)L;
+  char **const buf = (char **)ud;
+  size_t const len = OV_ARRAY_LENGTH(*buf);
+  if (!OV_ARRAY_GROW(buf, len + sz)) {
+    return 1;
+  }
+  memcpy(*buf + len, p, sz);
+  OV_ARRAY_SET_LENGTH(*buf, len + sz);
+  return 0;
+}
+
+/**
+ * @brief Store the function at the top of the stack in the bytecode cache
+ *
+ * Failures are ignored; the source is simply loaded again next time.
+ *
+ * @param L Lua state
+ * @param cache_path Cache entry path
+ * @param header Cache entry header
+ */
+static void store_cached_bytecode(struct lua_State *const L,
+                                  wchar_t const *const cache_path,
+                                  char const *const header) {
+  char *buf = NULL;
+  wchar_t *tmp_path = NULL;
+  struct ovl_file *file = NULL;
+  bool written = false;
+
+  {
+    size_t const header_len = strlen(header);
+    if (!OV_ARRAY_GROW(&buf, header_len + 4096)) {
+      goto cleanup;
+    }
+    memcpy(buf, header, header_len);
+    OV_ARRAY_SET_LENGTH(buf, header_len);
+    if (lua_dump(L, bytecode_writer, &buf) != 0) {
+      goto cleanup;
+    }
+
+    // Write to a temporary file first so a partially written entry is never read.
+    // The thread id keeps Lua states on different threads that compile the same script from sharing the file.
+    static wchar_t const tmp_suffix_format[] = L".%1$u.tmp";
+    wchar_t tmp_suffix[16];
+    ov_snprintf_wchar(tmp_suffix,
+                      sizeof(tmp_suffix) / sizeof(tmp_suffix[0]),
+                      tmp_suffix_format,
+                      tmp_suffix_format,
+                      (unsigned int)GetCurrentThreadId());
+    size_t const path_len = wcslen(cache_path);
+    size_t const suffix_len = wcslen(tmp_suffix);
+    if (!OV_ARRAY_GROW(&tmp_path, path_len + suffix_len + 1)) {
       goto cleanup;
     }
+    wcscpy(tmp_path, cache_path);
+    wcscpy(tmp_path + path_len, tmp_suffix);
+    if (!ovl_file_create(tmp_path, &file, NULL)) {
+      goto cleanup;
+    }
+    size_t const len = OV_ARRAY_LENGTH(buf);
+    size_t n = 0;
+    bool const ok = ovl_file_write(file, buf, len, &n, NULL) && n == len;
+    ovl_file_close(file);
+    file = NULL;
+    if (!ok || !MoveFileExW(tmp_path, cache_path, MOVEFILE_REPLACE_EXISTING)) {
+      goto cleanup;
+    }
+    written = true;
+  }
+
+cleanup:
+  if (file) {
+    ovl_file_close(file);
+  }
+  if (tmp_path) {
+    if (!written) {
+      DeleteFileW(tmp_path);
+    }
+    OV_ARRAY_DESTROY(&tmp_path);
+  }
+  if (buf) {
+    OV_ARRAY_DESTROY(&buf);
+  }
+}
+
+static bool lua_loadfile_w(struct lua_State *const L, NATIVE_CHAR const *const filepath, struct ov_error *const err) {
+  if (!L || !filepath || filepath[0] == L'\0') {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
 
+  struct ovl_file *file = NULL;
+  char *chunkname = NULL;
+  wchar_t *cache_path = NULL;
+  char *cache_header = NULL;
+  bool result = false;
+
+  {
     // Build chunk name "@filepath" in one allocation
     size_t const filepath_len = wcslen(filepath);
     size_t const utf8_len = ov_wchar_to_utf8_len(filepath, filepath_len);
@@ -254,6 +538,17 @@ static bool lua_loadfile_w(struct lua_State *const L, NATIVE_CHAR const *const f
       goto cleanup;
     }
 
+    bool const use_cache = build_bytecode_cache_key(L, filepath, chunkname, &cache_path, &cache_header);
+    if (use_cache && load_cached_bytecode(L, cache_path, cache_header, chunkname)) {
+      result = true;
+      goto cleanup;
+    }
+
+    if (!ovl_file_open(filepath, &file, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+
     struct lua_reader_state state = {
         .file = file,
         .first_read = true,
@@ -266,11 +561,21 @@ static bool lua_loadfile_w(struct lua_State *const L, NATIVE_CHAR const *const f
       lua_pop(L, 1);
       goto cleanup;
     }
+
+    if (use_cache) {
+      store_cached_bytecode(L, cache_path, cache_header);
+    }
   }
 
   result = true;
 
 cleanup:
+  if (cache_header) {
+    OV_ARRAY_DESTROY(&cache_header);
+  }
+  if (cache_path) {
+    OV_ARRAY_DESTROY(&cache_path);
+  }
   if (chunkname) {
     OV_ARRAY_DESTROY(&chunkname);
   }
@@ -422,76 +727,259 @@ static char const *get_package_field(struct lua_State *L, char const *field) {
   return path;
 }
 
+/**
+ * @brief Registry key for the module search cache
+ *
+ * The table holds two subtables:
+ * - dirs: folded directory path -> set of folded file names, or false if the directory cannot be listed
+ * - resolved: path pattern .. "\n" .. module name -> UTF-8 path of the file that was found
+ */
+static char const module_search_cache_key[] = "gcmz_module_search_cache";
+
+/**
+ * @brief Push a subtable of the module search cache, creating it if needed
+ */
+static void push_module_search_cache(struct lua_State *L, char const *name) {
+  lua_getfield(L, LUA_REGISTRYINDEX, module_search_cache_key);
+  if (!lua_istable(L, -1)) {
+    lua_pop(L, 1);
+    lua_createtable(L, 0, 2);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, LUA_REGISTRYINDEX, module_search_cache_key);
+  }
+  lua_getfield(L, -1, name);
+  if (!lua_istable(L, -1)) {
+    lua_pop(L, 1);
+    lua_newtable(L);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -3, name);
+  }
+  lua_remove(L, -2);
+}
+
+/**
+ * @brief Push a wide string with ASCII letters folded to lower case as a Lua string key
+ *
+ * Windows file names are case-insensitive, so the directory index is keyed by folded names.
+ */
+static bool push_folded_key(struct lua_State *L, wchar_t const *src, size_t len, wchar_t **scratch) {
+  if (!OV_ARRAY_GROW(scratch, len + 1)) {
+    return false;
+  }
+  for (size_t i = 0; i < len; i++) {
+    wchar_t const c = src[i];
+    (*scratch)[i] = (c >= L'A' && c <= L'Z') ? (wchar_t)(c - L'A' + L'a') : c;
+  }
+  lua_pushlstring(L, (char const *)*scratch, len * sizeof(wchar_t));
+  return true;
+}
+
+/**
+ * @brief Push the index of a directory, listing it on first use
+ *
+ * Stack: [] -> [set of folded file names, or false]
+ *
+ * @param dir Directory path ending with a separator
+ * @param dir_len Length of dir in characters
+ */
+static void push_directory_index(struct lua_State *L, wchar_t const *dir, size_t dir_len, wchar_t **scratch) {
+  push_module_search_cache(L, "dirs");
+  if (!push_folded_key(L, dir, dir_len, scratch)) {
+    lua_pop(L, 1);
+    lua_pushboolean(L, 0);
+    return;
+  }
+  lua_pushvalue(L, -1);
+  lua_rawget(L, -3);
+  if (!lua_isnil(L, -1)) {
+    lua_replace(L, -3);
+    lua_pop(L, 1);
+    return;
+  }
+  lua_pop(L, 1);
+  // Stack: [dirs, key]
+
+  bool indexed = false;
+  if (OV_ARRAY_GROW(scratch, dir_len + 2)) {
+    memcpy(*scratch, dir, dir_len * sizeof(wchar_t));
+    (*scratch)[dir_len] = L'*';
+    (*scratch)[dir_len + 1] = L'\0';
+    WIN32_FIND_DATAW find_data;
+    HANDLE const h =
+        FindFirstFileExW(*scratch, FindExInfoBasic, &find_data, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+    if (h != INVALID_HANDLE_VALUE) {
+      lua_newtable(L);
+      do {
+        if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+          continue;
+        }
+        if (push_folded_key(L, find_data.cFileName, wcslen(find_data.cFileName), scratch)) {
+          lua_pushboolean(L, 1);
+          lua_rawset(L, -3);
+        }
+      } while (FindNextFileW(h, &find_data));
+      FindClose(h);
+      indexed = true;
+    }
+  }
+  if (!indexed) {
+    lua_pushboolean(L, 0);
+  }
+  // Stack: [dirs, key, index]
+  lua_pushvalue(L, -1);
+  lua_insert(L, -4);
+  lua_rawset(L, -3);
+  lua_pop(L, 1);
+}
+
+/**
+ * @brief Check if a file exists using the directory index
+ *
+ * Only absolute paths are indexed; relative paths depend on the current directory and are probed directly.
+ * Names with non-ASCII characters that are not in the index are probed as well,
+ * since the index only folds the case of ASCII letters.
+ */
+static bool indexed_file_exists(struct lua_State *L, wchar_t const *path, wchar_t **scratch) {
+  size_t const len = wcslen(path);
+  bool const absolute = (len >= 3 && path[1] == L':' && (path[2] == L'\\' || path[2] == L'/')) ||
+                        (len >= 2 && path[0] == L'\\' && path[1] == L'\\');
+  size_t dir_len = len;
+  while (dir_len > 0 && path[dir_len - 1] != L'\\' && path[dir_len - 1] != L'/') {
+    dir_len--;
+  }
+  if (!absolute || dir_len == 0) {
+    return file_exists_w(path);
+  }
+  wchar_t const *const name = path + dir_len;
+  size_t const name_len = len - dir_len;
+  if (name_len == 0) {
+    return false;
+  }
+
+  push_directory_index(L, path, dir_len, scratch);
+  bool exists = false;
+  if (lua_istable(L, -1) && push_folded_key(L, name, name_len, scratch)) {
+    lua_rawget(L, -2);
+    exists = lua_toboolean(L, -1) != 0;
+    lua_pop(L, 1);
+  }
+  lua_pop(L, 1);
+  if (exists) {
+    return true;
+  }
+  for (size_t i = 0; i < name_len; i++) {
+    if (name[i] >= 0x80) {
+      return file_exists_w(path);
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Push a path built from one template of a search path pattern
+ *
+ * @param template_begin Start of the template
+ * @param template_end End of the template (';' or the terminating null)
+ * @param modname Module name replacing each '?'
+ */
+static void
+push_template_path(struct lua_State *L, char const *template_begin, char const *template_end, char const *modname) {
+  luaL_Buffer path_buf;
+  luaL_buffinit(L, &path_buf);
+  for (char const *q = template_begin; q < template_end; q++) {
+    if (*q == '?') {
+      luaL_addstring(&path_buf, modname);
+    } else {
+      luaL_addchar(&path_buf, *q);
+    }
+  }
+  luaL_pushresult(&path_buf);
+}
+
+static char const *find_template_end(char const *p) {
+  char const *const template_end = strchr(p, ';');
+  return template_end ? template_end : p + strlen(p);
+}
+
 /**
  * @brief Search for a file in package.path/cpath pattern
  *
  * Replaces '?' with module name and checks if file exists.
+ * Results are cached per Lua state, and existence is checked against an index of each directory
+ * that is built the first time the directory is searched, so the file system is only touched
+ * on a cache miss. Call gcmz_lua_clear_module_search_cache when the directories change.
  *
  * @param L Lua state
  * @param modname Module name (with '.' replaced by separator)
  * @param path_pattern Search path pattern (e.g., "?.lua;?/init.lua")
  * @param found_path [in/out] Buffer to store found path (reusable)
- * @return true if file found, false otherwise
+ * @return true if file found, false otherwise (pushes the list of tried paths)
  */
 static bool search_path(struct lua_State *L, char const *modname, char const *path_pattern, wchar_t **found_path) {
   if (!path_pattern || !modname || !found_path) {
     return false;
   }
 
-  // Build error message for "not found" paths
-  luaL_Buffer tried;
-  luaL_buffinit(L, &tried);
-
-  char const *p = path_pattern;
-  while (*p) {
-    // Find end of this template
-    char const *template_end = strchr(p, ';');
-    if (!template_end) {
-      template_end = p + strlen(p);
-    }
-
-    // Build the filename by replacing '?' with modname
-    luaL_Buffer path_buf;
-    luaL_buffinit(L, &path_buf);
-
-    char const *q = p;
-    while (q < template_end) {
-      if (*q == '?') {
-        luaL_addstring(&path_buf, modname);
-      } else {
-        luaL_addchar(&path_buf, *q);
-      }
-      q++;
-    }
-    luaL_pushresult(&path_buf);
-
-    char const *const filepath = lua_tostring(L, -1);
-
-    // Convert to wchar_t and check existence
-    if (gcmz_utf8_to_wchar(filepath, found_path, NULL) && file_exists_w(*found_path)) {
-      // Clean up: remove filepath string and tried buffer
-      lua_pop(L, 1); // Pop filepath string
-      luaL_pushresult(&tried);
-      lua_pop(L, 1); // Discard tried buffer
-      return true;
+  push_module_search_cache(L, "resolved");
+  lua_pushstring(L, path_pattern);
+  lua_pushliteral(L, "\n");
+  lua_pushstring(L, modname);
+  lua_concat(L, 3);
+  lua_pushvalue(L, -1);
+  lua_rawget(L, -3);
+  if (lua_isstring(L, -1) && gcmz_utf8_to_wchar(lua_tostring(L, -1), found_path, NULL)) {
+    lua_pop(L, 3);
+    return true;
+  }
+  lua_pop(L, 1);
+  // Stack: [resolved, key]
+
+  wchar_t *scratch = NULL;
+  bool found = false;
+  for (char const *p = path_pattern; *p;) {
+    char const *const template_end = find_template_end(p);
+    push_template_path(L, p, template_end, modname);
+    if (gcmz_utf8_to_wchar(lua_tostring(L, -1), found_path, NULL) &&
+        indexed_file_exists(L, *found_path, &scratch)) {
+      lua_rawset(L, -3); // resolved[key] = filepath
+      found = true;
+      break;
     }
+    lua_pop(L, 1);
+    p = (*template_end == ';') ? template_end + 1 : template_end;
+  }
+  if (scratch) {
+    OV_ARRAY_DESTROY(&scratch);
+  }
+  if (found) {
+    lua_pop(L, 1);
+    return true;
+  }
+  lua_pop(L, 2);
 
-    // Add to "tried" list
+  // Push the "tried" message for error reporting
+  luaL_Buffer tried;
+  luaL_buffinit(L, &tried);
+  for (char const *p = path_pattern; *p;) {
+    char const *const template_end = find_template_end(p);
     luaL_addstring(&tried, "\n\tno file '");
-    luaL_addstring(&tried, filepath);
+    push_template_path(L, p, template_end, modname);
+    luaL_addvalue(&tried);
     luaL_addchar(&tried, '\'');
-
-    lua_pop(L, 1); // Pop filepath string
-
-    // Move to next template
     p = (*template_end == ';') ? template_end + 1 : template_end;
   }
-
-  // Push the "tried" message for error reporting
   luaL_pushresult(&tried);
   return false;
 }
 
+void gcmz_lua_clear_module_search_cache(struct lua_State *const L) {
+  if (!L) {
+    return;
+  }
+  lua_pushnil(L);
+  lua_setfield(L, LUA_REGISTRYINDEX, module_search_cache_key);
+}
+
 /**
  * @brief package.loaders[2] - Lua file searcher with UTF-8 support
  *
@@ -847,63 +1335,281 @@ enum io_file_type {
 };
 
 /**
- * @brief File handle structure stored as userdata
+ * @brief Buffering mode selected by file:setvbuf
+ */
+enum io_file_buffer_mode {
+  io_file_buffer_mode_no,
+  io_file_buffer_mode_full,
+  io_file_buffer_mode_line,
+};
+
+/**
+ * @brief What the buffer currently holds
+ */
+enum io_file_buffer_state {
+  io_file_buffer_state_empty,
+  io_file_buffer_state_read,  ///< Read-ahead data, buffer_pos..buffer_len is not consumed yet
+  io_file_buffer_state_write, ///< Pending output, 0..buffer_len is not written yet
+};
+
+/**
+ * @brief Default buffer size, also used when file:setvbuf is given a non-positive size
+ */
+static size_t const io_file_default_buffer_size = 4096;
+
+/**
+ * @brief File handle structure stored as userdata
+ *
+ * This structure is used for both io.open and io.popen file handles.
+ * Reads and writes go through a user-space buffer so that line reads and small writes
+ * do not turn into one ReadFile/WriteFile call per character or fragment.
+ */
+struct io_file {
+  enum io_file_type type;
+  HANDLE handle;
+  bool is_closed;
+  bool is_read;
+  bool is_write;
+  bool is_binary;
+  enum io_file_buffer_mode buffer_mode;
+  enum io_file_buffer_state buffer_state;
+  char *buffer; ///< Allocated on first use, buffer_size bytes
+  size_t buffer_size;
+  size_t buffer_pos;
+  size_t buffer_len;
+  union {
+    struct {
+      HANDLE process_handle;
+    } popen;
+  } u;
+};
+
+/**
+ * @brief Check if file handle is open and valid
+ */
+static inline bool io_file_is_open(struct io_file const *f) {
+  return f && !f->is_closed && f->handle != INVALID_HANDLE_VALUE;
+}
+
+/**
+ * @brief Get file handle from userdata, push nil + error message if invalid
+ * @return File handle if valid and open, NULL otherwise (nil + error pushed)
+ */
+static struct io_file *get_file_handle_soft(struct lua_State *L, int index) {
+  struct io_file *f = (struct io_file *)luaL_checkudata(L, index, io_file_handle_key);
+  if (!io_file_is_open(f)) {
+    lua_pushnil(L);
+    lua_pushstring(L, "attempt to use a closed file");
+    return NULL;
+  }
+  return f;
+}
+
+/**
+ * @brief Check if file handle is valid and open, throw error if not
+ */
+static struct io_file *check_file_handle(struct lua_State *L, int index, char const *func_name) {
+  struct io_file *f = (struct io_file *)luaL_checkudata(L, index, io_file_handle_key);
+  if (!io_file_is_open(f)) {
+    luaL_error(L, "attempt to use a closed file in %s", func_name);
+    return NULL;
+  }
+  return f;
+}
+
+/**
+ * @brief Get file handle from userdata without validity check
+ */
+static struct io_file *get_file_handle(struct lua_State *L, int index) {
+  return (struct io_file *)luaL_testudata(L, index, io_file_handle_key);
+}
+
+/**
+ * @brief Write data straight to the file handle
+ *
+ * @param f File handle
+ * @param data Data to write
+ * @param len Length of data
+ * @return true on success, false on failure
+ */
+static bool write_data(struct io_file *f, void const *data, size_t len) {
+  DWORD bytes_written;
+  return WriteFile(f->handle, data, (DWORD)len, &bytes_written, NULL) && bytes_written == (DWORD)len;
+}
+
+/**
+ * @brief Allocate the buffer on first use
+ */
+static bool io_file_ensure_buffer(struct io_file *f) {
+  if (f->buffer) {
+    return true;
+  }
+  if (!OV_ARRAY_GROW(&f->buffer, f->buffer_size)) {
+    SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Write out pending output and give back unconsumed read-ahead data
+ *
+ * Read-ahead data of a regular file is given back by moving the file pointer so that the handle position
+ * matches what the script has consumed. Data read ahead from a pipe cannot be given back and is kept.
+ *
+ * @param f File handle
+ * @return true on success, false on failure (GetLastError() has the reason)
+ */
+static bool io_file_sync(struct io_file *f) {
+  bool ok = true;
+  if (f->buffer_state == io_file_buffer_state_write) {
+    ok = f->buffer_len == 0 || write_data(f, f->buffer, f->buffer_len);
+  } else if (f->buffer_state == io_file_buffer_state_read) {
+    if (f->type == io_file_type_popen) {
+      return true;
+    }
+    size_t const unread = f->buffer_len - f->buffer_pos;
+    if (unread > 0) {
+      ok = SetFilePointerEx(f->handle, (LARGE_INTEGER){.QuadPart = -(LONGLONG)unread}, NULL, FILE_CURRENT);
+    }
+  }
+  f->buffer_state = io_file_buffer_state_empty;
+  f->buffer_pos = 0;
+  f->buffer_len = 0;
+  return ok;
+}
+
+/**
+ * @brief Read straight from the file handle
  *
- * This structure is used for both io.open and io.popen file handles.
- * Flags are packed into a single byte using bit fields.
+ * A closed pipe is reported as end of file.
+ *
+ * @param f File handle
+ * @param dest Destination buffer
+ * @param len Maximum number of bytes to read
+ * @param bytes_read [out] Number of bytes read, 0 on end of file
+ * @return true on success, false on failure (GetLastError() has the reason)
  */
-struct io_file {
-  enum io_file_type type;
-  HANDLE handle;
-  bool is_closed;
-  bool is_read;
-  bool is_write;
-  bool is_binary;
-  union {
-    struct {
-      HANDLE process_handle;
-    } popen;
-  } u;
-};
+static bool read_data(struct io_file *f, void *dest, size_t len, size_t *bytes_read) {
+  DWORD n = 0;
+  if (!ReadFile(f->handle, dest, len > MAXDWORD ? MAXDWORD : (DWORD)len, &n, NULL)) {
+    if (GetLastError() != ERROR_BROKEN_PIPE) {
+      return false;
+    }
+    n = 0;
+  }
+  *bytes_read = n;
+  return true;
+}
 
 /**
- * @brief Check if file handle is open and valid
+ * @brief Make sure there is unconsumed read-ahead data in the buffer
+ *
+ * @param f File handle
+ * @param error [out] Optional, receives 0 on end of file or the error code on failure
+ * @return true if at least one byte is available, false on end of file or failure
  */
-static inline bool io_file_is_open(struct io_file const *f) {
-  return f && !f->is_closed && f->handle != INVALID_HANDLE_VALUE;
+static bool io_file_fill(struct io_file *f, DWORD *error) {
+  if (f->buffer_state == io_file_buffer_state_read && f->buffer_pos < f->buffer_len) {
+    return true;
+  }
+  size_t bytes_read = 0;
+  if (!io_file_sync(f) || !io_file_ensure_buffer(f) || !read_data(f, f->buffer, f->buffer_size, &bytes_read)) {
+    if (error) {
+      *error = GetLastError();
+    }
+    return false;
+  }
+  if (bytes_read == 0) {
+    if (error) {
+      *error = 0;
+    }
+    return false;
+  }
+  f->buffer_state = io_file_buffer_state_read;
+  f->buffer_pos = 0;
+  f->buffer_len = bytes_read;
+  return true;
 }
 
 /**
- * @brief Get file handle from userdata, push nil + error message if invalid
- * @return File handle if valid and open, NULL otherwise (nil + error pushed)
+ * @brief Look at the next byte without consuming it
+ *
+ * @return true if a byte is available, false on end of file or failure
  */
-static struct io_file *get_file_handle_soft(struct lua_State *L, int index) {
-  struct io_file *f = (struct io_file *)luaL_checkudata(L, index, io_file_handle_key);
-  if (!io_file_is_open(f)) {
-    lua_pushnil(L);
-    lua_pushstring(L, "attempt to use a closed file");
-    return NULL;
+static inline bool io_file_peek(struct io_file *f, char *ch) {
+  if (!io_file_fill(f, NULL)) {
+    return false;
   }
-  return f;
+  *ch = f->buffer[f->buffer_pos];
+  return true;
 }
 
 /**
- * @brief Check if file handle is valid and open, throw error if not
+ * @brief Write data through the buffer
+ *
+ * Data that does not fit the buffer is written directly after the pending output.
+ *
+ * @param f File handle
+ * @param data Data to write
+ * @param len Length of data
+ * @return true on success, false on failure (GetLastError() has the reason)
  */
-static struct io_file *check_file_handle(struct lua_State *L, int index, char const *func_name) {
-  struct io_file *f = (struct io_file *)luaL_checkudata(L, index, io_file_handle_key);
-  if (!io_file_is_open(f)) {
-    luaL_error(L, "attempt to use a closed file in %s", func_name);
-    return NULL;
+static bool io_file_buffered_write(struct io_file *f, void const *data, size_t len) {
+  if (f->buffer_state == io_file_buffer_state_read && !io_file_sync(f)) {
+    return false;
   }
-  return f;
+  if (f->buffer_mode == io_file_buffer_mode_no) {
+    return write_data(f, data, len);
+  }
+  if (f->buffer_state == io_file_buffer_state_write && len > f->buffer_size - f->buffer_len && !io_file_sync(f)) {
+    return false;
+  }
+  if (len >= f->buffer_size || !io_file_ensure_buffer(f)) {
+    return write_data(f, data, len);
+  }
+  memcpy(f->buffer + f->buffer_len, data, len);
+  f->buffer_len += len;
+  f->buffer_state = io_file_buffer_state_write;
+  return true;
 }
 
 /**
- * @brief Get file handle from userdata without validity check
+ * @brief Write out pending output, close the handles and free the buffer
+ *
+ * @param f File handle, must be open
+ * @param terminate_process Terminate a popen child process instead of waiting for it to exit
+ * @param error [out] Optional, receives the error code on failure
+ * @return true on success, false if pending output could not be written or the file could not be closed
  */
-static struct io_file *get_file_handle(struct lua_State *L, int index) {
-  return (struct io_file *)luaL_testudata(L, index, io_file_handle_key);
+static bool io_file_release(struct io_file *f, bool terminate_process, DWORD *error) {
+  bool ok = io_file_sync(f);
+  DWORD last_error = ok ? 0 : GetLastError();
+
+  if (!CloseHandle(f->handle) && ok && f->type == io_file_type_normal) {
+    ok = false;
+    last_error = GetLastError();
+  }
+  f->handle = INVALID_HANDLE_VALUE;
+
+  if (f->type == io_file_type_popen && f->u.popen.process_handle != INVALID_HANDLE_VALUE) {
+    if (terminate_process) {
+      TerminateProcess(f->u.popen.process_handle, 1);
+    } else {
+      WaitForSingleObject(f->u.popen.process_handle, INFINITE);
+    }
+    CloseHandle(f->u.popen.process_handle);
+    f->u.popen.process_handle = INVALID_HANDLE_VALUE;
+  }
+
+  if (f->buffer) {
+    OV_ARRAY_DESTROY(&f->buffer);
+  }
+  f->is_closed = true;
+  if (error) {
+    *error = last_error;
+  }
+  return ok;
 }
 
 /**
@@ -923,23 +1629,13 @@ static int io_file_close(struct lua_State *L) {
     return 2;
   }
 
-  if (f->type == io_file_type_normal) {
-    if (!CloseHandle(f->handle)) {
-      lua_pushnil(L);
-      lua_pushfstring(L, "close failed (error %d)", (int)GetLastError());
-      return 2;
-    }
-  } else {
-    CloseHandle(f->handle);
-    if (f->u.popen.process_handle != INVALID_HANDLE_VALUE) {
-      WaitForSingleObject(f->u.popen.process_handle, INFINITE);
-      CloseHandle(f->u.popen.process_handle);
-      f->u.popen.process_handle = INVALID_HANDLE_VALUE;
-    }
+  DWORD error = 0;
+  if (!io_file_release(f, false, &error)) {
+    lua_pushnil(L);
+    lua_pushfstring(L, "close failed (error %d)", (int)error);
+    return 2;
   }
 
-  f->handle = INVALID_HANDLE_VALUE;
-  f->is_closed = true;
   lua_pushboolean(L, 1);
   return 1;
 }
@@ -954,16 +1650,7 @@ static int io_file_gc(struct lua_State *L) {
     return 0;
   }
 
-  CloseHandle(f->handle);
-  f->handle = INVALID_HANDLE_VALUE;
-
-  if (f->type == io_file_type_popen && f->u.popen.process_handle != INVALID_HANDLE_VALUE) {
-    TerminateProcess(f->u.popen.process_handle, 1);
-    CloseHandle(f->u.popen.process_handle);
-    f->u.popen.process_handle = INVALID_HANDLE_VALUE;
-  }
-
-  f->is_closed = true;
+  io_file_release(f, true, NULL);
   return 0;
 }
 
@@ -999,6 +1686,12 @@ static int io_file_flush(struct lua_State *L) {
     return 2;
   }
 
+  if (f->buffer_state == io_file_buffer_state_write && !io_file_sync(f)) {
+    lua_pushnil(L);
+    lua_pushfstring(L, "flush failed (error %d)", (int)GetLastError());
+    return 2;
+  }
+
   if (f->type == io_file_type_normal) {
     if (!FlushFileBuffers(f->handle)) {
       lua_pushnil(L);
@@ -1016,6 +1709,9 @@ static int io_file_flush(struct lua_State *L) {
 /**
  * @brief Read a line from file
  *
+ * Accepts LF, CRLF and lone CR line endings. After a CR, a pipe only looks at data that is already buffered
+ * so that reading a line never waits for the child process to write the next one.
+ *
  * @param f File handle
  * @param B Lua buffer for output
  * @param keep_newline Whether to keep the newline character
@@ -1023,49 +1719,101 @@ static int io_file_flush(struct lua_State *L) {
  */
 static bool read_line(struct io_file *f, luaL_Buffer *B, bool keep_newline) {
   bool has_data = false;
-  char ch;
-  DWORD bytes_read;
 
-  while (ReadFile(f->handle, &ch, 1, &bytes_read, NULL) && bytes_read > 0) {
+  while (io_file_fill(f, NULL)) {
     has_data = true;
-    if (ch == '\n') {
-      if (keep_newline) {
-        luaL_addchar(B, '\n');
-      }
-      break;
+    char const *const start = f->buffer + f->buffer_pos;
+    size_t const avail = f->buffer_len - f->buffer_pos;
+    size_t n = 0;
+    while (n < avail && start[n] != '\n' && start[n] != '\r') {
+      ++n;
+    }
+    luaL_addlstring(B, start, n);
+    f->buffer_pos += n;
+    if (n == avail) {
+      continue;
     }
+
+    char const ch = f->buffer[f->buffer_pos++];
     if (ch == '\r') {
-      if (f->type == io_file_type_popen) {
-        break;
-      }
+      bool const can_peek = f->type == io_file_type_normal || f->buffer_pos < f->buffer_len;
       char next_ch;
-      DWORD next_read;
-      if (ReadFile(f->handle, &next_ch, 1, &next_read, NULL) && next_read > 0) {
-        if (next_ch != '\n') {
-          SetFilePointer(f->handle, -1, NULL, FILE_CURRENT);
-        } else if (keep_newline) {
-          luaL_addchar(B, '\n');
-        }
+      if (!can_peek || !io_file_peek(f, &next_ch) || next_ch != '\n') {
+        break;
       }
-      break;
+      f->buffer_pos++;
     }
-    luaL_addchar(B, ch);
+    if (keep_newline) {
+      luaL_addchar(B, '\n');
+    }
+    break;
   }
 
   return has_data;
 }
 
+/**
+ * @brief Number of bytes left to read from a regular file, including buffered read-ahead
+ *
+ * @return true if the size is known, false for pipes and devices or when pending output could not be written
+ */
+static bool io_file_remaining_size(struct io_file *f, size_t *remaining) {
+  if (f->type != io_file_type_normal || (f->buffer_state == io_file_buffer_state_write && !io_file_sync(f))) {
+    return false;
+  }
+  LARGE_INTEGER size, pos;
+  if (!GetFileSizeEx(f->handle, &size) || !SetFilePointerEx(f->handle, (LARGE_INTEGER){0}, &pos, FILE_CURRENT)) {
+    return false;
+  }
+  size_t const buffered = f->buffer_state == io_file_buffer_state_read ? f->buffer_len - f->buffer_pos : 0;
+  uint64_t const left = size.QuadPart > pos.QuadPart ? (uint64_t)(size.QuadPart - pos.QuadPart) : 0;
+  if (left > SIZE_MAX - buffered) {
+    return false;
+  }
+  *remaining = (size_t)left + buffered;
+  return true;
+}
+
 /**
  * @brief Read entire file content
+ *
+ * The rest of a regular file is read into one right-sized allocation, normally with a single ReadFile call.
+ * Pipes, devices and data appended after the size was taken are collected through the buffer.
  */
 static int read_all(struct lua_State *L, struct io_file *f) {
   luaL_Buffer B;
-  luaL_buffinit(L, &B);
+  size_t remaining = 0;
+  char *data = NULL;
+
+  if (io_file_remaining_size(f, &remaining) && remaining > 0 && OV_ARRAY_GROW(&data, remaining)) {
+    size_t total = 0;
+    if (f->buffer_state == io_file_buffer_state_read) {
+      total = f->buffer_len - f->buffer_pos;
+      memcpy(data, f->buffer + f->buffer_pos, total);
+      f->buffer_pos = f->buffer_len;
+    }
+    while (total < remaining) {
+      size_t bytes_read = 0;
+      if (!read_data(f, data + total, remaining - total, &bytes_read) || bytes_read == 0) {
+        break;
+      }
+      total += bytes_read;
+    }
+    lua_pushlstring(L, data, total);
+    OV_ARRAY_DESTROY(&data);
+    if (total < remaining || !io_file_fill(f, NULL)) {
+      return 1;
+    }
+    // The file grew after the size was taken
+    luaL_buffinit(L, &B);
+    luaL_addvalue(&B);
+  } else {
+    luaL_buffinit(L, &B);
+  }
 
-  char buffer[4096];
-  DWORD bytes_read;
-  while (ReadFile(f->handle, buffer, sizeof(buffer), &bytes_read, NULL) && bytes_read > 0) {
-    luaL_addlstring(&B, buffer, bytes_read);
+  while (io_file_fill(f, NULL)) {
+    luaL_addlstring(&B, f->buffer + f->buffer_pos, f->buffer_len - f->buffer_pos);
+    f->buffer_pos = f->buffer_len;
   }
 
   luaL_pushresult(&B);
@@ -1074,16 +1822,16 @@ static int read_all(struct lua_State *L, struct io_file *f) {
 
 /**
  * @brief Read specified number of bytes
+ *
+ * Requests at least as large as the buffer bypass it once the buffered data has been used up.
  */
 static int read_bytes(struct lua_State *L, struct io_file *f, size_t n) {
   if (n == 0) {
     // Special case: check EOF
-    DWORD file_pos = SetFilePointer(f->handle, 0, NULL, FILE_CURRENT);
-    DWORD file_size = GetFileSize(f->handle, NULL);
-    if (file_pos >= file_size) {
-      lua_pushnil(L);
-    } else {
+    if (io_file_fill(f, NULL)) {
       lua_pushliteral(L, "");
+    } else {
+      lua_pushnil(L);
     }
     return 1;
   }
@@ -1095,21 +1843,45 @@ static int read_bytes(struct lua_State *L, struct io_file *f, size_t n) {
     return 2;
   }
 
-  DWORD bytes_read;
-  if (!ReadFile(f->handle, buffer, (DWORD)n, &bytes_read, NULL)) {
-    OV_ARRAY_DESTROY(&buffer);
-    lua_pushnil(L);
-    lua_pushfstring(L, "read failed (error %d)", (int)GetLastError());
-    return 2;
+  size_t total = 0;
+  DWORD error = 0;
+  while (total < n) {
+    if (f->buffer_state == io_file_buffer_state_read && f->buffer_pos < f->buffer_len) {
+      size_t const avail = f->buffer_len - f->buffer_pos;
+      size_t const len = avail < n - total ? avail : n - total;
+      memcpy(buffer + total, f->buffer + f->buffer_pos, len);
+      f->buffer_pos += len;
+      total += len;
+      continue;
+    }
+    if (n - total < f->buffer_size) {
+      if (!io_file_fill(f, &error)) {
+        break;
+      }
+      continue;
+    }
+    size_t bytes_read = 0;
+    if (!io_file_sync(f) || !read_data(f, buffer + total, n - total, &bytes_read)) {
+      error = GetLastError();
+      break;
+    }
+    if (bytes_read == 0) {
+      break;
+    }
+    total += bytes_read;
   }
 
-  if (bytes_read == 0) {
+  if (total == 0) {
     OV_ARRAY_DESTROY(&buffer);
     lua_pushnil(L);
+    if (error) {
+      lua_pushfstring(L, "read failed (error %d)", (int)error);
+      return 2;
+    }
     return 1;
   }
 
-  lua_pushlstring(L, buffer, bytes_read);
+  lua_pushlstring(L, buffer, total);
   OV_ARRAY_DESTROY(&buffer);
   return 1;
 }
@@ -1122,45 +1894,30 @@ static int read_number(struct lua_State *L, struct io_file *f) {
   luaL_buffinit(L, &B);
 
   char ch;
-  DWORD bytes_read;
   bool has_digits = false;
-  bool in_number = false;
 
   // Skip leading whitespace
-  while (ReadFile(f->handle, &ch, 1, &bytes_read, NULL) && bytes_read > 0) {
-    if (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r') {
-      continue;
-    }
-    if ((ch >= '0' && ch <= '9') || ch == '-' || ch == '+' || ch == '.') {
-      luaL_addchar(&B, ch);
-      in_number = true;
-      if (ch >= '0' && ch <= '9') {
-        has_digits = true;
-      }
-      break;
-    }
-    // Non-number character
-    SetFilePointer(f->handle, -1, NULL, FILE_CURRENT);
-    lua_pushnil(L);
-    return 1;
+  while (io_file_peek(f, &ch) && (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r')) {
+    f->buffer_pos++;
   }
 
-  if (!in_number) {
+  // Non-number character is left unread
+  if (!io_file_peek(f, &ch) || !((ch >= '0' && ch <= '9') || ch == '-' || ch == '+' || ch == '.')) {
     lua_pushnil(L);
     return 1;
   }
+  luaL_addchar(&B, ch);
+  has_digits = ch >= '0' && ch <= '9';
+  f->buffer_pos++;
 
   // Read rest of number
-  while (ReadFile(f->handle, &ch, 1, &bytes_read, NULL) && bytes_read > 0) {
-    if ((ch >= '0' && ch <= '9') || ch == '.' || ch == 'e' || ch == 'E' || ch == '-' || ch == '+') {
-      luaL_addchar(&B, ch);
-      if (ch >= '0' && ch <= '9') {
-        has_digits = true;
-      }
-    } else {
-      SetFilePointer(f->handle, -1, NULL, FILE_CURRENT);
-      break;
+  while (io_file_peek(f, &ch) &&
+         ((ch >= '0' && ch <= '9') || ch == '.' || ch == 'e' || ch == 'E' || ch == '-' || ch == '+')) {
+    luaL_addchar(&B, ch);
+    if (ch >= '0' && ch <= '9') {
+      has_digits = true;
     }
+    f->buffer_pos++;
   }
 
   luaL_pushresult(&B);
@@ -1267,19 +2024,6 @@ static int io_file_read(struct lua_State *L) {
   return nresults;
 }
 
-/**
- * @brief Write data to file handle
- *
- * @param f File handle
- * @param data Data to write
- * @param len Length of data
- * @return true on success, false on failure
- */
-static bool write_data(struct io_file *f, void const *data, size_t len) {
-  DWORD bytes_written;
-  return WriteFile(f->handle, data, (DWORD)len, &bytes_written, NULL) && bytes_written == (DWORD)len;
-}
-
 /**
  * @brief file:write(...) method
  */
@@ -1296,6 +2040,7 @@ static int io_file_write(struct lua_State *L) {
 
   DWORD last_error = 0;
   int result = -1;
+  bool has_newline = false;
 
   int const nargs = lua_gettop(L);
   for (int i = 2; i <= nargs; i++) {
@@ -1307,9 +2052,12 @@ static int io_file_write(struct lua_State *L) {
       str = luaL_checklstring(L, i, &len);
     }
 
-    // Binary mode, popen, or no newline: direct write
-    if (f->is_binary || f->type == io_file_type_popen || !memchr(str, '\n', len)) {
-      if (!write_data(f, str, len)) {
+    char const *next_nl = (char const *)memchr(str, '\n', len);
+    has_newline = has_newline || next_nl != NULL;
+
+    // Binary mode, popen, or no newline: written as is
+    if (f->is_binary || f->type == io_file_type_popen || !next_nl) {
+      if (!io_file_buffered_write(f, str, len)) {
         last_error = GetLastError();
         goto cleanup;
       }
@@ -1320,21 +2068,21 @@ static int io_file_write(struct lua_State *L) {
     char const *p = str;
     char const *end = str + len;
     while (p < end) {
-      char const *next_nl = (char const *)memchr(p, '\n', (size_t)(end - p));
+      next_nl = (char const *)memchr(p, '\n', (size_t)(end - p));
       if (!next_nl) {
         size_t remaining_len = (size_t)(end - p);
-        if (remaining_len > 0 && !write_data(f, p, remaining_len)) {
+        if (remaining_len > 0 && !io_file_buffered_write(f, p, remaining_len)) {
           last_error = GetLastError();
           goto cleanup;
         }
         break;
       }
       ptrdiff_t chunk_len = next_nl - p;
-      if (chunk_len > 0 && !write_data(f, p, (size_t)chunk_len)) {
+      if (chunk_len > 0 && !io_file_buffered_write(f, p, (size_t)chunk_len)) {
         last_error = GetLastError();
         goto cleanup;
       }
-      if (!write_data(f, "\r\n", 2)) {
+      if (!io_file_buffered_write(f, "\r\n", 2)) {
         last_error = GetLastError();
         goto cleanup;
       }
@@ -1342,6 +2090,11 @@ static int io_file_write(struct lua_State *L) {
     }
   }
 
+  if (f->buffer_mode == io_file_buffer_mode_line && has_newline && !io_file_sync(f)) {
+    last_error = GetLastError();
+    goto cleanup;
+  }
+
   lua_pushvalue(L, 1); // Return the file handle for chaining
 
   result = 1;
@@ -1370,6 +2123,13 @@ static int io_file_seek(struct lua_State *L) {
   int op = luaL_checkoption(L, 2, "cur", mode_names);
   lua_Integer offset = luaL_optinteger(L, 3, 0);
 
+  // Buffered data moves the handle position away from the position the script sees
+  if (!io_file_sync(f)) {
+    lua_pushnil(L);
+    lua_pushfstring(L, "seek failed (error %d)", (int)GetLastError());
+    return 2;
+  }
+
   LARGE_INTEGER li;
   li.QuadPart = offset;
   LARGE_INTEGER new_pos;
@@ -1387,17 +2147,43 @@ static int io_file_seek(struct lua_State *L) {
 /**
  * @brief file:setvbuf(mode [, size]) method
  *
- * This is a stub implementation since we use Win32 file handles directly.
+ * "no" writes every file:write call through immediately, "full" writes when the buffer fills up,
+ * and "line" also writes after each file:write call that contains a newline.
+ * Reads are always buffered.
  */
 static int io_file_setvbuf(struct lua_State *L) {
-  (void)check_file_handle(L, 1, "setvbuf");
-  // Always returns success - buffering is handled by Windows
+  struct io_file *f = check_file_handle(L, 1, "setvbuf");
+  if (!f) {
+    return 2;
+  }
+
+  static char const *const mode_names[] = {"no", "full", "line", NULL};
+  static enum io_file_buffer_mode const modes[] = {
+      io_file_buffer_mode_no, io_file_buffer_mode_full, io_file_buffer_mode_line};
+
+  int const op = luaL_checkoption(L, 2, NULL, mode_names);
+  lua_Integer const size = luaL_optinteger(L, 3, (lua_Integer)io_file_default_buffer_size);
+
+  if (!io_file_sync(f)) {
+    lua_pushnil(L);
+    lua_pushfstring(L, "setvbuf failed (error %d)", (int)GetLastError());
+    return 2;
+  }
+
+  size_t const new_size = size > 0 ? (size_t)size : io_file_default_buffer_size;
+  if (new_size != f->buffer_size && f->buffer) {
+    OV_ARRAY_DESTROY(&f->buffer);
+  }
+  f->buffer_size = new_size;
+  f->buffer_mode = modes[op];
   lua_pushboolean(L, 1);
   return 1;
 }
 
 /**
  * @brief file:lines() iterator function
+ *
+ * The second upvalue is true when the iterator owns the file and closes it at the end.
  */
 static int io_file_lines_iterator(struct lua_State *L) {
   struct io_file *f = (struct io_file *)lua_touserdata(L, lua_upvalueindex(1));
@@ -1412,6 +2198,9 @@ static int io_file_lines_iterator(struct lua_State *L) {
     return 1;
   }
 
+  if (lua_toboolean(L, lua_upvalueindex(2))) {
+    io_file_release(f, false, NULL);
+  }
   return 0;
 }
 
@@ -1421,7 +2210,8 @@ static int io_file_lines_iterator(struct lua_State *L) {
 static int io_file_lines(struct lua_State *L) {
   check_file_handle(L, 1, "lines");
   lua_pushvalue(L, 1);
-  lua_pushcclosure(L, io_file_lines_iterator, 1);
+  lua_pushboolean(L, 0);
+  lua_pushcclosure(L, io_file_lines_iterator, 2);
   return 1;
 }
 
@@ -1430,12 +2220,15 @@ static int io_file_lines(struct lua_State *L) {
  */
 static struct io_file *create_file_handle(struct lua_State *L, HANDLE h, bool is_read, bool is_write, bool is_binary) {
   struct io_file *f = (struct io_file *)lua_newuserdata(L, sizeof(struct io_file));
-  f->type = io_file_type_normal;
-  f->handle = h;
-  f->is_closed = false;
-  f->is_read = is_read;
-  f->is_write = is_write;
-  f->is_binary = is_binary;
+  *f = (struct io_file){
+      .type = io_file_type_normal,
+      .handle = h,
+      .is_read = is_read,
+      .is_write = is_write,
+      .is_binary = is_binary,
+      .buffer_mode = io_file_buffer_mode_full,
+      .buffer_size = io_file_default_buffer_size,
+  };
 
   luaL_getmetatable(L, io_file_handle_key);
   lua_setmetatable(L, -2);
@@ -1729,60 +2522,6 @@ static int io_write_utf8(struct lua_State *L) {
   return io_file_write(L);
 }
 
-/**
- * @brief io.lines iterator state for file path version
- */
-struct io_lines_state {
-  HANDLE handle;
-  bool should_close;
-};
-
-/**
- * @brief __gc for io.lines state
- */
-static int io_lines_state_gc(struct lua_State *L) {
-  struct io_lines_state *state = (struct io_lines_state *)lua_touserdata(L, 1);
-  if (state && state->should_close && state->handle != INVALID_HANDLE_VALUE) {
-    CloseHandle(state->handle);
-    state->handle = INVALID_HANDLE_VALUE;
-  }
-  return 0;
-}
-
-/**
- * @brief Iterator function for io.lines(filename)
- */
-static int io_lines_file_iterator(struct lua_State *L) {
-  struct io_lines_state *state = (struct io_lines_state *)lua_touserdata(L, lua_upvalueindex(1));
-  if (!state || state->handle == INVALID_HANDLE_VALUE) {
-    return 0;
-  }
-
-  luaL_Buffer B;
-  luaL_buffinit(L, &B);
-
-  // Create temporary file struct for read_line
-  struct io_file f = {
-      .handle = state->handle,
-      .is_closed = false,
-      .is_read = true,
-      .is_write = false,
-  };
-
-  if (read_line(&f, &B, false)) {
-    luaL_pushresult(&B);
-    return 1;
-  }
-
-  // EOF - close file if we own it
-  if (state->should_close) {
-    CloseHandle(state->handle);
-    state->handle = INVALID_HANDLE_VALUE;
-  }
-
-  return 0;
-}
-
 /**
  * @brief io.lines([filename]) - UTF-8 aware version
  */
@@ -1816,19 +2555,10 @@ static int io_lines_utf8(struct lua_State *L) {
     return luaL_error(L, "%s: Cannot open file (error %d)", filename, (int)error_code);
   }
 
-  // Create state userdata
-  struct io_lines_state *state = (struct io_lines_state *)lua_newuserdata(L, sizeof(struct io_lines_state));
-  state->handle = h;
-  state->should_close = true;
-
-  // Set metatable with __gc
-  if (luaL_newmetatable(L, "gcmz_io_lines_state")) {
-    lua_pushcfunction(L, io_lines_state_gc);
-    lua_setfield(L, -2, "__gc");
-  }
-  lua_setmetatable(L, -2);
-
-  lua_pushcclosure(L, io_lines_file_iterator, 1);
+  // The iterator owns the file and closes it at the end, __gc closes it if the loop is abandoned
+  create_file_handle(L, h, true, false, false);
+  lua_pushboolean(L, 1);
+  lua_pushcclosure(L, io_file_lines_iterator, 2);
   return 1;
 }
 
@@ -1978,14 +2708,18 @@ static int io_popen_utf8(struct lua_State *L) {
     CloseHandle(pi.hThread);
 
     // Create popen file userdata
+    // Output is not held back by default so the child sees each write as before
     struct io_file *f = (struct io_file *)lua_newuserdata(L, sizeof(struct io_file));
-    f->type = io_file_type_popen;
-    f->handle = our_pipe;
-    f->is_closed = false;
-    f->is_read = is_read;
-    f->is_write = !is_read;
-    f->is_binary = false;
-    f->u.popen.process_handle = pi.hProcess;
+    *f = (struct io_file){
+        .type = io_file_type_popen,
+        .handle = our_pipe,
+        .is_read = is_read,
+        .is_write = !is_read,
+        .is_binary = false,
+        .buffer_mode = io_file_buffer_mode_no,
+        .buffer_size = io_file_default_buffer_size,
+        .u.popen.process_handle = pi.hProcess,
+    };
 
     luaL_getmetatable(L, io_file_handle_key);
     lua_setmetatable(L, -2);
@@ -2600,7 +3334,7 @@ static void setup_io_utf8_funcs(struct lua_State *L) {
   if (h_stdout != INVALID_HANDLE_VALUE && h_stdout != NULL) {
     HANDLE h_dup = INVALID_HANDLE_VALUE;
     if (DuplicateHandle(GetCurrentProcess(), h_stdout, GetCurrentProcess(), &h_dup, 0, FALSE, DUPLICATE_SAME_ACCESS)) {
-      create_file_handle(L, h_dup, false, true, true);
+      create_file_handle(L, h_dup, false, true, true)->buffer_mode = io_file_buffer_mode_line;
       lua_setfield(L, -2, "stdout");
       // Also set as default output
       lua_getfield(L, -1, "stdout");
@@ -2612,7 +3346,7 @@ static void setup_io_utf8_funcs(struct lua_State *L) {
   if (h_stderr != INVALID_HANDLE_VALUE && h_stderr != NULL) {
     HANDLE h_dup = INVALID_HANDLE_VALUE;
     if (DuplicateHandle(GetCurrentProcess(), h_stderr, GetCurrentProcess(), &h_dup, 0, FALSE, DUPLICATE_SAME_ACCESS)) {
-      create_file_handle(L, h_dup, false, true, true);
+      create_file_handle(L, h_dup, false, true, true)->buffer_mode = io_file_buffer_mode_no;
       lua_setfield(L, -2, "stderr");
     }
   }
@@ -113,3 +113,44 @@ NODISCARD bool gcmz_wchar_to_utf8(wchar_t const *src, char **dest, struct ov_err
  * @param L Lua state
  */
 void gcmz_lua_setup_utf8_funcs(struct lua_State *const L);
+
+/**
+ * @brief Forget the module search results and directory contents cached by require
+ *
+ * require lists each directory in package.path and package.cpath once and remembers where
+ * each module was found, so files added or removed afterwards are not noticed until this is called.
+ *
+ * @param L Lua state (gcmz_lua_setup_utf8_funcs must have been called)
+ */
+void gcmz_lua_clear_module_search_cache(struct lua_State *const L);
+
+/**
+ * @brief Build the bytecode cache directory path under a base directory
+ *
+ * The result is base_dir followed by "\gcmzdrops\luacache". The directory is not created.
+ *
+ * @param base_dir Base directory, usually the local application data folder
+ * @param dest [out] Built path, reused if it already has a buffer
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+NODISCARD bool gcmz_lua_build_bytecode_cache_dir(wchar_t const *const base_dir,
+                                                 wchar_t **const dest,
+                                                 struct ov_error *const err);
+
+/**
+ * @brief Enable or disable the bytecode cache for Lua source files
+ *
+ * When enabled, chunks loaded by loadfile, dofile and require are compiled once and the
+ * bytecode is stored in cache_dir. An entry is used only when the source path, size,
+ * last write time and LuaJIT version/architecture all match; otherwise the source is loaded
+ * and the entry is rewritten. Cache I/O failures silently fall back to the source.
+ *
+ * @param L Lua state (gcmz_lua_setup_utf8_funcs must have been called)
+ * @param cache_dir Existing directory to store cache entries, or NULL to disable the cache
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+NODISCARD bool gcmz_lua_set_bytecode_cache_dir(struct lua_State *const L,
+                                               wchar_t const *const cache_dir,
+                                               struct ov_error *const err);
@@ -2241,6 +2241,149 @@ cleanup:
   }
 }
 
+static void test_io_buffering(void) {
+  lua_State *L = NULL;
+  wchar_t *exe_dir = NULL;
+  wchar_t *test_file_path = NULL;
+  char *test_file_path_utf8 = NULL;
+  struct ov_error err = {0};
+
+  {
+    if (!get_exe_directory(&exe_dir, &err)) {
+      OV_ERROR_REPORT(&err, NULL);
+      return;
+    }
+
+    size_t const test_file_len = wcslen(exe_dir) + wcslen(L"\\test_data\\buffering_test.txt") + 1;
+    if (!OV_ARRAY_GROW(&test_file_path, test_file_len)) {
+      goto cleanup;
+    }
+    wcscpy(test_file_path, exe_dir);
+    wcscat(test_file_path, L"\\test_data\\buffering_test.txt");
+
+    size_t const path_wlen = wcslen(test_file_path);
+    size_t const path_utf8_len = ov_wchar_to_utf8_len(test_file_path, path_wlen);
+    if (!path_utf8_len || !OV_ARRAY_GROW(&test_file_path_utf8, path_utf8_len + 1)) {
+      goto cleanup;
+    }
+    if (!ov_wchar_to_utf8(test_file_path, path_wlen, test_file_path_utf8, path_utf8_len + 1, NULL)) {
+      goto cleanup;
+    }
+
+    DeleteFileW(test_file_path);
+
+    L = luaL_newstate();
+    if (!TEST_CHECK(L != NULL)) {
+      goto cleanup;
+    }
+    luaL_openlibs(L);
+    gcmz_lua_setup_utf8_funcs(L);
+
+    lua_pushstring(L, test_file_path_utf8);
+    lua_setglobal(L, "TEST_FILE");
+
+    // Lines longer than the buffer and line endings split across buffer boundaries
+    {
+      TEST_CASE("lines across buffer boundaries");
+      char const *script = "local f = io.open(TEST_FILE, 'wb') "
+                           "f:setvbuf('full', 7) "
+                           "for i = 1, 500 do "
+                           "  f:write(string.rep('x', i % 13), i % 2 == 0 and '\\r\\n' or '\\n') "
+                           "end "
+                           "f:write('last\\r') "
+                           "f:close() "
+                           "local count = 0 "
+                           "for line in io.lines(TEST_FILE) do "
+                           "  count = count + 1 "
+                           "  if count <= 500 then "
+                           "    assert(line == string.rep('x', count % 13), 'line ' .. count .. ': ' .. line) "
+                           "  else "
+                           "    assert(line == 'last', 'last line: ' .. line) "
+                           "  end "
+                           "end "
+                           "assert(count == 501, 'expected 501 lines, got ' .. count)";
+      if (!TEST_CHECK(luaL_dostring(L, script) == LUA_OK)) {
+        char const *err_msg = lua_tostring(L, -1);
+        TEST_MSG("lines across buffer boundaries script failed: %s", err_msg ? err_msg : "unknown error");
+        lua_pop(L, 1);
+      }
+    }
+
+    // Buffered output is not visible to other handles until it is flushed
+    {
+      TEST_CASE("setvbuf modes");
+      char const *script = "local f = io.open(TEST_FILE, 'wb') "
+                           "local function size() "
+                           "  local r = io.open(TEST_FILE, 'rb') "
+                           "  local n = #r:read('*a') "
+                           "  r:close() "
+                           "  return n "
+                           "end "
+                           "f:write('abc') "
+                           "assert(size() == 0, 'full buffering should hold output') "
+                           "f:flush() "
+                           "assert(size() == 3, 'flush should write output') "
+                           "assert(f:setvbuf('line')) "
+                           "f:write('de') "
+                           "assert(size() == 3, 'line buffering should hold output without newline') "
+                           "f:write('f\\n') "
+                           "assert(size() == 7, 'line buffering should write output at newline') "
+                           "assert(f:setvbuf('no')) "
+                           "f:write('g') "
+                           "assert(size() == 8, 'no buffering should write output immediately') "
+                           "f:close() "
+                           "assert(size() == 8)";
+      if (!TEST_CHECK(luaL_dostring(L, script) == LUA_OK)) {
+        char const *err_msg = lua_tostring(L, -1);
+        TEST_MSG("setvbuf modes script failed: %s", err_msg ? err_msg : "unknown error");
+        lua_pop(L, 1);
+      }
+    }
+
+    // Switching between reading, writing and seeking keeps the position the script sees
+    {
+      TEST_CASE("read write seek interleaving");
+      char const *script = "local f = io.open(TEST_FILE, 'wb') "
+                           "f:write('line1\\nline2\\nline3\\n') "
+                           "f:close() "
+                           "f = io.open(TEST_FILE, 'r+b') "
+                           "assert(f:read('*l') == 'line1') "
+                           "assert(f:seek() == 6, 'position after read') "
+                           "f:write('LINE2') "
+                           "assert(f:read('*l') == '') "
+                           "assert(f:read('*l') == 'line3') "
+                           "assert(f:read('*l') == nil) "
+                           "assert(f:seek('set', 3) == 3) "
+                           "assert(f:read(4) == 'e1\\nL') "
+                           "f:close() "
+                           "f = io.open(TEST_FILE, 'rb') "
+                           "local all = f:read('*a') "
+                           "f:close() "
+                           "assert(all == 'line1\\nLINE2\\nline3\\n', all)";
+      if (!TEST_CHECK(luaL_dostring(L, script) == LUA_OK)) {
+        char const *err_msg = lua_tostring(L, -1);
+        TEST_MSG("read write seek interleaving script failed: %s", err_msg ? err_msg : "unknown error");
+        lua_pop(L, 1);
+      }
+    }
+  }
+
+cleanup:
+  if (L) {
+    lua_close(L);
+  }
+  if (test_file_path) {
+    DeleteFileW(test_file_path);
+    OV_ARRAY_DESTROY(&test_file_path);
+  }
+  if (test_file_path_utf8) {
+    OV_ARRAY_DESTROY(&test_file_path_utf8);
+  }
+  if (exe_dir) {
+    OV_ARRAY_DESTROY(&exe_dir);
+  }
+}
+
 static void test_io_read_formats(void) {
   lua_State *L_standard = NULL;
   lua_State *L_override = NULL;
@@ -2780,6 +2923,214 @@ cleanup:
   }
 }
 
+static bool write_text_file(wchar_t const *const path, char const *const content) {
+  HANDLE h = CreateFileW(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (h == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  DWORD const len = (DWORD)strlen(content);
+  DWORD written = 0;
+  BOOL const ok = WriteFile(h, content, len, &written, NULL);
+  CloseHandle(h);
+  return ok && written == len;
+}
+
+static int run_int_script(lua_State *L, char const *const script) {
+  if (luaL_loadstring(L, script) != LUA_OK || lua_pcall(L, 0, 1, 0) != LUA_OK) {
+    TEST_MSG("script error: %s", lua_tostring(L, -1));
+    lua_pop(L, 1);
+    return -1;
+  }
+  int const value = (int)lua_tointeger(L, -1);
+  lua_pop(L, 1);
+  return value;
+}
+
+static size_t find_cache_entry(wchar_t const *const cache_dir, wchar_t *const entry_path) {
+  wchar_t pattern[MAX_PATH];
+  wcscpy(pattern, cache_dir);
+  wcscat(pattern, L"\\*.luac");
+  WIN32_FIND_DATAW fd;
+  HANDLE h = FindFirstFileW(pattern, &fd);
+  if (h == INVALID_HANDLE_VALUE) {
+    return 0;
+  }
+  size_t count = 0;
+  do {
+    wcscpy(entry_path, cache_dir);
+    wcscat(entry_path, L"\\");
+    wcscat(entry_path, fd.cFileName);
+    ++count;
+  } while (FindNextFileW(h, &fd));
+  FindClose(h);
+  return count;
+}
+
+static void test_bytecode_cache_dir(void) {
+  wchar_t *dir = NULL;
+  struct ov_error err = {0};
+
+  if (TEST_SUCCEEDED(gcmz_lua_build_bytecode_cache_dir(L"C:\\Users\\user\\AppData\\Local", &dir, &err), &err)) {
+    TEST_CHECK(wcscmp(dir, L"C:\\Users\\user\\AppData\\Local\\gcmzdrops\\luacache") == 0);
+    TEST_MSG("got %ls", dir);
+    TEST_CHECK(OV_ARRAY_LENGTH(dir) == wcslen(dir));
+  }
+
+  // A trailing separator is not doubled
+  if (TEST_SUCCEEDED(gcmz_lua_build_bytecode_cache_dir(L"D:\\Local\\", &dir, &err), &err)) {
+    TEST_CHECK(wcscmp(dir, L"D:\\Local\\gcmzdrops\\luacache") == 0);
+    TEST_MSG("got %ls", dir);
+  }
+
+  TEST_FAILED_WITH(gcmz_lua_build_bytecode_cache_dir(NULL, &dir, &err),
+                   &err,
+                   ov_error_type_generic,
+                   ov_error_generic_invalid_argument);
+
+  if (dir) {
+    OV_ARRAY_DESTROY(&dir);
+  }
+}
+
+static void test_bytecode_cache(void) {
+  wchar_t cache_dir[MAX_PATH];
+  wchar_t script_path[MAX_PATH];
+  wchar_t entry_path[MAX_PATH] = {0};
+  char script_path_utf8[MAX_PATH * 3];
+  lua_State *L = NULL;
+  struct ov_error err = {0};
+
+  GetTempPathW(MAX_PATH, cache_dir);
+  wcscpy(script_path, cache_dir);
+  wcscat(cache_dir, L"gcmz_bytecode_cache_test");
+  wcscat(script_path, L"gcmz_bytecode_cache_test.lua");
+  CreateDirectoryW(cache_dir, NULL);
+  if (!TEST_CHECK(write_text_file(script_path, "return 1"))) {
+    goto cleanup;
+  }
+  if (!TEST_CHECK(ov_snprintf_char(script_path_utf8, sizeof(script_path_utf8), NULL, "%ls", script_path))) {
+    goto cleanup;
+  }
+
+  L = luaL_newstate();
+  if (!TEST_CHECK(L != NULL)) {
+    goto cleanup;
+  }
+  luaL_openlibs(L);
+  gcmz_lua_setup_utf8_funcs(L);
+  if (!TEST_SUCCEEDED(gcmz_lua_set_bytecode_cache_dir(L, cache_dir, &err), &err)) {
+    goto cleanup;
+  }
+  lua_pushstring(L, script_path_utf8);
+  lua_setglobal(L, "TEST_LUA");
+
+  // First load compiles the source and stores the entry
+  TEST_CHECK(run_int_script(L, "return dofile(TEST_LUA)") == 1);
+  TEST_CHECK(find_cache_entry(cache_dir, entry_path) == 1);
+
+  // Second load uses the entry
+  TEST_CHECK(run_int_script(L, "return loadfile(TEST_LUA)()") == 1);
+
+  // Modified source invalidates the entry
+  if (!TEST_CHECK(write_text_file(script_path, "return 22"))) {
+    goto cleanup;
+  }
+  TEST_CHECK(run_int_script(L, "return dofile(TEST_LUA)") == 22);
+
+  // Broken entry falls back to the source
+  if (!TEST_CHECK(find_cache_entry(cache_dir, entry_path) == 1) ||
+      !TEST_CHECK(write_text_file(entry_path, "GCMZLBC1\nbroken"))) {
+    goto cleanup;
+  }
+  TEST_CHECK(run_int_script(L, "return dofile(TEST_LUA)") == 22);
+
+  // Errors still report the source path
+  if (!TEST_CHECK(write_text_file(script_path, "error('boom')"))) {
+    goto cleanup;
+  }
+  static char const check_error_source[] =
+      "local ok, msg = pcall(dofile, TEST_LUA) "
+      "return (not ok and msg:find('gcmz_bytecode_cache_test.lua', 1, true)) and 1 or 0";
+  TEST_CHECK(run_int_script(L, check_error_source) == 1);
+  TEST_CHECK(run_int_script(L, check_error_source) == 1);
+
+  // Disabled cache does not touch the directory
+  if (!TEST_SUCCEEDED(gcmz_lua_set_bytecode_cache_dir(L, NULL, &err), &err)) {
+    goto cleanup;
+  }
+  if (find_cache_entry(cache_dir, entry_path) == 1) {
+    DeleteFileW(entry_path);
+  }
+  TEST_CHECK(run_int_script(L, "return select('#', pcall(dofile, TEST_LUA))") == 2);
+  TEST_CHECK(find_cache_entry(cache_dir, entry_path) == 0);
+
+cleanup:
+  if (L) {
+    lua_close(L);
+  }
+  if (find_cache_entry(cache_dir, entry_path) == 1) {
+    DeleteFileW(entry_path);
+  }
+  DeleteFileW(script_path);
+  RemoveDirectoryW(cache_dir);
+}
+
+static void test_module_search_cache(void) {
+  wchar_t module_dir[MAX_PATH];
+  wchar_t module_a[MAX_PATH];
+  wchar_t module_b[MAX_PATH];
+  char module_dir_utf8[MAX_PATH * 3];
+  lua_State *L = NULL;
+
+  GetTempPathW(MAX_PATH, module_dir);
+  wcscat(module_dir, L"gcmz_module_search_test");
+  wcscpy(module_a, module_dir);
+  wcscat(module_a, L"\\gcmz_search_a.lua");
+  wcscpy(module_b, module_dir);
+  wcscat(module_b, L"\\gcmz_search_b.lua");
+  CreateDirectoryW(module_dir, NULL);
+  DeleteFileW(module_b);
+  if (!TEST_CHECK(write_text_file(module_a, "return 1"))) {
+    goto cleanup;
+  }
+  if (!TEST_CHECK(ov_snprintf_char(module_dir_utf8, sizeof(module_dir_utf8), NULL, "%ls", module_dir))) {
+    goto cleanup;
+  }
+
+  L = luaL_newstate();
+  if (!TEST_CHECK(L != NULL)) {
+    goto cleanup;
+  }
+  luaL_openlibs(L);
+  gcmz_lua_setup_utf8_funcs(L);
+  lua_getglobal(L, "package");
+  lua_pushfstring(L, "%s\\?.lua", module_dir_utf8);
+  lua_setfield(L, -2, "path");
+  lua_pop(L, 1);
+
+  // The first search indexes the directory, file names are matched case-insensitively
+  TEST_CHECK(run_int_script(L, "return require('gcmz_search_a')") == 1);
+  TEST_CHECK(run_int_script(L, "return require('GCMZ_SEARCH_A')") == 1);
+
+  // Files added later are not seen until the cache is cleared
+  if (!TEST_CHECK(write_text_file(module_b, "return 2"))) {
+    goto cleanup;
+  }
+  TEST_CHECK(run_int_script(L,
+                            "local ok, msg = pcall(require, 'gcmz_search_b') "
+                            "return (not ok and msg:find('gcmz_search_b.lua', 1, true)) and 1 or 0") == 1);
+  gcmz_lua_clear_module_search_cache(L);
+  TEST_CHECK(run_int_script(L, "return require('gcmz_search_b')") == 2);
+
+cleanup:
+  if (L) {
+    lua_close(L);
+  }
+  DeleteFileW(module_a);
+  DeleteFileW(module_b);
+  RemoveDirectoryW(module_dir);
+}
+
 TEST_LIST = {
     {"utf8_funcs_ascii_compatibility", test_utf8_funcs_ascii_compatibility},
     {"unicode_paths", test_unicode_paths},
@@ -2794,6 +3145,10 @@ TEST_LIST = {
     {"io_stdio_handles", test_io_stdio_handles},
     {"io_lines_variants", test_io_lines_variants},
     {"io_read_formats", test_io_read_formats},
+    {"io_buffering", test_io_buffering},
     {"error_compatibility", test_error_compatibility},
+    {"bytecode_cache_dir", test_bytecode_cache_dir},
+    {"bytecode_cache", test_bytecode_cache},
+    {"module_search_cache", test_module_search_cache},
     {NULL, NULL},
 };
@@ -0,0 +1,356 @@
+#include "object_info.h"
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include <ovarray.h>
+#include <ovthreads.h>
+
+#include <limits.h>
+#include <string.h>
+
+#include "ini_reader.h"
+
+enum { cache_capacity = 16 };
+
+struct cache_entry {
+  wchar_t *path;
+  uint64_t size;
+  uint64_t last_write;
+  uint64_t last_used;
+  struct gcmz_object_info info;
+};
+
+struct gcmz_object_info_cache {
+  mtx_t mtx;
+  struct cache_entry entries[cache_capacity];
+  uint64_t tick;
+};
+
+static bool is_object_section(char const *const name, size_t const name_len) {
+  if (name_len == 0) {
+    return false;
+  }
+  for (size_t i = 0; i < name_len; ++i) {
+    if (name[i] < '0' || name[i] > '9') {
+      return false;
+    }
+  }
+  return true;
+}
+
+static size_t parse_uint(char const *const ptr, size_t const size, int *const value) {
+  int v = 0;
+  size_t i = 0;
+  for (; i < size && ptr[i] >= '0' && ptr[i] <= '9'; ++i) {
+    v = v * 10 + (ptr[i] - '0');
+  }
+  *value = v;
+  return i;
+}
+
+static void collect_info(struct gcmz_ini_reader const *const reader, struct gcmz_object_info *const info) {
+  int layer_min = INT_MAX;
+  int layer_max = INT_MIN;
+  int frame_start = INT_MAX;
+  int frame_end = INT_MIN;
+  size_t object_count = 0;
+
+  // Object sections are named [0], [1], etc. with layer=N and frame=start,end entries
+  struct gcmz_ini_iter section_iter = {0};
+  while (gcmz_ini_reader_iter_sections(reader, &section_iter)) {
+    if (!is_object_section(section_iter.name, section_iter.name_len)) {
+      continue;
+    }
+    char section_name[32];
+    if (section_iter.name_len >= sizeof(section_name)) {
+      continue;
+    }
+    memcpy(section_name, section_iter.name, section_iter.name_len);
+    section_name[section_iter.name_len] = '\0';
+    ++object_count;
+
+    struct gcmz_ini_value const layer_value = gcmz_ini_reader_get_value(reader, section_name, "layer");
+    if (layer_value.ptr && layer_value.size > 0) {
+      int layer = 0;
+      if (parse_uint(layer_value.ptr, layer_value.size, &layer) > 0) {
+        if (layer < layer_min) {
+          layer_min = layer;
+        }
+        if (layer > layer_max) {
+          layer_max = layer;
+        }
+      }
+    }
+
+    struct gcmz_ini_value const frame_value = gcmz_ini_reader_get_value(reader, section_name, "frame");
+    if (frame_value.ptr && frame_value.size > 0) {
+      int start = 0;
+      int end = 0;
+      size_t const n = parse_uint(frame_value.ptr, frame_value.size, &start);
+      if (n > 0) {
+        end = start;
+        if (n + 1 < frame_value.size && frame_value.ptr[n] == ',') {
+          if (parse_uint(frame_value.ptr + n + 1, frame_value.size - n - 1, &end) == 0) {
+            end = start;
+          }
+        }
+        if (start < frame_start) {
+          frame_start = start;
+        }
+        if (end > frame_end) {
+          frame_end = end;
+        }
+      }
+    }
+  }
+
+  bool const found_layer = layer_min <= layer_max;
+  bool const found_frame = frame_start <= frame_end;
+  *info = (struct gcmz_object_info){
+      .layer_min = found_layer ? layer_min : 0,
+      .layer_max = found_layer ? layer_max : 0,
+      .layer_count = found_layer ? layer_max - layer_min + 1 : 1,
+      .frame_start = found_frame ? frame_start : 0,
+      .frame_end = found_frame ? frame_end : 0,
+      .object_count = object_count,
+  };
+}
+
+bool gcmz_object_info_parse_memory(void const *const ptr,
+                                   size_t const size,
+                                   struct gcmz_object_info *const info,
+                                   struct ov_error *const err) {
+  if (!ptr || !info) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  struct gcmz_ini_reader *reader = NULL;
+  bool result = false;
+
+  if (!gcmz_ini_reader_create(&reader, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+  if (!gcmz_ini_reader_load_memory(reader, ptr, size, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+  collect_info(reader, info);
+  result = true;
+
+cleanup:
+  if (reader) {
+    gcmz_ini_reader_destroy(&reader);
+  }
+  return result;
+}
+
+bool gcmz_object_info_parse_file(wchar_t const *const filepath,
+                                 struct gcmz_object_info *const info,
+                                 struct ov_error *const err) {
+  if (!filepath || !info) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  struct gcmz_ini_reader *reader = NULL;
+  bool result = false;
+
+  if (!gcmz_ini_reader_create(&reader, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+  if (!gcmz_ini_reader_load_file(reader, filepath, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+  collect_info(reader, info);
+  result = true;
+
+cleanup:
+  if (reader) {
+    gcmz_ini_reader_destroy(&reader);
+  }
+  return result;
+}
+
+/**
+ * @brief Query the identity of a file
+ *
+ * @param filepath Path to the file
+ * @param size [out] File size in bytes
+ * @param last_write [out] Last write time
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+static NODISCARD bool get_file_identity(wchar_t const *const filepath,
+                                        uint64_t *const size,
+                                        uint64_t *const last_write,
+                                        struct ov_error *const err) {
+  WIN32_FILE_ATTRIBUTE_DATA fad;
+  if (!GetFileAttributesExW(filepath, GetFileExInfoStandard, &fad)) {
+    OV_ERROR_SET_HRESULT(err, HRESULT_FROM_WIN32(GetLastError()));
+    return false;
+  }
+  *size = ((uint64_t)fad.nFileSizeHigh << 32) | (uint64_t)fad.nFileSizeLow;
+  *last_write = ((uint64_t)fad.ftLastWriteTime.dwHighDateTime << 32) | (uint64_t)fad.ftLastWriteTime.dwLowDateTime;
+  return true;
+}
+
+struct gcmz_object_info_cache *gcmz_object_info_cache_create(struct ov_error *const err) {
+  struct gcmz_object_info_cache *c = NULL;
+
+  if (!OV_REALLOC(&c, 1, sizeof(struct gcmz_object_info_cache))) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return NULL;
+  }
+  *c = (struct gcmz_object_info_cache){
+      .entries = {{0}},
+      .tick = 0,
+  };
+  if (mtx_init(&c->mtx, mtx_plain) != thrd_success) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    OV_FREE(&c);
+    return NULL;
+  }
+  return c;
+}
+
+void gcmz_object_info_cache_destroy(struct gcmz_object_info_cache **const cache) {
+  if (!cache || !*cache) {
+    return;
+  }
+  struct gcmz_object_info_cache *const c = *cache;
+  for (size_t i = 0; i < cache_capacity; ++i) {
+    if (c->entries[i].path) {
+      OV_ARRAY_DESTROY(&c->entries[i].path);
+    }
+  }
+  mtx_destroy(&c->mtx);
+  OV_FREE(cache);
+}
+
+/**
+ * @brief Find the entry for a path
+ *
+ * Must be called with the cache mutex held.
+ */
+static struct cache_entry *find_entry(struct gcmz_object_info_cache *const c, wchar_t const *const filepath) {
+  for (size_t i = 0; i < cache_capacity; ++i) {
+    if (c->entries[i].path && wcscmp(c->entries[i].path, filepath) == 0) {
+      return &c->entries[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Store an entry, replacing the one for the same path or the least recently used one
+ *
+ * Must be called with the cache mutex held.
+ */
+static NODISCARD bool store_entry(struct gcmz_object_info_cache *const c,
+                                  wchar_t const *const filepath,
+                                  uint64_t const size,
+                                  uint64_t const last_write,
+                                  struct gcmz_object_info const *const info,
+                                  struct ov_error *const err) {
+  struct cache_entry *entry = find_entry(c, filepath);
+  if (!entry) {
+    entry = &c->entries[0];
+    for (size_t i = 0; i < cache_capacity; ++i) {
+      if (!c->entries[i].path) {
+        entry = &c->entries[i];
+        break;
+      }
+      if (c->entries[i].last_used < entry->last_used) {
+        entry = &c->entries[i];
+      }
+    }
+    size_t const len = wcslen(filepath);
+    if (!OV_ARRAY_GROW(&entry->path, len + 1)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      return false;
+    }
+    memcpy(entry->path, filepath, (len + 1) * sizeof(wchar_t));
+    OV_ARRAY_SET_LENGTH(entry->path, len);
+  }
+  entry->size = size;
+  entry->last_write = last_write;
+  entry->last_used = ++c->tick;
+  entry->info = *info;
+  return true;
+}
+
+bool gcmz_object_info_cache_get(struct gcmz_object_info_cache *const cache,
+                                wchar_t const *const filepath,
+                                struct gcmz_object_info *const info,
+                                struct ov_error *const err) {
+  if (!cache || !filepath || !info) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  uint64_t size = 0;
+  uint64_t last_write = 0;
+  if (!get_file_identity(filepath, &size, &last_write, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+
+  mtx_lock(&cache->mtx);
+  struct cache_entry *const entry = find_entry(cache, filepath);
+  if (entry && entry->size == size && entry->last_write == last_write) {
+    entry->last_used = ++cache->tick;
+    *info = entry->info;
+    mtx_unlock(&cache->mtx);
+    return true;
+  }
+  mtx_unlock(&cache->mtx);
+
+  // Parse outside the lock; the identity was taken before parsing, so a file modified meanwhile
+  // is detected on the next lookup
+  struct gcmz_object_info parsed = {0};
+  if (!gcmz_object_info_parse_file(filepath, &parsed, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+
+  mtx_lock(&cache->mtx);
+  bool const stored = store_entry(cache, filepath, size, last_write, &parsed, err);
+  mtx_unlock(&cache->mtx);
+  if (!stored) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  *info = parsed;
+  return true;
+}
+
+bool gcmz_object_info_cache_put(struct gcmz_object_info_cache *const cache,
+                                wchar_t const *const filepath,
+                                struct gcmz_object_info const *const info,
+                                struct ov_error *const err) {
+  if (!cache || !filepath || !info) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  uint64_t size = 0;
+  uint64_t last_write = 0;
+  if (!get_file_identity(filepath, &size, &last_write, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+
+  mtx_lock(&cache->mtx);
+  bool const stored = store_entry(cache, filepath, size, last_write, info, err);
+  mtx_unlock(&cache->mtx);
+  if (!stored) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  return true;
+}
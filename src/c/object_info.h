@@ -0,0 +1,95 @@
+#pragma once
+
+#include <ovbase.h>
+
+/**
+ * @brief Layout information of an .object file
+ */
+struct gcmz_object_info {
+  int layer_min;       ///< Smallest layer value used by objects (0-based)
+  int layer_max;       ///< Largest layer value used by objects (0-based)
+  int layer_count;     ///< Number of layers occupied (layer_max - layer_min + 1, 1 if no layer was found)
+  int frame_start;     ///< Smallest start frame of all objects
+  int frame_end;       ///< Largest end frame of all objects
+  size_t object_count; ///< Number of object sections ([0], [1], ...)
+};
+
+struct gcmz_object_info_cache;
+
+/**
+ * @brief Parse layout information from .object data in memory
+ *
+ * @param ptr Pointer to .object file content
+ * @param size Size of the content in bytes
+ * @param info [out] Parsed layout information
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+NODISCARD bool gcmz_object_info_parse_memory(void const *const ptr,
+                                             size_t const size,
+                                             struct gcmz_object_info *const info,
+                                             struct ov_error *const err);
+
+/**
+ * @brief Parse layout information from an .object file
+ *
+ * @param filepath Path to the .object file
+ * @param info [out] Parsed layout information
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+NODISCARD bool gcmz_object_info_parse_file(wchar_t const *const filepath,
+                                           struct gcmz_object_info *const info,
+                                           struct ov_error *const err);
+
+/**
+ * @brief Create .object layout information cache
+ *
+ * Entries are keyed by file path, size and last write time, so a modified file is parsed again.
+ * The cache holds a small fixed number of entries and evicts the least recently used one.
+ * All functions are thread-safe.
+ *
+ * @param err [out] Error information on failure
+ * @return Pointer to new cache on success, NULL on failure
+ */
+NODISCARD struct gcmz_object_info_cache *gcmz_object_info_cache_create(struct ov_error *const err);
+
+/**
+ * @brief Destroy .object layout information cache
+ *
+ * @param cache Pointer to cache pointer
+ */
+void gcmz_object_info_cache_destroy(struct gcmz_object_info_cache **const cache);
+
+/**
+ * @brief Get layout information of an .object file
+ *
+ * Only queries file attributes when a matching entry exists; otherwise parses the file and stores the result.
+ *
+ * @param cache Cache instance
+ * @param filepath Path to the .object file
+ * @param info [out] Layout information
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+NODISCARD bool gcmz_object_info_cache_get(struct gcmz_object_info_cache *const cache,
+                                          wchar_t const *const filepath,
+                                          struct gcmz_object_info *const info,
+                                          struct ov_error *const err);
+
+/**
+ * @brief Store layout information for an .object file
+ *
+ * Use this when the layout is already known (for example, right after generating the file)
+ * to avoid parsing it later.
+ *
+ * @param cache Cache instance
+ * @param filepath Path to the .object file
+ * @param info Layout information
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+NODISCARD bool gcmz_object_info_cache_put(struct gcmz_object_info_cache *const cache,
+                                          wchar_t const *const filepath,
+                                          struct gcmz_object_info const *const info,
+                                          struct ov_error *const err);
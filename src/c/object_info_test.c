@@ -0,0 +1,177 @@
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include <ovtest.h>
+
+#include <string.h>
+
+#include "object_info.h"
+
+#ifndef SOURCE_DIR
+#  define SOURCE_DIR .
+#endif
+
+#define LSTR(x) L##x
+#define LSTR2(x) LSTR(#x)
+#define STRINGIZE(x) LSTR2(x)
+#define TEST_PATH(relative_path) STRINGIZE(SOURCE_DIR) L"/test_data/exo/" relative_path
+
+static bool write_test_file(wchar_t const *const file_path, char const *const content) {
+  HANDLE h = CreateFileW(file_path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (h == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  DWORD const len = (DWORD)strlen(content);
+  DWORD written = 0;
+  BOOL const ok = WriteFile(h, content, len, &written, NULL);
+  CloseHandle(h);
+  return ok && written == len;
+}
+
+static bool set_last_write_time(wchar_t const *const file_path, FILETIME const *const ft) {
+  HANDLE h = CreateFileW(file_path, FILE_WRITE_ATTRIBUTES, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (h == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  BOOL const ok = SetFileTime(h, NULL, NULL, ft);
+  CloseHandle(h);
+  return ok != 0;
+}
+
+static void test_parse_memory(void) {
+  static char const data[] = "[exedit]\r\n"
+                             "length=100\r\n"
+                             "[0]\r\n"
+                             "layer=2\r\n"
+                             "frame=10,40\r\n"
+                             "[0.0]\r\n"
+                             "effect.name=Text\r\n"
+                             "[1]\r\n"
+                             "layer=6\r\n"
+                             "frame=0,20\r\n"
+                             "[1.0]\r\n"
+                             "effect.name=Text\r\n";
+  struct gcmz_object_info info = {0};
+  struct ov_error err = {0};
+  if (!TEST_SUCCEEDED(gcmz_object_info_parse_memory(data, sizeof(data) - 1, &info, &err), &err)) {
+    return;
+  }
+  TEST_CHECK(info.layer_min == 2);
+  TEST_CHECK(info.layer_max == 6);
+  TEST_CHECK(info.layer_count == 5);
+  TEST_CHECK(info.frame_start == 0);
+  TEST_CHECK(info.frame_end == 40);
+  TEST_CHECK(info.object_count == 2);
+}
+
+static void test_parse_memory_without_layer(void) {
+  static char const data[] = "[exedit]\r\nlength=100\r\n";
+  struct gcmz_object_info info = {0};
+  struct ov_error err = {0};
+  if (!TEST_SUCCEEDED(gcmz_object_info_parse_memory(data, sizeof(data) - 1, &info, &err), &err)) {
+    return;
+  }
+  TEST_CHECK(info.layer_count == 1);
+  TEST_CHECK(info.object_count == 0);
+}
+
+static void test_parse_file(void) {
+  struct gcmz_object_info info = {0};
+  struct ov_error err = {0};
+  if (!TEST_SUCCEEDED(gcmz_object_info_parse_file(TEST_PATH(L"1-dest.object"), &info, &err), &err)) {
+    return;
+  }
+  TEST_CHECK(info.layer_min == 3);
+  TEST_CHECK(info.layer_max == 5);
+  TEST_CHECK(info.layer_count == 3);
+  TEST_CHECK(info.frame_start == 3);
+  TEST_CHECK(info.frame_end == 497);
+  TEST_CHECK(info.object_count == 3);
+}
+
+static void test_cache(void) {
+  static char const content1[] = "[0]\r\nlayer=0\r\nframe=0,10\r\n[1]\r\nlayer=1\r\nframe=0,10\r\n";
+  static char const content2[] = "[0]\r\nlayer=0\r\nframe=0,10\r\n[1]\r\nlayer=3\r\nframe=0,10\r\n";
+  static char const content3[] = "[0]\r\nlayer=0\r\nframe=0,10\r\n[1]\r\nlayer=7\r\nframe=0,100\r\n";
+  wchar_t path[MAX_PATH];
+  struct gcmz_object_info_cache *cache = NULL;
+  struct gcmz_object_info info = {0};
+  struct ov_error err = {0};
+
+  GetTempPathW(MAX_PATH, path);
+  wcscat(path, L"gcmz_object_info_test.object");
+  if (!TEST_CHECK(write_test_file(path, content1))) {
+    return;
+  }
+
+  cache = gcmz_object_info_cache_create(&err);
+  if (!TEST_SUCCEEDED(cache != NULL, &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_object_info_cache_get(cache, path, &info, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(info.layer_count == 2);
+
+  {
+    // Same size and same last write time: the cached entry is returned without parsing
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    if (!TEST_CHECK(GetFileAttributesExW(path, GetFileExInfoStandard, &fad))) {
+      goto cleanup;
+    }
+    if (!TEST_CHECK(write_test_file(path, content2)) || !TEST_CHECK(set_last_write_time(path, &fad.ftLastWriteTime))) {
+      goto cleanup;
+    }
+    if (!TEST_SUCCEEDED(gcmz_object_info_cache_get(cache, path, &info, &err), &err)) {
+      goto cleanup;
+    }
+    TEST_CHECK(info.layer_count == 2);
+  }
+
+  // Different size: the file is parsed again
+  if (!TEST_CHECK(write_test_file(path, content3))) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(gcmz_object_info_cache_get(cache, path, &info, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(info.layer_count == 8);
+  TEST_CHECK(info.frame_end == 100);
+
+  // Stored information is returned as is
+  {
+    struct gcmz_object_info const stored = {
+        .layer_min = 1,
+        .layer_max = 4,
+        .layer_count = 4,
+        .frame_start = 0,
+        .frame_end = 5,
+        .object_count = 4,
+    };
+    if (!TEST_SUCCEEDED(gcmz_object_info_cache_put(cache, path, &stored, &err), &err)) {
+      goto cleanup;
+    }
+    if (!TEST_SUCCEEDED(gcmz_object_info_cache_get(cache, path, &info, &err), &err)) {
+      goto cleanup;
+    }
+    TEST_CHECK(info.layer_count == 4);
+    TEST_CHECK(info.object_count == 4);
+  }
+
+  TEST_FAILED_WITH(gcmz_object_info_cache_get(cache, NULL, &info, &err),
+                   &err,
+                   ov_error_type_generic,
+                   ov_error_generic_invalid_argument);
+
+cleanup:
+  gcmz_object_info_cache_destroy(&cache);
+  DeleteFileW(path);
+}
+
+TEST_LIST = {
+    {"parse_memory", test_parse_memory},
+    {"parse_memory_without_layer", test_parse_memory_without_layer},
+    {"parse_file", test_parse_file},
+    {"cache", test_cache},
+    {NULL, NULL},
+};
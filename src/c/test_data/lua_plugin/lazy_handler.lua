@@ -0,0 +1,13 @@
+-- Test handler module for lazy loading test
+-- @gcmz_name Lazy Handler
+-- @gcmz_priority 400
+-- @gcmz_extensions .lazytest
+_LAZY_HANDLER_DRAG_ENTER = 0
+return {
+  name = "Lazy Handler",
+  priority = 400,
+  drag_enter = function(files, state)
+    _LAZY_HANDLER_DRAG_ENTER = _LAZY_HANDLER_DRAG_ENTER + 1
+    return true
+  end,
+}
@@ -7,18 +7,538 @@ local M = {}
 -- Local module storage (not accessible from global scope)
 local modules = {}
 
+-- Number of recent durations kept per handler and hook to estimate the 95th percentile
+local PROFILE_SAMPLES = 256
+
+-- Clock used to time handler calls, returns seconds (replaced with a high-resolution clock by the C side)
+local profile_clock = os.clock
+
+-- Calls taking at least this many milliseconds are reported with debug_print, nil to disable
+local slow_threshold = nil
+
+-- Function calling a handler under a time budget, set by the C side (nil if unavailable)
+-- guarded_pcall(ms, fn, ...) behaves like pcall(fn, ...) and additionally returns true if the call was aborted.
+local guarded_pcall = nil
+
+-- Time budget in milliseconds of a single handler call for each hook name
+local time_budgets = {}
+
+-- Stamp of each module from the script directory as of its last load: stamps[modname] = stamp
+-- The C side derives the stamp from the size and last write time of the module files.
+local stamps = {}
+
+-- Execution profile: profile[name][hook] = { count = n, total = ms, max = ms, samples = { ms, ... }, next = i }
+local profile = {}
+
+-- Access to the file list held by the C side, set by set_file_list_source (nil if unavailable)
+-- { to_table = fn, from_table = fn, api = lightuserdata, list = lightuserdata, view = cdata }
+local file_list_source = nil
+
+-- Metatable-bound pointer type of the FFI file list view, created the first time a view is needed
+local file_list_view_type = nil
+
+-- C declarations of the file list accessors, must match lua_file_list_ffi.h
+local FILE_LIST_CDEF = [[
+struct gcmz_lua_file_list_ffi;
+struct gcmz_lua_file_list_ffi_api {
+  size_t (*count)(struct gcmz_lua_file_list_ffi *ffi);
+  const char *(*get_path)(struct gcmz_lua_file_list_ffi *ffi, size_t index);
+  const char *(*get_mime_type)(struct gcmz_lua_file_list_ffi *ffi, size_t index);
+  bool (*get_temporary)(struct gcmz_lua_file_list_ffi *ffi, size_t index);
+  bool (*set_path)(struct gcmz_lua_file_list_ffi *ffi, size_t index, const char *path);
+  bool (*set_mime_type)(struct gcmz_lua_file_list_ffi *ffi, size_t index, const char *mime_type);
+  bool (*set_temporary)(struct gcmz_lua_file_list_ffi *ffi, size_t index, bool temporary);
+  bool (*append)(struct gcmz_lua_file_list_ffi *ffi, const char *path, const char *mime_type, bool temporary);
+  bool (*remove)(struct gcmz_lua_file_list_ffi *ffi, size_t index);
+};
+]]
+
+--- Record the duration of a single handler call.
+-- @param name string Handler name
+-- @param hook string Hook name
+-- @param elapsed number Duration in milliseconds
+-- @local
+local function record_profile(name, hook, elapsed)
+  local hooks = profile[name]
+  if not hooks then
+    hooks = {}
+    profile[name] = hooks
+  end
+  local p = hooks[hook]
+  if not p then
+    p = { count = 0, total = 0, max = 0, samples = {}, next = 1 }
+    hooks[hook] = p
+  end
+  p.count = p.count + 1
+  p.total = p.total + elapsed
+  if elapsed > p.max then
+    p.max = elapsed
+  end
+  p.samples[p.next] = elapsed
+  p.next = p.next % PROFILE_SAMPLES + 1
+  if slow_threshold and elapsed >= slow_threshold then
+    debug_print(string.format("slow handler: %s.%s took %.3f ms", name, hook, elapsed))
+  end
+end
+
+--- Call a handler function in protected mode and record how long it took.
+-- The call runs under the time budget of the hook and is aborted with an error once the budget is exceeded.
+-- @param name string Handler name
+-- @param hook string Hook name
+-- @param fn function Function to call
+-- @return boolean, any, boolean Same as pcall, followed by true if the call was aborted by the watchdog
+-- @local
+local function profiled_pcall(name, hook, fn, ...)
+  local budget = guarded_pcall and time_budgets[hook]
+  local start = profile_clock()
+  local ok, result, timed_out
+  if budget then
+    ok, result, timed_out = guarded_pcall(budget, fn, ...)
+  else
+    ok, result = pcall(fn, ...)
+    timed_out = false
+  end
+  record_profile(name, hook, (profile_clock() - start) * 1000)
+  return ok, result, timed_out
+end
+
+--- Disable a module that exceeded its time budget for the rest of the drag session.
+-- @param entry table Module entry
+-- @param hook string Hook name
+-- @local
+local function disable_timed_out(entry, hook)
+  entry.active = false
+  debug_print(
+    string.format(
+      "%s.%s exceeded the time budget of %d ms and is disabled for this drag session",
+      entry.name,
+      hook,
+      time_budgets[hook]
+    )
+  )
+end
+
+--- Get the 95th percentile of the recorded samples.
+-- @local
+local function percentile95(samples)
+  local sorted = {}
+  for i = 1, #samples do
+    sorted[i] = samples[i]
+  end
+  table.sort(sorted)
+  return sorted[math.max(1, math.ceil(#sorted * 0.95))] or 0
+end
+
 --- Sort modules by priority (ascending order)
 -- @local
 local function sort_modules(a, b)
   return a.priority < b.priority
 end
 
+--- Add an extension to a filter.
+-- Extensions are stored lowercased with a leading dot.
+-- @param filter table Filter to update
+-- @param ext string Extension such as ".psd" or "psd"
+-- @local
+local function add_filter_extension(filter, ext)
+  ext = ext:lower()
+  if ext:sub(1, 1) ~= "." then
+    ext = "." .. ext
+  end
+  filter.extensions = filter.extensions or {}
+  filter.extensions[ext] = true
+end
+
+--- Add a MIME type pattern to a filter.
+-- @param filter table Filter to update
+-- @param mime string MIME type such as "image/png" or "image/*"
+-- @local
+local function add_filter_mimetype(filter, mime)
+  filter.mimetypes = filter.mimetypes or {}
+  table.insert(filter.mimetypes, mime:lower())
+end
+
+--- Read the handler manifest from the leading comment lines of a Lua source file.
+-- Only line comments before the first line of code are examined. Recognized tags:
+--   -- @gcmz_name <name>
+--   -- @gcmz_priority <number>
+--   -- @gcmz_extensions <.ext> [<.ext> ...]
+--   -- @gcmz_mimetypes <type/subtype|type/*> [...]
+--   -- @gcmz_from_api <true|false>
+-- @param filepath string Path to the handler source file
+-- @return table|nil { name = string|nil, priority = number|nil, filter = table|nil }, or nil if no tag was found
+-- @local
+local function read_manifest(filepath)
+  if not filepath:lower():match("%.lua$") then
+    return nil
+  end
+  local f = io.open(filepath, "rb")
+  if not f then
+    return nil
+  end
+  local manifest = nil
+  local filter = nil
+  local first = true
+  for line in f:lines() do
+    if first then
+      line = line:gsub("^\239\187\191", "")
+      first = false
+    end
+    if not line:match("^%s*$") then
+      if not line:match("^%s*%-%-") then
+        break
+      end
+      local tag, value = line:match("^%s*%-%-+%s*@gcmz_([%w_]+)%s*(.-)%s*$")
+      if tag then
+        manifest = manifest or {}
+        if tag == "name" and value ~= "" then
+          manifest.name = value
+        elseif tag == "priority" then
+          manifest.priority = tonumber(value)
+        elseif tag == "extensions" then
+          filter = filter or {}
+          for ext in value:gmatch("[^%s,]+") do
+            add_filter_extension(filter, ext)
+          end
+        elseif tag == "mimetypes" then
+          filter = filter or {}
+          for mime in value:gmatch("[^%s,]+") do
+            add_filter_mimetype(filter, mime)
+          end
+        elseif tag == "from_api" then
+          filter = filter or {}
+          filter.from_api = value == "true"
+        end
+      end
+    end
+  end
+  f:close()
+  if manifest then
+    manifest.filter = filter
+  end
+  return manifest
+end
+
+--- Build a filter from the accepts field of a module table.
+-- The accepts field has the format { extensions = { ".ext", ... }, mimetypes = { "type/subtype", ... }, from_api = bool }.
+-- @param accepts any Value of the accepts field
+-- @return table|nil Filter, or nil if accepts is not a table
+-- @local
+local function filter_from_accepts(accepts)
+  if type(accepts) ~= "table" then
+    return nil
+  end
+  local filter = {}
+  if type(accepts.extensions) == "table" then
+    for _, ext in ipairs(accepts.extensions) do
+      if type(ext) == "string" and ext ~= "" then
+        add_filter_extension(filter, ext)
+      end
+    end
+  end
+  if type(accepts.mimetypes) == "table" then
+    for _, mime in ipairs(accepts.mimetypes) do
+      if type(mime) == "string" and mime ~= "" then
+        add_filter_mimetype(filter, mime)
+      end
+    end
+  end
+  if accepts.from_api == true then
+    filter.from_api = true
+  end
+  return filter
+end
+
+-- Index from extension and MIME type to handlers, rebuilt after the module list changes
+local dispatch_index = nil
+
+--- Append a module entry to an index bucket.
+-- @local
+local function add_to_bucket(buckets, key, entry)
+  local bucket = buckets[key]
+  if not bucket then
+    bucket = {}
+    buckets[key] = bucket
+  end
+  table.insert(bucket, entry)
+end
+
+--- Build the dispatch index from the registered modules.
+-- Modules must already be sorted by priority, so every bucket is in priority order.
+-- "type/*" patterns are indexed by their media type.
+-- Modules without extension or MIME type filters are collected into the unfiltered list.
+-- @return table { extensions = {}, mimetypes = {}, mediatypes = {}, unfiltered = {} }
+-- @local
+local function build_dispatch_index()
+  local index = { extensions = {}, mimetypes = {}, mediatypes = {}, unfiltered = {} }
+  for order, entry in ipairs(modules) do
+    entry.order = order
+    local filter = entry.filter
+    if not filter or (not filter.extensions and not filter.mimetypes) then
+      table.insert(index.unfiltered, entry)
+    else
+      if filter.extensions then
+        for ext in pairs(filter.extensions) do
+          add_to_bucket(index.extensions, ext, entry)
+        end
+      end
+      if filter.mimetypes then
+        for _, mime in ipairs(filter.mimetypes) do
+          if mime:sub(-2) == "/*" then
+            add_to_bucket(index.mediatypes, mime:sub(1, -3), entry)
+          else
+            add_to_bucket(index.mimetypes, mime, entry)
+          end
+        end
+      end
+    end
+  end
+  return index
+end
+
+--- Append the entries of a bucket that have not been selected yet.
+-- @local
+local function select_bucket(selected, seen, bucket)
+  if not bucket then
+    return
+  end
+  for _, entry in ipairs(bucket) do
+    if not seen[entry] then
+      seen[entry] = true
+      selected[#selected + 1] = entry
+    end
+  end
+end
+
+--- Sort selected module entries by registration order (priority order)
+-- @local
+local function sort_selected(a, b)
+  return a.order < b.order
+end
+
+--- Append the modules indexed for a single file.
+-- @local
+local function select_file(selected, seen, index, filepath, mimetype)
+  if type(filepath) == "string" then
+    local ext = filepath:match("(%.[^%./\\]+)$")
+    if ext then
+      select_bucket(selected, seen, index.extensions[ext:lower()])
+    end
+  end
+  if type(mimetype) == "string" and mimetype ~= "" then
+    local mime = mimetype:lower()
+    select_bucket(selected, seen, index.mimetypes[mime])
+    local mediatype = mime:match("^([^/]+)/")
+    if mediatype then
+      select_bucket(selected, seen, index.mediatypes[mediatype])
+    end
+  end
+end
+
+--- Select the modules relevant to a file list using the dispatch index.
+-- @param files table|cdata Files table or FFI file list view
+-- @return table Array of module entries in priority order
+-- @local
+local function select_modules(files)
+  if not dispatch_index then
+    dispatch_index = build_dispatch_index()
+  end
+  local index = dispatch_index
+  local selected = {}
+  local seen = {}
+  select_bucket(selected, seen, index.unfiltered)
+  if type(files) == "table" then
+    for _, file in ipairs(files) do
+      select_file(selected, seen, index, file.filepath, file.mimetype)
+    end
+  else
+    for i = 1, files:count() do
+      select_file(selected, seen, index, files:get_filepath(i), files:get_mimetype(i))
+    end
+  end
+  if #selected > 1 then
+    table.sort(selected, sort_selected)
+  end
+  return selected
+end
+
+--- Create the pointer type of the FFI file list view.
+-- The methods take 1-based indices like the files table and raise an error on failure.
+-- @param api_ptr lightuserdata Pointer to struct gcmz_lua_file_list_ffi_api
+-- @return ctype Pointer type to cast the file list to
+-- @local
+local function create_file_list_view_type(api_ptr)
+  local ffi = require("ffi")
+  ffi.cdef(FILE_LIST_CDEF)
+  local api = ffi.cast("const struct gcmz_lua_file_list_ffi_api *", api_ptr)
+
+  local function to_index(list, i)
+    if type(i) ~= "number" or i % 1 ~= 0 or i < 1 or i > tonumber(api.count(list)) then
+      error("file index out of range: " .. tostring(i), 3)
+    end
+    return i - 1
+  end
+
+  local function check_string(value, name, optional)
+    if optional and value == nil then
+      return
+    end
+    if type(value) ~= "string" or (not optional and value == "") then
+      error(name .. " must be a non-empty string", 3)
+    end
+  end
+
+  local methods = {}
+
+  function methods.count(list)
+    return tonumber(api.count(list))
+  end
+
+  function methods.get_filepath(list, i)
+    local path = api.get_path(list, to_index(list, i))
+    if path == nil then
+      error("failed to get the file path", 2)
+    end
+    return ffi.string(path)
+  end
+
+  function methods.get_mimetype(list, i)
+    local mime_type = api.get_mime_type(list, to_index(list, i))
+    if mime_type == nil then
+      error("failed to get the MIME type", 2)
+    end
+    return ffi.string(mime_type)
+  end
+
+  function methods.is_temporary(list, i)
+    return api.get_temporary(list, to_index(list, i))
+  end
+
+  function methods.set_filepath(list, i, filepath)
+    local index = to_index(list, i)
+    check_string(filepath, "filepath", false)
+    if not api.set_path(list, index, filepath) then
+      error("failed to set the file path", 2)
+    end
+  end
+
+  function methods.set_mimetype(list, i, mimetype)
+    local index = to_index(list, i)
+    check_string(mimetype, "mimetype", true)
+    if not api.set_mime_type(list, index, mimetype) then
+      error("failed to set the MIME type", 2)
+    end
+  end
+
+  function methods.set_temporary(list, i, temporary)
+    api.set_temporary(list, to_index(list, i), temporary ~= false)
+  end
+
+  function methods.append(list, filepath, mimetype, temporary)
+    check_string(filepath, "filepath", false)
+    check_string(mimetype, "mimetype", true)
+    if not api.append(list, filepath, mimetype, temporary == true) then
+      error("failed to append the file", 2)
+    end
+  end
+
+  function methods.remove(list, i)
+    if not api.remove(list, to_index(list, i)) then
+      error("failed to remove the file", 2)
+    end
+  end
+
+  ffi.metatype("struct gcmz_lua_file_list_ffi", { __index = methods, __len = methods.count })
+  return ffi.typeof("struct gcmz_lua_file_list_ffi *")
+end
+
+--- Get the FFI view of the file list held by the C side.
+-- @return cdata File list view
+-- @local
+local function get_file_list_view()
+  if not file_list_source.view then
+    if not file_list_view_type then
+      file_list_view_type = create_file_list_view_type(file_list_source.api)
+    end
+    file_list_source.view = require("ffi").cast(file_list_view_type, file_list_source.list)
+  end
+  return file_list_source.view
+end
+
+--- Check whether any loaded module asks for the FFI file list view.
+-- @local
+local function has_ffi_modules()
+  for _, entry in ipairs(modules) do
+    if entry.module and entry.module.use_ffi then
+      return true
+    end
+  end
+  return false
+end
+
+--- Start handing out the file list of a hook call.
+-- When the C side holds the file list, the files table is only created once a handler needs it.
+-- @param files table|nil Files table, or nil to take the file list from the file list source
+-- @return table Files of the hook call
+-- @local
+local function open_files(files)
+  if files == nil and file_list_source then
+    return { source = file_list_source }
+  end
+  return { files = files or {} }
+end
+
+--- Get the files table of a hook call, creating it from the file list if needed.
+-- @local
+local function files_table(session)
+  if not session.files then
+    session.files, session.generation = session.source.to_table()
+  end
+  return session.files
+end
+
+--- Get the FFI view of a hook call, writing the files table back to the file list first if one was created.
+-- @local
+local function files_view(session)
+  if session.files then
+    session.source.from_table(session.files, session.generation)
+    session.files = nil
+    session.generation = nil
+  end
+  return get_file_list_view()
+end
+
+--- Get the files argument of a handler.
+-- Handlers with use_ffi receive the FFI view when the C side holds the file list, the others the files table.
+-- @local
+local function files_for(session, module)
+  if session.source and module.use_ffi then
+    return files_view(session)
+  end
+  return files_table(session)
+end
+
+--- Finish handing out the file list of a hook call.
+-- @return table|nil The files table, or nil if the file list held by the C side is already up to date
+-- @local
+local function close_files(session)
+  if not session.source then
+    return session.files
+  end
+  if session.files then
+    session.source.from_table(session.files, session.generation)
+  end
+  return nil
+end
+
 --- Register a module to the module list.
 -- @param module_table table The module table (must have name field)
 -- @param source string Source path of the module (file path or module origin, required)
+-- @param filter table|nil Filter declared in the handler manifest (takes precedence over the accepts field)
+-- @param modname string|nil Module name in the script directory, nil for modules added from a script
 -- @return boolean, string true on success, or false and error message on failure
 -- @local
-local function register_module(module_table, source)
+local function register_module(module_table, source, filter, modname)
   -- source is required
   if type(source) ~= "string" or source == "" then
     return false, "handler source path is required"
@@ -40,20 +560,43 @@ local function register_module(module_table, source)
     name = name,
     priority = priority,
     module = module_table,
+    modname = modname,
     source = source,
+    filter = filter or filter_from_accepts(module_table.accepts),
     active = true,
   })
   return true, nil
 end
 
---- Load handler modules from a list of module info.
--- Called from C side with the list of module info in the script directory.
--- Loads all modules using require, registers them, and sorts by priority.
--- @param modinfo table Array of { name = "modname", path = "filepath" }
-function M.load_handlers(modinfo)
-  if type(modinfo) ~= "table" then
-    return
+--- Load a lazily registered module on first use.
+-- @param entry table Module entry
+-- @return boolean true if the module is available
+-- @local
+local function ensure_loaded(entry)
+  if entry.module then
+    return true
+  end
+  if entry.load_failed then
+    return false
   end
+  local ok, result = pcall(require, entry.modname)
+  if ok and type(result) ~= "table" then
+    ok, result = false, "handler script must return a table"
+  end
+  if not ok then
+    entry.load_failed = true
+    debug_print("failed to load handler: " .. entry.modname .. ": " .. tostring(result))
+    return false
+  end
+  entry.module = result
+  return true
+end
+
+--- Load the modules of a list of module info and record their stamps.
+-- The module list is not sorted here.
+-- @param modinfo table Array of { name = "modname", path = "filepath", stamp = "..." }
+-- @local
+local function load_modules(modinfo)
   for _, info in ipairs(modinfo) do
     local modname = info.name
     local modpath = info.path
@@ -62,18 +605,119 @@ function M.load_handlers(modinfo)
     elseif type(modpath) ~= "string" or modpath == "" then
       debug_print("handler source path is required: " .. modname)
     else
-      local ok, result = pcall(require, modname)
-      if not ok then
-        debug_print("failed to load handler: " .. modname .. ": " .. tostring(result))
+      -- Recorded even if loading fails, so a fixed script is picked up by the next reload
+      stamps[modname] = info.stamp or ""
+      local manifest = read_manifest(modpath)
+      if manifest and manifest.name and manifest.filter then
+        table.insert(modules, {
+          name = manifest.name,
+          priority = manifest.priority or 1000,
+          module = nil,
+          modname = modname,
+          source = modpath,
+          filter = manifest.filter,
+          active = true,
+        })
       else
-        local registered, err = register_module(result, modpath)
-        if not registered then
-          debug_print(err .. ": " .. modname)
+        local ok, result = pcall(require, modname)
+        if not ok then
+          debug_print("failed to load handler: " .. modname .. ": " .. tostring(result))
+        else
+          local registered, err = register_module(result, modpath, manifest and manifest.filter, modname)
+          if not registered then
+            debug_print(err .. ": " .. modname)
+          end
         end
       end
     end
   end
+end
+
+--- Remove a module and its submodules from package.loaded so the next require runs the script again.
+-- @param modname string Module name
+-- @local
+local function unload_package(modname)
+  local loaded = package.loaded
+  local prefix = modname .. "."
+  for name in pairs(loaded) do
+    if name == modname or name:sub(1, #prefix) == prefix then
+      loaded[name] = nil
+    end
+  end
+end
+
+--- Load handler modules from a list of module info.
+-- Called from C side with the list of module info in the script directory.
+-- Loads modules using require, registers them, and sorts by priority.
+-- A handler whose manifest declares a name and a filter is registered without being loaded;
+-- it is required the first time a matching file list arrives in drag_enter.
+-- @param modinfo table Array of { name = "modname", path = "filepath", stamp = "..." }
+function M.load_handlers(modinfo)
+  if type(modinfo) ~= "table" then
+    return
+  end
+  load_modules(modinfo)
   table.sort(modules, sort_modules)
+  dispatch_index = nil
+end
+
+--- Reload the handler modules that changed since they were loaded.
+-- Called from C side between drag sessions with the current list of module info in the script directory.
+-- Modules whose stamp differs, new modules and removed modules are unregistered, dropped from package.loaded
+-- and loaded again; the other handlers keep their module tables and state.
+-- Handlers added from a script string or file are left untouched.
+-- @param modinfo table Array of { name = "modname", path = "filepath", stamp = "..." }
+-- @return number Number of module names that were reloaded or removed
+function M.reload_handlers(modinfo)
+  if type(modinfo) ~= "table" then
+    return 0
+  end
+  local current = {}
+  for _, info in ipairs(modinfo) do
+    if type(info.name) == "string" and info.name ~= "" then
+      current[info.name] = info
+    end
+  end
+  local changed = {}
+  local count = 0
+  for modname, stamp in pairs(stamps) do
+    local info = current[modname]
+    if not info or (info.stamp or "") ~= stamp then
+      changed[modname] = true
+      count = count + 1
+    end
+  end
+  for modname in pairs(current) do
+    if stamps[modname] == nil then
+      changed[modname] = true
+      count = count + 1
+    end
+  end
+  if count == 0 then
+    return 0
+  end
+
+  local kept = {}
+  for _, entry in ipairs(modules) do
+    if not (entry.modname and changed[entry.modname]) then
+      kept[#kept + 1] = entry
+    end
+  end
+  modules = kept
+  local reload = {}
+  for modname in pairs(changed) do
+    stamps[modname] = nil
+    unload_package(modname)
+  end
+  for _, info in ipairs(modinfo) do
+    if changed[info.name] then
+      reload[#reload + 1] = info
+    end
+  end
+  load_modules(reload)
+  table.sort(modules, sort_modules)
+  dispatch_index = nil
+  return count
 end
 
 --- Add a handler module from a table.
@@ -88,6 +732,7 @@ local function add_module(module_table, source)
     return false, err
   end
   table.sort(modules, sort_modules)
+  dispatch_index = nil
   return true, nil
 end
 
@@ -157,32 +802,133 @@ function M.enum_modules(fn)
   end
 end
 
---- Call drag_enter hook on all loaded modules in priority order.
--- Modules that return false from drag_enter are marked as inactive.
+--- Configure the handler profiler.
+-- Called from C side after the module is loaded.
+-- @param clock function|nil Function returning the current time in seconds (os.clock if nil)
+-- @param threshold_ms number|nil Calls taking at least this many milliseconds are logged, nil or 0 to disable
+function M.set_profiler(clock, threshold_ms)
+  profile_clock = type(clock) == "function" and clock or os.clock
+  if type(threshold_ms) == "number" and threshold_ms > 0 then
+    slow_threshold = threshold_ms
+  else
+    slow_threshold = nil
+  end
+end
+
+--- Configure the handler time budgets.
+-- Called from C side after the module is loaded.
+-- @param fn function|nil Function calling a handler under a time budget, nil to disable time budgets
+-- @param budgets table|nil { [hook_name] = ms }, hooks without a positive budget are not limited
+function M.set_watchdog(fn, budgets)
+  guarded_pcall = type(fn) == "function" and fn or nil
+  time_budgets = {}
+  if type(budgets) == "table" then
+    for hook, ms in pairs(budgets) do
+      if type(ms) == "number" and ms > 0 then
+        time_budgets[hook] = ms
+      end
+    end
+  end
+end
+
+--- Configure access to the file list held by the C side.
+-- Called from C side after the module is loaded. Once configured, the hooks are called without a files table
+-- and take the file list from here.
+-- @param to_table function Returns the files table of the running hook and its generation
+-- @param from_table function Writes a files table and its generation back to the file list of the running hook
+-- @param api lightuserdata Pointer to the accessor functions of the FFI file list view
+-- @param list lightuserdata Pointer to the file list shared with the FFI view
+function M.set_file_list_source(to_table, from_table, api, list)
+  file_list_source = { to_table = to_table, from_table = from_table, api = api, list = list }
+end
+
+--- Get execution statistics of the handlers.
+-- Durations are in milliseconds. p95 is computed from the most recent calls.
+-- @return table { [handler_name] = { [hook_name] = { count = n, total = ms, max = ms, p95 = ms } } }
+function M.get_handler_stats()
+  local result = {}
+  for name, hooks in pairs(profile) do
+    local r = {}
+    for hook, p in pairs(hooks) do
+      r[hook] = { count = p.count, total = p.total, max = p.max, p95 = percentile95(p.samples) }
+    end
+    result[name] = r
+  end
+  return result
+end
+
+--- Enumerate execution statistics of the handlers.
+-- Entries are passed sorted by handler name and hook name.
+-- @param fn function Callback function(name, hook, count, total, max, p95) called for each entry
+function M.enum_handler_stats(fn)
+  if type(fn) ~= "function" then
+    return
+  end
+  local names = {}
+  for name in pairs(profile) do
+    names[#names + 1] = name
+  end
+  table.sort(names)
+  for _, name in ipairs(names) do
+    local hooks = {}
+    for hook in pairs(profile[name]) do
+      hooks[#hooks + 1] = hook
+    end
+    table.sort(hooks)
+    for _, hook in ipairs(hooks) do
+      local p = profile[name][hook]
+      fn(name, hook, p.count, p.total, p.max, percentile95(p.samples))
+    end
+  end
+end
+
+--- Call drag_enter hook on the relevant modules in priority order.
+-- Only modules selected through the dispatch index are considered: modules without filters,
+-- and modules whose declared extensions or MIME types match at least one file.
+-- The selection is made from the files as passed in, before any handler modifies them.
+-- Modules that are not selected, or that return false from drag_enter, are marked as inactive.
+-- Lazily registered modules are loaded here the first time they are selected.
 -- If a handler throws an error, it is caught and logged, and the handler is marked inactive.
--- @param files table File list with format { {filepath="...", mimetype="...", temporary=bool}, ... }
+-- A handler exceeding the drag_enter time budget is aborted and marked inactive for the drag session.
+-- Handlers with use_ffi receive the FFI file list view instead of the files table.
+-- @param files table|nil File list with format { {filepath="...", mimetype="...", temporary=bool}, ... },
+-- or nil to take it from the file list source
 -- @param state table Key state with format { control=bool, shift=bool, alt=bool, ... }
--- @return table The files table (possibly modified by modules)
+-- @return table|nil The files table (possibly modified by modules), nil if the file list source is up to date
 function M.drag_enter(files, state)
-  -- Reset all module active flags to true
+  -- Reset all module active flags to false; selected modules are activated below
   for _, entry in ipairs(modules) do
-    entry.active = true
+    entry.active = false
   end
 
-  -- Call drag_enter on each module
-  for _, entry in ipairs(modules) do
-    if entry.active and entry.module and entry.module.drag_enter then
-      local ok, result = pcall(entry.module.drag_enter, files, state)
-      if not ok then
-        debug_print("error in " .. entry.name .. ".drag_enter: " .. tostring(result))
-        entry.active = false
-      elseif result == false then
-        entry.active = false
+  local session = open_files(files)
+  local candidates
+  if session.source and has_ffi_modules() then
+    candidates = select_modules(files_view(session))
+  else
+    candidates = select_modules(files_table(session))
+  end
+
+  local from_api = state and state.from_external_api
+  for _, entry in ipairs(candidates) do
+    if (not entry.filter or not entry.filter.from_api or from_api) and ensure_loaded(entry) then
+      entry.active = true
+      if entry.module.drag_enter then
+        local arg = files_for(session, entry.module)
+        local ok, result, timed_out = profiled_pcall(entry.name, "drag_enter", entry.module.drag_enter, arg, state)
+        if timed_out then
+          disable_timed_out(entry, "drag_enter")
+        elseif not ok then
+          debug_print("error in " .. entry.name .. ".drag_enter: " .. tostring(result))
+          entry.active = false
+        elseif result == false then
+          entry.active = false
+        end
       end
     end
   end
 
-  return files
+  return close_files(session)
 end
 
 --- Call drag_leave hook on all active modules in priority order.
@@ -190,8 +936,10 @@ end
 function M.drag_leave()
   for _, entry in ipairs(modules) do
     if entry.active and entry.module and entry.module.drag_leave then
-      local ok, err = pcall(entry.module.drag_leave)
-      if not ok then
+      local ok, err, timed_out = profiled_pcall(entry.name, "drag_leave", entry.module.drag_leave)
+      if timed_out then
+        disable_timed_out(entry, "drag_leave")
+      elseif not ok then
         debug_print("error in " .. entry.name .. ".drag_leave: " .. tostring(err))
       end
     end
@@ -200,20 +948,26 @@ end
 
 --- Call drop hook on all active modules in priority order.
 -- If a handler throws an error, it is caught and logged, but processing continues.
--- @param files table File list with format { {filepath="...", mimetype="...", temporary=bool}, ... }
+-- Handlers with use_ffi receive the FFI file list view instead of the files table.
+-- @param files table|nil File list with format { {filepath="...", mimetype="...", temporary=bool}, ... },
+-- or nil to take it from the file list source
 -- @param state table Key state with format { control=bool, shift=bool, alt=bool, ... }
--- @return table The files table (possibly modified by modules)
+-- @return table|nil The files table (possibly modified by modules), nil if the file list source is up to date
 function M.drop(files, state)
+  local session = open_files(files)
   for _, entry in ipairs(modules) do
     if entry.active and entry.module and entry.module.drop then
-      local ok, err = pcall(entry.module.drop, files, state)
-      if not ok then
+      local arg = files_for(session, entry.module)
+      local ok, err, timed_out = profiled_pcall(entry.name, "drop", entry.module.drop, arg, state)
+      if timed_out then
+        disable_timed_out(entry, "drop")
+      elseif not ok then
         debug_print("error in " .. entry.name .. ".drop: " .. tostring(err))
       end
     end
   end
 
-  return files
+  return close_files(session)
 end
 
 --- Convert EXO files to object format.
@@ -223,9 +977,13 @@ end
 -- @param files table File list with format { {filepath="...", mimetype="...", temporary=bool}, ... }
 -- @return table The files table (with .exo files converted to .object files)
 function M.exo_convert(files)
-  local ok, result = pcall(function()
+  local ok, result, timed_out = profiled_pcall("exo", "exo_convert", function()
     return require("exo").process_file_list(files)
   end)
+  if timed_out then
+    debug_print(string.format("exo_convert exceeded the time budget of %d ms", time_budgets.exo_convert))
+    return files
+  end
   if not ok then
     debug_print("error in exo_convert: " .. tostring(result))
     return files
@@ -4,8 +4,6 @@
 -- NOTE: This module does NOT implement drag_enter/drop hooks.
 -- It is called explicitly from C code only when the use_exo_converter flag is enabled.
 -- @module exo
-local ini = require("ini")
-
 local M = {}
 
 --- Effect conversion tables.
@@ -173,12 +171,13 @@ end
 
 --- Convert a single effect section.
 -- Processes one effect section from the EXO file and converts it to AviUtl2 format.
--- @param exo table The parsed EXO file as an INI object
--- @param section_name string The name of the effect section to convert
+-- @param props table Key/value pairs of the effect section
+-- @param section_name string The name of the effect section to convert (used for error messages)
+-- @param decoded table|nil Pre-decoded text fields keyed by EXO property name
 -- @return string|nil, table|nil Effect name and properties table, or nil if conversion fails
 -- @local
-local function convert_effect(exo, section_name)
-  local effect_name = exo:get(section_name, "_name")
+local function convert_effect(props, section_name, decoded)
+  local effect_name = props["_name"]
   if not effect_name then
     return nil
   end
@@ -201,11 +200,11 @@ local function convert_effect(exo, section_name)
   -- Apply property mappings
   if table_def.props then
     for exo_key, mapping in pairs(table_def.props) do
-      local value = exo:get(section_name, exo_key)
+      local value = props[exo_key]
       if value then
         -- Apply transformation if specified
         if mapping.transform == "decode_exo_text" then
-          value = gcmz.decode_exo_text(value):gsub("\r?\n", "\\n")
+          value = (decoded and decoded[exo_key] or gcmz.decode_exo_text(value)):gsub("\r?\n", "\\n")
         elseif mapping.decimals then
           value = format_number(value, mapping.decimals)
         end
@@ -214,99 +213,269 @@ local function convert_effect(exo, section_name)
     end
   end
 
-  -- Apply custom transform function (only build exo_props if needed)
+  -- Apply custom transform function
   if table_def.transform then
-    local exo_props = {}
-    for _, key in ipairs(exo:keys(section_name)) do
-      exo_props[key] = exo:get(section_name, key)
-    end
-    table_def.transform(out_props, exo_props)
+    table_def.transform(out_props, props)
   end
 
   return out_name, out_props
 end
 
---- Convert EXO content to object format.
--- Takes the raw content of an EXO file and converts it to AviUtl2 object format.
--- Handles encoding conversion, INI parsing, and effect conversion.
--- @param exo_content string Raw EXO file content in Shift_JIS encoding
--- @return string Converted object file content in UTF-8
--- @raise error if encoding conversion, parsing, or effect conversion fails
+--- Create a line iterator that reads a file in fixed-size chunks.
+-- Only one chunk plus the current partial line is held in memory at a time.
+-- Empty lines are skipped, matching the behavior of the ini module.
+-- @param f file Opened file handle
+-- @param chunk_size number Number of bytes to read at once
+-- @return function Iterator returning one line (without line terminator) per call
 -- @local
-local function convert_exo_to_object(exo_content)
-  -- Convert from Shift_JIS to UTF-8
-  local utf8_content = gcmz.convert_encoding(exo_content, "sjis", "utf8")
-  if not utf8_content then
-    error("Failed to convert encoding from Shift_JIS to UTF-8")
+local function chunked_lines(f, chunk_size)
+  local buf = ""
+  local pos = 1
+  local eof = false
+  return function()
+    while true do
+      local s, e = buf:find("[\r\n]+", pos)
+      if s then
+        local line = buf:sub(pos, s - 1)
+        pos = e + 1
+        if #line > 0 then
+          return line
+        end
+      elseif eof then
+        local line = buf:sub(pos)
+        buf = ""
+        pos = 1
+        if #line > 0 then
+          return line
+        end
+        return nil
+      else
+        local chunk = f:read(chunk_size)
+        if chunk then
+          buf = buf:sub(pos) .. chunk
+        else
+          buf = buf:sub(pos)
+          eof = true
+        end
+        pos = 1
+      end
+    end
+  end
+end
+
+--- Write one converted object group to the output file.
+-- Converts the object section and its effect sub-sections and writes them immediately.
+-- @param out file Output file handle
+-- @param section string Object section name (e.g. "0")
+-- @param group table Parsed group { props = {...}, effects = { [M] = {...} } } in UTF-8
+-- @return boolean|nil true if the object was written, false if it was skipped, nil if the group has no start value
+-- @return number|nil Layer (0-based) of the written object
+-- @return number|nil Start frame (0-based) of the written object
+-- @return number|nil End frame (0-based) of the written object
+-- @raise error if effect conversion fails
+-- @local
+local function write_object_group(out, section, group)
+  local props = group.props
+  local start_val = props["start"]
+  if not start_val then
+    return nil
   end
 
-  -- Parse INI
-  local exo = ini.new(utf8_content)
-  if not exo then
-    error("Failed to parse EXO content as INI format")
+  local end_val = props["end"]
+  local layer_val = props["layer"]
+  if not end_val or not layer_val then
+    return false
   end
 
-  -- Output INI
-  local out = ini.new()
-  local obj_idx = 0
+  local start_frame = tonumber(start_val) - 1
+  local end_frame = tonumber(end_val) - 1
+  local layer = tonumber(layer_val) - 1
+
+  local r = {
+    "[" .. section .. "]",
+    "layer=" .. layer,
+    "frame=" .. start_frame .. "," .. end_frame,
+  }
+  if props["group"] then
+    table.insert(r, "group=" .. props["group"])
+  end
 
-  while true do
-    local section = tostring(obj_idx)
-    local start_val = exo:get(section, "start")
-    if not start_val then
-      break
+  -- Decode all text fields of this object in one call
+  local hex_texts = {}
+  local text_refs = {}
+  local effect_count = 0
+  while group.effects[effect_count] do
+    local effect_props = group.effects[effect_count]
+    local table_def = effect_tables[effect_props["_name"]]
+    if table_def and table_def.props then
+      for exo_key, mapping in pairs(table_def.props) do
+        if mapping.transform == "decode_exo_text" and effect_props[exo_key] then
+          table.insert(hex_texts, effect_props[exo_key])
+          table.insert(text_refs, { effect_count, exo_key })
+        end
+      end
+    end
+    effect_count = effect_count + 1
+  end
+  local decoded = {}
+  if #hex_texts > 0 then
+    -- On failure, convert_effect falls back to decoding each field and reports the error there
+    local texts = gcmz.decode_exo_texts(hex_texts)
+    if texts then
+      for i, ref in ipairs(text_refs) do
+        decoded[ref[1]] = decoded[ref[1]] or {}
+        decoded[ref[1]][ref[2]] = texts[i]
+      end
     end
+  end
 
-    local end_val = exo:get(section, "end")
-    local layer_val = exo:get(section, "layer")
-    local group_val = exo:get(section, "group")
+  -- Process effect sub-sections [0.0], [0.1], etc.
+  local out_effect_idx = 0
+  for effect_idx = 0, effect_count - 1 do
+    local effect_props = group.effects[effect_idx]
+    local effect_section = section .. "." .. effect_idx
+    local out_name, out_props = convert_effect(effect_props, effect_section, decoded[effect_idx])
+    if out_name and out_props then
+      table.insert(r, "[" .. section .. "." .. out_effect_idx .. "]")
+      table.insert(r, "effect.name=" .. out_name)
+      for key, value in pairs(out_props) do
+        table.insert(r, key .. "=" .. value)
+      end
+      out_effect_idx = out_effect_idx + 1
+    end
+  end
 
-    if start_val and end_val and layer_val then
-      local start_frame = tonumber(start_val) - 1
-      local end_frame = tonumber(end_val) - 1
-      local layer = tonumber(layer_val) - 1
+  table.insert(r, "")
+  if not out:write(table.concat(r, "\r\n")) then
+    error("failed to write object file")
+  end
+  return true, layer, start_frame, end_frame
+end
 
-      -- Use same index for output section
-      local out_section = section
+--- Decode and parse the raw lines of one object group.
+-- The raw Shift_JIS lines are converted to UTF-8 in a single call and then split into sections.
+-- @param raw_lines table Array of raw lines belonging to one [N] / [N.M] group
+-- @return table Parsed group { props = {...}, effects = { [M] = {...} } }
+-- @raise error if encoding conversion fails
+-- @local
+local function parse_object_group(raw_lines)
+  local utf8_content = gcmz.convert_encoding(table.concat(raw_lines, "\n"), "sjis", "utf8")
+  if not utf8_content then
+    error("Failed to convert encoding from Shift_JIS to UTF-8")
+  end
 
-      out:set(out_section, "layer", tostring(layer))
-      out:set(out_section, "frame", start_frame .. "," .. end_frame)
-      if group_val then
-        out:set(out_section, "group", group_val)
+  local group = { props = {}, effects = {} }
+  local current = nil
+  for line in utf8_content:gmatch("[^\r\n]+") do
+    local obj, effect = line:match("^%[(%d+)%.?(%d*)%]$")
+    if obj then
+      if effect == "" then
+        current = group.props
+      else
+        local idx = tonumber(effect)
+        current = group.effects[idx] or {}
+        group.effects[idx] = current
       end
+    elseif current then
+      local key, value = line:match("^([^=]+)=(.*)$")
+      if key then
+        current[key] = value
+      end
+    end
+  end
+  return group
+end
+
+--- Convert an EXO file to object format, streaming one object at a time.
+-- Reads the EXO file line by line and converts each [N] section together with its
+-- [N.M] effect sub-sections as soon as the group is complete.
+-- Peak memory usage is bounded by the size of the largest object rather than the file.
+-- Objects are processed in index order starting from [0]; conversion stops at the first gap.
+-- @param input file Input EXO file handle (Shift_JIS, opened in binary mode)
+-- @param out file Output object file handle (opened in binary mode)
+-- @return table|nil Layout of the written objects
+--   { layer_min, layer_max, frame_start, frame_end, object_count }, or nil if no object was written
+-- @raise error if encoding conversion, effect conversion, or writing fails
+-- @local
+local function convert_exo_stream(input, out)
+  local expected_idx = 0
+  local group_idx = nil
+  local raw_lines = {}
+  local info = nil
+
+  -- Flush the buffered group. Returns false when conversion should stop.
+  local function flush()
+    if not group_idx then
+      return true
+    end
+    local group = parse_object_group(raw_lines)
+    raw_lines = {}
+    local r, layer, start_frame, end_frame = write_object_group(out, tostring(group_idx), group)
+    if r == nil then
+      return false
+    end
+    if r then
+      if info then
+        info.layer_min = math.min(info.layer_min, layer)
+        info.layer_max = math.max(info.layer_max, layer)
+        info.frame_start = math.min(info.frame_start, start_frame)
+        info.frame_end = math.max(info.frame_end, end_frame)
+        info.object_count = info.object_count + 1
+      else
+        info = {
+          layer_min = layer,
+          layer_max = layer,
+          frame_start = start_frame,
+          frame_end = end_frame,
+          object_count = 1,
+        }
+      end
+    end
+    expected_idx = expected_idx + 1
+    return true
+  end
 
-      -- Process effect sub-sections [0.0], [0.1], etc.
-      local effect_idx = 0
-      local out_effect_idx = 0
-      while true do
-        local effect_section = section .. "." .. effect_idx
-        if not exo:sectionexists(effect_section) then
+  for line in chunked_lines(input, 65536) do
+    -- Section headers are plain ASCII, so they can be detected before decoding
+    local obj = line:match("^%[(%d+)%.?%d*%]$")
+    if obj then
+      obj = tonumber(obj)
+      if obj ~= group_idx then
+        if not flush() then
+          group_idx = nil
           break
         end
-
-        local out_name, out_props = convert_effect(exo, effect_section)
-        if out_name and out_props then
-          local out_effect_section = out_section .. "." .. out_effect_idx
-          out:set(out_effect_section, "effect.name", out_name)
-          for key, value in pairs(out_props) do
-            out:set(out_effect_section, key, value)
-          end
-          out_effect_idx = out_effect_idx + 1
+        if obj ~= expected_idx then
+          group_idx = nil
+          break
         end
-
-        effect_idx = effect_idx + 1
+        group_idx = obj
       end
+      table.insert(raw_lines, line)
+    elseif line:match("^%[.*%]$") then
+      -- Non-object section such as [exedit] ends the current group
+      if not flush() then
+        group_idx = nil
+        break
+      end
+      group_idx = nil
+    elseif group_idx then
+      table.insert(raw_lines, line)
     end
-
-    obj_idx = obj_idx + 1
   end
+  flush()
 
-  return tostring(out)
+  if not info then
+    if not out:write("\r\n") then
+      error("failed to write object file")
+    end
+  end
+  return info
 end
 
 --- Process a single EXO file entry and convert it to object format.
 -- Converts an EXO file to a temporary object file if the file has .exo extension.
--- The file entry is modified in-place with the new temporary file path.
+-- The file entry is modified in-place with the new temporary file path and object_info layout.
 -- @param file table File entry with filepath, mimetype, and other properties
 -- @local
 local function process_exo_file_entry(file)
@@ -318,25 +487,10 @@ local function process_exo_file_entry(file)
     return
   end
 
-  -- Read file content
   local f = io.open(filepath, "rb")
   if not f then
     return
   end
-  local content = f:read("*a")
-  f:close()
-  if not content then
-    return
-  end
-
-  -- Convert EXO file
-  local success, object_content = pcall(convert_exo_to_object, content)
-  if not success then
-    return
-  end
-  if not object_content then
-    return
-  end
 
   -- Create temp file
   local basename = filepath:match("([^/\\]+)$") or "converted.exo"
@@ -344,23 +498,33 @@ local function process_exo_file_entry(file)
 
   local temp_path = gcmz.create_temp_file(temp_filename)
   if not temp_path then
+    f:close()
     return
   end
 
-  -- Write content to temp file
   local out = io.open(temp_path, "wb")
   if not out then
+    f:close()
+    os.remove(temp_path)
     return
   end
-  local ok = out:write(object_content)
-  out:close()
 
-  if ok then
-    -- Update file entry
-    file.filepath = temp_path
-    file.mimetype = "application/aviutl-object"
-    file.temporary = true
+  -- Convert EXO file directly into the temp file
+  local success, info = pcall(convert_exo_stream, f, out)
+  f:close()
+  out:close()
+  if not success then
+    os.remove(temp_path)
+    return
   end
+
+  -- Update file entry
+  file.filepath = temp_path
+  file.mimetype = "application/aviutl-object"
+  file.temporary = true
+  -- Layout of the generated file, so it does not have to be read again on insertion
+  info.filepath = temp_path
+  file.object_info = info
 end
 
 --- Process file list and convert EXO files to object files.